@@ -0,0 +1,50 @@
+#!/bin/sh
+# Mock driver for persistent QM workers (see src/qm_worker.h).
+# Runs every "RUN <command>" with sh and answers "DONE <exit status>".
+# Answers "GEOMETRY" with the energy 0.5 * sum of x^2 + y^2 + z^2 of the atoms plus the total charge,
+# the gradients x y z of the atoms and q q q of the point charges and the partial charge 0.1 per atom.
+# Test commands:
+#   RUN mock-crash <file>    exits without answer if <file> exists (and removes it)
+#   RUN mock-hang <seconds>  answers after sleeping
+#   RUN mock-pid <file>      writes the process id of the driver to <file>
+while IFS= read -r line
+do
+  case "$line" in
+    "RUN mock-crash "*)
+      f=${line#RUN mock-crash }
+      if [ -e "$f" ]; then rm -f "$f"; exit 3; fi
+      echo "DONE 0" ;;
+    "RUN mock-hang "*)
+      sleep "${line#RUN mock-hang }"
+      echo "DONE 0" ;;
+    "RUN mock-pid "*)
+      echo "$$" > "${line#RUN mock-pid }"
+      echo "DONE 0" ;;
+    "GEOMETRY "*)
+      set -- ${line#GEOMETRY }
+      lines=$(($1 + $2))
+      body=""
+      while [ "$lines" -gt 0 ]
+      do
+        IFS= read -r record
+        body="$body$record
+"
+        lines=$((lines - 1))
+      done
+      printf '%s' "$body" | awk -v n="$1" -v q="$3" -v grad="$4" '
+        NR <= n { e += 0.5 * ($2 * $2 + $3 * $3 + $4 * $4); g[NR] = $2 " " $3 " " $4 }
+        NR > n { c[NR - n] = $4 " " $4 " " $4; m = NR - n }
+        END {
+          printf "ENERGY %.12f\n", e + q
+          if (grad == 1) {
+            for (i = 1; i <= n; i++) print "GRADIENT " g[i]
+            for (i = 1; i <= m; i++) print "CHARGEGRADIENT " c[i]
+          }
+          for (i = 1; i <= n; i++) print "CHARGE 0.1"
+          print "DONE 0"
+        }' ;;
+    "RUN "*)
+      sh -c "${line#RUN }" < /dev/null 1>&2
+      echo "DONE $?" ;;
+  esac
+done
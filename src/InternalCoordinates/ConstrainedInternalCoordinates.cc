@@ -10,12 +10,44 @@ namespace internals {
 		scon::mathmatrix<coords::float_type> const& hessianMatrix,
 		CartesianType const& cartesians
 	) {
-		auto pmat = projectorMatrix(cartesians);
-		auto imat = scon::mathmatrix<coords::float_type>::identity(pmat.rows(), pmat.cols());
-		auto projectedHessian = pmat * hessianMatrix * pmat + (imat - pmat) * static_cast<coords::float_type>(1000.0);
-		auto projectedGradient = pmat * gradients;
+		if (primitive_internals.size() < ProjectedStepFinder::denseSize) {
+			auto pmat = projectorMatrix(cartesians);
+			auto imat = scon::mathmatrix<coords::float_type>::identity(pmat.rows(), pmat.cols());
+			auto projectedHessian = pmat * hessianMatrix * pmat + (imat - pmat) * static_cast<coords::float_type>(1000.0);
+			auto projectedGradient = pmat * gradients;
+			return std::make_unique<AppropriateStepFinder>(converter, projectedGradient, projectedHessian);
+		}
+		return std::make_unique<ProjectedStepFinder>(converter, gradients, hessianMatrix, projector(cartesians), 3u * cartesians.size());
+	}
+
+	PrimitiveInternalCoordinates::Projector ConstrainedInternalCoordinates::projector(CartesianType const& cartesians) {
+		using Mat = scon::mathmatrix<coords::float_type>;
+		auto P = PrimitiveInternalCoordinates::projector(cartesians);
+		std::vector<std::size_t> constrained;
+		for (std::size_t i = 0; i < primitive_internals.size(); ++i) {
+			if (primitive_internals[i]->is_constrained()) constrained.emplace_back(i);
+		}
+		if (constrained.empty()) return P;
+
+		// P C is made of the columns P e_k of the constrained coordinates k, C P C is their constrained rows
+		auto const size = primitive_internals.size();
+		auto projectedConstraints = Mat::zero(size, constrained.size());
+		auto CPC = Mat::zero(constrained.size(), constrained.size());
+		for (std::size_t k = 0; k < constrained.size(); ++k) {
+			auto unitVector = Mat::zero(size, 1);
+			unitVector(constrained[k], 0) = 1.0;
+			auto column = P(unitVector);
+			for (std::size_t j = 0; j < constrained.size(); ++j) CPC(j, k) = column(constrained[j], 0);
+			projectedConstraints.set_col(k, column);
+		}
+		auto const inverseCPC = CPC.pinv();
 
-		return std::make_unique<AppropriateStepFinder>(converter, projectedGradient, projectedHessian);
+		return [P, constrained, projectedConstraints, inverseCPC](Mat const& internalVector) {
+			auto projected = P(internalVector);
+			auto constrainedPart = Mat::zero(constrained.size(), 1);
+			for (std::size_t j = 0; j < constrained.size(); ++j) constrainedPart(j, 0) = projected(constrained[j], 0);
+			return Mat(projected - projectedConstraints * (inverseCPC * constrainedPart));
+		};
 	}
 
 	scon::mathmatrix<coords::float_type> ConstrainedInternalCoordinates::projectorMatrix(CartesianType const& cartesian) {
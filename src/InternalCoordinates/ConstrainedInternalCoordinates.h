@@ -19,6 +19,8 @@ namespace internals {
 		using PrimitiveInternalCoordinates::PrimitiveInternalCoordinates;
 
 		virtual scon::mathmatrix<coords::float_type> projectorMatrix(CartesianType const& cartesian) override;
+		/**P - P C (C P C)^+ C P like projectorMatrix, with P applied as the projector of the base class*/
+		virtual Projector projector(CartesianType const& cartesians) override;
 		virtual scon::mathmatrix<coords::float_type> constraintMatrix() const;
 
 		virtual std::unique_ptr<AppropriateStepFinder> constructStepFinder(
@@ -8,6 +8,26 @@
 
 namespace InternalCoordinates {
 
+  namespace {
+    using SparseDerivatives = std::vector<std::pair<std::size_t, coords::float_type>>;
+
+    void appendAtomDerivative(SparseDerivatives & result, std::size_t const atom, coords::r3 const& derivative) {
+      if (derivative.x() != 0.0) result.emplace_back(3u * atom, derivative.x());
+      if (derivative.y() != 0.0) result.emplace_back(3u * atom + 1u, derivative.y());
+      if (derivative.z() != 0.0) result.emplace_back(3u * atom + 2u, derivative.z());
+    }
+  }
+
+  std::vector<std::pair<std::size_t, coords::float_type>>
+    InternalCoordinate::sparse_der_vec(coords::Representation_3D const& cartesians) const {
+    SparseDerivatives result;
+    auto const dense = der_vec(cartesians);
+    for (std::size_t i = 0u; i < dense.size(); ++i) {
+      if (dense[i] != 0.0) result.emplace_back(i, dense[i]);
+    }
+    return result;
+  }
+
 	CartesiansForInternalCoordinates::CartesiansForInternalCoordinates(CartesiansForInternalCoordinates && cartesians)
 		: observerList(std::move(cartesians.observerList)), coordinates(std::move(cartesians.coordinates)) {}
 
@@ -47,6 +67,10 @@ namespace InternalCoordinates {
 
 	std::vector<coords::float_type> CartesiansForInternalCoordinates::getInternalDerivativeVector(InternalCoordinate const& in) const { return in.der_vec(coordinates); }
 
+	std::vector<std::pair<std::size_t, coords::float_type>> CartesiansForInternalCoordinates::getInternalSparseDerivativeVector(InternalCoordinate const& in) const {
+		return in.sparse_der_vec(coordinates);
+	}
+
 	coords::float_type CartesiansForInternalCoordinates::getInternalHessianGuess(InternalCoordinate const& in) const { return in.hessian_guess(coordinates); }
 
 	coords::float_type CartesiansForInternalCoordinates::getInternalDifference(CartesiansForInternalCoordinates const& other, InternalCoordinate const& in) const {
@@ -109,6 +133,16 @@ namespace InternalCoordinates {
     return ic_util::flatten_c3_vec(der_vec);
   }
 
+  std::vector<std::pair<std::size_t, coords::float_type>>
+    BondDistance::sparse_der_vec(coords::Representation_3D const& cartesians) const {
+    auto firstder = der(cartesians);
+    SparseDerivatives result;
+    result.reserve(6u);
+    appendAtomDerivative(result, index_a_, firstder.first);
+    appendAtomDerivative(result, index_b_, firstder.second);
+    return result;
+  }
+
   //enums hold an integral thus I pass them by value
   bool BondDistance::bothElementsInPeriodOne(ic_util::period const atomA, ic_util::period const atomB) const {
     return atomA == ic_util::period::one && atomB == ic_util::period::one;
@@ -250,6 +284,17 @@ namespace InternalCoordinates {
     return ic_util::flatten_c3_vec(der_vec);
   }
 
+  std::vector<std::pair<std::size_t, coords::float_type>>
+    BondAngle::sparse_der_vec(coords::Representation_3D const& cartesians) const {
+    auto firstder = BondAngle::der(cartesians);
+    SparseDerivatives result;
+    result.reserve(9u);
+    appendAtomDerivative(result, index_a_, std::get<0>(firstder));
+    appendAtomDerivative(result, index_b_, std::get<1>(firstder));
+    appendAtomDerivative(result, index_c_, std::get<2>(firstder));
+    return result;
+  }
+
   coords::float_type BondAngle::hessian_guess(coords::Representation_3D const& /*cartesians*/) const {
     using ic_util::element_period;
     using ic_util::period;
@@ -363,6 +408,18 @@ namespace InternalCoordinates {
     return ic_util::flatten_c3_vec(der_vec);
   }
 
+  std::vector<std::pair<std::size_t, coords::float_type>>
+    DihedralAngle::sparse_der_vec(coords::Representation_3D const& cartesians) const {
+    auto firstder = der(cartesians);
+    SparseDerivatives result;
+    result.reserve(12u);
+    appendAtomDerivative(result, index_a_, std::get<0>(firstder));
+    appendAtomDerivative(result, index_b_, std::get<1>(firstder));
+    appendAtomDerivative(result, index_c_, std::get<2>(firstder));
+    appendAtomDerivative(result, index_d_, std::get<3>(firstder));
+    return result;
+  }
+
   coords::float_type DihedralAngle::hessian_guess(coords::Representation_3D const & /*cartesians*/) const{
     return 0.023;
   }
@@ -431,6 +488,16 @@ namespace InternalCoordinates {
     return ic_util::flatten_c3_vec(result);
   }
 
+  std::vector<std::pair<std::size_t, coords::float_type>>
+  Translations::sparse_der_vec(coords::Representation_3D const& /*cartesians*/) const {
+    SparseDerivatives result;
+    result.reserve(indices_.size());
+    for (auto const& i : indices_) {
+      appendAtomDerivative(result, i, size_reciprocal());
+    }
+    return result;
+  }
+
   void RotatorObserver::setNewRotator(std::shared_ptr<AbstractRotatorListener> const rotator) { this->rotator = rotator; }
 
   void RotatorObserver::update(){
@@ -19,6 +19,8 @@ namespace InternalCoordinates {
 	virtual coords::float_type val(coords::Representation_3D const& cartesians) const = 0;
 	virtual coords::float_type difference(coords::Representation_3D const& newCoordinates, coords::Representation_3D const& oldCoordinates) const = 0;
 	virtual std::vector<coords::float_type> der_vec(coords::Representation_3D const& cartesians) const = 0;
+	/**non-zero elements of der_vec as (index, value), the default compresses der_vec*/
+	virtual std::vector<std::pair<std::size_t, coords::float_type>> sparse_der_vec(coords::Representation_3D const& cartesians) const;
 	virtual coords::float_type hessian_guess(coords::Representation_3D const& cartesians) const = 0;
 	virtual std::string info(coords::Representation_3D const & cartesians) const = 0;
 	virtual void makeConstrained() = 0;
@@ -72,9 +74,11 @@ namespace InternalCoordinates {
 
 		coords::Cartesian_Point const& at(std::size_t const i) const;
 		coords::Cartesian_Point & at(std::size_t const i);
+		std::size_t size() const { return coordinates.size(); }
 
 		coords::float_type getInternalValue(InternalCoordinate const& in) const;
 		std::vector<coords::float_type> getInternalDerivativeVector(InternalCoordinate const& in) const;
+		std::vector<std::pair<std::size_t, coords::float_type>> getInternalSparseDerivativeVector(InternalCoordinate const& in) const;
 		coords::float_type getInternalHessianGuess(InternalCoordinate const& in) const;
 		coords::float_type getInternalDifference(CartesiansForInternalCoordinates const& other, InternalCoordinate const& in) const;
 
@@ -140,6 +144,7 @@ namespace InternalCoordinates {
 	coords::float_type difference(coords::Representation_3D const& newCoordinates, coords::Representation_3D const& oldCoordinates) const override;
     std::pair<coords::r3, coords::r3> der(coords::Representation_3D const& cartesians) const;
     std::vector<coords::float_type> der_vec(coords::Representation_3D const& cartesians) const override;
+    std::vector<std::pair<std::size_t, coords::float_type>> sparse_der_vec(coords::Representation_3D const& cartesians) const override;
     coords::float_type hessian_guess(coords::Representation_3D const& cartesians) const override;
     std::string info(coords::Representation_3D const& cartesians) const override;
 
@@ -179,6 +184,7 @@ namespace InternalCoordinates {
 	coords::float_type difference(coords::Representation_3D const& newCoordinates, coords::Representation_3D const& oldCoordinates) const override;
     std::tuple<coords::r3, coords::r3, coords::r3> der(coords::Representation_3D const& cartesians) const;
     std::vector<coords::float_type> der_vec(coords::Representation_3D const& cartesians) const override;
+    std::vector<std::pair<std::size_t, coords::float_type>> sparse_der_vec(coords::Representation_3D const& cartesians) const override;
     coords::float_type hessian_guess(coords::Representation_3D const& cartesians) const override;
     std::string info(coords::Representation_3D const& cartesians) const override;
 
@@ -206,6 +212,7 @@ namespace InternalCoordinates {
     std::tuple<coords::r3, coords::r3, coords::r3, coords::r3>
       der(coords::Representation_3D const& cartesians) const;
     std::vector<coords::float_type> der_vec(coords::Representation_3D const& cartesians) const override;
+    std::vector<std::pair<std::size_t, coords::float_type>> sparse_der_vec(coords::Representation_3D const& cartesians) const override;
     coords::float_type hessian_guess(coords::Representation_3D const& cartesians) const override;
     std::string info(coords::Representation_3D const& cartesians) const override;
 
@@ -245,6 +252,7 @@ namespace InternalCoordinates {
 	coords::float_type difference(coords::Representation_3D const& newCoordinates, coords::Representation_3D const& oldCoordinates) const override;
     virtual std::string info(coords::Representation_3D const& cartesians) const override;
     virtual std::vector<coords::float_type> der_vec(coords::Representation_3D const& cartesians) const override;
+    virtual std::vector<std::pair<std::size_t, coords::float_type>> sparse_der_vec(coords::Representation_3D const& cartesians) const override;
 
     std::vector<std::size_t> indices_;
 
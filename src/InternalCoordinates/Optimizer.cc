@@ -149,7 +149,7 @@ void Optimizer::optimize(coords::Coordinates & coords) {
         
     applyHessianChange();
     
-    auto projectedGradient = internalCoordinateSystem.projectorMatrix(*cartesianCoordinates) * (*currentVariables->systemGradients);
+    auto projectedGradient = internalCoordinateSystem.applyProjector(*cartesianCoordinates, *currentVariables->systemGradients);
     if (ConvergenceCheck{ i + 1, projectedGradient, *this }()) {
       std::cout << "Converged after " << i + 1 << " steps!\n";
       break;
@@ -1,5 +1,9 @@
 #include "PrimitiveInternalCoordinates.h"
 
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
 #include "InternalCoordinateDecorator.h"
 #include "Optimizer.h"
 
@@ -9,16 +13,54 @@
 
 namespace internals {
 
+	namespace {
+		using Mat = scon::mathmatrix<coords::float_type>;
+		using Vec = std::vector<coords::float_type>;
+	}
+
 	struct GradientsAndHessians {
 		GradientsAndHessians(scon::mathmatrix<coords::float_type> const& gradients, scon::mathmatrix<coords::float_type> const& hessian) :
-			gradients{ gradients }, hessian{ hessian }, inverseHessian{ hessian.pinv() }{}
+			gradients{ gradients }, hessian{ hessian }, inverseHessian{}, decomposed{ false } {
+			decompose();
+			// pseudo inverse from the eigenvectors, eigenvalues as small as the ones pinv() discards are dropped
+			auto scaledEigenvectors = eigenvectors;
+			for (std::size_t j = 0u; j < eigenvalues.rows(); ++j) {
+				auto const value = eigenvalues(j, 0);
+				auto const inverse = std::fabs(value) > Mat::close_to_zero_tol ? 1. / value : 0.0;
+				for (std::size_t i = 0u; i < scaledEigenvectors.rows(); ++i) scaledEigenvectors(i, j) *= inverse;
+			}
+			inverseHessian = scaledEigenvectors * eigenvectors.t();
+		}
 
 		GradientsAndHessians(scon::mathmatrix<coords::float_type> const& gradients, scon::mathmatrix<coords::float_type> const& hessian, scon::mathmatrix<coords::float_type> && inverseHessian) :
-			gradients{ gradients }, hessian{ hessian }, inverseHessian{ std::move(inverseHessian) }{}
+			gradients{ gradients }, hessian{ hessian }, inverseHessian{ std::move(inverseHessian) }, decomposed{ false }{}
+
+		/**-(H + alteration * 1)^+ g, the Hessian is only diagonalized on the first call*/
+		scon::mathmatrix<coords::float_type> shiftedStep(coords::float_type const alteration) {
+			decompose();
+			auto projected = eigenvectors.t() * gradients;
+			for (std::size_t j = 0u; j < projected.rows(); ++j) {
+				auto const value = eigenvalues(j, 0) + alteration;
+				projected(j, 0) *= std::fabs(value) > Mat::close_to_zero_tol ? -1. / value : 0.0;
+			}
+			return eigenvectors * projected;
+		}
 
 		scon::mathmatrix<coords::float_type> gradients;
 		scon::mathmatrix<coords::float_type> hessian;
 		scon::mathmatrix<coords::float_type> inverseHessian;
+
+	private:
+		void decompose() {
+			if (decomposed) return;
+			auto symmetricHessian = hessian;
+			std::tie(eigenvalues, eigenvectors) = symmetricHessian.eigensym();
+			decomposed = true;
+		}
+
+		scon::mathmatrix<coords::float_type> eigenvalues;
+		scon::mathmatrix<coords::float_type> eigenvectors;
+		bool decomposed;
 	};
 
 PrimitiveInternalCoordinates::PrimitiveInternalCoordinates() = default;
@@ -145,6 +187,57 @@ PrimitiveInternalCoordinates::projectorMatrix(CartesianType const& cartesian) {
   return Gmat(cartesian) * pseudoInverseOfGmat(cartesian);
 }
 
+PrimitiveInternalCoordinates::Projector
+PrimitiveInternalCoordinates::projector(CartesianType const& cartesians) {
+  // G G^+ = B B^T (B B^T)^+ = B B^+
+  auto const B = sparseBmat(cartesians);
+  return [B](Mat const& internalVector) {
+    return Mat::col_from_vec(B.times(leastSquaresSolution(
+        [&B](Vec const& x) { return B.times(x); },
+        [&B](Vec const& y) { return B.transposedTimes(y); },
+        internalVector.col_to_std_vector())));
+  };
+}
+
+scon::mathmatrix<coords::float_type>
+PrimitiveInternalCoordinates::applyProjector(CartesianType const& cartesians,
+    scon::mathmatrix<coords::float_type> const& internalVector) {
+  return projector(cartesians)(internalVector);
+}
+
+SparseBMatrix const&
+PrimitiveInternalCoordinates::sparseBmat(CartesianType const& cartesians) {
+  std::vector<SparseBMatrix::Row> rows;
+  rows.reserve(primitive_internals.size());
+  for (auto const& pic : primitive_internals) {
+    rows.emplace_back(cartesians.getInternalSparseDerivativeVector(*pic));
+  }
+  sparse_B_matrix.assign(rows, 3u * cartesians.size());
+  return sparse_B_matrix;
+}
+
+scon::mathmatrix<coords::float_type>
+PrimitiveInternalCoordinates::cartesianChange(CartesianType const& cartesians,
+    scon::mathmatrix<coords::float_type> const& internalChange) {
+  // minimum-norm solution of B dx = dq, which is B^T (B B^T)^+ dq
+  auto const& B = sparseBmat(cartesians);
+  return Mat::col_from_vec(leastSquaresSolution(
+      [&B](Vec const& x) { return B.times(x); },
+      [&B](Vec const& y) { return B.transposedTimes(y); },
+      internalChange.col_to_std_vector()));
+}
+
+scon::mathmatrix<coords::float_type>
+PrimitiveInternalCoordinates::internalGradients(CartesianType const& cartesians,
+    scon::mathmatrix<coords::float_type> const& cartesianGradients) {
+  // minimum-norm solution of B^T g_q = g_x, which is (B B^T)^+ B g_x
+  auto const& B = sparseBmat(cartesians);
+  return Mat::col_from_vec(leastSquaresSolution(
+      [&B](Vec const& y) { return B.transposedTimes(y); },
+      [&B](Vec const& x) { return B.times(x); },
+      cartesianGradients.col_to_std_vector()));
+}
+
 std::vector<std::vector<coords::float_type>>
 PrimitiveInternalCoordinates::deriv_vec(CartesianType const& cartesians) {
   std::vector<std::vector<coords::float_type>> result;
@@ -211,8 +304,7 @@ InternalToCartesianConverter::~InternalToCartesianConverter() = default;
 scon::mathmatrix<coords::float_type>
 InternalToCartesianConverter::calculateInternalGradients(
     scon::mathmatrix<coords::float_type> const& gradients) {
-  return internalCoordinates.pseudoInverseOfGmat(cartesianCoordinates) *
-         internalCoordinates.Bmat(cartesianCoordinates) * gradients;
+  return internalCoordinates.internalGradients(cartesianCoordinates, gradients);
 }
 
 std::pair<coords::float_type, coords::float_type>
@@ -260,7 +352,7 @@ coords::float_type StepRestrictor::operator()(AppropriateStepFinder& finder) {
   auto i = 0u;
   for (; i < 1000; ++i) {
     v0 += (1. - internalStepNorm / target) * (internalStepNorm / deltaYPrime);
-    *restrictedStep = finder.getInternalStep(finder.alterHessian(v0));
+    *restrictedStep = finder.getShiftedInternalStep(v0);
     internalStepNorm = getStepNorm();
     if (std::fabs(internalStepNorm - target) / target < 0.001) {
       return restrictedSol = finder.getSol(*restrictedStep);
@@ -476,6 +568,135 @@ scon::mathmatrix<coords::float_type> AppropriateStepFinder::getInternalStep(
   return hessian.pinv() * matrices->gradients * -1.f;
 }
 
+scon::mathmatrix<coords::float_type> AppropriateStepFinder::getShiftedInternalStep(
+    coords::float_type const alteration) const {
+  return matrices->shiftedStep(alteration);
+}
+
+namespace {
+  /**symmetric tridiagonal matrix of the Lanczos iterations*/
+  Mat tridiagonalMatrix(Vec const& alphas, Vec const& betas) {
+    auto const dimension = alphas.size();
+    auto tridiagonal = Mat::zero(dimension, dimension);
+    for (std::size_t i = 0u; i < dimension; ++i) {
+      tridiagonal(i, i) = alphas[i];
+      if (i + 1u < dimension) tridiagonal(i, i + 1u) = tridiagonal(i + 1u, i) = betas[i];
+    }
+    return tridiagonal;
+  }
+
+  /**
+   * true if the Newton step -(P H P)^+ g and the lowest Ritz pair of the Krylov space are converged.
+   * The residuals follow from the last components of the Ritz vectors times the next beta,
+   * the one of the step is relative to the norm of the gradients.
+   */
+  bool ritzPairsConverged(Vec const& alphas, Vec const& betas, coords::float_type const beta,
+      coords::float_type const hessianNorm) {
+    Mat values, eigenvectors;
+    std::tie(values, eigenvectors) = tridiagonalMatrix(alphas, betas).eigensym();
+    auto const last = alphas.size() - 1u;
+    coords::float_type stepComponent{ 0.0 };
+    std::size_t lowest{ 0u };
+    for (std::size_t j = 0u; j < values.rows(); ++j) {
+      auto const value = values(j, 0);
+      if (std::fabs(value) > Mat::close_to_zero_tol) stepComponent += eigenvectors(last, j) * eigenvectors(0u, j) / value;
+      if (value < values(lowest, 0)) lowest = j;
+    }
+    auto const tolerance = ProjectedStepFinder::ritzTolerance;
+    return beta * std::fabs(stepComponent) <= tolerance
+      && beta * std::fabs(eigenvectors(last, lowest)) <= tolerance * hessianNorm;
+  }
+}
+
+/**Ritz vectors of P H P as columns, their Ritz values and the projected gradients in the basis of the Ritz vectors*/
+struct ProjectedStepFinder::RitzPairs {
+  scon::mathmatrix<coords::float_type> vectors, values, gradients;
+};
+
+ProjectedStepFinder::ProjectedStepFinder(InternalToCartesianConverter const& converter, scon::mathmatrix<coords::float_type> const& gradients,
+    scon::mathmatrix<coords::float_type> const& hessian, PrimitiveInternalCoordinates::Projector const& projector,
+    std::size_t const maximumRank) :
+  AppropriateStepFinder(converter, projector(gradients), hessian, Mat()), ritz{ std::make_unique<RitzPairs>() } {
+  auto const& projectedGradients = matrices->gradients;
+  auto const size = projectedGradients.rows();
+  // the Krylov space lies in the range of P, which is at most the rank of B
+  auto const maximumDimension = std::min<std::size_t>(size, maximumRank);
+  auto const gradientNorm = projectedGradients.norm();
+  std::vector<Mat> krylovBasis;
+  Vec alphas, betas;
+  if (gradientNorm > 0.0) {
+    auto current = projectedGradients * (1. / gradientNorm);
+    auto previous = Mat::zero(size, 1);
+    coords::float_type beta{ 0.0 }, hessianNorm{ 0.0 };
+    while (krylovBasis.size() < maximumDimension) {
+      krylovBasis.emplace_back(current);
+      auto next = projector(hessian * current);
+      auto const alpha = (current.t() * next)(0, 0);
+      next -= current * alpha + previous * beta;
+      // the projector is only solved to the CGLS tolerance, so the basis is orthogonalized twice
+      for (auto pass = 0; pass < 2; ++pass) {
+        for (auto const& vector : krylovBasis) next -= vector * (vector.t() * next)(0, 0);
+      }
+      alphas.emplace_back(alpha);
+      hessianNorm = std::max(hessianNorm, std::fabs(alpha) + beta);
+      beta = next.norm();
+      if (beta <= 1.e-10 * hessianNorm) break;
+      if (alphas.size() % ritzCheckInterval == 0u && ritzPairsConverged(alphas, betas, beta, hessianNorm)) break;
+      betas.emplace_back(beta);
+      previous = std::move(current);
+      current = next * (1. / beta);
+    }
+  }
+  auto const dimension = alphas.size();
+  if (dimension == 0u) {
+    ritz->vectors = Mat::zero(size, 1);
+    ritz->values = Mat::identity(1, 1);
+    ritz->gradients = Mat::zero(1, 1);
+    return;
+  }
+  Mat eigenvectors;
+  std::tie(ritz->values, eigenvectors) = tridiagonalMatrix(alphas, betas).eigensym();
+  auto krylovMatrix = Mat::zero(size, dimension);
+  for (std::size_t j = 0u; j < dimension; ++j) krylovMatrix.set_col(j, krylovBasis[j]);
+  ritz->vectors = krylovMatrix * eigenvectors;
+  ritz->gradients = ritz->vectors.t() * projectedGradients;
+}
+
+ProjectedStepFinder::~ProjectedStepFinder() = default;
+
+coords::float_type ProjectedStepFinder::getDeltaYPrime(scon::mathmatrix<coords::float_type> const& internalStep) const {
+  // internalStep^T (-(P H P)^+) internalStep in the basis of the Ritz vectors
+  auto const coefficients = ritz->vectors.t() * internalStep;
+  coords::float_type result{ 0.0 };
+  for (std::size_t j = 0u; j < coefficients.rows(); ++j) {
+    auto const value = ritz->values(j, 0);
+    if (std::fabs(value) > Mat::close_to_zero_tol) result -= coefficients(j, 0) * coefficients(j, 0) / value;
+  }
+  return result / internalStep.norm();
+}
+
+coords::float_type ProjectedStepFinder::getSol(scon::mathmatrix<coords::float_type> const& internalStep) const {
+  auto const coefficients = ritz->vectors.t() * internalStep;
+  coords::float_type result{ 0.0 };
+  for (std::size_t j = 0u; j < coefficients.rows(); ++j) {
+    result += 0.5 * ritz->values(j, 0) * coefficients(j, 0) * coefficients(j, 0);
+  }
+  return result + (internalStep.t() * matrices->gradients)(0, 0);
+}
+
+scon::mathmatrix<coords::float_type> ProjectedStepFinder::getInternalStep() const {
+  return getShiftedInternalStep(0.0);
+}
+
+scon::mathmatrix<coords::float_type> ProjectedStepFinder::getShiftedInternalStep(coords::float_type const alteration) const {
+  auto coefficients = ritz->gradients;
+  for (std::size_t j = 0u; j < coefficients.rows(); ++j) {
+    auto const value = ritz->values(j, 0) + alteration;
+    coefficients(j, 0) *= std::fabs(value) > Mat::close_to_zero_tol ? -1. / value : 0.0;
+  }
+  return ritz->vectors * coefficients;
+}
+
 InternalToCartesianStep::~InternalToCartesianStep() = default;
 
 scon::mathmatrix<coords::float_type> InternalToCartesianConverter::calculateInternalValues()const {
@@ -520,9 +741,7 @@ coords::Representation_3D InternalToCartesianConverter::applyInternalChange(
             << actual_xyz.coordinates << "\n\n";*/
 
     takeCartesianStep(
-        internalCoordinates.transposeOfBmat(actual_xyz.coordinates) *
-            internalCoordinates.pseudoInverseOfGmat(actual_xyz.coordinates) *
-            damp * d_int_left,
+        internalCoordinates.cartesianChange(actual_xyz.coordinates, d_int_left * damp),
         actual_xyz);
 
     auto d_now = internalCoordinates
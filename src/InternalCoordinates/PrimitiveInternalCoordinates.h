@@ -14,6 +14,7 @@ Purpose: Definition of primitive Internal Coordinate Systems
 #include"InternalCoordinateBase.h"
 #include"../coords.h"
 #include "BondGraph.h"
+#include "SparseBMatrix.h"
 
 namespace scon {
 	template<typename T> class mathmatrix;
@@ -52,6 +53,7 @@ namespace internals {
 	std::unique_ptr<scon::mathmatrix<coords::float_type>> B_matrix;
 	std::unique_ptr<scon::mathmatrix<coords::float_type>> G_matrix;
 	std::unique_ptr<scon::mathmatrix<coords::float_type>> hessian;
+    SparseBMatrix sparse_B_matrix;
 
     std::vector<std::vector<coords::float_type>> deriv_vec(CartesianType const& cartesians);
 
@@ -69,6 +71,18 @@ namespace internals {
     virtual scon::mathmatrix<coords::float_type> pseudoInverseOfGmat(CartesianType const& cartesian);
     virtual scon::mathmatrix<coords::float_type> projectorMatrix(CartesianType const& cartesian);
 
+    /**application of the projector G G^+ to a vector of internal coordinates*/
+    using Projector = std::function<scon::mathmatrix<coords::float_type>(scon::mathmatrix<coords::float_type> const&)>;
+    /**projector B B^+ v, B^+ v is solved iteratively with a copy of the sparse B matrix, the dense projector is never formed*/
+    virtual Projector projector(CartesianType const& cartesians);
+    scon::mathmatrix<coords::float_type> applyProjector(CartesianType const& cartesians, scon::mathmatrix<coords::float_type> const& internalVector);
+
+    SparseBMatrix const& sparseBmat(CartesianType const& cartesians);
+    /**Cartesian change B^T G^+ internalChange, solved iteratively with the sparse B matrix*/
+    virtual scon::mathmatrix<coords::float_type> cartesianChange(CartesianType const& cartesians, scon::mathmatrix<coords::float_type> const& internalChange);
+    /**internal gradients G^+ B cartesianGradients, solved iteratively with the sparse B matrix*/
+    virtual scon::mathmatrix<coords::float_type> internalGradients(CartesianType const& cartesians, scon::mathmatrix<coords::float_type> const& cartesianGradients);
+
   };
 
   class InternalToCartesianConverter {
@@ -225,6 +239,8 @@ namespace internals {
 
     virtual scon::mathmatrix<coords::float_type> getInternalStep() const;
     virtual scon::mathmatrix<coords::float_type> getInternalStep(scon::mathmatrix<coords::float_type> const& hessian) const;
+    /**same as getInternalStep(alterHessian(alteration)), from the eigenvectors of the Hessian which are only computed once*/
+    virtual scon::mathmatrix<coords::float_type> getShiftedInternalStep(coords::float_type const alteration) const;
 
     coords::Representation_3D & getCartesians() { return *bestCartesiansSoFar; }
 
@@ -256,6 +272,43 @@ namespace internals {
 	std::shared_ptr<coords::Representation_3D> bestCartesiansSoFar;
     StepRestrictorFactory stepRestrictorFactory;
   };
+
+  /**
+   * @brief Step finder for the projected Hessian P H P + 1000 (1 - P) of a constrained coordinate system
+   * which only applies the projector to vectors.
+   * The steps lie in the range of P, where the projected Hessian is P H P. Its eigenpairs are taken from
+   * Lanczos iterations started at the projected gradients, with full reorthogonalization. They stop when the
+   * Krylov space is exhausted, after maximumRank iterations, or when the Newton step and the lowest Ritz pair
+   * are converged to ritzTolerance. So the steps and the shifted steps of the trust radius search match the
+   * dense projected Hessian, but only a small tridiagonal matrix is diagonalized.
+   * matrices->hessian stays the unprojected Hessian.
+   */
+  class ProjectedStepFinder : public AppropriateStepFinder {
+  public:
+    /**below this number of primitive internals the exact dense projected Hessian is used, it takes milliseconds there*/
+    static constexpr std::size_t denseSize = 64u;
+    /**convergence of the Ritz pairs is checked every ritzCheckInterval Lanczos iterations*/
+    static constexpr std::size_t ritzCheckInterval = 10u;
+    static constexpr coords::float_type ritzTolerance = 1.e-8;
+
+    /**maximumRank: upper bound of the rank of B, e.g. the number of Cartesian coordinates*/
+    ProjectedStepFinder(InternalToCartesianConverter const& converter, scon::mathmatrix<coords::float_type> const& gradients,
+      scon::mathmatrix<coords::float_type> const& hessian, PrimitiveInternalCoordinates::Projector const& projector,
+      std::size_t const maximumRank);
+
+    coords::float_type getDeltaYPrime(scon::mathmatrix<coords::float_type> const& internalStep) const override;
+    coords::float_type getSol(scon::mathmatrix<coords::float_type> const& internalStep) const override;
+
+    using AppropriateStepFinder::getInternalStep;
+    scon::mathmatrix<coords::float_type> getInternalStep() const override;
+    scon::mathmatrix<coords::float_type> getShiftedInternalStep(coords::float_type const alteration) const override;
+
+    ~ProjectedStepFinder();
+
+  private:
+    struct RitzPairs;
+    std::unique_ptr<RitzPairs> ritz;
+  };
 }
 
 #endif
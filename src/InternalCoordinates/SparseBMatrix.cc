@@ -0,0 +1,108 @@
+#include "SparseBMatrix.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "../Scon/scon_mathmatrix.h"
+
+namespace internals {
+
+  namespace {
+    float_type dot(std::vector<float_type> const& a, std::vector<float_type> const& b) {
+      float_type sum{ 0.0 };
+      for (std::size_t i = 0u; i < a.size(); ++i) sum += a[i] * b[i];
+      return sum;
+    }
+
+    /**number of eigenvalues below x of the symmetric tridiagonal matrix with the diagonal d
+    and the squared off-diagonal elements e2 (Sturm sequence)*/
+    std::size_t eigenvaluesBelow(std::vector<float_type> const& d, std::vector<float_type> const& e2, float_type const x) {
+      std::size_t count{ 0u };
+      float_type q{ 1.0 };
+      for (std::size_t i = 0u; i < d.size(); ++i) {
+        q = d[i] - x - (i > 0u ? e2[i - 1u] / q : 0.0);
+        if (q == 0.0) q = -1.e-300;
+        if (q < 0.0) ++count;
+      }
+      return count;
+    }
+  }
+
+  void SparseBMatrix::assign(std::vector<Row> const& rows, std::size_t const columns) {
+    numberOfColumns = columns;
+    rowStart.clear();
+    columnIndices.clear();
+    values.clear();
+    rowStart.reserve(rows.size() + 1u);
+    rowStart.emplace_back(0u);
+    for (auto const& row : rows) {
+      for (auto const& entry : row) {
+        if (entry.first >= columns) {
+          throw std::out_of_range("Derivative of a primitive internal coordinate refers to a Cartesian beyond the structure.");
+        }
+        columnIndices.emplace_back(entry.first);
+        values.emplace_back(entry.second);
+      }
+      rowStart.emplace_back(values.size());
+    }
+  }
+
+  std::vector<float_type> SparseBMatrix::times(std::vector<float_type> const& x) const {
+    std::vector<float_type> result(rows(), 0.0);
+    for (std::size_t i = 0u; i < result.size(); ++i) {
+      float_type sum{ 0.0 };
+      for (auto j = rowStart[i]; j < rowStart[i + 1u]; ++j) {
+        sum += values[j] * x[columnIndices[j]];
+      }
+      result[i] = sum;
+    }
+    return result;
+  }
+
+  std::vector<float_type> SparseBMatrix::transposedTimes(std::vector<float_type> const& y) const {
+    std::vector<float_type> result(numberOfColumns, 0.0);
+    for (std::size_t i = 0u; i + 1u < rowStart.size(); ++i) {
+      for (auto j = rowStart[i]; j < rowStart[i + 1u]; ++j) {
+        result[columnIndices[j]] += values[j] * y[i];
+      }
+    }
+    return result;
+  }
+
+  std::vector<float_type> leastSquaresSolution(
+    std::function<std::vector<float_type>(std::vector<float_type> const&)> const& apply,
+    std::function<std::vector<float_type>(std::vector<float_type> const&)> const& applyTransposed,
+    std::vector<float_type> const& b, float_type const tolerance, std::size_t const maxIterations) {
+    auto r = b;
+    auto s = applyTransposed(r);
+    auto p = s;
+    std::vector<float_type> x(s.size(), 0.0);
+    auto gamma = dot(s, s);
+    auto const limit = tolerance * tolerance * gamma;
+    auto const iterations = maxIterations > 0u ? maxIterations : std::max<std::size_t>(100u, 2u * x.size());
+    // Lanczos tridiagonal matrix of A^T A: diagonal 1 / alpha_k + beta_(k-1) / alpha_(k-1),
+    // squared off-diagonal beta_k / alpha_k^2
+    std::vector<float_type> diagonal, offDiagonal2;
+    float_type lastAlpha{ 0.0 }, beta{ 0.0 };
+
+    for (std::size_t iteration = 0u; iteration < iterations && gamma > limit; ++iteration) {
+      auto q = apply(p);
+      auto const qq = dot(q, q);
+      if (qq == 0.0) break;
+      auto const alpha = gamma / qq;
+      if (iteration > 0u) offDiagonal2.emplace_back(beta / (lastAlpha * lastAlpha));
+      diagonal.emplace_back(1. / alpha + (iteration > 0u ? beta / lastAlpha : 0.0));
+      if (eigenvaluesBelow(diagonal, offDiagonal2, scon::mathmatrix<float_type>::close_to_zero_tol) > 0u) break;
+      lastAlpha = alpha;
+      for (std::size_t i = 0u; i < x.size(); ++i) x[i] += alpha * p[i];
+      for (std::size_t i = 0u; i < r.size(); ++i) r[i] -= alpha * q[i];
+      s = applyTransposed(r);
+      auto const newGamma = dot(s, s);
+      beta = newGamma / gamma;
+      for (std::size_t i = 0u; i < p.size(); ++i) p[i] = s[i] + beta * p[i];
+      gamma = newGamma;
+    }
+    return x;
+  }
+}
@@ -0,0 +1,74 @@
+/**
+CAST 3
+SparseBMatrix.h
+Purpose: Sparse Wilson B matrix of the primitive internal coordinates and an
+iterative least-squares solver for the back-transformation to Cartesians.
+
+Every primitive depends on the positions of at most four atoms (translations
+and rotations on the atoms of one fragment), so each row of B only holds a few
+non-zero entries. Products with B and its transpose cost O(non-zeros) and the
+minimum-norm solutions B^T (B B^T)^+ dq and (B B^T)^+ B g_x, for which the
+dense code needs the pseudo inverse of G = B B^T, are obtained with conjugate
+gradients on the normal equations (CGLS) from these products alone.
+
+@version 1.0
+*/
+
+#ifndef SPARSE_B_MATRIX_H
+#define SPARSE_B_MATRIX_H
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "InternalCoordinateBase.h"
+
+namespace internals {
+
+  class SparseBMatrix {
+  public:
+    /**non-zero derivatives of one primitive: index of the flattened Cartesian (3 * atom + xyz) and value*/
+    using Row = std::vector<std::pair<std::size_t, float_type>>;
+
+    SparseBMatrix() : numberOfColumns{ 0u } {}
+
+    /**replaces the rows, the storage of the previous matrix is reused*/
+    void assign(std::vector<Row> const& rows, std::size_t const columns);
+
+    std::size_t rows() const { return rowStart.empty() ? 0u : rowStart.size() - 1u; }
+    std::size_t cols() const { return numberOfColumns; }
+    std::size_t nonZeros() const { return values.size(); }
+
+    /**B x, x has cols() elements*/
+    std::vector<float_type> times(std::vector<float_type> const& x) const;
+    /**B^T y, y has rows() elements*/
+    std::vector<float_type> transposedTimes(std::vector<float_type> const& y) const;
+
+  private:
+    std::vector<std::size_t> rowStart;
+    std::vector<std::size_t> columnIndices;
+    std::vector<float_type> values;
+    std::size_t numberOfColumns;
+  };
+
+  /**
+   * @brief Minimum-norm least-squares solution of A x = b with conjugate gradients on the normal equations (CGLS).
+   * A only enters through the products A x and A^T y. Starting from x = 0 the iterates stay in the range of A^T,
+   * so the result is A^+ b.
+   * Like pinv() of A A^T, which drops the eigenvalues below scon::mathmatrix::close_to_zero_tol, the iteration
+   * stops before it takes a direction belonging to such an eigenvalue: the eigenvalues of A^T A are estimated
+   * from the Lanczos tridiagonal matrix of the iteration (Ritz values) and the solve ends as soon as
+   * one of them falls below the threshold.
+   * @param apply: A x
+   * @param applyTransposed: A^T y
+   * @param b: right hand side
+   * @param tolerance: stop when |A^T r| has dropped below tolerance * |A^T b|
+   * @param maxIterations: upper limit of the iterations, 0 allows twice the number of unknowns (at least 100)
+   */
+  std::vector<float_type> leastSquaresSolution(
+    std::function<std::vector<float_type>(std::vector<float_type> const&)> const& apply,
+    std::function<std::vector<float_type>(std::vector<float_type> const&)> const& applyTransposed,
+    std::vector<float_type> const& b, float_type const tolerance = 1.e-10, std::size_t const maxIterations = 0u);
+}
+
+#endif
@@ -76,5 +76,32 @@ namespace internals {
 		return scon::mathmatrix<coords::float_type>::identity(s, s);
 	}
 
+	PrimitiveInternalCoordinates::Projector TRIC::projector(CartesianType const& /*cartesian*/) {
+		return [](scon::mathmatrix<coords::float_type> const& internalVector) { return internalVector; };
+	}
+
+	scon::mathmatrix<coords::float_type> TRIC::cartesianChange(CartesianType const& cartesians, scon::mathmatrix<coords::float_type> const& internalChange) {
+		using Mat = scon::mathmatrix<coords::float_type>;
+		using Vec = std::vector<coords::float_type>;
+		// B of the delocalized coordinates is del_mat^T B, only the sparse primitive B is set up
+		auto const& B = sparseBmat(cartesians);
+		auto const& U = *del_mat;
+		return Mat::col_from_vec(leastSquaresSolution(
+			[&B, &U](Vec const& x) { return (Mat::row_from_vec(B.times(x)) * U).row_to_std_vector(); },
+			[&B, &U](Vec const& y) { return B.transposedTimes((U * Mat::col_from_vec(y)).col_to_std_vector()); },
+			internalChange.col_to_std_vector()));
+	}
+
+	scon::mathmatrix<coords::float_type> TRIC::internalGradients(CartesianType const& cartesians, scon::mathmatrix<coords::float_type> const& cartesianGradients) {
+		using Mat = scon::mathmatrix<coords::float_type>;
+		using Vec = std::vector<coords::float_type>;
+		auto const& B = sparseBmat(cartesians);
+		auto const& U = *del_mat;
+		return Mat::col_from_vec(leastSquaresSolution(
+			[&B, &U](Vec const& y) { return B.transposedTimes((U * Mat::col_from_vec(y)).col_to_std_vector()); },
+			[&B, &U](Vec const& x) { return (Mat::row_from_vec(B.times(x)) * U).row_to_std_vector(); },
+			cartesianGradients.col_to_std_vector()));
+	}
+
 	scon::mathmatrix<coords::float_type> const& TRIC::getDelMat() const { return *del_mat; }
 }
@@ -28,6 +28,9 @@ namespace internals {
 		scon::mathmatrix<coords::float_type> calc(CartesianType const& xyz) const override;//F
 		scon::mathmatrix<coords::float_type> calc_diff(CartesianType const& lhs, CartesianType const& rhs) const override;//F
 		virtual scon::mathmatrix<coords::float_type> projectorMatrix(CartesianType const& cartesian) override;
+		virtual Projector projector(CartesianType const& cartesian) override;
+		scon::mathmatrix<coords::float_type> cartesianChange(CartesianType const& cartesians, scon::mathmatrix<coords::float_type> const& internalChange) override;
+		scon::mathmatrix<coords::float_type> internalGradients(CartesianType const& cartesians, scon::mathmatrix<coords::float_type> const& cartesianGradients) override;
 
 		scon::mathmatrix<coords::float_type> const& getDelMat()const;
 	protected:
@@ -1,4 +1,5 @@
 ﻿#include "PCA.h"
+#include "coords_io_stream.h"
 namespace pca
 {
 	using float_type = coords::float_type;
@@ -14,9 +15,9 @@ namespace pca
 		if (!Config::get().PCA.pca_trunc_atoms_bool) Config::set().PCA.pca_trunc_atoms_num = std::vector<size_t>();
 
 		coords::Coordinates coords_ref(coords);
-		if (Config::get().PCA.pca_ref_frame_num >= ci->size())
+		if (Config::get().PCA.pca_ref_frame_num >= ci->frames())
 			throw std::runtime_error("Error in config-option pca_ref_frame_num: Number higher than total number of simulation frames.");
-		auto holder = ci->PES()[Config::get().PCA.pca_ref_frame_num].structure.cartesian;
+		auto holder = ci->frame(Config::get().PCA.pca_ref_frame_num);
 		coords_ref.set_xyz(holder);
 		//Constructs two coordinate objects and sets reference frame according to INPUTFILE
 
@@ -62,7 +63,7 @@ namespace pca
 				}
 			}
 			matrix_aligned = Matrix_Class((size_t) /* explicitly casting to round down */ (
-				(ci->size() - Config::get().PCA.pca_start_frame_num) / Config::get().PCA.pca_offset),
+				(ci->frames() - Config::get().PCA.pca_start_frame_num) / Config::get().PCA.pca_offset),
 				Config::get().PCA.pca_internal_dih.size() * 2u);
 		}
 		else
@@ -94,34 +95,34 @@ namespace pca
 					Config::set().PCA.pca_trunc_atoms_bool = true;
 			}
 			matrix_aligned = Matrix_Class((size_t) /* explicitly casting to round down */ \
-				((ci->size() - Config::get().PCA.pca_start_frame_num) / \
+				((ci->frames() - Config::get().PCA.pca_start_frame_num) / \
 					Config::get().PCA.pca_offset), (Config::get().PCA.pca_trunc_atoms_num.size()) * 3u);
 		}
 
-		/* j counts the (truncated) matrix access, i the frames in ci */
+		/* j counts the (truncated) matrix access, the frames are read chunk by chunk */
 		{
 			std::size_t j = 0;
-			if (Config::get().PCA.pca_use_internal)
+			coords::input::frame_chunks chunks(*ci, Config::get().PCA.pca_start_frame_num, Config::get().PCA.pca_offset, matrix_aligned.rows());
+			coords::input::frame_chunk chunk;
+			while (chunks.next(chunk))
 			{
-				for (auto i = Config::get().PCA.pca_start_frame_num; j < matrix_aligned.rows(); ++j, i += Config::get().PCA.pca_offset)
+				for (std::size_t k = 0; k < chunk.size(); ++k, ++j)
 				{
-					auto holder2 = ci->PES()[i].structure.intern;
-					coords.set_internal(holder2);
-					matrix_aligned.row(j) = ::matop::transformToOneline(coords, Config::get().PCA.pca_internal_dih, true);
-				}
-			}
-			else
-			{
-				for (auto i = Config::get().PCA.pca_start_frame_num; j < matrix_aligned.rows(); ++j, i += Config::get().PCA.pca_offset)
-				{
-					auto holder2 = ci->PES()[i].structure.cartesian;
-					coords.set_xyz(holder2);
-					if (Config::get().PCA.pca_alignment)        //Translational and rotational alignment
+					coords.set_xyz(chunk.xyz[k]);
+					if (Config::get().PCA.pca_use_internal)
 					{
-						align::centerOfMassAlignment(coords); //Alignes center of mass
-						align::kabschAlignment(coords, coords_ref); //Rotates
+						coords.to_internal_light();
+						matrix_aligned.row(j) = ::matop::transformToOneline(coords, Config::get().PCA.pca_internal_dih, true);
+					}
+					else
+					{
+						if (Config::get().PCA.pca_alignment)        //Translational and rotational alignment
+						{
+							align::centerOfMassAlignment(coords); //Alignes center of mass
+							align::kabschAlignment(coords, coords_ref); //Rotates
+						}
+						matrix_aligned.row(j) = ::matop::transformToOneline(coords, Config::get().PCA.pca_trunc_atoms_num, false).row(0u);
 					}
-					matrix_aligned.row(j) = ::matop::transformToOneline(coords, Config::get().PCA.pca_trunc_atoms_num, false).row(0u);
 				}
 			}
 		}
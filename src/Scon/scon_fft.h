@@ -0,0 +1,96 @@
+#if !defined(SCON_FFT_HEADER)
+#define SCON_FFT_HEADER
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "scon.h"
+#include "scon_angle.h"
+
+namespace scon
+{
+	namespace fft
+	{
+
+		/**smallest power of two which is not smaller than n*/
+		inline std::size_t next_pow2(std::size_t const n)
+		{
+			std::size_t p(1u);
+			while (p < n) p <<= 1u;
+			return p;
+		}
+
+		inline bool is_pow2(std::size_t const n)
+		{
+			return n > 0u && (n & (n - 1u)) == 0u;
+		}
+
+		/**in-place radix-2 transform of n = 2^k values which are stride elements apart
+		forward: X(k) = sum_j x(j) exp(-2 pi i jk/n), backward: exp(+2 pi i jk/n) without normalization*/
+		template<class T>
+		void transform(std::complex<T>* data, std::size_t const n, std::size_t const stride, bool const backward)
+		{
+			// bit reversal permutation
+			for (std::size_t i = 1u, j = 0u; i < n; ++i)
+			{
+				std::size_t bit = n >> 1u;
+				for (; j & bit; bit >>= 1u) j ^= bit;
+				j ^= bit;
+				if (i < j) std::swap(data[i * stride], data[j * stride]);
+			}
+			// butterflies
+			T const sign(backward ? T(1) : T(-1));
+			for (std::size_t len = 2u; len <= n; len <<= 1u)
+			{
+				T const angle = sign * T(2) * T(SCON_PI) / static_cast<T>(len);
+				std::complex<T> const wlen(std::cos(angle), std::sin(angle));
+				std::size_t const half(len >> 1u);
+				for (std::size_t i = 0u; i < n; i += len)
+				{
+					std::complex<T> w(T(1), T(0));
+					for (std::size_t j = 0u; j < half; ++j)
+					{
+						std::complex<T>& a(data[(i + j) * stride]);
+						std::complex<T>& b(data[(i + j + half) * stride]);
+						std::complex<T> const t(b * w);
+						b = a - t;
+						a += t;
+						w *= wlen;
+					}
+				}
+			}
+		}
+
+		/**three-dimensional transform of a grid with row-major layout (index = (x*ny + y)*nz + z),
+		all dimensions have to be powers of two; lines of one direction are transformed in parallel*/
+		template<class T>
+		void transform_3d(std::vector<std::complex<T>>& grid, std::array<std::size_t, 3u> const& dim, bool const backward)
+		{
+			if (!is_pow2(dim[0]) || !is_pow2(dim[1]) || !is_pow2(dim[2]))
+				throw std::logic_error("FFT grid dimensions have to be powers of two.");
+			if (grid.size() != dim[0] * dim[1] * dim[2])
+				throw std::logic_error("FFT grid size does not match its dimensions.");
+			std::ptrdiff_t const nx(dim[0]), ny(dim[1]), nz(dim[2]);
+			std::complex<T>* const g(grid.data());
+			// z-lines
+#pragma omp parallel for
+			for (std::ptrdiff_t xy = 0; xy < nx * ny; ++xy)
+				transform(g + xy * nz, dim[2], 1u, backward);
+			// y-lines
+#pragma omp parallel for
+			for (std::ptrdiff_t xz = 0; xz < nx * nz; ++xz)
+				transform(g + (xz / nz) * ny * nz + xz % nz, dim[1], dim[2], backward);
+			// x-lines
+#pragma omp parallel for
+			for (std::ptrdiff_t yz = 0; yz < ny * nz; ++yz)
+				transform(g + yz, dim[0], dim[1] * dim[2], backward);
+		}
+
+	}
+}
+
+#endif
@@ -6,6 +6,8 @@
 #include <stdexcept>
 #include <limits>
 #include <utility>
+#include <algorithm>
+#include <cmath>
 #include "scon.h"
 #include "scon_vect.h"
 #include "scon_utility.h"
@@ -59,20 +61,22 @@ namespace scon
 
 			void inc()
 			{
-				auto const& f = m_box->cells().fragments();
-				if (d.x() < f) ++d.x();
+				auto const& lo = m_box->cells().neighbour_lower();
+				auto const& hi = m_box->cells().neighbour_upper();
+				if (d.x() < hi.x()) ++d.x();
 				else
 				{
-					if (d.y() < f)
+					if (d.y() < hi.y())
 					{
-						d.x() = -f;
+						d.x() = lo.x();
 						++d.y();
 					}
 					else
 					{
-						if (d.z() < f)
+						if (d.z() < hi.z())
 						{
-							d.x() = d.y() = -f;
+							d.x() = lo.x();
+							d.y() = lo.y();
 							++d.z();
 						}
 						else m_end = true;
@@ -82,21 +86,23 @@ namespace scon
 
 			bool dec()
 			{
-				auto const& f = m_box->cells().fragments();
-				if (d.x() > -f) --d.x();
+				auto const& lo = m_box->cells().neighbour_lower();
+				auto const& hi = m_box->cells().neighbour_upper();
+				if (d.x() > lo.x()) --d.x();
 				else
 				{
-					if (d.y() > -f)
+					if (d.y() > lo.y())
 					{
 						--d.y();
-						d.x() = f;
+						d.x() = hi.x();
 					}
 					else
 					{
-						if (d.z() > -f)
+						if (d.z() > lo.z())
 						{
 							--d.z();
-							d.y() = d.x() = f;
+							d.y() = hi.y();
+							d.x() = hi.x();
 						}
 						else return false;
 					}
@@ -132,7 +138,7 @@ namespace scon
 		public:
 
 			box_neighbour_iter(Box const& box, bool const end = true)
-				: m_box(&box), d(end ? m_box->cells().fragments() : -m_box->cells().fragments()),
+				: m_box(&box), d(end ? m_box->cells().neighbour_upper() : m_box->cells().neighbour_lower()),
 				offset(-1), m_end(end)
 			{
 				if (!m_box->cells().periodic())
@@ -199,7 +205,6 @@ namespace scon
 			}
 			my_type& operator-- ()
 			{
-				auto const f = m_box->cells().fragments();
 				if (m_end)
 				{
 					m_end = false;
@@ -208,7 +213,7 @@ namespace scon
 				{
 					if (!dec())
 					{
-						throw std::logic_error("Cannot iterate lower than -F(ragmentation), -F , -F in linked cells.");
+						throw std::logic_error("Cannot iterate lower than the first neighbour in linked cells.");
 					}
 					if (!m_box->cells().periodic()) dec_to_system();
 				}
@@ -579,23 +584,19 @@ namespace scon
 				using std::max;
 				m_min = vec_type(0);
 				m_max = vec_type(0);
-				if (!empty())
+				if (m_periodic)
+				{ // the cells span exactly one periodic box centered at the origin
+					m_max = m_pb / T(2);
+					m_min = -m_max;
+				}
+				else if (!empty())
 				{
-					m_min = m_periodic ? pb_clip(positions.front()) : positions.front();
+					m_min = positions.front();
 					m_max = m_min;
 					for (auto const& position : positions)
 					{
-						vec_type const p = m_periodic ?
-							pb_clip(position) : position;
-						m_min = min(p, m_min);
-						m_max = max(p, m_max);
-					}
-					if (m_periodic)
-					{
-						vec_type const phb = m_pb
-							/ T(2), mhb(-phb);
-						m_min = min(mhb, m_min);
-						m_max = max(phb, m_max);
+						m_min = min(position, m_min);
+						m_max = max(position, m_max);
 					}
 					// space extension
 					m_max += extent;
@@ -612,16 +613,28 @@ namespace scon
 			{
 				using std::floor;
 				T const edgeInverse = 1.0 / edge;
-				zero_diff = floor(m_min * edgeInverse);
+				if (m_periodic)
+				{ // as many cells as fit into the box (the last cell of each axis takes the remainder)
+					zero_diff = m_min * edgeInverse;
+					auto const dim_t = floor(m_pb * edgeInverse);
+					dim = int3d_type(std::max(std::ptrdiff_t(dim_t.x()), std::ptrdiff_t(1)),
+						std::max(std::ptrdiff_t(dim_t.y()), std::ptrdiff_t(1)),
+						std::max(std::ptrdiff_t(dim_t.z()), std::ptrdiff_t(1)));
+				}
+				else
+				{
+					zero_diff = floor(m_min * edgeInverse);
+					auto dim_t = (floor(m_max * edgeInverse) - zero_diff) + 1.0;
+					dim = int3d_type(std::ptrdiff_t(dim_t.x()),
+						std::ptrdiff_t(dim_t.y()),
+						std::ptrdiff_t(dim_t.z()));
+				}
 				if (Config::get().general.verbosity > 4U)
 				{
 					std::cout << "LinkedCells::calcDimensions edgeinv: ";
 					std::cout << edgeInverse << ", zerodiff: " << zero_diff << "." << endl;
 				}
-				auto dim_t = (floor(m_max * edgeInverse) - zero_diff) + 1.0;
-				dim = int3d_type(std::ptrdiff_t(dim_t.x()),
-					std::ptrdiff_t(dim_t.y()),
-					std::ptrdiff_t(dim_t.z()));
+				calcNeighbourRange();
 				std::size_t const cells(static_cast<std::size_t>(dim.x() * dim.y() * dim.z()));
 				if (Config::get().general.verbosity > 4U)
 				{
@@ -631,6 +644,21 @@ namespace scon
 				Nbox.assign(cells, 0);
 			}
 
+			// range of cell offsets which have to be visited around every cell
+			void calcNeighbourRange(void)
+			{
+				int_type const f(fragments());
+				m_nlower = int3d_type(-f, -f, -f);
+				m_nupper = int3d_type(f, f, f);
+				if (m_periodic)
+				{ // if there are less than 2f+1 cells in one direction the periodic images of
+					// the neighbours overlap, so every cell of this direction is visited exactly once
+					if (dim.x() <= 2 * f) { m_nlower.x() = 0; m_nupper.x() = dim.x() - 1; }
+					if (dim.y() <= 2 * f) { m_nlower.y() = 0; m_nupper.y() = dim.y() - 1; }
+					if (dim.z() <= 2 * f) { m_nlower.z() = 0; m_nupper.z() = dim.z() - 1; }
+				}
+			}
+
 			void link()
 			{
 				std::size_t const N(positions.size());
@@ -657,6 +685,7 @@ namespace scon
 			std::vector<int_type>    m_roots, m_links;
 			std::vector<std::size_t> cellofelement, Nbox;
 			int_type                 m_fragmentation;
+			int3d_type               m_nlower, m_nupper;
 			nvec_type const& positions;
 			bool                     m_periodic;
 
@@ -664,7 +693,7 @@ namespace scon
 				vec_type const& periodic_boundaries = vec_type(0), T const ext = 0.0,
 				fragmentation::T const fragments = fragmentation::full)
 				: m_pb(periodic_boundaries), edge(edge_length), extent(ext), m_fragmentation(fragments > 0 ? fragments : 1),
-				positions(rep), m_periodic(periodicity)
+				m_nlower(), m_nupper(), positions(rep), m_periodic(periodicity)
 			{
 				edge = edge_length > 0.0 ? edge_length
 					/ static_cast<double>(m_fragmentation) : 10.0;
@@ -708,7 +737,14 @@ namespace scon
 			{
 				using scon::min;
 				using scon::max;
-				if (m_periodic) p = pb_clip(p);
+				if (m_periodic)
+				{
+					p = (pb_clip(p) - m_min) / edge;
+					return int3d_type(
+						std::min(std::max(std::ptrdiff_t(std::floor(p.x())), std::ptrdiff_t(0)), dim.x() - 1),
+						std::min(std::max(std::ptrdiff_t(std::floor(p.y())), std::ptrdiff_t(0)), dim.y() - 1),
+						std::min(std::max(std::ptrdiff_t(std::floor(p.z())), std::ptrdiff_t(0)), dim.z() - 1));
+				}
 				p = min(m_max, max(m_min, p));
 				return int3d_type{ floor(p / edge) - zero_diff };
 			}
@@ -783,8 +819,11 @@ namespace scon
 
 			int_type fragments() const
 			{
-				return m_periodic ? m_fragmentation + 1 : m_fragmentation;
+				return m_fragmentation;
 			}
+			// lowest and highest offset of neighbouring cells
+			int3d_type const& neighbour_lower() const { return m_nlower; }
+			int3d_type const& neighbour_upper() const { return m_nupper; }
 			bool periodic() const { return m_periodic; }
 
 			bool verify() const
@@ -796,9 +835,17 @@ namespace scon
 				{
 					vec_type const p = m_periodic ? pb_clip(positions[i]) : positions[i];
 					vec_type const box_p = box_of_element(i).position();
-					if (p.x() < box_p.x() || p.x() > (box_p.x() + edge)) return false;
-					if (p.y() < box_p.y() || p.y() > (box_p.y() + edge)) return false;
-					if (p.z() < box_p.z() || p.z() > (box_p.z() + edge)) return false;
+					vec_type box_q = box_p + edge;
+					if (m_periodic)
+					{ // last cell of each axis extends to the end of the box
+						auto const o = box_offset(std::ptrdiff_t(cellofelement[i]));
+						if (o.x() == dim.x() - 1) box_q.x() = m_max.x();
+						if (o.y() == dim.y() - 1) box_q.y() = m_max.y();
+						if (o.z() == dim.z() - 1) box_q.z() = m_max.z();
+					}
+					if (p.x() < box_p.x() || p.x() > box_q.x()) return false;
+					if (p.y() < box_p.y() || p.y() > box_q.y()) return false;
+					if (p.z() < box_p.z() || p.z() > box_q.z()) return false;
 				}
 				return true;
 			}
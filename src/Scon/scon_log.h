@@ -117,6 +117,13 @@ namespace scon
 			return false;
 		}
 
+		// Pass all buffered values to the callable
+		void flush()
+		{
+			using _buffer::unary_flush_container;
+			unary_flush_container(this->p.first, this->p.second);
+		}
+
 	};
 
 	template<class StreamBase, class Callable, class Container>
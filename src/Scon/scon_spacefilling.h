@@ -0,0 +1,128 @@
+#if !defined(SCON_SPACEFILLING_HEADER)
+#define SCON_SPACEFILLING_HEADER
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace scon
+{
+	/**keys and orders along space-filling curves:
+	points that are close on the curve are close in space, so sorting
+	elements along the curve improves the memory locality of neighbour loops*/
+	namespace spacefilling
+	{
+
+		/**bits per dimension of the keys (3*21 bits fit into 64 bit)*/
+		std::size_t constexpr bits = 21u;
+
+		/**interleaves the bits of the three coordinates (x is the most significant one)*/
+		inline std::uint64_t interleave(std::array<std::uint32_t, 3u> const& X)
+		{
+			std::uint64_t key(0u);
+			for (std::size_t b = bits; b-- > 0u; )
+			{
+				for (std::size_t d = 0u; d < 3u; ++d)
+				{
+					key = (key << 1u) | ((X[d] >> b) & 1u);
+				}
+			}
+			return key;
+		}
+
+		/**Morton (Z-order) key of integer coordinates*/
+		inline std::uint64_t morton_key(std::array<std::uint32_t, 3u> const& X)
+		{
+			return interleave(X);
+		}
+
+		/**Hilbert key of integer coordinates
+		(J. Skilling, AIP Conf. Proc. 707, 381 (2004): coordinates are transformed
+		to the "transposed" Hilbert index which is then interleaved)*/
+		inline std::uint64_t hilbert_key(std::array<std::uint32_t, 3u> X)
+		{
+			std::uint32_t const M(std::uint32_t(1u) << (bits - 1u));
+			// inverse undo
+			for (std::uint32_t Q = M; Q > 1u; Q >>= 1u)
+			{
+				std::uint32_t const P(Q - 1u);
+				for (std::size_t i = 0u; i < 3u; ++i)
+				{
+					if (X[i] & Q) X[0] ^= P;
+					else
+					{
+						std::uint32_t const t((X[0] ^ X[i]) & P);
+						X[0] ^= t;
+						X[i] ^= t;
+					}
+				}
+			}
+			// gray encode
+			X[1] ^= X[0];
+			X[2] ^= X[1];
+			std::uint32_t t(0u);
+			for (std::uint32_t Q = M; Q > 1u; Q >>= 1u)
+			{
+				if (X[2] & Q) t ^= Q - 1u;
+			}
+			for (auto& x : X) x ^= t;
+			return interleave(X);
+		}
+
+		enum class curves { MORTON, HILBERT };
+
+		/**permutation that sorts the points along the curve:
+		the element at position k of the sorted sequence is points[order[k]]
+		(points with equal keys keep their relative order)
+		@param points: random access range of points with x(), y() and z()*/
+		template<class POINTS>
+		std::vector<std::size_t> order(POINTS const& points, curves const curve)
+		{
+			std::size_t const N(points.size());
+			std::vector<std::size_t> ret(N);
+			for (std::size_t i = 0u; i < N; ++i) ret[i] = i;
+			if (N < 2u) return ret;
+			// bounding box
+			std::array<double, 3u> low, high;
+			low.fill(std::numeric_limits<double>::max());
+			high.fill(std::numeric_limits<double>::lowest());
+			for (auto const& p : points)
+			{
+				std::array<double, 3u> const c{ { p.x(), p.y(), p.z() } };
+				for (std::size_t d = 0u; d < 3u; ++d)
+				{
+					low[d] = std::min(low[d], c[d]);
+					high[d] = std::max(high[d], c[d]);
+				}
+			}
+			// one common scale for all directions keeps the curve isotropic
+			double extent(0.0);
+			for (std::size_t d = 0u; d < 3u; ++d) extent = std::max(extent, high[d] - low[d]);
+			double const cells(static_cast<double>((std::uint32_t(1u) << bits) - 1u));
+			double const scale(extent > 0.0 ? cells / extent : 0.0);
+			std::vector<std::pair<std::uint64_t, std::size_t>> keys(N);
+			for (std::size_t i = 0u; i < N; ++i)
+			{
+				std::array<double, 3u> const c{ { points[i].x(), points[i].y(), points[i].z() } };
+				std::array<std::uint32_t, 3u> X;
+				for (std::size_t d = 0u; d < 3u; ++d)
+				{
+					X[d] = static_cast<std::uint32_t>(std::min(cells, std::max(0.0, (c[d] - low[d]) * scale)));
+				}
+				keys[i].first = curve == curves::HILBERT ? hilbert_key(X) : morton_key(X);
+				keys[i].second = i;
+			}
+			std::sort(keys.begin(), keys.end());
+			for (std::size_t k = 0u; k < N; ++k) ret[k] = keys[k].second;
+			return ret;
+		}
+
+	}
+}
+
+#endif
@@ -0,0 +1,69 @@
+/**
+CAST 3
+Purpose: Tests the k-d tree of the kNN entropy estimators against the brute-force search
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "../../entropy.h"
+#include "../../entropy_knn.h"
+
+namespace
+{
+	/**matrix with dimensions as rows and draws as columns
+	@param integer: rounds the values so that there are many identical distances*/
+	Matrix_Class randomDraws(std::size_t const dimensions, std::size_t const draws, bool const integer)
+	{
+		std::mt19937 engine(2017u);
+		std::normal_distribution<double> dist(0.0, 3.0);
+		Matrix_Class m(static_cast<uint_type>(dimensions), static_cast<uint_type>(draws), 0.0);
+		for (std::size_t j = 0u; j < draws; ++j)
+		{
+			for (std::size_t i = 0u; i < dimensions; ++i)
+			{
+				m(i, j) = integer ? std::round(dist(engine)) : dist(engine);
+			}
+		}
+		return m;
+	}
+
+	void compareWithBruteForce(Matrix_Class const& draws, std::vector<std::size_t> const& rows)
+	{
+		entropy::KNNTree const tree(draws, rows, 4u);
+		for (std::size_t k = 1u; k <= 4u; ++k)
+		{
+			for (std::size_t i = 0u; i < draws.cols(); ++i)
+			{
+				EXPECT_EQ(tree.knn_distance_eucl_squared(k, i), entropy::knn_distance_eucl_squared(draws, rows.size(), k, rows, i));
+				EXPECT_EQ(tree.maximum_norm_knn_distance(k, i), entropy::maximum_norm_knn_distance(draws, rows.size(), k, rows, i));
+			}
+		}
+	}
+}
+
+TEST(KNNTree, sameDistancesAsBruteForce)
+{
+	auto const draws = randomDraws(4u, 300u, false);
+	compareWithBruteForce(draws, { 0u, 1u, 2u, 3u });
+}
+
+TEST(KNNTree, sameDistancesAsBruteForceForSubsetOfDimensions)
+{
+	auto const draws = randomDraws(5u, 250u, false);
+	compareWithBruteForce(draws, { 3u, 1u });
+	compareWithBruteForce(draws, { 4u });
+}
+
+TEST(KNNTree, sameDistancesAsBruteForceWithTies)
+{
+	auto const draws = randomDraws(2u, 200u, true);
+	compareWithBruteForce(draws, { 0u, 1u });
+}
+
+#endif
@@ -0,0 +1,99 @@
+/**
+CAST 3
+Purpose: Tests the mutual information expansion of the kNN entropy estimators
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../configuration.h"
+#include "../../entropy.h"
+
+namespace
+{
+	/**matrix with draws as rows and dimensions as columns (correlated dimensions)*/
+	Matrix_Class randomDraws(std::size_t const dimensions, std::size_t const draws)
+	{
+		std::mt19937 engine(1234u);
+		std::normal_distribution<double> dist(0.0, 1.0);
+		Matrix_Class m(static_cast<uint_type>(draws), static_cast<uint_type>(dimensions), 0.0);
+		for (std::size_t j = 0u; j < draws; ++j)
+		{
+			for (std::size_t i = 0u; i < dimensions; ++i)
+			{
+				m(j, i) = dist(engine) + (i > 0u ? 0.5 * m(j, i - 1u) : 0.0);
+			}
+		}
+		return m;
+	}
+
+	double expansion(Matrix_Class const& draws, std::size_t const order)
+	{
+		entropyobj const obj(draws, draws.cols(), draws.rows());
+		calculatedentropyobj calc(3u, obj);
+		return calc.calculateNN_MIExpansion(order, kNN_NORM::EUCLEDEAN, kNN_FUNCTION::HNIZDO, false);
+	}
+}
+
+TEST(MIExpansion, fullOrderSameAsFullDimensionalEntropy)
+{
+	auto const oldEntropyConfig = Config::get().entropy;
+	Config::set().entropy.entropy_mi_checkpoint.clear();
+	auto const draws = randomDraws(3u, 200u);
+	entropyobj const obj(draws, draws.cols(), draws.rows());
+	calculatedentropyobj calc(3u, obj);
+	// all lower order terms cancel
+	EXPECT_NEAR(expansion(draws, 3u), calc.calculateNN(kNN_NORM::EUCLEDEAN, false, kNN_FUNCTION::HNIZDO), 1e-8);
+	Config::set().entropy = oldEntropyConfig;
+}
+
+TEST(MIExpansion, resumedFromCheckpointSameAsFreshRun)
+{
+	auto const oldEntropyConfig = Config::get().entropy;
+	std::string const filename("mi_expansion_test.checkpoint");
+	auto const draws = randomDraws(4u, 150u);
+
+	Config::set().entropy.entropy_mi_checkpoint.clear();
+	auto const fresh = expansion(draws, 2u);
+
+	Config::set().entropy.entropy_mi_checkpoint = filename;
+	std::remove(filename.c_str());
+	EXPECT_DOUBLE_EQ(expansion(draws, 2u), fresh);
+
+	// keep header and three joint entropies, add an incomplete line like a killed run would
+	std::vector<std::string> lines;
+	{
+		std::ifstream in(filename);
+		std::string line;
+		while (std::getline(in, line))
+			lines.push_back(line);
+	}
+	ASSERT_EQ(lines.size(), 11u);   // header, 4 single and 6 pair entropies
+	{
+		std::ofstream out(filename, std::ios_base::trunc);
+		for (std::size_t i = 0u; i < 4u; ++i)
+			out << lines[i] << "\n";
+		out << "2 1";
+	}
+	EXPECT_DOUBLE_EQ(expansion(draws, 2u), fresh);
+
+	// data of another calculation is not used
+	auto const other = randomDraws(4u, 120u);
+	auto const otherFromFile = expansion(other, 2u);
+	Config::set().entropy.entropy_mi_checkpoint.clear();
+	EXPECT_DOUBLE_EQ(otherFromFile, expansion(other, 2u));
+
+	std::remove(filename.c_str());
+	Config::set().entropy = oldEntropyConfig;
+}
+
+#endif
@@ -0,0 +1,236 @@
+/**
+CAST 3
+Purpose: Tests the conjugate gradient solver for the induced dipoles of AMOEBA
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../../energy_int_amoeba_polarization.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+	/**polarizable sites with random fields, moving with constant velocity*/
+	struct sites
+	{
+		std::vector<double> x, v, polarity, field_d, field_p, field_v;
+
+		explicit sites(std::size_t const n)
+		{
+			std::mt19937 engine(5u);
+			std::uniform_real_distribution<double> unit(0.0, 1.0);
+			while (x.size() < 3u * n)
+			{
+				double const p[3] = { 12.0 * unit(engine), 12.0 * unit(engine), 12.0 * unit(engine) };
+				bool close(false);
+				for (std::size_t j = 0u; j < x.size(); j += 3u)
+				{
+					double const dx = p[0] - x[j], dy = p[1] - x[j + 1u], dz = p[2] - x[j + 2u];
+					close = close || dx * dx + dy * dy + dz * dz < 2.0 * 2.0;
+				}
+				if (close) continue;
+				x.insert(x.end(), p, p + 3);
+				polarity.push_back(0.5 + unit(engine));
+			}
+			for (std::size_t j = 0u; j < 3u * n; ++j)
+			{
+				v.push_back(0.02 * (unit(engine) - 0.5));
+				field_d.push_back(unit(engine) - 0.5);
+				field_p.push_back(unit(engine) - 0.5);
+				field_v.push_back(0.01 * (unit(engine) - 0.5));
+			}
+		}
+
+		void move()
+		{
+			for (std::size_t j = 0u; j < x.size(); ++j)
+			{
+				x[j] += v[j];
+				field_d[j] += field_v[j];
+				field_p[j] += field_v[j];
+			}
+		}
+
+		/**pair list with the Thole damping of amoeba_ff::e_ind, neighbouring sites are scaled by half,
+		box: edges of the periodic box (zero if not periodic)*/
+		void pairs(energy::interfaces::amoeba::polarization_solver& solver, std::array<double, 3> const& box = {}) const
+		{
+			std::size_t const n = polarity.size();
+			std::vector<double> damp;
+			for (auto const a : polarity) damp.push_back(std::pow(a, 1.0 / 6.0));
+			solver.clear_pairs(x, damp, std::vector<double>(n, 0.39), std::numeric_limits<double>::max(), box);
+			std::vector<energy::interfaces::amoeba::polarization_solver::scaled_pair> scaled;
+			for (std::size_t i = n - 1u; i > 0u; --i)
+			{
+				scaled.push_back({ static_cast<std::uint32_t>(i - 1u), static_cast<std::uint32_t>(i), 0.5 });
+			}
+			solver.scale_pairs(scaled);
+			solver.build_pairs();
+		}
+	};
+
+	/**damped iteration u = alpha (E + T u) of the former solver, converged tightly*/
+	std::vector<double> reference(energy::interfaces::amoeba::polarization_solver const& solver,
+		std::vector<double> const& polarity, std::vector<double> const& e)
+	{
+		std::vector<double> u(e.size()), t;
+		for (std::size_t j = 0u; j < e.size(); ++j) u[j] = polarity[j / 3u] * e[j];
+		for (int iter = 0; iter < 10000; ++iter)
+		{
+			solver.field(u, t);
+			double change(0.0);
+			for (std::size_t j = 0u; j < e.size(); ++j)
+			{
+				double const next = u[j] + 0.55 * (polarity[j / 3u] * (e[j] + t[j]) - u[j]);
+				change = std::max(change, std::abs(next - u[j]));
+				u[j] = next;
+			}
+			if (change < 1e-13) break;
+		}
+		return u;
+	}
+}
+
+TEST(AmoebaPolarization, sameAsDampedIteration)
+{
+	sites s(60u);
+	energy::interfaces::amoeba::polarization_solver solver;
+	solver.tolerance = 1e-10;
+	s.pairs(solver);
+	EXPECT_EQ(solver.pairs(), 60u * 59u / 2u);
+	EXPECT_TRUE(solver.stored());
+	std::vector<double> ud, up;
+	ASSERT_TRUE(solver.solve(s.polarity, s.field_d, s.field_p, ud, up));
+	EXPECT_GT(solver.iterations(), 0u);
+	EXPECT_LT(solver.iterations(), 60u);
+	EXPECT_LE(solver.rms(), 1e-10);
+	EXPECT_FALSE(solver.predicted());
+	auto const rd = reference(solver, s.polarity, s.field_d), rp = reference(solver, s.polarity, s.field_p);
+	for (std::size_t j = 0u; j < ud.size(); ++j)
+	{
+		EXPECT_NEAR(ud[j], rd[j], 1e-9);
+		EXPECT_NEAR(up[j], rp[j], 1e-9);
+	}
+}
+
+TEST(AmoebaPolarization, predictedDipolesNeedFewerIterations)
+{
+	sites s(40u);
+	energy::interfaces::amoeba::polarization_solver solver;
+	std::vector<double> ud, up;
+	std::size_t first(0u);
+	for (std::size_t step = 0u; step < 8u; ++step)
+	{
+		s.pairs(solver);
+		ASSERT_TRUE(solver.solve(s.polarity, s.field_d, s.field_p, ud, up));
+		if (step == 0u) first = solver.iterations();
+		if (step >= 4u)
+		{
+			EXPECT_TRUE(solver.predicted());
+			EXPECT_LT(solver.iterations(), first);
+		}
+		auto const rd = reference(solver, s.polarity, s.field_d);
+		for (std::size_t j = 0u; j < ud.size(); ++j) EXPECT_NEAR(ud[j], rd[j], 1e-5);
+		s.move();
+	}
+	// a different number of sites starts again from the direct dipoles
+	sites other(30u);
+	other.pairs(solver);
+	ASSERT_TRUE(solver.solve(other.polarity, other.field_d, other.field_p, ud, up));
+	EXPECT_FALSE(solver.predicted());
+}
+
+TEST(AmoebaPolarization, sitesWithoutPolarityStayZero)
+{
+	sites s(20u);
+	s.polarity[3] = 0.0;
+	s.polarity[11] = 0.0;
+	energy::interfaces::amoeba::polarization_solver solver;
+	s.pairs(solver);
+	std::vector<double> ud, up;
+	ASSERT_TRUE(solver.solve(s.polarity, s.field_d, s.field_p, ud, up));
+	for (std::size_t j = 9u; j < 12u; ++j) EXPECT_EQ(ud[j], 0.0);
+	for (std::size_t j = 33u; j < 36u; ++j) EXPECT_EQ(up[j], 0.0);
+	auto const rd = reference(solver, s.polarity, s.field_d);
+	for (std::size_t j = 0u; j < ud.size(); ++j) EXPECT_NEAR(ud[j], rd[j], 1e-5);
+}
+
+TEST(AmoebaPolarization, parallelFieldSameAsSerial)
+{
+	sites s(150u);
+	energy::interfaces::amoeba::polarization_solver solver;
+	s.pairs(solver);
+	auto const solve = [&](int const threads)
+	{
+#ifdef _OPENMP
+		auto const max_threads = omp_get_max_threads();
+		omp_set_num_threads(threads);
+#endif
+		solver.clear_history();
+		std::vector<double> ud, up, e;
+		EXPECT_TRUE(solver.solve(s.polarity, s.field_d, s.field_p, ud, up));
+		solver.field(ud, e);
+#ifdef _OPENMP
+		omp_set_num_threads(max_threads);
+#endif
+		return std::make_pair(ud, e);
+	};
+	auto const serial = solve(1);
+	for (int const threads : { 2, 3, 8 })
+	{
+		auto const parallel = solve(threads);
+		ASSERT_EQ(parallel.first.size(), serial.first.size());
+		for (std::size_t j = 0u; j < serial.first.size(); ++j)
+		{
+			EXPECT_NEAR(parallel.first[j], serial.first[j], 1e-10);
+			EXPECT_NEAR(parallel.second[j], serial.second[j], 1e-10);
+		}
+	}
+}
+
+TEST(AmoebaPolarization, pairsOverMemoryBudgetAreRecomputed)
+{
+	sites s(80u);
+	std::array<double, 3> const box = { 14.0, 14.0, 14.0 };
+	energy::interfaces::amoeba::polarization_solver stored, recomputed;
+	s.pairs(stored, box);
+	// 32-bit indices and two factors per pair, reserved up front
+	EXPECT_TRUE(stored.stored());
+	EXPECT_EQ(stored.storage(), 80u * 79u / 2u * (2u * sizeof(std::uint32_t) + 2u * sizeof(double)));
+	EXPECT_LE(stored.storage(), stored.memory_budget);
+	recomputed.memory_budget = 1000u;
+	s.pairs(recomputed, box);
+	EXPECT_FALSE(recomputed.stored());
+	EXPECT_EQ(recomputed.storage(), 0u);
+	EXPECT_EQ(recomputed.pairs(), stored.pairs());
+	std::vector<double> sd, sp, rd, rp, se, re;
+	ASSERT_TRUE(stored.solve(s.polarity, s.field_d, s.field_p, sd, sp));
+	ASSERT_TRUE(recomputed.solve(s.polarity, s.field_d, s.field_p, rd, rp));
+	stored.field(sd, se);
+	recomputed.field(sd, re);
+	EXPECT_EQ(recomputed.iterations(), stored.iterations());
+	for (std::size_t j = 0u; j < sd.size(); ++j)
+	{
+		EXPECT_NEAR(rd[j], sd[j], 1e-12);
+		EXPECT_NEAR(rp[j], sp[j], 1e-12);
+		EXPECT_NEAR(re[j], se[j], 1e-12);
+	}
+}
+
+#endif
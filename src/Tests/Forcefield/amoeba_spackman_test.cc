@@ -0,0 +1,148 @@
+/**
+CAST 3
+Purpose: Tests the shared tables of the Spackman correction of AMOEBA
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "../../energy_int_amoeba_spackman.h"
+
+using energy::interfaces::amoeba::spackman_tables;
+
+namespace
+{
+	char const* const table_files[] = {
+		"HH_GRAD.in", "CC_GRAD.in", "CH_GRAD.in", "HH_EN.in", "CC_EN.in", "CH_EN.in",
+		"OH_GRAD.in", "OC_GRAD.in", "OO_GRAD.in", "OH_EN.in", "OC_EN.in", "OO_EN.in",
+		"NH_GRAD.in", "NC_GRAD.in", "NN_GRAD.in", "NO_GRAD.in", "NH_EN.in", "NC_EN.in", "NN_EN.in", "NO_EN.in" };
+
+	/**complete set of Spackman files with prefix, the first rows and values are set,
+	o_rows: rows of occupations in spackman.prm, hh_grad: values of HH_GRAD.in*/
+	void write_tables(std::string const& prefix, std::size_t const o_rows = spackman_tables::elements,
+		std::size_t const hh_grad = spackman_tables::required_points)
+	{
+		std::ofstream prm(prefix + "spackman.prm");
+		for (std::size_t i = 0u; i < spackman_tables::elements; ++i)
+		{
+			prm << "n 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19\n";
+			prm << "z 0.5 1.5 2.5 3.5 4.5 5.5 6.5 7.5 8.5 9.5 10.5 11.5 12.5 13.5 14.5 15.5 16.5 17.5 18.5\n";
+			prm << "c 0.1 0.2 0.3 0.4 0.5 0.6 0.7 0.8 0.9 1.0 1.1 1.2 1.3 1.4 1.5 1.6 1.7 1.8 1.9\n";
+			if (i < o_rows) prm << "o 2 1 0\n";
+		}
+		prm << "6 1.25\n1 0.75\n5 1.0\n8 1.0\n";
+		prm << "e\n";
+		prm << "n 9 9 9\n";
+		for (auto const file : table_files)
+		{
+			std::ofstream column(prefix + file);
+			std::size_t const values(std::string(file) == "HH_GRAD.in" ? hh_grad : spackman_tables::required_points);
+			column << "0.5\n-1.5\n2.0e-3\n";
+			for (std::size_t i = 3u; i < values; ++i) column << 1.0 / static_cast<double>(i) << "\n";
+		}
+	}
+
+	void remove_tables(std::string const& prefix)
+	{
+		std::remove((prefix + "spackman.prm").c_str());
+		for (auto const file : table_files) std::remove((prefix + file).c_str());
+	}
+
+	/**message of the exception of reading the tables with prefix, empty if there is none*/
+	std::string read_error(std::string const& prefix)
+	{
+		try
+		{
+			spackman_tables::from_files(prefix);
+		}
+		catch (std::runtime_error const& e)
+		{
+			return e.what();
+		}
+		return std::string();
+	}
+}
+
+TEST(AmoebaSpackman, readsParametersAndColumns)
+{
+	std::string const prefix("spackman_test_");
+	write_tables(prefix);
+	auto const t = spackman_tables::from_files(prefix);
+	remove_tables(prefix);
+
+	ASSERT_EQ(t.nijx.size(), spackman_tables::elements);
+	EXPECT_EQ(t.nijx[0][18], 19);
+	ASSERT_EQ(t.zetax.size(), spackman_tables::elements);
+	EXPECT_FLOAT_EQ(t.zetax[0][1], 1.5f);
+	ASSERT_EQ(t.cs.size(), spackman_tables::elements);
+	EXPECT_FLOAT_EQ(t.cs[9][18], 1.9f);
+	ASSERT_EQ(t.occ.size(), spackman_tables::elements);
+	EXPECT_EQ(t.occ[0][0], 2);
+	// lines behind 'e' are ignored
+	ASSERT_EQ(t.kappan.size(), spackman_tables::kappas);
+	EXPECT_DOUBLE_EQ(t.kappan[1], 0.75);
+
+	ASSERT_EQ(t.exa11.size(), spackman_tables::grid_points);
+	EXPECT_DOUBLE_EQ(t.exa11[0], 0.5);
+	EXPECT_DOUBLE_EQ(t.exa11[1], -1.5);
+	EXPECT_DOUBLE_EQ(t.exa11[2], 2.0e-3);
+	// the grid points behind the values repeat the last one once, the rest stays zero
+	double const last = t.exa11[spackman_tables::required_points - 1u];
+	EXPECT_GT(last, 0.0);
+	EXPECT_DOUBLE_EQ(t.exa11[spackman_tables::required_points], last);
+	EXPECT_EQ(t.exa11.back(), 0.0);
+	ASSERT_EQ(t.dex1010.size(), spackman_tables::grid_points);
+	ASSERT_EQ(t.eveca1.size(), spackman_tables::grid_points);
+	EXPECT_DOUBLE_EQ(t.eveca1.front(), 0.001);
+	EXPECT_DOUBLE_EQ(t.eveca1.back(), 11.002);
+}
+
+TEST(AmoebaSpackman, missingFileThrows)
+{
+	std::string const prefix("spackman_missing_");
+	write_tables(prefix);
+	std::remove((prefix + "NO_EN.in").c_str());
+	auto const table = read_error(prefix);
+	std::remove((prefix + "spackman.prm").c_str());
+	auto const parameters = read_error(prefix);
+	remove_tables(prefix);
+	EXPECT_NE(table.find("spackman_missing_NO_EN.in"), std::string::npos) << table;
+	EXPECT_NE(parameters.find("spackman_missing_spackman.prm"), std::string::npos) << parameters;
+}
+
+TEST(AmoebaSpackman, truncatedFilesThrow)
+{
+	std::string const prefix("spackman_truncated_");
+	write_tables(prefix, spackman_tables::elements, 100u);
+	auto const table = read_error(prefix);
+	remove_tables(prefix);
+	EXPECT_NE(table.find("spackman_truncated_HH_GRAD.in' has 100 values"), std::string::npos) << table;
+
+	write_tables(prefix, spackman_tables::elements - 1u);
+	auto const parameters = read_error(prefix);
+	remove_tables(prefix);
+	EXPECT_NE(parameters.find("have 9 rows 'o'"), std::string::npos) << parameters;
+}
+
+TEST(AmoebaSpackman, tablesAreSharedByAllCallers)
+{
+	// the tables of the working directory, unless there are real ones
+	bool const written(!std::ifstream("spackman.prm"));
+	if (written) write_tables(std::string());
+	auto const first = spackman_tables::shared();
+	auto const second = spackman_tables::shared();
+	if (written) remove_tables(std::string());
+	ASSERT_TRUE(first != nullptr);
+	EXPECT_EQ(first.get(), second.get());
+	EXPECT_EQ(first->eveca1.size(), spackman_tables::grid_points);
+}
+
+#endif
@@ -0,0 +1,295 @@
+/**
+CAST 3
+Purpose: Tests the threaded multipole and polarization energy of AMOEBA against one thread
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../../configuration.h"
+#include "../../coords_io.h"
+#include "../../energy_int_amoeba.h"
+
+namespace
+{
+	/**atom of a test cluster: symbol, position, AMOEBA type and bonded atoms (numbers in the arc file)*/
+	struct cluster_atom
+	{
+		std::string symbol;
+		double x, y, z;
+		int type;
+		std::vector<int> bonds;
+	};
+
+	/**four AMOEBA water molecules*/
+	std::vector<cluster_atom> waters()
+	{
+		return {
+			{ "O", 0.0, 0.0, 0.0, 1, { 2, 3 } },
+			{ "H", 0.9572, 0.0, 0.0, 2, { 1 } },
+			{ "H", -0.24, 0.9266, 0.0, 2, { 1 } },
+			{ "O", 2.9, 0.1, 0.2, 1, { 5, 6 } },
+			{ "H", 3.3, 0.9, 0.5, 2, { 4 } },
+			{ "H", 3.5, -0.4, -0.3, 2, { 4 } },
+			{ "O", 0.3, 2.8, 1.1, 1, { 8, 9 } },
+			{ "H", -0.5, 3.3, 1.2, 2, { 7 } },
+			{ "H", 0.9, 3.4, 0.7, 2, { 7 } },
+			{ "O", 1.5, 1.2, -2.6, 1, { 11, 12 } },
+			{ "H", 1.2, 0.5, -2.0, 2, { 10 } },
+			{ "H", 2.4, 1.0, -2.9, 2, { 10 } } };
+	}
+
+	/**the atoms, written with a minimal parameter file for AMOEBA water and a sodium ion*/
+	coords::Coordinates read_cluster(std::vector<cluster_atom> const& atoms)
+	{
+		std::string const prefix("amoeba_threads_test_");
+		{
+			std::ofstream prm(prefix + "water.prm");
+			prm << "forcefield              AMOEBA-WATER\n\n";
+			prm << "bond-cubic              -2.55\n";
+			prm << "bond-quartic            3.793125\n";
+			prm << "angle-cubic             -0.014\n";
+			prm << "angle-quartic           0.000056\n";
+			prm << "angle-pentic            -0.0000007\n";
+			prm << "angle-sextic            0.000000022\n";
+			prm << "vdwtype                 BUFFERED-14-7\n";
+			prm << "radiusrule              CUBIC-MEAN\n";
+			prm << "radiustype              R-MIN\n";
+			prm << "radiussize              DIAMETER\n";
+			prm << "epsilonrule             HHG\n";
+			prm << "dielectric              1.0\n";
+			prm << "vdw-12-scale            0.0\n";
+			prm << "vdw-13-scale            0.0\n";
+			prm << "vdw-14-scale            1.0\n";
+			prm << "vdw-15-scale            1.0\n";
+			prm << "mpole-12-scale          0.0\n";
+			prm << "mpole-13-scale          0.0\n";
+			prm << "mpole-14-scale          0.4\n";
+			prm << "mpole-15-scale          0.8\n";
+			prm << "polar-12-scale          0.0\n";
+			prm << "polar-13-scale          0.0\n";
+			prm << "polar-14-scale          1.0\n";
+			prm << "polar-15-scale          1.0\n";
+			prm << "direct-11-scale         0.0\n";
+			prm << "direct-12-scale         1.0\n";
+			prm << "direct-13-scale         1.0\n";
+			prm << "direct-14-scale         1.0\n";
+			prm << "mutual-11-scale         1.0\n";
+			prm << "mutual-12-scale         1.0\n";
+			prm << "mutual-13-scale         1.0\n";
+			prm << "mutual-14-scale         1.0\n\n";
+			prm << "atom          1    1    O     \"AMOEBA Water O\"               8    15.995    2\n";
+			prm << "atom          2    2    H     \"AMOEBA Water H\"               1     1.008    1\n";
+			prm << "atom          3    3    Na    \"Sodium Ion Na+\"              11    22.990    0\n\n";
+			prm << "vdw           1               3.4050     0.1100\n";
+			prm << "vdw           2               2.6550     0.0135      0.910\n";
+			prm << "vdw           3               2.6900     0.2600\n\n";
+			prm << "bond          1    2          556.85     0.9572\n";
+			prm << "angle         2    1    2      48.70     108.50\n";
+			prm << "ureybrad      2    1    2      -7.60     1.5537\n\n";
+			prm << "multipole     1   -2   -2              -0.51966\n";
+			prm << "                                        0.00000    0.00000    0.14279\n";
+			prm << "                                        0.37928\n";
+			prm << "                                        0.00000   -0.41809\n";
+			prm << "                                        0.00000    0.00000    0.03881\n";
+			prm << "multipole     2    1    2               0.25983\n";
+			prm << "                                       -0.03859    0.00000   -0.05818\n";
+			prm << "                                       -0.03673\n";
+			prm << "                                        0.00000   -0.10739\n";
+			prm << "                                       -0.00203    0.00000    0.14412\n";
+			// no axis atoms, the dipole and quadrupole stay in the global frame
+			prm << "multipole     3    0    0               1.00000\n";
+			prm << "                                        0.10000   -0.20000    0.30000\n";
+			prm << "                                        0.20000\n";
+			prm << "                                        0.10000   -0.30000\n";
+			prm << "                                        0.05000    0.15000    0.10000\n\n";
+			prm << "polarize      1          0.837     0.390      2\n";
+			prm << "polarize      2          0.496     0.390      1\n";
+			prm << "polarize      3          0.120     0.390\n";
+			std::ofstream arc(prefix + "water.arc");
+			arc << std::setw(6) << atoms.size() << "  AMOEBA water cluster\n";
+			arc << std::fixed << std::setprecision(6);
+			for (std::size_t i = 0u; i < atoms.size(); ++i)
+			{
+				arc << std::setw(6) << i + 1 << "  " << std::left << std::setw(3) << atoms[i].symbol << std::right;
+				arc << std::setw(12) << atoms[i].x << std::setw(12) << atoms[i].y << std::setw(12) << atoms[i].z;
+				arc << std::setw(6) << atoms[i].type;
+				for (auto const b : atoms[i].bonds) arc << std::setw(6) << b;
+				arc << '\n';
+			}
+		}
+		auto const interface = Config::get().general.energy_interface;
+		auto const parameters = Config::get().general.paramFilename;
+		Config::set().general.energy_interface = config::interface_types::AMOEBA;
+		Config::set().general.paramFilename = prefix + "water.prm";
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		auto coords = ci->read(prefix + "water.arc");
+		Config::set().general.energy_interface = interface;
+		Config::set().general.paramFilename = parameters;
+		std::remove((prefix + "water.prm").c_str());
+		std::remove((prefix + "water.arc").c_str());
+		return coords;
+	}
+
+	/**four AMOEBA water molecules*/
+	coords::Coordinates water_cluster()
+	{
+		return read_cluster(waters());
+	}
+
+	/**the four water molecules and a sodium ion without axis atoms, the ion listed first or last*/
+	coords::Coordinates water_cluster_with_ion(bool const ion_first)
+	{
+		auto atoms = waters();
+		cluster_atom const ion{ "Na", 2.8, 2.9, -1.1, 3, {} };
+		if (ion_first)
+		{
+			for (auto& a : atoms)
+			{
+				for (auto& b : a.bonds) ++b;
+			}
+			atoms.insert(atoms.begin(), ion);
+		}
+		else atoms.push_back(ion);
+		return read_cluster(atoms);
+	}
+
+	/**energy of e() and energy and gradients of g() with the given number of threads*/
+	std::pair<double, std::pair<double, coords::Representation_3D>> evaluate(coords::Coordinates& coords, int const threads)
+	{
+#ifdef _OPENMP
+		auto const max_threads = omp_get_max_threads();
+		omp_set_num_threads(threads);
+#endif
+		auto const e = coords.e();
+		auto const g = coords.g();
+		auto gradients = coords.g_xyz();
+#ifdef _OPENMP
+		omp_set_num_threads(max_threads);
+#endif
+		return std::make_pair(e, std::make_pair(g, gradients));
+	}
+}
+
+TEST(AmoebaThreads, sameEnergyAndGradientsAsOneThread)
+{
+	auto coords = water_cluster();
+	ASSERT_EQ(coords.size(), 12u);
+	auto const serial = evaluate(coords, 1);
+	EXPECT_NE(serial.first, 0.0);
+	EXPECT_NEAR(serial.first, serial.second.first, 1e-10);
+	for (int const threads : { 2, 3, 8 })
+	{
+		auto const parallel = evaluate(coords, threads);
+		EXPECT_NEAR(parallel.first, serial.first, 1e-10);
+		EXPECT_NEAR(parallel.second.first, serial.second.first, 1e-10);
+		ASSERT_EQ(parallel.second.second.size(), serial.second.second.size());
+		for (std::size_t i = 0u; i < serial.second.second.size(); ++i)
+		{
+			EXPECT_NEAR(parallel.second.second[i].x(), serial.second.second[i].x(), 1e-10);
+			EXPECT_NEAR(parallel.second.second[i].y(), serial.second.second[i].y(), 1e-10);
+			EXPECT_NEAR(parallel.second.second[i].z(), serial.second.second[i].z(), 1e-10);
+		}
+	}
+}
+
+TEST(AmoebaThreads, sameMultipolesAsSerialCode)
+{
+	// em, ep and their gradients from the serial e_perm before it was threaded
+	double const em_reference = -8.8058989320270342;
+	double const ep_reference = -1.9973018544633876;
+	std::array<std::array<double, 3>, 12> const gm_reference{ {
+		{ 2.3183526617418431, 4.8190426694320552, 9.1470408906073484 },
+		{ -9.0870285152465371, -3.381302334094737, -7.3739298219831619 },
+		{ -4.4482186144032649, -4.4698762700571288, -5.0116227592278175 },
+		{ 9.6017002676153655, 3.0259640661128411, 2.7703485366078011 },
+		{ -0.4099676618506321, -1.4578031838588743, -0.56253984794658707 },
+		{ -2.0427749713027876, 0.23035608719870765, -0.3915512318555322 },
+		{ 1.0779951502651586, 3.1589266091333541, 2.4671330131944189 },
+		{ 0.24386732599016828, -0.94301250325530372, -0.85174077751417998 },
+		{ 0.43719986212987982, -0.62775916684381128, 1.1021480139676474 },
+		{ -1.8591633703905643, -2.3136259827249597, 1.4041353391799167 },
+		{ 3.183357383952532, 1.4591469367977248, -2.4891680230680837 },
+		{ 0.98468048149884424, 0.49994307216012945, -0.21025333196177146 }
+	} };
+	std::array<std::array<double, 3>, 12> const gp_reference{ {
+		{ -0.60587626790203963, -1.5684051077168168, -1.2948416835905914 },
+		{ 2.6636718826170966, 0.75930990411283317, 2.3126252395157305 },
+		{ 1.0826056102722239, 1.2467849800081345, 1.1281298552576926 },
+		{ -1.6854035550237756, -0.89493556257340456, -1.8785732596919023 },
+		{ -0.33310459705389961, 0.47668285304928143, 0.43397555946565136 },
+		{ 0.3721795318627279, -0.26637434522115522, 0.3207398538705345 },
+		{ -0.65633550216236491, -0.1518688469523857, -0.99754169419707506 },
+		{ -0.10781801292716604, 0.12142737924333891, 0.20416660764580111 },
+		{ -0.0093631902966615985, -0.0594714472297838, -0.27443845831166891 },
+		{ 0.22416086779427052, 0.65603278468990145, -0.16908176386739882 },
+		{ -0.69112708412009816, -0.52580739781605024, 0.40424307757701916 },
+		{ -0.2535896830603131, 0.20662480640610642, -0.18940333367379311 }
+	} };
+	auto coords = water_cluster();
+	ASSERT_EQ(coords.size(), 12u);
+	for (int const threads : { 1, 2, 3, 8 })
+	{
+		evaluate(coords, threads);
+		auto const& amoeba = dynamic_cast<energy::interfaces::amoeba::amoeba_ff const&>(*coords.energyinterface());
+		EXPECT_NEAR(amoeba.multipole_energy(), em_reference, 1e-10);
+		EXPECT_NEAR(amoeba.polarization_energy(), ep_reference, 1e-10);
+		auto const& gm = amoeba.multipole_gradients();
+		auto const& gp = amoeba.polarization_gradients();
+		ASSERT_EQ(gm.size(), coords.size());
+		ASSERT_EQ(gp.size(), coords.size());
+		for (std::size_t i = 0u; i < coords.size(); ++i)
+		{
+			EXPECT_NEAR(gm[i].x(), gm_reference[i][0], 1e-10);
+			EXPECT_NEAR(gm[i].y(), gm_reference[i][1], 1e-10);
+			EXPECT_NEAR(gm[i].z(), gm_reference[i][2], 1e-10);
+			EXPECT_NEAR(gp[i].x(), gp_reference[i][0], 1e-10);
+			EXPECT_NEAR(gp[i].y(), gp_reference[i][1], 1e-10);
+			EXPECT_NEAR(gp[i].z(), gp_reference[i][2], 1e-10);
+		}
+	}
+}
+
+TEST(AmoebaThreads, siteWithoutAxesIndependentOfAtomOrder)
+{
+	// a site without axis atoms keeps its multipoles in the global frame,
+	// it must not take over the frame of the site rotated before it
+	auto first = water_cluster_with_ion(true);
+	auto last = water_cluster_with_ion(false);
+	ASSERT_EQ(first.size(), 13u);
+	ASSERT_EQ(last.size(), 13u);
+	evaluate(first, 1);
+	evaluate(last, 1);
+	auto const& amoeba_first = dynamic_cast<energy::interfaces::amoeba::amoeba_ff const&>(*first.energyinterface());
+	auto const& amoeba_last = dynamic_cast<energy::interfaces::amoeba::amoeba_ff const&>(*last.energyinterface());
+	EXPECT_NEAR(amoeba_first.multipole_energy(), amoeba_last.multipole_energy(), 1e-8);
+	EXPECT_NEAR(amoeba_first.polarization_energy(), amoeba_last.polarization_energy(), 1e-8);
+	// the ion is atom 1 of the first and atom 13 of the last cluster
+	for (std::size_t i = 0u; i < first.size(); ++i)
+	{
+		std::size_t const j = i == 0u ? 12u : i - 1u;
+		auto const g_first = amoeba_first.multipole_gradients()[i] + amoeba_first.polarization_gradients()[i];
+		auto const g_last = amoeba_last.multipole_gradients()[j] + amoeba_last.polarization_gradients()[j];
+		EXPECT_NEAR(g_first.x(), g_last.x(), 1e-8);
+		EXPECT_NEAR(g_first.y(), g_last.y(), 1e-8);
+		EXPECT_NEAR(g_first.z(), g_last.z(), 1e-8);
+	}
+}
+
+#endif
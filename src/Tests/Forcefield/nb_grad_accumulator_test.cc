@@ -0,0 +1,87 @@
+/**
+CAST 3
+Purpose: Tests the thread-local gradient accumulator of the forcefield interface
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include "../../energy_int_aco_accumulator.h"
+
+namespace
+{
+	/**every thread adds (1, 2, 3) to every atom and its thread number to the virial diagonal*/
+	void accumulate(energy::interfaces::aco::nb_grad_accumulator& acc, coords::Representation_3D& grad,
+		coords::virial_t& virial)
+	{
+		acc.prepare(grad.size());
+#pragma omp parallel
+		{
+			coords::Representation_3D& local = acc.local();
+			coords::virial_t tempvir(coords::empty_virial());
+#if defined(_OPENMP)
+			tempvir[0][0] = tempvir[1][1] = tempvir[2][2] = static_cast<double>(omp_get_thread_num());
+#endif
+			for (auto& g : local) g += coords::Cartesian_Point(1.0, 2.0, 3.0);
+			acc.reduce(grad, tempvir, virial);
+		}
+	}
+
+	std::size_t threads()
+	{
+#if defined(_OPENMP)
+		std::size_t t(0u);
+#pragma omp parallel
+		{
+#pragma omp single
+			t = static_cast<std::size_t>(omp_get_num_threads());
+		}
+		return t;
+#else
+		return 1u;
+#endif
+	}
+}
+
+TEST(nb_grad_accumulator, sumsBuffersOfAllThreads)
+{
+	energy::interfaces::aco::nb_grad_accumulator acc;
+	coords::Representation_3D grad(10u, coords::Cartesian_Point(0.0, 0.0, 0.0));
+	coords::virial_t virial(coords::empty_virial());
+	accumulate(acc, grad, virial);
+
+	double const T(static_cast<double>(threads()));
+	for (auto const& g : grad)
+	{
+		EXPECT_DOUBLE_EQ(g.x(), T);
+		EXPECT_DOUBLE_EQ(g.y(), 2.0 * T);
+		EXPECT_DOUBLE_EQ(g.z(), 3.0 * T);
+	}
+	EXPECT_DOUBLE_EQ(virial[0][0], T * (T - 1.0) / 2.0);
+	EXPECT_DOUBLE_EQ(virial[0][1], 0.0);
+}
+
+TEST(nb_grad_accumulator, buffersAreZeroAfterReduction)
+{
+	energy::interfaces::aco::nb_grad_accumulator acc;
+	coords::Representation_3D grad(10u, coords::Cartesian_Point(0.0, 0.0, 0.0));
+	coords::virial_t virial(coords::empty_virial());
+	accumulate(acc, grad, virial);
+
+	coords::Representation_3D second(10u, coords::Cartesian_Point(0.0, 0.0, 0.0));
+	coords::virial_t second_virial(coords::empty_virial());
+	accumulate(acc, second, second_virial);
+
+	for (std::size_t i = 0u; i < grad.size(); ++i)
+	{
+		EXPECT_DOUBLE_EQ(grad[i].x(), second[i].x());
+		EXPECT_DOUBLE_EQ(grad[i].y(), second[i].y());
+		EXPECT_DOUBLE_EQ(grad[i].z(), second[i].z());
+	}
+	EXPECT_DOUBLE_EQ(virial[2][2], second_virial[2][2]);
+}
+
+#endif
@@ -0,0 +1,138 @@
+/**
+CAST 3
+Purpose: Tests the nonbonded pairlists of the forcefield interface
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <set>
+#include <utility>
+
+#include "../../coords_io.h"
+#include "../../configuration.h"
+#include "../../energy_int_aco.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+// tests use the test system butanol.arc
+
+namespace
+{
+	using pair_set = std::set<std::pair<std::size_t, std::size_t>>;
+
+	/**all pairs of all pair matrices (with index of the pair matrix) that are within the cutoff*/
+	std::set<std::pair<std::size_t, std::pair<std::size_t, std::size_t>>> pairsWithinCutoff(coords::Coordinates const& coords)
+	{
+		auto const& aco = dynamic_cast<energy::interfaces::aco::aco_ff const&>(*coords.energyinterface());
+		auto const& box = Config::get().periodics.pb_box;
+		std::set<std::pair<std::size_t, std::pair<std::size_t, std::size_t>>> pairs;
+		for (std::size_t m = 0u; m < aco.refined.pair_matrices().size(); ++m)
+		{
+			for (auto const& pairvec : aco.refined.pair_matrices()[m].pair_matrix)
+			{
+				for (auto const& pair : pairvec)
+				{
+					coords::Cartesian_Point d(coords.xyz(pair.a) - coords.xyz(pair.b));
+					if (Config::get().periodics.periodic)
+					{
+						d.x() -= box.x() * std::round(d.x() / box.x());
+						d.y() -= box.y() * std::round(d.y() / box.y());
+						d.z() -= box.z() * std::round(d.z() / box.z());
+					}
+					if (std::sqrt(dot(d, d)) <= Config::get().energy.cutoff)
+					{
+						pairs.emplace(m, std::make_pair(std::min(pair.a, pair.b), std::max(pair.a, pair.b)));
+					}
+				}
+			}
+		}
+		return pairs;
+	}
+
+	/**compares the pairs of the linked cell algorithm with the pairs of the brute-force path*/
+	void compareLinkedCellsAndBruteForce(double const cutoff)
+	{
+		auto const oldEnergyConfig = Config::get().energy;
+		Config::set().energy.qmmm.qm_systems.clear();   // might be set by other tests
+		Config::set().energy.qmmm.mm_charges.clear();
+
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		coords::Coordinates coords(ci->read("test_files/butanol.arc"));
+		Config::set().energy.cutoff = 1000.0;   // brute force: all pairs
+		coords.energy_update();
+		Config::set().energy.cutoff = cutoff;
+		auto const bruteForcePairs = pairsWithinCutoff(coords);
+
+		coords.energy_update(true);   // linked cells
+		auto const linkedCellPairs = pairsWithinCutoff(coords);
+
+		EXPECT_FALSE(linkedCellPairs.empty());
+		EXPECT_EQ(bruteForcePairs, linkedCellPairs);
+		Config::set().energy = oldEnergyConfig;
+	}
+}
+
+TEST(pairlist, linkedCellsSameAsBruteForce)
+{
+	compareLinkedCellsAndBruteForce(3.0);
+}
+
+TEST(pairlist, periodicLinkedCellsSameAsBruteForce)
+{
+	auto const oldPeriodicsConfig = Config::get().periodics;
+	Config::set().periodics.periodic = true;
+	Config::set().periodics.pb_box = coords::Cartesian_Point(7.0, 8.0, 9.5);
+	compareLinkedCellsAndBruteForce(3.4);
+	Config::set().periodics = oldPeriodicsConfig;
+}
+
+TEST(pairlist, sameOrderOfPairsForAnyNumberOfThreads)
+{
+#if defined(_OPENMP)
+	auto const oldEnergyConfig = Config::get().energy;
+	Config::set().energy.qmmm.qm_systems.clear();   // might be set by other tests
+	Config::set().energy.qmmm.mm_charges.clear();
+	std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+	coords::Coordinates coords(ci->read("test_files/butanol.arc"));
+	auto pairMatrices = [&coords](int const threads) {
+		int const oldThreads(omp_get_max_threads());
+		omp_set_num_threads(threads);
+		coords.energy_update();
+		omp_set_num_threads(oldThreads);
+		return dynamic_cast<energy::interfaces::aco::aco_ff const&>(*coords.energyinterface()).refined.pair_matrices();
+	};
+
+	for (double const cutoff : { 3.0, 1000.0 })   // linked cells and all pairs
+	{
+		Config::set().energy.cutoff = cutoff;
+		auto const serial = pairMatrices(1);
+		auto const parallel = pairMatrices(4);
+		ASSERT_EQ(serial.size(), parallel.size());
+		for (std::size_t m = 0u; m < serial.size(); ++m)
+		{
+			ASSERT_EQ(serial[m].pair_matrix.size(), parallel[m].pair_matrix.size());
+			for (std::size_t k = 0u; k < serial[m].pair_matrix.size(); ++k)
+			{
+				auto const& s = serial[m].pair_matrix(k);
+				auto const& p = parallel[m].pair_matrix(k);
+				ASSERT_EQ(s.size(), p.size());
+				for (std::size_t i = 0u; i < s.size(); ++i)
+				{
+					EXPECT_EQ(s[i].a, p[i].a);
+					EXPECT_EQ(s[i].b, p[i].b);
+				}
+			}
+		}
+	}
+	Config::set().energy = oldEnergyConfig;
+#endif
+}
+
+#endif
@@ -0,0 +1,199 @@
+/**
+CAST 3
+Purpose: Tests the particle-mesh Ewald summation of the forcefield interface
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "../../coords_io.h"
+#include "../../configuration.h"
+#include "../../energy_int_aco.h"
+#include "../../Scon/scon_angle.h"
+
+namespace
+{
+	using energy::interfaces::aco::pme::reciprocal;
+
+	coords::Cartesian_Point const box(10.0, 11.0, 12.0);
+	coords::float_type const alpha(0.35);
+
+	/**random positions and charges (sum of charges = 2)*/
+	void randomSystem(coords::Representation_3D& xyz, std::vector<coords::float_type>& q)
+	{
+		std::mt19937 engine(4321u);
+		std::uniform_real_distribution<double> dist(0.0, 1.0);
+		for (std::size_t i = 0u; i < 20u; ++i)
+		{
+			xyz.emplace_back(dist(engine) * box.x(), dist(engine) * box.y(), dist(engine) * box.z());
+			q.push_back(i % 2 == 0 ? 10.0 : -10.0);
+		}
+		q.back() += 2.0;
+	}
+
+	coords::float_type pmeEnergy(coords::Representation_3D const& xyz, std::vector<coords::float_type> const& q,
+		coords::Cartesian_Point const& b, coords::Representation_3D& grad, coords::virial_t& virial)
+	{
+		reciprocal rec;
+		rec.setup(b, alpha, 0.5, 6u);
+		grad.assign(xyz.size(), coords::Cartesian_Point(0.0, 0.0, 0.0));
+		virial = coords::empty_virial();
+		return rec.energy(xyz, q, grad, virial);
+	}
+
+	/**reciprocal Ewald sum over all wave vectors, self term and background term*/
+	coords::float_type ewaldEnergy(coords::Representation_3D const& xyz, std::vector<coords::float_type> const& q)
+	{
+		coords::float_type const V(box.x() * box.y() * box.z());
+		coords::float_type e(0.0);
+		int const M(12);
+		for (int kx = -M; kx <= M; ++kx)
+		{
+			for (int ky = -M; ky <= M; ++ky)
+			{
+				for (int kz = -M; kz <= M; ++kz)
+				{
+					if (kx == 0 && ky == 0 && kz == 0) continue;
+					coords::Cartesian_Point const m(kx / box.x(), ky / box.y(), kz / box.z());
+					coords::float_type const m2(dot(m, m));
+					coords::float_type sc(0.0), ss(0.0);
+					for (std::size_t i = 0u; i < xyz.size(); ++i)
+					{
+						coords::float_type const arg(2.0 * SCON_PI * dot(m, xyz[i]));
+						sc += q[i] * std::cos(arg);
+						ss += q[i] * std::sin(arg);
+					}
+					e += std::exp(-SCON_PI * SCON_PI * m2 / (alpha * alpha)) / m2 * (sc * sc + ss * ss);
+				}
+			}
+		}
+		e /= 2.0 * SCON_PI * V;
+		coords::float_type qq(0.0), qsum(0.0);
+		for (auto const c : q)
+		{
+			qq += c * c;
+			qsum += c;
+		}
+		return e - alpha / std::sqrt(SCON_PI) * qq - SCON_PI * qsum * qsum / (2.0 * V * alpha * alpha);
+	}
+}
+
+TEST(pme, ewaldCoefficientMatchesTolerance)
+{
+	auto const a = energy::interfaces::aco::pme::ewald_coefficient(9.0, 1e-5);
+	EXPECT_NEAR(std::erfc(a * 9.0), 1e-5, 1e-12);
+}
+
+TEST(pme, reciprocalEnergySameAsEwaldSum)
+{
+	coords::Representation_3D xyz, grad;
+	std::vector<coords::float_type> q;
+	coords::virial_t virial;
+	randomSystem(xyz, q);
+	auto const ewald = ewaldEnergy(xyz, q);
+	EXPECT_NEAR(pmeEnergy(xyz, q, box, grad, virial), ewald, 1e-4 * std::abs(ewald));
+}
+
+TEST(pme, gradientsSameAsFiniteDifferences)
+{
+	coords::Representation_3D xyz, grad, tmp;
+	std::vector<coords::float_type> q;
+	coords::virial_t virial;
+	randomSystem(xyz, q);
+	pmeEnergy(xyz, q, box, grad, virial);
+	double const h(1e-5);
+	for (std::size_t i = 0u; i < xyz.size(); i += 3u)
+	{
+		auto moved = xyz;
+		moved[i].x() += h;
+		auto const ep = pmeEnergy(moved, q, box, tmp, virial);
+		moved[i].x() -= 2.0 * h;
+		auto const em = pmeEnergy(moved, q, box, tmp, virial);
+		EXPECT_NEAR(grad[i].x(), (ep - em) / (2.0 * h), 1e-5 * std::abs(grad[i].x()) + 1e-6);
+	}
+}
+
+TEST(pme, virialSameAsStrainDerivative)
+{
+	coords::Representation_3D xyz, grad;
+	std::vector<coords::float_type> q;
+	coords::virial_t virial, tmp;
+	randomSystem(xyz, q);
+	pmeEnergy(xyz, q, box, grad, virial);
+	// stretch box and positions in y-direction
+	double const h(1e-6);
+	auto strained = [&](double const eps) {
+		auto moved = xyz;
+		for (auto& p : moved) p.y() *= 1.0 + eps;
+		return pmeEnergy(moved, q, coords::Cartesian_Point(box.x(), box.y() * (1.0 + eps), box.z()), grad, tmp);
+	};
+	EXPECT_NEAR(virial[1][1], (strained(h) - strained(-h)) / (2.0 * h), 1e-5 * std::abs(virial[1][1]) + 1e-5);
+}
+
+TEST(pme, forcefieldGradientsSameAsFiniteDifferences)
+{
+	auto const oldEnergyConfig = Config::get().energy;
+	auto const oldPeriodicsConfig = Config::get().periodics;
+	Config::set().energy.qmmm.qm_systems.clear();   // might be set by other tests
+	Config::set().energy.qmmm.mm_charges.clear();
+	Config::set().energy.cutoff = 9.0;
+	Config::set().energy.switchdist = 7.0;
+	Config::set().energy.pme.on = true;
+	Config::set().periodics.periodic = true;
+	Config::set().periodics.pb_box = coords::Cartesian_Point(18.5, 19.0, 20.0);
+
+	std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+	coords::Coordinates coords(ci->read("test_files/butanol.arc"));
+	coords.energy_update();
+	coords.g();
+	auto const grad = coords.g_xyz();
+	double const h(1e-5);
+	for (std::size_t i = 0u; i < coords.size(); ++i)
+	{
+		coords.move_atom_by(i, coords::Cartesian_Point(0.0, 0.0, h));
+		auto const ep = coords.e();
+		coords.move_atom_by(i, coords::Cartesian_Point(0.0, 0.0, -2.0 * h));
+		auto const em = coords.e();
+		coords.move_atom_by(i, coords::Cartesian_Point(0.0, 0.0, h));
+		EXPECT_NEAR(grad[i].z(), (ep - em) / (2.0 * h), 1e-4);
+	}
+	Config::set().energy = oldEnergyConfig;
+	Config::set().periodics = oldPeriodicsConfig;
+}
+
+TEST(pme, forcefieldCoulombEnergyOfIsolatedMoleculeSameAsDirectSum)
+{
+	auto const oldEnergyConfig = Config::get().energy;
+	auto const oldPeriodicsConfig = Config::get().periodics;
+	Config::set().energy.qmmm.qm_systems.clear();   // might be set by other tests
+	Config::set().energy.qmmm.mm_charges.clear();
+
+	std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+	coords::Coordinates coords(ci->read("test_files/butanol.arc"));
+	auto coulomb = [&coords]() {
+		coords.energy_update();
+		coords.e();
+		return dynamic_cast<energy::interfaces::aco::aco_ff const&>(*coords.energyinterface()).part_energy[energy::interfaces::aco::aco_ff::CHARGE];
+	};
+	Config::set().energy.cutoff = 1000.0;   // all pairs, no switching
+	auto const direct = coulomb();
+
+	// in a large box the interactions with the periodic images are negligible
+	Config::set().energy.cutoff = 28.0;
+	Config::set().energy.switchdist = 26.0;
+	Config::set().energy.pme.on = true;
+	Config::set().periodics.periodic = true;
+	Config::set().periodics.pb_box = coords::Cartesian_Point(60.0, 60.0, 60.0);
+	EXPECT_NEAR(coulomb(), direct, 1e-3);
+
+	Config::set().energy = oldEnergyConfig;
+	Config::set().periodics = oldPeriodicsConfig;
+}
+
+#endif
@@ -0,0 +1,134 @@
+/**
+CAST 3
+Purpose: Tests the structure-of-arrays kernel for non-bonded interactions
+against the scalar kernel of the forcefield interface
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include "../../coords_io.h"
+#include "../../configuration.h"
+#include "../../energy_int_aco.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+// tests use the test system butanol.arc
+
+namespace
+{
+	/**calculates energy, gradients and virial once with the scalar and once with the SoA kernel
+	and checks that they are equal (the pairs are distributed differently onto threads,
+	so the order of summation can differ; on one thread without reordering of the atoms
+	both kernels sum in the same order and have to be bit-identical)*/
+	void compareScalarAndSoa(bool const exact = false)
+	{
+		auto expectSame = [exact](double const a, double const b) {
+			if (exact) EXPECT_EQ(a, b);
+			else EXPECT_NEAR(a, b, 1e-10);
+		};
+
+		auto const oldEnergyConfig = Config::get().energy;
+		Config::set().energy.qmmm.qm_systems.clear();   // might be set by other tests
+		Config::set().energy.qmmm.mm_charges.clear();
+
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		coords::Coordinates coords(ci->read("test_files/butanol.arc"));
+		coords.energy_update();
+
+		Config::set().energy.nb_soa = false;
+		auto const scalarEnergy = coords.g();
+		auto const scalarGradients = coords.g_xyz();
+		auto const scalarVirial = coords.virial();
+
+		Config::set().energy.nb_soa = true;
+		auto const soaEnergy = coords.g();
+		auto const& soaGradients = coords.g_xyz();
+		auto const& soaVirial = coords.virial();
+
+		expectSame(scalarEnergy, soaEnergy);
+		ASSERT_EQ(scalarGradients.size(), soaGradients.size());
+		for (std::size_t i = 0u; i < soaGradients.size(); ++i)
+		{
+			expectSame(scalarGradients[i].x(), soaGradients[i].x());
+			expectSame(scalarGradients[i].y(), soaGradients[i].y());
+			expectSame(scalarGradients[i].z(), soaGradients[i].z());
+		}
+		for (std::size_t i = 0u; i < 3u; ++i)
+		{
+			for (std::size_t j = 0u; j < 3u; ++j)
+			{
+				expectSame(scalarVirial[i][j], soaVirial[i][j]);
+			}
+		}
+		Config::set().energy = oldEnergyConfig;
+	}
+}
+
+TEST(soa_nonbonded, sameResultsAsScalarKernelWithoutCutoff)
+{
+	compareScalarAndSoa();
+}
+
+TEST(soa_nonbonded, sameResultsAsScalarKernelWithCutoff)
+{
+	auto const oldEnergyConfig = Config::get().energy;
+	Config::set().energy.cutoff = 4.0;
+	Config::set().energy.switchdist = 3.0;
+	compareScalarAndSoa();
+	Config::set().energy = oldEnergyConfig;
+}
+
+TEST(soa_nonbonded, sameResultsAsScalarKernelWithPeriodics)
+{
+	auto const oldEnergyConfig = Config::get().energy;
+	auto const oldPeriodicsConfig = Config::get().periodics;
+	Config::set().energy.cutoff = 4.5;
+	Config::set().energy.switchdist = 3.5;
+	Config::set().periodics.periodic = true;  // default box of 10 x 10 x 10 Angstrom
+	compareScalarAndSoa();
+	Config::set().energy = oldEnergyConfig;
+	Config::set().periodics = oldPeriodicsConfig;
+}
+
+TEST(soa_nonbonded, bitIdenticalToScalarKernelOnOneThread)
+{
+#if defined(_OPENMP)
+	int const oldThreads(omp_get_max_threads());
+	omp_set_num_threads(1);
+#endif
+	auto const oldEnergyConfig = Config::get().energy;
+	auto const oldPeriodicsConfig = Config::get().periodics;
+	compareScalarAndSoa(true);
+	Config::set().energy.cutoff = 4.0;
+	Config::set().energy.switchdist = 3.0;
+	compareScalarAndSoa(true);
+	Config::set().energy.cutoff = 4.5;
+	Config::set().energy.switchdist = 3.5;
+	Config::set().periodics.periodic = true;
+	compareScalarAndSoa(true);
+	Config::set().energy = oldEnergyConfig;
+	Config::set().periodics = oldPeriodicsConfig;
+#if defined(_OPENMP)
+	omp_set_num_threads(oldThreads);
+#endif
+}
+
+TEST(soa_nonbonded, sameResultsWithAtomsSortedAlongSpaceFillingCurve)
+{
+	auto const oldEnergyConfig = Config::get().energy;
+	Config::set().energy.cutoff = 4.0;
+	Config::set().energy.switchdist = 3.0;
+	Config::set().energy.nb_order = config::energy::nb_orders::HILBERT;
+	compareScalarAndSoa();
+	Config::set().energy.nb_order = config::energy::nb_orders::MORTON;
+	compareScalarAndSoa();
+	Config::set().energy = oldEnergyConfig;
+}
+
+#endif
@@ -0,0 +1,103 @@
+/**
+CAST 3
+Purpose: Tests the Verlet neighbor list of the forcefield interface
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include "../../coords_io.h"
+#include "../../configuration.h"
+#include "../../energy_int_aco.h"
+
+// tests use the test system butanol.arc
+
+class VerletListTest : public testing::Test
+{
+protected:
+	VerletListTest() : oldEnergyConfig(Config::get().energy), oldPeriodicsConfig(Config::get().periodics)
+	{
+		Config::set().energy.qmmm.qm_systems.clear();   // might be set by other tests
+		Config::set().energy.qmmm.mm_charges.clear();
+		Config::set().energy.cutoff = 4.0;
+		Config::set().energy.switchdist = 3.0;
+		Config::set().energy.verlet_skin = 1.0;
+	}
+
+	~VerletListTest()
+	{
+		Config::set().energy = oldEnergyConfig;
+		Config::set().periodics = oldPeriodicsConfig;
+	}
+
+	::tinker::refine::nb_list_stats const& stats(coords::Coordinates const& coords)
+	{
+		return dynamic_cast<energy::interfaces::aco::aco_ff const*>(coords.energyinterface())->refined.nb_stats();
+	}
+
+	config::energy const oldEnergyConfig;
+	config::periodics const oldPeriodicsConfig;
+};
+
+TEST_F(VerletListTest, rebuildsOnlyIfAtomMovedMoreThanHalfSkin)
+{
+	std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+	coords::Coordinates coords(ci->read("test_files/butanol.arc"));
+	coords.energy_update();
+	coords.g();
+	auto const builds = stats(coords).builds;
+
+	coords.move_atom_by(0u, coords::Cartesian_Point(0.4, 0.0, 0.0));
+	coords.g();
+	EXPECT_EQ(stats(coords).builds, builds);
+	EXPECT_NEAR(stats(coords).max_displacement, 0.4, 1e-12);
+
+	coords.move_atom_by(0u, coords::Cartesian_Point(0.2, 0.0, 0.0));
+	coords.g();
+	EXPECT_EQ(stats(coords).builds, builds + 1u);
+	EXPECT_EQ(stats(coords).checks, 3u);
+}
+
+TEST_F(VerletListTest, rebuildsIfBoxChanged)
+{
+	Config::set().periodics.periodic = true;
+	Config::set().periodics.pb_box = coords::Cartesian_Point(20.0, 20.0, 20.0);
+	std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+	coords::Coordinates coords(ci->read("test_files/butanol.arc"));
+	coords.energy_update();
+	coords.g();
+	auto const builds = stats(coords).builds;
+
+	coords.g();
+	EXPECT_EQ(stats(coords).builds, builds);
+
+	// the barostat scales the box, no atom moved
+	Config::set().periodics.pb_box *= 1.01;
+	coords.g();
+	EXPECT_EQ(stats(coords).builds, builds + 1u);
+
+	coords.g();
+	EXPECT_EQ(stats(coords).builds, builds + 1u);
+}
+
+TEST_F(VerletListTest, sameEnergyAsFreshPairlist)
+{
+	std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+	coords::Coordinates coords(ci->read("test_files/butanol.arc"));
+	coords.energy_update();
+	coords.g();
+	for (std::size_t i = 0u; i < coords.size(); ++i)
+	{
+		coords.move_atom_by(i, coords::Cartesian_Point(0.3, -0.2, 0.1) * (i % 3 == 0 ? 1.0 : -1.0));
+	}
+	auto const verletEnergy = coords.g();
+
+	Config::set().energy.verlet_skin = 0.0;
+	coords.energy_update(true);
+	EXPECT_NEAR(verletEnergy, coords.g(), 1e-10);
+}
+
+#endif
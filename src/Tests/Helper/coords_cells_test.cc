@@ -0,0 +1,111 @@
+/**
+CAST 3
+Purpose: Tests the linked cell search for close atom pairs against the loop over all pairs
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+
+#include "../../coords_cells.h"
+#include "../../configuration.h"
+#include "../../coords_io.h"
+
+namespace
+{
+	coords::Representation_3D random_positions(std::size_t const n, double const range, unsigned const seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_real_distribution<double> dist(0.0, range);
+		coords::Representation_3D positions;
+		for (std::size_t i = 0u; i < n; ++i) positions.emplace_back(dist(engine), dist(engine), dist(engine));
+		return positions;
+	}
+
+	std::vector<double> random_radii(std::size_t const n, unsigned const seed)
+	{
+		// covalent radii of H, C, N, O, S and Cl
+		double const r[] = { 0.32, 0.75, 0.71, 0.64, 1.04, 0.99 };
+		std::mt19937 engine(seed);
+		std::uniform_int_distribution<std::size_t> dist(0u, 5u);
+		std::vector<double> radii;
+		for (std::size_t i = 0u; i < n; ++i) radii.push_back(r[dist(engine)]);
+		return radii;
+	}
+}
+
+TEST(CovalentPairs, sameAsBruteForce)
+{
+	// about the density of liquid water, so that every atom has some partners
+	auto const xyz = random_positions(3000u, 31.0, 3u);
+	auto const radii = random_radii(xyz.size(), 5u);
+	auto const brute_force = coords::covalent_pairs_brute_force(xyz, radii);
+	EXPECT_FALSE(brute_force.empty());
+	EXPECT_EQ(coords::covalent_pairs(xyz, radii), brute_force);
+	EXPECT_EQ(coords::covalent_pairs(xyz, radii, 1.5), coords::covalent_pairs_brute_force(xyz, radii, 1.5));
+}
+
+TEST(CovalentPairs, sparseAndBrokenStructures)
+{
+	auto xyz = random_positions(200u, 12.0, 11u);
+	auto const radii = random_radii(xyz.size(), 13u);
+	// one atom far away from the others
+	xyz.back() = coords::Cartesian_Point(1.0e7, -1.0e7, 1.0e7);
+	EXPECT_EQ(coords::covalent_pairs(xyz, radii), coords::covalent_pairs_brute_force(xyz, radii));
+	xyz.front().x() = std::nan("");
+	EXPECT_EQ(coords::covalent_pairs(xyz, radii), coords::covalent_pairs_brute_force(xyz, radii));
+	EXPECT_TRUE(coords::covalent_pairs(coords::Representation_3D(), std::vector<double>()).empty());
+}
+
+TEST(CovalentPairs, crashesDetected)
+{
+	std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+	auto coords = ci->read("test_files/butanol.arc");
+	EXPECT_TRUE(coords.check_for_crashes());
+	// move the hydroxyl hydrogen onto a methyl carbon
+	auto xyz = coords.xyz();
+	xyz.back() = xyz.front() + coords::Cartesian_Point(0.3, 0.0, 0.0);
+	coords.set_xyz(xyz, true);
+	EXPECT_FALSE(coords.check_for_crashes());
+}
+
+TEST(CovalentPairs, xyzBondsSameAsTinker)
+{
+	std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+	auto const tinker = ci->read("test_files/butanol.arc");
+	{
+		std::ofstream xyz("covalent_pairs_butanol.xyz");
+		xyz << tinker.size() << "\n\n";
+		for (std::size_t i = 0u; i < tinker.size(); ++i)
+		{
+			xyz << tinker.atoms(i).symbol() << " " << tinker.xyz(i).x() << " " << tinker.xyz(i).y() << " " << tinker.xyz(i).z() << "\n";
+		}
+	}
+	// XYZ files can not be read with a forcefield interface
+	auto const interface = Config::get().general.energy_interface;
+	auto const input = Config::get().general.input;
+	Config::set().general.energy_interface = config::interface_types::MOPAC;
+	Config::set().general.input = config::input_types::XYZ;
+	std::unique_ptr<coords::input::format> xi(coords::input::new_format());
+	auto const xyz = xi->read("covalent_pairs_butanol.xyz");
+	Config::set().general.energy_interface = interface;
+	Config::set().general.input = input;
+	std::remove("covalent_pairs_butanol.xyz");
+	ASSERT_EQ(xyz.size(), tinker.size());
+	for (std::size_t i = 0u; i < tinker.size(); ++i)
+	{
+		auto expected = tinker.atoms(i).bonds();
+		std::sort(expected.begin(), expected.end());
+		EXPECT_EQ(xyz.atoms(i).bonds(), expected) << "Bonds of atom " << i + 1u;
+	}
+}
+
+#endif
@@ -0,0 +1,134 @@
+/**
+CAST 3
+Purpose: Tests the chunked reading of trajectories
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "../../configuration.h"
+#include "../../coords_io.h"
+#include "../../coords_io_stream.h"
+#include "../../coords_io_trajectory.h"
+
+namespace
+{
+	std::size_t const n_frames(7u);
+
+	coords::Representation_3D shaken(coords::Representation_3D xyz, unsigned const seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_real_distribution<double> dist(-0.2, 0.2);
+		for (auto& p : xyz) p += coords::Cartesian_Point(dist(engine), dist(engine), dist(engine));
+		return xyz;
+	}
+
+	/**writes a TINKER trajectory of n_frames shaken butanol structures*/
+	void write_trajectory(std::string const& file)
+	{
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		auto coords = ci->read("test_files/butanol.arc");
+		auto const start = coords.xyz();
+		std::ofstream out(file);
+		for (unsigned i = 0u; i < n_frames; ++i)
+		{
+			coords.set_xyz(shaken(start, i), true);
+			out << coords::output::formats::tinker(coords);
+		}
+	}
+
+	/**frames of the file read with the given chunk size (0: no streaming)*/
+	std::vector<coords::Representation_3D> read_frames(std::string const& file, std::size_t const stream_chunk,
+		std::size_t const first = 0u, std::size_t const step = 1u)
+	{
+		auto const general = Config::get().general;
+		Config::set().general.stream_chunk = stream_chunk;
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		ci->read(file);
+		Config::set().general = general;
+		std::vector<coords::Representation_3D> ret;
+		coords::input::frame_chunks chunks(*ci, first, step, static_cast<std::size_t>(-1), stream_chunk);
+		coords::input::frame_chunk chunk;
+		while (chunks.next(chunk))
+		{
+			EXPECT_LE(chunk.size(), stream_chunk > 0u ? stream_chunk : 1024u);
+			for (std::size_t k = 0u; k < chunk.size(); ++k)
+			{
+				EXPECT_EQ(chunk.index[k], first + ret.size() * step);
+				ret.push_back(chunk.xyz[k]);
+			}
+		}
+		return ret;
+	}
+
+	void expect_same(std::vector<coords::Representation_3D> const& a, std::vector<coords::Representation_3D> const& b)
+	{
+		ASSERT_EQ(a.size(), b.size());
+		for (std::size_t i = 0u; i < a.size(); ++i)
+		{
+			ASSERT_EQ(a[i].size(), b[i].size());
+			for (std::size_t j = 0u; j < a[i].size(); ++j)
+			{
+				EXPECT_EQ(a[i][j].x(), b[i][j].x());
+				EXPECT_EQ(a[i][j].y(), b[i][j].y());
+				EXPECT_EQ(a[i][j].z(), b[i][j].z());
+			}
+		}
+	}
+}
+
+TEST(StreamedTrajectory, sameFramesAsLoadedEnsemble)
+{
+	std::string const file("stream_test.arc");
+	write_trajectory(file);
+	auto const loaded = read_frames(file, 0u);
+	EXPECT_EQ(loaded.size(), n_frames);
+	expect_same(read_frames(file, 3u), loaded);
+	expect_same(read_frames(file, 1u), loaded);
+	std::remove(file.c_str());
+}
+
+TEST(StreamedTrajectory, firstFrameAndStepHonoured)
+{
+	std::string const file("stream_test.arc");
+	write_trajectory(file);
+	auto const loaded = read_frames(file, 0u);
+	auto const streamed = read_frames(file, 2u, 1u, 3u);
+	ASSERT_EQ(streamed.size(), 2u);
+	expect_same(streamed, { loaded[1], loaded[4] });
+	EXPECT_TRUE(read_frames(file, 2u, n_frames).empty());
+	std::remove(file.c_str());
+}
+
+TEST(StreamedTrajectory, compressedTrajectory)
+{
+	std::string const arc("stream_test.arc"), file("stream_test.ctrj");
+	write_trajectory(arc);
+	auto const loaded = read_frames(arc, 0u);
+	{
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		auto coords = ci->read(arc);
+		coords::trajectory::writer traj(file, coords.atoms(), 1000.0);
+		for (auto const& xyz : loaded) traj.write(xyz);
+	}
+	auto const general = Config::get().general;
+	Config::set().general.input = config::input_types::CTRJ;
+	auto const in_memory = read_frames(file, 0u);
+	auto const streamed = read_frames(file, 4u);
+	Config::set().general = general;
+	EXPECT_EQ(in_memory.size(), n_frames);
+	expect_same(streamed, in_memory);
+	std::remove(arc.c_str());
+	std::remove(file.c_str());
+}
+
+#endif
@@ -0,0 +1,165 @@
+/**
+CAST 3
+Purpose: Tests the compressed binary trajectories
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "../../configuration.h"
+#include "../../coords_io.h"
+#include "../../coords_io_trajectory.h"
+
+namespace
+{
+	std::string const filename("trajectory_test.ctrj");
+	double const precision(1000.0);
+
+	coords::Coordinates butanol()
+	{
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		return ci->read("test_files/butanol.arc");
+	}
+
+	/**structure moved randomly by up to 0.5 Angstrom*/
+	coords::Representation_3D shaken(coords::Representation_3D xyz, unsigned const seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_real_distribution<double> dist(-0.5, 0.5);
+		for (auto& p : xyz) p += coords::Cartesian_Point(dist(engine), dist(engine), dist(engine));
+		return xyz;
+	}
+
+	void expectSameStructure(coords::Representation_3D const& a, coords::Representation_3D const& b)
+	{
+		ASSERT_EQ(a.size(), b.size());
+		for (std::size_t i = 0u; i < a.size(); ++i)
+		{
+			EXPECT_NEAR(a[i].x(), b[i].x(), 0.5 / precision + 1e-12);
+			EXPECT_NEAR(a[i].y(), b[i].y(), 0.5 / precision + 1e-12);
+			EXPECT_NEAR(a[i].z(), b[i].z(), 0.5 / precision + 1e-12);
+		}
+	}
+}
+
+TEST(CompressedTrajectory, decodedFrameSameAsInputWithinPrecision)
+{
+	std::mt19937 engine(42u);
+	std::uniform_real_distribution<double> dist(-2000.0, 2000.0);
+	coords::Representation_3D xyz;
+	for (std::size_t i = 0u; i < 150u; ++i)   // more than one block of atoms
+	{
+		xyz.emplace_back(dist(engine), dist(engine), dist(engine));
+	}
+	auto const payload = coords::trajectory::encode(xyz, precision);
+	expectSameStructure(coords::trajectory::decode(payload, xyz.size(), precision), xyz);
+}
+
+TEST(CompressedTrajectory, frameSmallerThanSinglePrecision)
+{
+	auto const xyz = butanol().xyz();
+	EXPECT_LT(coords::trajectory::encode(xyz, precision).size(), xyz.size() * 3u * sizeof(float));
+}
+
+TEST(CompressedTrajectory, framesReadInAnyOrder)
+{
+	auto coords = butanol();
+	{
+		coords::trajectory::writer traj(filename, coords.atoms(), precision);
+		for (unsigned i = 0u; i < 5u; ++i) traj.write(shaken(coords.xyz(), i));
+		EXPECT_EQ(traj.size(), 5u);
+	}
+	coords::trajectory::reader traj(filename);
+	ASSERT_EQ(traj.size(), 5u);
+	EXPECT_EQ(traj.get_precision(), precision);
+	for (unsigned i : { 3u, 0u, 4u, 1u })
+	{
+		expectSameStructure(traj.frame(i), shaken(coords.xyz(), i));
+	}
+	ASSERT_EQ(traj.atoms(), coords.size());
+	for (std::size_t i = 0u; i < coords.size(); ++i)
+	{
+		EXPECT_EQ(traj.get_topology().atom(i).symbol(), coords.atoms().atom(i).symbol());
+		EXPECT_EQ(traj.get_topology().atom(i).energy_type(), coords.atoms().atom(i).energy_type());
+		EXPECT_EQ(traj.get_topology().atom(i).bonds(), coords.atoms().atom(i).bonds());
+	}
+	std::remove(filename.c_str());
+}
+
+TEST(CompressedTrajectory, appendedAfterIncompleteFrame)
+{
+	auto coords = butanol();
+	{
+		coords::trajectory::writer traj(filename, coords.atoms(), precision);
+		for (unsigned i = 0u; i < 3u; ++i) traj.write(shaken(coords.xyz(), i));
+	}
+	{
+		// start of a frame of a killed run
+		std::ofstream out(filename, std::ios_base::app | std::ios_base::binary);
+		out << "FRA";
+	}
+	EXPECT_EQ(coords::trajectory::reader(filename).size(), 3u);
+	{
+		coords::trajectory::writer traj(filename, coords.atoms(), precision, true);
+		EXPECT_EQ(traj.size(), 3u);
+		for (unsigned i = 3u; i < 5u; ++i) traj.write(shaken(coords.xyz(), i));
+	}
+	coords::trajectory::reader traj(filename);
+	ASSERT_EQ(traj.size(), 5u);
+	for (unsigned i = 0u; i < 5u; ++i)
+	{
+		expectSameStructure(traj.frame(i), shaken(coords.xyz(), i));
+	}
+	EXPECT_THROW(coords::trajectory::writer(filename, coords.atoms(), 100.0, true), std::runtime_error);
+	std::remove(filename.c_str());
+}
+
+TEST(CompressedTrajectory, writtenByBufferedSnapshotLog)
+{
+	auto coords = butanol();
+	auto const file = Config::get().general.outputFilename + "_TRAJ_TEST" + coords::trajectory::extension;
+	std::remove(file.c_str());
+	{
+		// every second call is logged, two snapshots are buffered
+		auto log = coords::make_buffered_cartesian_log(coords, "_TRAJ_TEST", 2u, 2u, false, precision, true);
+		for (unsigned i = 0u; i < 7u; ++i) log(shaken(coords.xyz(), i));
+	}
+	coords::trajectory::reader traj(file);
+	ASSERT_EQ(traj.size(), 4u);
+	for (unsigned i = 0u; i < 4u; ++i)
+	{
+		expectSameStructure(traj.frame(i), shaken(coords.xyz(), 2u * i));
+	}
+	std::remove(file.c_str());
+}
+
+TEST(CompressedTrajectory, readAsInputEnsemble)
+{
+	auto coords = butanol();
+	{
+		coords::trajectory::writer traj(filename, coords.atoms(), precision);
+		for (unsigned i = 0u; i < 4u; ++i) traj.write(shaken(coords.xyz(), i));
+	}
+	auto const oldInput = Config::get().general.input;
+	Config::set().general.input = config::input_types::CTRJ;
+	std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+	auto const fromTrajectory = ci->read(filename);
+	Config::set().general.input = oldInput;
+
+	EXPECT_EQ(ci->size(), 4u);
+	EXPECT_EQ(ci->atoms(), coords.size());
+	EXPECT_EQ(fromTrajectory.size(), coords.size());
+	expectSameStructure(ci->PES()[2].structure.cartesian, shaken(coords.xyz(), 2u));
+	std::remove(filename.c_str());
+}
+
+#endif
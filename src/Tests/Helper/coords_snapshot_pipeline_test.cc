@@ -0,0 +1,113 @@
+/**
+CAST 3
+Purpose: Tests the background output of snapshots
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "../../configuration.h"
+#include "../../coords_io.h"
+#include "../../coords_io_trajectory.h"
+#include "../../coords_snapshot_pipeline.h"
+
+namespace
+{
+	double const precision(1000.0);
+
+	coords::Coordinates butanol()
+	{
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		return ci->read("test_files/butanol.arc");
+	}
+
+	coords::Representation_3D shaken(coords::Representation_3D xyz, unsigned const seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_real_distribution<double> dist(-0.2, 0.2);
+		for (auto& p : xyz) p += coords::Cartesian_Point(dist(engine), dist(engine), dist(engine));
+		return xyz;
+	}
+
+	/**logs frames 0, ..., n-1 and returns the trajectory written*/
+	std::vector<coords::Representation_3D> logged(coords::Coordinates& coords, unsigned const n,
+		bool const optimize, bool const asynchronous, std::size_t const threads)
+	{
+		std::string const suffix("_PIPELINE_TEST");
+		auto const file = Config::get().general.outputFilename + suffix + coords::trajectory::extension;
+		std::remove(file.c_str());
+		{
+			auto log = coords::make_buffered_cartesian_log(coords, suffix, 3u, 1u, optimize, precision, true, asynchronous, threads);
+			for (unsigned i = 0u; i < n; ++i) log(shaken(coords.xyz(), i));
+			log.flush();
+			log.p.first.wait();
+		}
+		coords::trajectory::reader traj(file);
+		std::vector<coords::Representation_3D> ret;
+		for (std::size_t i = 0u; i < traj.size(); ++i) ret.push_back(traj.frame(i));
+		std::remove(file.c_str());
+		return ret;
+	}
+}
+
+TEST(SnapshotPipeline, framesWrittenInOrder)
+{
+	auto coords = butanol();
+	auto const frames = logged(coords, 20u, false, true, 1u);
+	ASSERT_EQ(frames.size(), 20u);
+	for (unsigned i = 0u; i < 20u; ++i)
+	{
+		auto const expected = shaken(coords.xyz(), i);
+		for (std::size_t j = 0u; j < expected.size(); ++j)
+		{
+			EXPECT_NEAR(frames[i][j].x(), expected[j].x(), 0.5 / precision + 1e-12);
+		}
+	}
+}
+
+TEST(SnapshotPipeline, optimizedSnapshotsSameAsSynchronous)
+{
+	auto coords = butanol();
+	auto const start = coords.xyz();
+	auto const synchronous = logged(coords, 4u, true, false, 1u);
+	// the synchronous drain restores the structure after optimizing
+	ASSERT_EQ(coords.xyz().size(), start.size());
+	EXPECT_EQ(coords.xyz()[0].x(), start[0].x());
+	auto const background = logged(coords, 4u, true, true, 2u);
+	ASSERT_EQ(background.size(), synchronous.size());
+	for (std::size_t i = 0u; i < background.size(); ++i)
+	{
+		for (std::size_t j = 0u; j < background[i].size(); ++j)
+		{
+			EXPECT_EQ(background[i][j].x(), synchronous[i][j].x());
+			EXPECT_EQ(background[i][j].z(), synchronous[i][j].z());
+		}
+	}
+}
+
+TEST(SnapshotPipeline, errorThrownOnce)
+{
+	std::string const file("pipeline_test.ctrj");
+	auto coords = butanol();
+	{
+		coords::snapshot_pipeline pipeline(coords, nullptr,
+			std::make_shared<coords::trajectory::writer>(file, coords.atoms(), precision), false, 1u, 2u);
+		pipeline.push(coords::Representation_3D(coords.xyz()));
+		pipeline.push(coords::Representation_3D(3u));   // wrong number of atoms
+		EXPECT_THROW(pipeline.wait(), std::logic_error);
+		EXPECT_NO_THROW(pipeline.push(coords::Representation_3D(coords.xyz())));
+		EXPECT_NO_THROW(pipeline.wait());
+	}
+	EXPECT_EQ(coords::trajectory::reader(file).size(), 1u);
+	std::remove(file.c_str());
+}
+
+#endif
@@ -0,0 +1,132 @@
+/**
+CAST 3
+Purpose: Tests the concurrent jobs for batches of structures
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <experimental/filesystem>
+
+#include "../../configuration.h"
+#include "../../coords_io.h"
+#include "../../energy.h"
+#include "../../qm_job_pool.h"
+
+namespace fs = std::experimental::filesystem;
+
+namespace
+{
+	coords::Coordinates butanol()
+	{
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		return ci->read("test_files/butanol.arc");
+	}
+
+	std::vector<coords::Representation_3D> shaken_structures(coords::Representation_3D const& xyz, unsigned const n)
+	{
+		std::vector<coords::Representation_3D> ret;
+		std::mt19937 engine(7u);
+		std::uniform_real_distribution<double> dist(-0.1, 0.1);
+		for (unsigned i = 0u; i < n; ++i)
+		{
+			ret.push_back(xyz);
+			for (auto& p : ret.back()) p += coords::Cartesian_Point(dist(engine), dist(engine), dist(engine));
+		}
+		return ret;
+	}
+
+	std::size_t job_directories()
+	{
+		std::size_t n(0u);
+		for (auto const& entry : fs::directory_iterator(fs::current_path()))
+		{
+			if (entry.path().filename().string().compare(0u, 9u, "cast_job_") == 0) ++n;
+		}
+		return n;
+	}
+}
+
+TEST(QmJobPool, concurrentJobsSameAsSequential)
+{
+	auto coords = butanol();
+	auto const structures = shaken_structures(coords.xyz(), 5u);
+	auto const sequential = energy::qm_job_pool(coords, 1u).run(structures, energy::qm_job_types::GRADIENT);
+	std::multiset<std::size_t> finished;
+	auto const concurrent = energy::qm_job_pool(coords, 3u).run(structures, energy::qm_job_types::GRADIENT,
+		[&](std::size_t const i, energy::qm_job_result const& r) { finished.insert(i); EXPECT_TRUE(r.ok); });
+	EXPECT_EQ(finished, (std::multiset<std::size_t>{ 0u, 1u, 2u, 3u, 4u }));
+	ASSERT_EQ(concurrent.size(), sequential.size());
+	for (std::size_t i = 0u; i < concurrent.size(); ++i)
+	{
+		ASSERT_TRUE(concurrent[i].ok);
+		// the jobs use one OpenMP thread, so sums may be reordered
+		EXPECT_NEAR(concurrent[i].energy, sequential[i].energy, 1e-9);
+		ASSERT_EQ(concurrent[i].gradient.size(), sequential[i].gradient.size());
+		for (std::size_t j = 0u; j < concurrent[i].gradient.size(); ++j)
+		{
+			EXPECT_NEAR(concurrent[i].gradient[j].x(), sequential[i].gradient[j].x(), 1e-9);
+			EXPECT_NEAR(concurrent[i].gradient[j].z(), sequential[i].gradient[j].z(), 1e-9);
+		}
+	}
+	EXPECT_EQ(job_directories(), 0u);
+}
+
+#if !defined(_MSC_VER)
+TEST(QmJobPool, relativePathsWorkInScratchDirectories)
+{
+	auto const oldGeneralConfig = Config::get().general;
+	auto const oldEnergyConfig = Config::get().energy;
+	Config::set().energy.qmmm.mm_charges.clear();   // might be set by other tests
+	Config::set().general.energy_interface = config::interface_types::T::DFTB;
+	Config::set().energy.dftb.charge = 0;
+	// relative to the working directory, not to the directories of the jobs
+	Config::set().energy.qm_worker.driver = "sh test_files/mock_qm_driver.sh";
+	Config::set().energy.qm_worker.geometry = true;
+	{
+		auto coords = butanol();
+		auto const structures = shaken_structures(coords.xyz(), 4u);
+		auto const results = energy::qm_job_pool(coords, 2u).run(structures, energy::qm_job_types::GRADIENT);
+		ASSERT_EQ(results.size(), structures.size());
+		for (std::size_t i = 0u; i < results.size(); ++i)
+		{
+			ASSERT_TRUE(results[i].ok) << results[i].error;
+			EXPECT_TRUE(results[i].integrity);
+			double expected(0.0);
+			for (auto const& p : structures[i]) expected += 0.5 * scon::dot(p, p);
+			EXPECT_NEAR(results[i].energy, expected * energy::au2kcal_mol, 1e-6);
+		}
+	}
+	Config::set().general = oldGeneralConfig;
+	Config::set().energy = oldEnergyConfig;
+	EXPECT_EQ(job_directories(), 0u);
+}
+#endif
+
+TEST(QmJobPool, failedJobReported)
+{
+	auto coords = butanol();
+	auto structures = shaken_structures(coords.xyz(), 3u);
+	structures[1].pop_back();   // wrong number of atoms
+	auto const results = energy::qm_job_pool(coords, 2u).run(structures, energy::qm_job_types::ENERGY);
+	ASSERT_EQ(results.size(), 3u);
+	EXPECT_TRUE(results[0].ok);
+	EXPECT_FALSE(results[1].ok);
+	EXPECT_FALSE(results[1].error.empty());
+	EXPECT_TRUE(results[2].ok);
+	// the directory of the failed job is kept
+	EXPECT_EQ(job_directories(), 1u);
+	for (auto const& entry : fs::directory_iterator(fs::current_path()))
+	{
+		if (entry.path().filename().string().compare(0u, 9u, "cast_job_") == 0) fs::remove_all(entry.path());
+	}
+}
+
+#endif
@@ -0,0 +1,134 @@
+/**
+CAST 3
+Purpose: Tests the persistent QM driver processes with the mock driver
+
+@version 1.0
+*/
+
+#if defined(GOOGLE_MOCK) && !defined(_MSC_VER)
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "../../configuration.h"
+#include "../../coords_io.h"
+#include "../../energy.h"
+#include "../../qm_worker.h"
+
+namespace
+{
+	std::string const mock_driver("sh test_files/mock_qm_driver.sh");
+
+	long read_pid(std::string const& file)
+	{
+		long pid(0);
+		std::ifstream(file) >> pid;
+		std::remove(file.c_str());
+		return pid;
+	}
+}
+
+TEST(QmWorker, driverKeptAliveBetweenCalls)
+{
+	energy::qm_worker worker(mock_driver, 0.0, 0u);
+	ASSERT_EQ(worker.run("mock-pid worker_pid_1.txt"), 0);
+	ASSERT_EQ(worker.run("mock-pid worker_pid_2.txt"), 0);
+	auto const pid = read_pid("worker_pid_1.txt");
+	EXPECT_NE(pid, 0);
+	EXPECT_EQ(read_pid("worker_pid_2.txt"), pid);
+	EXPECT_NE(worker.driver_pid(), 0);
+	EXPECT_EQ(worker.run("exit 5"), 5);
+	EXPECT_EQ(worker.run("echo 42 > worker_output.txt"), 0);
+	EXPECT_EQ(read_pid("worker_output.txt"), 42);
+	EXPECT_EQ(worker.restarts(), 0u);
+}
+
+TEST(QmWorker, crashedDriverRestarted)
+{
+	std::string const marker("worker_crash_marker.txt");
+	std::ofstream(marker) << "crash\n";
+	energy::qm_worker worker(mock_driver, 0.0, 2u);
+	ASSERT_EQ(worker.run("mock-pid worker_pid_1.txt"), 0);
+	auto const first = read_pid("worker_pid_1.txt");
+	EXPECT_EQ(worker.run("mock-crash " + marker), 0);
+	EXPECT_EQ(worker.restarts(), 1u);
+	ASSERT_EQ(worker.run("mock-pid worker_pid_2.txt"), 0);
+	EXPECT_NE(read_pid("worker_pid_2.txt"), first);
+}
+
+TEST(QmWorker, geometrySentAndGradientsReceived)
+{
+	energy::qm_worker worker(mock_driver, 0.0, 0u);
+	energy::qm_geometry geometry;
+	geometry.symbols = { "C", "H" };
+	geometry.xyz = { { { 1.0, 2.0, 3.0 } }, { { 0.0, 0.0, 1.5 } } };
+	geometry.point_charges = { { { 0.5, 0.5, 0.5, -0.25 } } };
+	geometry.charge = 1;
+	geometry.gradients = true;
+	energy::qm_result result;
+	ASSERT_EQ(worker.evaluate(geometry, result), 0);
+	EXPECT_DOUBLE_EQ(result.energy, 9.125);
+	ASSERT_EQ(result.gradients.size(), 2u);
+	EXPECT_DOUBLE_EQ(result.gradients[0][1], 2.0);
+	EXPECT_DOUBLE_EQ(result.gradients[1][2], 1.5);
+	ASSERT_EQ(result.charge_gradients.size(), 1u);
+	EXPECT_DOUBLE_EQ(result.charge_gradients[0][0], -0.25);
+	EXPECT_EQ(result.partial_charges, (std::vector<double>{ 0.1, 0.1 }));
+	// command lines still work with the same driver
+	EXPECT_EQ(worker.run("exit 2"), 2);
+	EXPECT_EQ(worker.restarts(), 0u);
+}
+
+TEST(QmWorker, dftbInterfaceSendsGeometry)
+{
+	auto const oldGeneralConfig = Config::get().general;
+	auto const oldEnergyConfig = Config::get().energy;
+	Config::set().energy.qmmm.mm_charges.clear();   // might be set by other tests
+	Config::set().general.energy_interface = config::interface_types::T::DFTB;
+	Config::set().energy.dftb.charge = 0;
+	Config::set().energy.qm_worker.driver = mock_driver;
+	Config::set().energy.qm_worker.geometry = true;
+	{
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		coords::Coordinates coords(ci->read("test_files/butanol.arc"));
+		double expected(0.0);
+		for (auto const& p : coords.xyz()) expected += 0.5 * scon::dot(p, p);
+		EXPECT_NEAR(coords.g(), expected * energy::au2kcal_mol, 1e-6);
+		ASSERT_EQ(coords.g_xyz().size(), coords.size());
+		for (std::size_t i = 0u; i < coords.size(); ++i)
+		{
+			EXPECT_NEAR(coords.g_xyz(i).x(), coords.xyz(i).x() * energy::Hartree_Bohr2Kcal_MolAng, 1e-8);
+			EXPECT_NEAR(coords.g_xyz(i).z(), coords.xyz(i).z() * energy::Hartree_Bohr2Kcal_MolAng, 1e-8);
+		}
+	}
+	Config::set().general = oldGeneralConfig;
+	Config::set().energy = oldEnergyConfig;
+}
+
+TEST(QmWorker, detachClosesSocket)
+{
+	energy::qm_worker worker(mock_driver, 0.0, 0u);
+	ASSERT_EQ(worker.run("true"), 0);
+	auto const pid = static_cast<pid_t>(worker.driver_pid());
+	worker.detach();
+	EXPECT_EQ(worker.driver_pid(), 0);
+	// this process held the only other end of the socket, so the driver reads the end of its input
+	EXPECT_EQ(::waitpid(pid, nullptr, 0), pid);
+}
+
+TEST(QmWorker, hangingDriverTimesOut)
+{
+	energy::qm_worker worker(mock_driver, 0.3, 1u);
+	EXPECT_EQ(worker.run("mock-hang 30"), -1);
+	EXPECT_EQ(worker.restarts(), 1u);
+	EXPECT_EQ(worker.run("true"), 0);
+}
+
+#endif
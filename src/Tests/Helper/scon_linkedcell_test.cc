@@ -0,0 +1,104 @@
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <set>
+#include <utility>
+
+#include "../../coords.h"
+#include "../../Scon/scon_linkedcell.h"
+
+namespace {
+	using cells_type = scon::linked::Cells<coords::float_type, coords::Cartesian_Point, coords::Representation_3D>;
+	using pair_set = std::set<std::pair<std::size_t, std::size_t>>;
+
+	coords::Representation_3D randomPositions(std::size_t const n, coords::Cartesian_Point const& range)
+	{
+		std::mt19937 engine(1234u);
+		std::uniform_real_distribution<double> dist(-1.0, 1.0);
+		coords::Representation_3D positions;
+		for (std::size_t i = 0u; i < n; ++i)
+		{
+			positions.emplace_back(dist(engine) * range.x(), dist(engine) * range.y(), dist(engine) * range.z());
+		}
+		return positions;
+	}
+
+	double distance(coords::Cartesian_Point d, bool const periodic, coords::Cartesian_Point const& box)
+	{
+		if (periodic)
+		{
+			d.x() -= box.x() * std::round(d.x() / box.x());
+			d.y() -= box.y() * std::round(d.y() / box.y());
+			d.z() -= box.z() * std::round(d.z() / box.z());
+		}
+		return std::sqrt(dot(d, d));
+	}
+
+	// pairs within cutoff found by the linked cells, every pair has to be found exactly once
+	pair_set pairsFromCells(coords::Representation_3D const& positions, double const cutoff,
+		bool const periodic, coords::Cartesian_Point const& box)
+	{
+		cells_type cells(positions, cutoff, periodic, box, 0.0, scon::linked::fragmentation::half);
+		pair_set pairs;
+		for (std::size_t i = 0u; i < positions.size(); ++i)
+		{
+			auto const box_of_i = cells.box_of_element(i);
+			for (auto j : box_of_i.adjacencies())
+			{
+				if (j < 0 || static_cast<std::size_t>(j) >= i) continue;
+				std::size_t const uj = static_cast<std::size_t>(j);
+				EXPECT_TRUE(pairs.emplace(uj, i).second) << "Pair " << uj << ", " << i << " found twice.";
+			}
+		}
+		pair_set ret;
+		for (auto const& p : pairs)
+		{
+			if (distance(positions[p.first] - positions[p.second], periodic, box) <= cutoff) ret.insert(p);
+		}
+		return ret;
+	}
+
+	pair_set pairsFromBruteForce(coords::Representation_3D const& positions, double const cutoff,
+		bool const periodic, coords::Cartesian_Point const& box)
+	{
+		pair_set pairs;
+		for (std::size_t i = 0u; i < positions.size(); ++i)
+		{
+			for (std::size_t j = 0u; j < i; ++j)
+			{
+				if (distance(positions[j] - positions[i], periodic, box) <= cutoff) pairs.emplace(j, i);
+			}
+		}
+		return pairs;
+	}
+}
+
+TEST(SconLinkedCells, sameAsBruteForceWithoutPeriodics)
+{
+	coords::Cartesian_Point const range(12.0, 15.0, 9.0);
+	auto const positions = randomPositions(400u, range);
+	EXPECT_EQ(pairsFromCells(positions, 4.0, false, range), pairsFromBruteForce(positions, 4.0, false, range));
+}
+
+TEST(SconLinkedCells, sameAsBruteForceInOrthorhombicBox)
+{
+	coords::Cartesian_Point const box(21.0, 26.5, 33.0);
+	// positions are also outside of the box
+	auto const positions = randomPositions(600u, box);
+	auto const cellPairs = pairsFromCells(positions, 5.0, true, box);
+	EXPECT_FALSE(cellPairs.empty());
+	EXPECT_EQ(cellPairs, pairsFromBruteForce(positions, 5.0, true, box));
+}
+
+TEST(SconLinkedCells, sameAsBruteForceWithFewCellsPerDirection)
+{
+	// less than five half-cutoff cells in x- and y-direction
+	coords::Cartesian_Point const box(9.0, 12.0, 30.0);
+	auto const positions = randomPositions(300u, box / 2.0);
+	EXPECT_EQ(pairsFromCells(positions, 4.5, true, box), pairsFromBruteForce(positions, 4.5, true, box));
+}
+
+#endif
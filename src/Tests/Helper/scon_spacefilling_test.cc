@@ -0,0 +1,76 @@
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+#include "../../coords.h"
+#include "../../Scon/scon_spacefilling.h"
+
+namespace {
+	/**all points of a regular n x n x n grid with distance 1 (in a shuffled order)*/
+	coords::Representation_3D shuffledGrid(int const n)
+	{
+		coords::Representation_3D points;
+		for (int x = 0; x < n; ++x)
+			for (int y = 0; y < n; ++y)
+				for (int z = 0; z < n; ++z)
+					points.emplace_back(x, y, z);
+		std::mt19937 engine(99u);
+		std::shuffle(points.begin(), points.end(), engine);
+		return points;
+	}
+
+	bool isPermutation(std::vector<std::size_t> order)
+	{
+		std::sort(order.begin(), order.end());
+		for (std::size_t i = 0u; i < order.size(); ++i)
+		{
+			if (order[i] != i) return false;
+		}
+		return true;
+	}
+}
+
+TEST(SconSpaceFilling, mortonKeyInterleavesBits)
+{
+	using scon::spacefilling::morton_key;
+	EXPECT_EQ(morton_key({ { 0u, 0u, 1u } }), 1u);
+	EXPECT_EQ(morton_key({ { 0u, 1u, 0u } }), 2u);
+	EXPECT_EQ(morton_key({ { 1u, 0u, 0u } }), 4u);
+	EXPECT_EQ(morton_key({ { 0u, 0u, 2u } }), 8u);
+	EXPECT_EQ(morton_key({ { 3u, 3u, 3u } }), 63u);
+}
+
+TEST(SconSpaceFilling, hilbertOrderVisitsNeighbouringGridPoints)
+{
+	auto const points = shuffledGrid(8);
+	auto const order = scon::spacefilling::order(points, scon::spacefilling::curves::HILBERT);
+	ASSERT_EQ(order.size(), points.size());
+	EXPECT_TRUE(isPermutation(order));
+	// consecutive points on the hilbert curve are direct neighbours
+	for (std::size_t k = 1u; k < order.size(); ++k)
+	{
+		coords::Cartesian_Point const d(points[order[k]] - points[order[k - 1u]]);
+		EXPECT_DOUBLE_EQ(std::abs(d.x()) + std::abs(d.y()) + std::abs(d.z()), 1.0);
+	}
+}
+
+TEST(SconSpaceFilling, mortonOrderSortsOctants)
+{
+	auto const points = shuffledGrid(4);
+	auto const order = scon::spacefilling::order(points, scon::spacefilling::curves::MORTON);
+	EXPECT_TRUE(isPermutation(order));
+	// the first 8 points are the lower 2 x 2 x 2 block
+	for (std::size_t k = 0u; k < 8u; ++k)
+	{
+		EXPECT_LT(points[order[k]].x(), 2.0);
+		EXPECT_LT(points[order[k]].y(), 2.0);
+		EXPECT_LT(points[order[k]].z(), 2.0);
+	}
+}
+
+#endif
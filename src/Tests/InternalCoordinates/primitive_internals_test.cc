@@ -122,6 +122,21 @@ namespace {
 		EXPECT_NEAR(lhs.z(), rhs.z(), doubleNearThreshold);
 	}
 
+	inline void isColumnNear(scon::mathmatrix<coords::float_type> const& lhs, scon::mathmatrix<coords::float_type> const& rhs, double const threshold) {
+		ASSERT_EQ(lhs.rows(), rhs.rows());
+		for (auto i = 0u; i < rhs.rows(); ++i) {
+			EXPECT_NEAR(lhs(i, 0), rhs(i, 0), threshold);
+		}
+	}
+
+	scon::mathmatrix<coords::float_type> smallChangeOfInternals(std::size_t const size) {
+		std::vector<coords::float_type> change;
+		for (auto i = 0u; i < size; ++i) {
+			change.emplace_back(0.01 * std::sin(static_cast<coords::float_type>(i + 1u)));
+		}
+		return scon::mathmatrix<coords::float_type>::col_from_vec(change);
+	}
+
 }
 
 PrimitiveInternalSetTest::PrimitiveInternalSetTest() : cartesians{ createSystemOfTwoMethanolMolecules() }, testSystem(), molecules({ createFirstResidueIndices(), createSecondResidueIndices() }),
@@ -357,6 +372,141 @@ TEST_F(MatricesTest, calculatePrimitiveInternalValuesTest) {
 	calculatePrimitiveInternalValuesTest();
 }
 
+void MatricesTest::sparseBMatrixTest() {
+	auto const& dense = testSystem->Bmat(cartesians);
+	auto const& sparse = testSystem->sparseBmat(cartesians);
+	ASSERT_EQ(sparse.rows(), dense.rows());
+	ASSERT_EQ(sparse.cols(), dense.cols());
+	EXPECT_LT(sparse.nonZeros(), dense.rows() * dense.cols() / 2u);
+
+	auto x = smallChangeOfInternals(dense.cols());
+	auto y = smallChangeOfInternals(dense.rows());
+	isColumnNear(scon::mathmatrix<coords::float_type>::col_from_vec(sparse.times(x.col_to_std_vector())), dense * x, doubleNearThreshold);
+	isColumnNear(scon::mathmatrix<coords::float_type>::col_from_vec(sparse.transposedTimes(y.col_to_std_vector())), dense.t() * y, doubleNearThreshold);
+}
+
+TEST_F(MatricesTest, sparseBMatrixTest) {
+	sparseBMatrixTest();
+}
+
+void MatricesTest::cartesianChangeTest() {
+	auto internalChange = smallChangeOfInternals(testSystem->primitive_internals.size());
+	auto dense = testSystem->transposeOfBmat(cartesians) * testSystem->pseudoInverseOfGmat(cartesians) * internalChange;
+	isColumnNear(testSystem->cartesianChange(cartesians, internalChange), dense, 1.e-8);
+}
+
+TEST_F(MatricesTest, cartesianChangeTest) {
+	cartesianChangeTest();
+}
+
+void MatricesTest::internalGradientsTest() {
+	auto dense = testSystem->pseudoInverseOfGmat(cartesians) * testSystem->Bmat(cartesians) * gradientsOfTwoMethanolMolecules();
+	isColumnNear(testSystem->internalGradients(cartesians, gradientsOfTwoMethanolMolecules()), dense, 1.e-8);
+}
+
+TEST_F(MatricesTest, internalGradientsTest) {
+	internalGradientsTest();
+}
+
+std::shared_ptr<internals::ConstrainedInternalCoordinates> MatricesTest::createConstrainedSystem() {
+	std::unique_ptr<internals::ICDecoratorBase> decorator = std::make_unique<internals::ICRotationDecorator>(nullptr);
+	decorator = std::make_unique<internals::ICTranslationDecorator>(std::move(decorator));
+	decorator = std::make_unique<internals::ICDihedralDecorator>(std::move(decorator));
+	decorator = std::make_unique<internals::ICAngleDecorator>(std::move(decorator));
+	decorator = std::make_unique<internals::ICBondDecorator>(std::move(decorator));
+	internals::NoConstraintManager manager;
+	decorator->buildCoordinates(cartesians, systemGraph, molecules, manager);
+	auto system = std::make_shared<internals::ConstrainedInternalCoordinates>(*decorator);
+	// bonds 0 and 5, angles 10 and 17
+	for (auto const index : { 0u, 5u, 10u, 17u }) system->primitive_internals.at(index)->makeConstrained();
+	return system;
+}
+
+void MatricesTest::projectorTest() {
+	auto internalVector = smallChangeOfInternals(testSystem->primitive_internals.size());
+	isColumnNear(testSystem->applyProjector(cartesians, internalVector), testSystem->projectorMatrix(cartesians) * internalVector, 1.e-8);
+}
+
+TEST_F(MatricesTest, projectorTest) {
+	projectorTest();
+}
+
+void MatricesTest::constrainedProjectorTest() {
+	auto system = createConstrainedSystem();
+	auto internalVector = smallChangeOfInternals(system->primitive_internals.size());
+	auto projected = system->applyProjector(cartesians, internalVector);
+	isColumnNear(projected, system->projectorMatrix(cartesians) * internalVector, 1.e-8);
+	for (auto const index : { 0u, 5u, 10u, 17u }) EXPECT_NEAR(projected(index, 0), 0.0, 1.e-8);
+}
+
+TEST_F(MatricesTest, constrainedProjectorTest) {
+	constrainedProjectorTest();
+}
+
+void MatricesTest::projectedStepFinderTest() {
+	using Mat = scon::mathmatrix<coords::float_type>;
+	auto system = createConstrainedSystem();
+	auto const size = system->primitive_internals.size();
+	auto hessian = system->guess_hessian(cartesians);
+	auto gradients = system->internalGradients(cartesians, gradientsOfTwoMethanolMolecules());
+	internals::InternalToCartesianConverter converter(*system, cartesians);
+	// the two methanols are below denseSize, so the iterative step finder is built directly,
+	// with more primitives than Cartesian coordinates the Lanczos iterations stop at the rank bound
+	ASSERT_GT(size, 3u * cartesians.size());
+	auto finder = std::make_unique<internals::ProjectedStepFinder>(converter, gradients, hessian, system->projector(cartesians), 3u * cartesians.size());
+
+	// the dense projected Hessian and gradients which were used before
+	auto P = system->projectorMatrix(cartesians);
+	auto projectedHessian = P * hessian * P + (Mat::identity(size, size) - P) * 1000.0;
+	internals::AppropriateStepFinder dense(converter, P * gradients, projectedHessian);
+
+	isColumnNear(finder->getInternalStep(), dense.getInternalStep(), 1.e-6);
+	auto shifted = finder->getShiftedInternalStep(0.5);
+	isColumnNear(shifted, dense.getShiftedInternalStep(0.5), 1.e-6);
+	EXPECT_NEAR(finder->getSol(shifted), dense.getSol(shifted), 1.e-8);
+	EXPECT_NEAR(finder->getDeltaYPrime(shifted), dense.getDeltaYPrime(shifted), 1.e-6);
+
+	// small systems keep the dense projected Hessian
+	auto constructed = system->constructStepFinder(converter, gradients, hessian, cartesians);
+	EXPECT_EQ(dynamic_cast<internals::ProjectedStepFinder*>(constructed.get()), nullptr);
+	isColumnNear(constructed->getInternalStep(), dense.getInternalStep(), 1.e-10);
+}
+
+TEST_F(MatricesTest, projectedStepFinderTest) {
+	projectedStepFinderTest();
+}
+
+TEST(NearlyLinearBendTest, iterativeSolutionsDropSmallEigenvaluesLikePinv) {
+	using Mat = scon::mathmatrix<coords::float_type>;
+	// the three distances of a triatomic which is bent by 1e-5 rad only, the bend is
+	// almost no change of the distances, so G has an eigenvalue far below pinv's threshold
+	std::vector<ic_util::Node> atoms{
+		ic_util::Node{ 1, "C", "C", coords::Cartesian_Point() }, ic_util::Node{ 2, "C", "C", coords::Cartesian_Point() },
+		ic_util::Node{ 3, "C", "C", coords::Cartesian_Point() }
+	};
+	auto graph = ic_util::make_graph(std::vector<std::pair<std::size_t, std::size_t>>{ { 0u, 1u }, { 1u, 2u }, { 0u, 2u } }, atoms);
+	InternalCoordinates::CartesiansForInternalCoordinates cartesians{ coords::Representation_3D{
+		coords::Cartesian_Point(-2.0, 0.0, 0.0), coords::Cartesian_Point(0.0, 0.0, 0.0), coords::Cartesian_Point(2.2, 2.2e-5, 0.0) } };
+	std::vector<std::vector<std::size_t>> molecules{ { 1u, 2u, 3u } };
+	auto decorator = std::make_unique<internals::ICBondDecorator>(nullptr);
+	internals::NoConstraintManager manager;
+	decorator->buildCoordinates(cartesians, graph, molecules, manager);
+	internals::PrimitiveInternalCoordinates system(*decorator);
+	ASSERT_EQ(system.primitive_internals.size(), 3u);
+
+	auto G = system.Gmat(cartesians);
+	auto const smallestEigenvalue = G.eigensym().first(0, 0);
+	EXPECT_GT(smallestEigenvalue, 0.0);
+	EXPECT_LT(smallestEigenvalue, Mat::close_to_zero_tol);
+
+	auto const pinv = system.pseudoInverseOfGmat(cartesians);
+	Mat cartesianGradients(9u, 1u);
+	for (auto i = 0u; i < 9u; ++i) cartesianGradients(i, 0) = std::sin(1.0 + i);
+	isColumnNear(system.internalGradients(cartesians, cartesianGradients), pinv * system.Bmat(cartesians) * cartesianGradients, 1.e-5);
+	auto internalChange = smallChangeOfInternals(3u);
+	isColumnNear(system.cartesianChange(cartesians, internalChange), system.transposeOfBmat(cartesians) * pinv * internalChange, 1.e-7);
+}
+
 void DelocalizedMatricesTest::internalDifferencesTest() {
 	EXPECT_EQ(testSystem->calc_diff(cartesianChangeOfTwoMethanolMoleculesAfterFirstStep(), createSystemOfTwoMethanolMolecules() / energy::bohr2ang), expectedInternalChangeBetweenInitialAndFirstStepStructure());
 }
@@ -372,4 +522,23 @@ void DelocalizedMatricesTest::internalValuesForTricTest() {
 TEST_F(DelocalizedMatricesTest, internalValuesForTricTest) {
 	internalValuesForTricTest();
 }
+
+void DelocalizedMatricesTest::cartesianChangeTest() {
+	auto internalChange = smallChangeOfInternals(testSystem->getDelMat().cols());
+	auto dense = testSystem->transposeOfBmat(cartesians) * testSystem->pseudoInverseOfGmat(cartesians) * internalChange;
+	isColumnNear(testSystem->cartesianChange(cartesians, internalChange), dense, 1.e-8);
+}
+
+TEST_F(DelocalizedMatricesTest, cartesianChangeTest) {
+	cartesianChangeTest();
+}
+
+void DelocalizedMatricesTest::internalGradientsTest() {
+	auto dense = testSystem->pseudoInverseOfGmat(cartesians) * testSystem->Bmat(cartesians) * gradientsOfTwoMethanolMolecules();
+	isColumnNear(testSystem->internalGradients(cartesians, gradientsOfTwoMethanolMolecules()), dense, 1.e-8);
+}
+
+TEST_F(DelocalizedMatricesTest, internalGradientsTest) {
+	internalGradientsTest();
+}
 #endif
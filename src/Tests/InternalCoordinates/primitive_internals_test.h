@@ -12,6 +12,7 @@
 #include"../../coords.h"
 #include"../../InternalCoordinates/PrimitiveInternalCoordinates.h"
 #include"../../InternalCoordinates/TranslationRotationInternalCoordinates.h"
+#include"../../InternalCoordinates/ConstrainedInternalCoordinates.h"
 #include"../../InternalCoordinates/InternalCoordinates.h"
 #include"ExpectedValuesForInternalCoordinatesTest.h"
 
@@ -26,6 +27,14 @@ public:
 	MOCK_METHOD1(Gmat, scon::mathmatrix<coords::float_type>& (CartesianType const& cartesians));
 	MOCK_METHOD1(transposeOfBmat, scon::mathmatrix<coords::float_type>(CartesianType const& cartesians));
 	MOCK_METHOD1(pseudoInverseOfGmat, scon::mathmatrix<coords::float_type>(CartesianType const& cartesians));
+
+	// dense formulations on top of the mocked matrices
+	scon::mathmatrix<coords::float_type> cartesianChange(CartesianType const& cartesians, scon::mathmatrix<coords::float_type> const& internalChange) override {
+		return transposeOfBmat(cartesians) * pseudoInverseOfGmat(cartesians) * internalChange;
+	}
+	scon::mathmatrix<coords::float_type> internalGradients(CartesianType const& cartesians, scon::mathmatrix<coords::float_type> const& cartesianGradients) override {
+		return pseudoInverseOfGmat(cartesians) * Bmat(cartesians) * cartesianGradients;
+	}
 };
 
 class PrimitiveInternalSetTest : public testing::Test {
@@ -63,6 +72,15 @@ public:
 	void gMatrixTest();
 	void hessianGuessTest();
 	void calculatePrimitiveInternalValuesTest();
+	void sparseBMatrixTest();
+	void cartesianChangeTest();
+	void internalGradientsTest();
+	void projectorTest();
+	void constrainedProjectorTest();
+	void projectedStepFinderTest();
+
+	/**the same coordinates with the first bond and the first angle of each methanol constrained*/
+	std::shared_ptr<internals::ConstrainedInternalCoordinates> createConstrainedSystem();
 };
 
 class DelocalizedMatricesTest : public testing::Test {
@@ -74,6 +92,8 @@ public:
 	void delocalizedInitialHessianTest();
 	void internalDifferencesTest();
 	void internalValuesForTricTest();
+	void cartesianChangeTest();
+	void internalGradientsTest();
 
 
 	InternalCoordinates::CartesiansForInternalCoordinates cartesians;
@@ -0,0 +1,131 @@
+/**
+CAST 3
+Purpose: Tests the exchange criterion and the output of concurrent FEP windows
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../configuration.h"
+#include "../../coords_io.h"
+#include "../../md.h"
+
+namespace
+{
+	/**butanol with the hydroxyl hydrogen appearing during the FEP calculation*/
+	coords::Coordinates butanol_with_appearing_hydrogen()
+	{
+		std::ifstream in("test_files/butanol.arc");
+		std::ofstream out("fep_butanol.arc");
+		std::string line;
+		for (std::size_t i = 0u; std::getline(in, line); ++i)
+		{
+			out << line << (i == 15u ? "  in" : "") << '\n';
+		}
+		out.close();
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		auto coords = ci->read("fep_butanol.arc");
+		std::remove("fep_butanol.arc");
+		return coords;
+	}
+
+	/**lines of a file split into words, numbers are replaced by #*/
+	std::vector<std::vector<std::string>> layout(std::string const& filename)
+	{
+		std::regex const number("[-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?|[-+]?(inf|nan)");
+		std::vector<std::vector<std::string>> lines;
+		std::ifstream file(filename);
+		std::string line, word;
+		while (std::getline(file, line))
+		{
+			lines.emplace_back();
+			std::istringstream words(line);
+			while (words >> word) lines.back().push_back(std::regex_match(word, number) ? "#" : word);
+		}
+		return lines;
+	}
+
+	/**runs a FEP calculation like the FEP task and returns the layouts of alchemical.txt and FEP_Results.txt*/
+	std::vector<std::vector<std::string>> fep_output(std::size_t const concurrent)
+	{
+		auto const md = Config::get().md;
+		auto const fep = Config::get().fep;
+		auto const output = Config::get().general.outputFilename;
+		Config::set().general.outputFilename = "fep_output_test";
+		Config::set().md.num_steps = 3u;
+		Config::set().md.num_snapShots = 0u;
+		Config::set().md.track = false;
+		Config::set().md.T_init = 300.0;
+		Config::set().md.T_final = 300.0;
+		Config::set().fep.dlambda = 0.25;
+		Config::set().fep.equil = 4u;
+		Config::set().fep.steps = 6u;
+		Config::set().fep.analyze = false;
+		Config::set().fep.bar = true;
+		Config::set().fep.concurrent = concurrent;
+		Config::set().fep.exchange = 2u;
+		std::remove("FEP_Results.txt");
+
+		auto coords = butanol_with_appearing_hydrogen();
+		{
+			md::simulation mdObject(coords);
+			mdObject.fepinit();
+			mdObject.run();
+			mdObject.feprun();
+		}
+		auto result = layout("alchemical.txt");
+		auto const results = layout("FEP_Results.txt");
+		result.insert(result.end(), results.begin(), results.end());
+
+		std::remove("alchemical.txt");
+		std::remove("FEP_Results.txt");
+		// snapshots and traces of the simulation and of the five windows
+		for (std::string const window : { "", "_FEP0", "_FEP1", "_FEP2", "_FEP3", "_FEP4" })
+		{
+			std::remove(("fep_output_test_MD_SNAP" + window + ".arc").c_str());
+			std::remove(("fep_output_test_MD_TRACE" + window + ".csv").c_str());
+		}
+		Config::set().md = md;
+		Config::set().fep = fep;
+		Config::set().general.outputFilename = output;
+		return result;
+	}
+}
+
+TEST(FepExchange, favourableExchangeAlwaysAccepted)
+{
+	// configuration i is lower in window i+1, configuration i+1 is lower in window i
+	EXPECT_DOUBLE_EQ(md::fep_exchange_probability(-1.0, 0.5, 300.0), 1.0);
+	EXPECT_DOUBLE_EQ(md::fep_exchange_probability(0.3, 0.3, 300.0), 1.0);
+}
+
+TEST(FepExchange, unfavourableExchangeBoltzmannWeighted)
+{
+	double const T(298.15);
+	double const p = md::fep_exchange_probability(2.0, 0.5, T);
+	EXPECT_NEAR(p, std::exp(-1.5 / (md::R * T)), 1e-12);
+	EXPECT_LT(p, 1.0);
+	// higher temperature, higher probability
+	EXPECT_GT(md::fep_exchange_probability(2.0, 0.5, 2.0 * T), p);
+}
+
+TEST(FepExchange, concurrentWindowsWriteSequentialOutput)
+{
+	auto const sequential = fep_output(0u);
+	auto const concurrent = fep_output(3u);
+	ASSERT_FALSE(sequential.empty());
+	EXPECT_EQ(concurrent, sequential);
+}
+
+#endif
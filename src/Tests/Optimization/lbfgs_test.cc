@@ -0,0 +1,253 @@
+/**
+CAST 3
+Purpose: Tests the double precision L-BFGS with the flat ring buffer of corrections
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "../../coords.h"
+#include "../../lbfgs.h"
+
+namespace
+{
+	/**Rosenbrock function in x and y plus z^2 for every point*/
+	template<class T>
+	struct rosenbrock
+	{
+		using rep = scon::vector<scon::c3<T>>;
+		T operator() (rep const& v, rep& g, std::size_t const, bool& go_on)
+		{
+			T f(0);
+			g.resize(v.size());
+			for (std::size_t i = 0u; i < v.size(); ++i)
+			{
+				T const x(v[i].x()), y(v[i].y()), z(v[i].z());
+				f += T(100) * (y - x * x) * (y - x * x) + (T(1) - x) * (T(1) - x) + z * z;
+				g[i] = scon::c3<T>(T(-400) * x * (y - x * x) - T(2) * (T(1) - x), T(200) * (y - x * x), T(2) * z);
+			}
+			go_on = true;
+			return f;
+		}
+	};
+
+	template<class T>
+	scon::vector<scon::c3<T>> start(std::size_t const n)
+	{
+		scon::vector<scon::c3<T>> x(n);
+		for (std::size_t i = 0u; i < n; ++i)
+		{
+			x[i] = scon::c3<T>(T(-1.2) + T(0.1) * T(i % 5), T(1), T(0.5) * T(i % 3));
+		}
+		return x;
+	}
+
+	template<class T>
+	double max_deviation_from_minimum(scon::vector<scon::c3<T>> const& x)
+	{
+		double d(0.0);
+		for (auto const& p : x)
+		{
+			d = std::max({ d, std::abs(double(p.x()) - 1.0), std::abs(double(p.y()) - 1.0), std::abs(double(p.z())) });
+		}
+		return d;
+	}
+
+	/**sum of -cos over all coordinates, has negative curvature away from the minima*/
+	struct cosines
+	{
+		using rep = scon::vector<scon::c3<double>>;
+		double operator() (rep const& v, rep& g, std::size_t const, bool& go_on)
+		{
+			double f(0.0);
+			g.resize(v.size());
+			for (std::size_t i = 0u; i < v.size(); ++i)
+			{
+				f -= std::cos(v[i].x()) + std::cos(v[i].y()) + std::cos(v[i].z());
+				g[i] = scon::c3<double>(std::sin(v[i].x()), std::sin(v[i].y()), std::sin(v[i].z()));
+			}
+			go_on = true;
+			return f;
+		}
+	};
+
+	/**takes every step in full without any Wolfe condition and records the directions and points*/
+	template<class CallbackT>
+	struct full_step
+	{
+		using callback_type = CallbackT;
+		using float_type = double;
+		using rep_type = scon::vector<scon::c3<double>>;
+		using grad_type = rep_type;
+		using point_type = optimization::Point<rep_type, grad_type, float_type>;
+		callback_type callback;
+		std::vector<std::vector<double>>* directions;
+		std::vector<std::vector<double>>* x;
+		std::vector<std::vector<double>>* g;
+
+		optimization::local::status operator() (grad_type const& d, float_type& step, point_type& p, rep_type const& xp, std::size_t const iter)
+		{
+			bool go_on(true);
+			p.x = xp;
+			for (std::size_t i = 0u; i < d.size(); ++i) p.x[i] += d[i] * step;
+			p.f = callback(p.x, p.g, iter, go_on);
+			directions->push_back(flat(d));
+			x->push_back(flat(p.x));
+			g->push_back(flat(p.g));
+			return optimization::local::status::SUCCESS;
+		}
+
+		static std::vector<double> flat(rep_type const& v)
+		{
+			std::vector<double> f(3u * v.size());
+			optimization::local::lbfgs_detail::to_flat(v, f.data());
+			return f;
+		}
+	};
+
+	double dot(std::vector<double> const& a, std::vector<double> const& b)
+	{
+		return optimization::local::lbfgs_detail::dot(a.data(), b.data(), a.size());
+	}
+
+	std::vector<double> difference(std::vector<double> a, std::vector<double> const& b)
+	{
+		for (std::size_t i = 0u; i < a.size(); ++i) a[i] -= b[i];
+		return a;
+	}
+
+	/**textbook two-loop recursion over the given corrections, oldest first*/
+	std::vector<double> two_loop(std::vector<double> q, std::vector<std::pair<std::vector<double>, std::vector<double>>> const& corrections)
+	{
+		for (auto& v : q) v = -v;
+		std::vector<double> alpha(corrections.size());
+		for (std::size_t j = corrections.size(); j-- > 0u;)
+		{
+			alpha[j] = dot(corrections[j].first, q) / dot(corrections[j].first, corrections[j].second);
+			for (std::size_t i = 0u; i < q.size(); ++i) q[i] -= alpha[j] * corrections[j].second[i];
+		}
+		auto const& newest = corrections.back();
+		double const gamma = dot(newest.first, newest.second) / dot(newest.second, newest.second);
+		for (auto& v : q) v *= gamma;
+		for (std::size_t j = 0u; j < corrections.size(); ++j)
+		{
+			double const beta = dot(corrections[j].second, q) / dot(corrections[j].first, corrections[j].second);
+			for (std::size_t i = 0u; i < q.size(); ++i) q[i] += (alpha[j] - beta) * corrections[j].first[i];
+		}
+		return q;
+	}
+
+	/**records the energies of the points passed to the logger*/
+	struct energy_logger
+	{
+		std::vector<double>* energies;
+		template<class PointT>
+		void operator() (PointT const& p) { energies->push_back(p.f); }
+	};
+}
+
+TEST(FlatLbfgs, flattensCartesianPoints)
+{
+	coords::Representation_3D const v{ coords::Cartesian_Point(1., 2., 3.), coords::Cartesian_Point(-4., 5., -6.) };
+	std::vector<double> flat(6u);
+	optimization::local::lbfgs_detail::to_flat(v, flat.data());
+	EXPECT_EQ(flat, (std::vector<double>{ 1., 2., 3., -4., 5., -6. }));
+	coords::Representation_3D back(2u);
+	optimization::local::lbfgs_detail::from_flat(flat.data(), back);
+	EXPECT_EQ(back, v);
+}
+
+TEST(FlatLbfgs, convergesOnRosenbrockWithWrappingHistory)
+{
+	using namespace optimization::local;
+	auto optimizer = make_flat_lbfgs(make_more_thuente(rosenbrock<double>()));
+	optimizer.config.m = 3u;
+	optimizer.config.epsilon = 1.e-6;
+	decltype(optimizer)::point_type x(start<double>(20u));
+	optimizer(x);
+	EXPECT_EQ(optimizer.state(), status::SUCCESS);
+	// more iterations than corrections, so the ring buffer was overwritten
+	EXPECT_GT(optimizer.iter(), optimizer.config.m);
+	EXPECT_LT(max_deviation_from_minimum(optimizer.p().x), 1.e-4);
+}
+
+TEST(FlatLbfgs, loggerSeesStartAndEveryIteration)
+{
+	using namespace optimization::local;
+	std::vector<double> energies;
+	auto optimizer = make_flat_lbfgs(make_more_thuente(rosenbrock<double>()), energy_logger{ &energies });
+	decltype(optimizer)::point_type x(start<double>(5u));
+	optimizer(x);
+	EXPECT_EQ(optimizer.state(), status::SUCCESS);
+	ASSERT_EQ(energies.size(), optimizer.iter() + 1u);
+	EXPECT_DOUBLE_EQ(energies.back(), optimizer.p().f);
+	EXPECT_LT(energies.back(), energies.front());
+}
+
+TEST(FlatLbfgs, rejectedCorrectionKeepsFullRing)
+{
+	using namespace optimization::local;
+	std::vector<std::vector<double>> directions, x, g;
+	flat_lbfgs<full_step<cosines>> optimizer(full_step<cosines>{ cosines(), &directions, &x, &g });
+	optimizer.config.m = 2u;
+	optimizer.config.max_iterations = 12u;
+	optimizer.config.epsilon = 1.e-12;
+	decltype(optimizer)::point_type start_point(scon::vector<scon::c3<double>>{
+		scon::c3<double>(0.6, 0.5, 0.8), scon::c3<double>(3.2, -1.7, -1.9) });
+	{
+		bool go_on(true);
+		start_point.f = cosines()(start_point.x, start_point.g, 0u, go_on);
+		x.push_back(full_step<cosines>::flat(start_point.x));
+		g.push_back(full_step<cosines>::flat(start_point.g));
+	}
+	optimizer(start_point);
+	ASSERT_EQ(directions.size(), optimizer.iter());
+
+	// direction k follows the correction from point k - 1 to point k, it is compared with
+	// the two-loop recursion over the last m accepted corrections
+	std::vector<std::pair<std::vector<double>, std::vector<double>>> accepted;
+	std::size_t rejected_with_full_ring(0u);
+	for (std::size_t k = 1u; k < directions.size(); ++k)
+	{
+		auto const s = difference(x[k], x[k - 1u]), y = difference(g[k], g[k - 1u]);
+		if (dot(s, y) > 0.0 && dot(y, y) > 0.0)
+		{
+			accepted.emplace_back(s, y);
+			if (accepted.size() > optimizer.config.m) accepted.erase(accepted.begin());
+		}
+		else if (accepted.size() == optimizer.config.m) ++rejected_with_full_ring;
+		if (accepted.empty()) continue;
+		auto const expected = two_loop(g[k], accepted);
+		double const scale = std::sqrt(dot(expected, expected));
+		for (std::size_t i = 0u; i < expected.size(); ++i) EXPECT_NEAR(directions[k][i], expected[i], 1.e-10 * scale);
+	}
+	EXPECT_GT(rejected_with_full_ring, 0u);
+}
+
+TEST(FlatLbfgs, doublePrecisionReachesTighterGradientThanFloat)
+{
+	using namespace optimization::local;
+	auto single = make_lbfgs(make_more_thuente(rosenbrock<float>()));
+	single.config.epsilon = 1.e-3f;
+	decltype(single)::point_type xs(start<float>(20u));
+	single(xs);
+
+	auto twofold = make_flat_lbfgs(make_more_thuente(rosenbrock<double>()));
+	twofold.config.epsilon = 1.e-9;
+	decltype(twofold)::point_type xd(start<double>(20u));
+	twofold(xd);
+
+	EXPECT_EQ(twofold.state(), status::SUCCESS);
+	EXPECT_LT(max_deviation_from_minimum(twofold.p().x), 1.e-7);
+	EXPECT_LT(max_deviation_from_minimum(twofold.p().x), max_deviation_from_minimum(single.p().x));
+}
+
+#endif
@@ -0,0 +1,252 @@
+/**
+CAST 3
+Purpose: Tests the parallel evaluation of NEB images
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../../configuration.h"
+#include "../../coords_io.h"
+#include "../../neb.h"
+
+/**reaches the private climbing image state of neb (friend of neb)*/
+struct neb_test_access
+{
+	static void set_climbing_maximum(neb& n, std::ptrdiff_t const maximum) { n.CIMaximum = maximum; }
+};
+
+namespace
+{
+	coords::Coordinates butanol()
+	{
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		return ci->read("test_files/butanol.arc");
+	}
+
+	std::vector<energy::qm_job_result> evaluated(coords::Coordinates& coords, std::vector<coords::Representation_3D> const& images, int const threads)
+	{
+#ifdef _OPENMP
+		auto const max_threads = omp_get_max_threads();
+		omp_set_num_threads(threads);
+#endif
+		neb n(&coords);
+		n.num_images = images.size();
+		n.imagi = images;
+		auto results = n.evaluate_images(0u, images.size());
+#ifdef _OPENMP
+		omp_set_num_threads(max_threads);
+#endif
+		return results;
+	}
+
+	/**path of images displaced randomly from the structure*/
+	std::vector<coords::Representation_3D> shaken_path(coords::Coordinates const& coords, unsigned const n)
+	{
+		std::vector<coords::Representation_3D> images;
+		std::mt19937 engine(11u);
+		std::uniform_real_distribution<double> dist(-0.1, 0.1);
+		for (unsigned i = 0u; i < n; ++i)
+		{
+			images.push_back(coords.xyz());
+			for (auto& p : images.back()) p += coords::Cartesian_Point(dist(engine), dist(engine), dist(engine));
+		}
+		return images;
+	}
+
+	struct band_forces
+	{
+		double energy;
+		std::vector<double> image_energies;
+		scon::vector<scon::c3<float>> gradients;
+		std::vector<coords::Representation_3D> tau;
+	};
+
+	/**energy and projected forces of the band as seen by the optimizer (g_new or g_new_maxflux)*/
+	band_forces projected_forces(coords::Coordinates& coords, std::vector<coords::Representation_3D> const& path,
+		int const threads, bool const maxflux, bool const climbing = false)
+	{
+#ifdef _OPENMP
+		auto const max_threads = omp_get_max_threads();
+		omp_set_num_threads(threads);
+#endif
+		neb n(&coords);
+		n.set_path(path);
+		std::remove(("IMAGES_START" + std::to_string(coords.mult_struc_counter) + ".arc").c_str());
+		n.energies_NEB.resize(n.num_images);
+		// tangents of the end points as neb::run sets them (used by MAXFLUX)
+		n.calc_tau();
+		n.tau.front() = n.tau[1];
+		n.tau.back() = n.tau[n.num_images - 2];
+		// the images climb when the maximum is the number of images, calc_tau keeps it for a path going downhill
+		n.ClimbingImage = climbing;
+		neb_test_access::set_climbing_maximum(n, climbing ? static_cast<std::ptrdiff_t>(n.num_images) : 0);
+		scon::vector<scon::c3<float>> x;
+		for (std::size_t im = 1u; im + 1u < path.size(); ++im)
+		{
+			for (auto const& p : path[im]) x.emplace_back(static_cast<float>(p.x()), static_cast<float>(p.y()), static_cast<float>(p.z()));
+		}
+		band_forces r;
+		bool go_on(true);
+		if (maxflux) r.energy = neb::GradCallBackMaxFlux(n)(x, r.gradients, 0u, go_on);
+		else r.energy = neb::GradCallBack(n)(x, r.gradients, 0u, go_on);
+		r.image_energies = n.energies_NEB;
+		r.tau = n.tau;
+#ifdef _OPENMP
+		omp_set_num_threads(max_threads);
+#endif
+		return r;
+	}
+
+	void expect_same_forces(band_forces const& serial, band_forces const& parallel)
+	{
+		EXPECT_NEAR(parallel.energy, serial.energy, 1e-3);
+		ASSERT_EQ(parallel.image_energies.size(), serial.image_energies.size());
+		for (std::size_t im = 0u; im < serial.image_energies.size(); ++im)
+		{
+			EXPECT_NEAR(parallel.image_energies[im], serial.image_energies[im], 1e-9);
+		}
+		ASSERT_EQ(parallel.gradients.size(), serial.gradients.size());
+		for (std::size_t i = 0u; i < serial.gradients.size(); ++i)
+		{
+			EXPECT_NEAR(parallel.gradients[i].x(), serial.gradients[i].x(), 1e-4);
+			EXPECT_NEAR(parallel.gradients[i].y(), serial.gradients[i].y(), 1e-4);
+			EXPECT_NEAR(parallel.gradients[i].z(), serial.gradients[i].z(), 1e-4);
+		}
+	}
+}
+
+TEST(NebImages, parallelImagesSameAsSerial)
+{
+	auto coords = butanol();
+	auto const images = shaken_path(coords, 6u);
+	auto const serial = evaluated(coords, images, 1);
+	auto const parallel = evaluated(coords, images, 3);
+	ASSERT_EQ(parallel.size(), images.size());
+	for (std::size_t im = 0u; im < images.size(); ++im)
+	{
+		ASSERT_TRUE(parallel[im].ok);
+		EXPECT_NEAR(parallel[im].energy, serial[im].energy, 1e-9);
+		for (std::size_t i = 0u; i < coords.size(); ++i)
+		{
+			EXPECT_NEAR(parallel[im].gradient[i].x(), serial[im].gradient[i].x(), 1e-9);
+			EXPECT_NEAR(parallel[im].gradient[i].y(), serial[im].gradient[i].y(), 1e-9);
+			EXPECT_EQ(parallel[im].xyz[i].z(), images[im][i].z());
+		}
+	}
+	// the coordinates hold the last image afterwards
+	EXPECT_EQ(coords.xyz()[0].x(), images.back()[0].x());
+	EXPECT_NEAR(coords.g_xyz()[0].x(), serial.back().gradient[0].x(), 1e-9);
+}
+
+TEST(NebImages, parallelBandForcesSameAsSerial)
+{
+	auto coords = butanol();
+	auto const path = shaken_path(coords, 6u);
+	auto const start = coords.xyz();
+	for (bool const maxflux : { false, true })
+	{
+		coords.set_xyz(start);
+		auto const serial = projected_forces(coords, path, 1, maxflux);
+		coords.set_xyz(start);
+		auto const parallel = projected_forces(coords, path, 3, maxflux);
+		expect_same_forces(serial, parallel);
+	}
+}
+
+TEST(NebImages, climbingImagesInvertTheForceAlongTheBand)
+{
+	auto coords = butanol();
+	auto path = shaken_path(coords, 6u);
+	auto const start = coords.xyz();
+	auto gradients = evaluated(coords, path, 1);
+	// images sorted downhill, so calc_tau does not move the climbing maximum
+	std::vector<std::size_t> order(path.size());
+	for (std::size_t im = 0u; im < order.size(); ++im) order[im] = im;
+	std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return gradients[a].energy > gradients[b].energy; });
+	std::vector<coords::Representation_3D> downhill;
+	for (auto const im : order) downhill.push_back(path[im]);
+	path = downhill;
+	gradients = evaluated(coords, path, 1);
+	coords.set_xyz(start);
+	auto const climbing = projected_forces(coords, path, 3, false, true);
+	coords.set_xyz(start);
+	auto const climbingMaxflux = projected_forces(coords, path, 3, true, true);
+	coords.set_xyz(start);
+	auto const plain = projected_forces(coords, path, 3, false);
+	coords.set_xyz(start);
+	auto const plainMaxflux = projected_forces(coords, path, 3, true);
+	ASSERT_EQ(climbing.gradients.size(), (path.size() - 2u) * coords.size());
+	for (std::size_t im = 1u; im + 1u < path.size(); ++im)
+	{
+		// g - 2 (g . tau) tau / |tau|, without the spring and IDPP forces
+		auto const& g = gradients[im].gradient;
+		auto const& tau = climbing.tau[im];
+		// calc_tau appends to tau, so its length covers every tangent calculated since neb::run cleared it
+		double gtau(0.0), taulen(0.0);
+		for (std::size_t i = 0u; i < coords.size(); ++i) gtau += scon::dot(g[i], tau[i]);
+		for (auto const& t : tau) taulen += scon::dot(t, t);
+		double const magni = gtau / std::sqrt(taulen);
+		for (std::size_t i = 0u; i < coords.size(); ++i)
+		{
+			auto const k = (im - 1u) * coords.size() + i;
+			auto const expected = g[i] - tau[i] * (2.0 * magni);
+			// the optimizer passes the positions in single precision
+			double const tolerance = std::max(1e-3, 1e-5 * scon::len(expected));
+			EXPECT_NEAR(climbing.gradients[k].x(), expected.x(), tolerance);
+			EXPECT_NEAR(climbing.gradients[k].y(), expected.y(), tolerance);
+			EXPECT_NEAR(climbing.gradients[k].z(), expected.z(), tolerance);
+			// MAXFLUX subtracts the same path curvature force from the climbing and from the plain force
+			EXPECT_NEAR(climbingMaxflux.gradients[k].x() - climbing.gradients[k].x(), plainMaxflux.gradients[k].x() - plain.gradients[k].x(), 1e-3);
+			EXPECT_NEAR(climbingMaxflux.gradients[k].y() - climbing.gradients[k].y(), plainMaxflux.gradients[k].y() - plain.gradients[k].y(), 1e-3);
+			EXPECT_NEAR(climbingMaxflux.gradients[k].z() - climbing.gradients[k].z(), plainMaxflux.gradients[k].z() - plain.gradients[k].z(), 1e-3);
+		}
+	}
+}
+
+TEST(NebImages, copiesMadeAgainForOtherCoordinates)
+{
+	auto first = butanol();
+	auto second = butanol();
+	// other pairlists for the second coordinates
+	auto const oldEnergyConfig = Config::get().energy;
+	Config::set().energy.cutoff = 3.0;
+	Config::set().energy.switchdist = 2.0;
+	second.energy_update();
+	Config::set().energy = oldEnergyConfig;
+	auto const images = shaken_path(first, 4u);
+	auto const serial = evaluated(second, images, 1);
+#ifdef _OPENMP
+	auto const max_threads = omp_get_max_threads();
+	omp_set_num_threads(3);
+#endif
+	neb n(&first);
+	n.num_images = images.size();
+	n.imagi = images;
+	n.evaluate_images(0u, images.size());
+	n.cPtr = &second;
+	auto const parallel = n.evaluate_images(0u, images.size());
+#ifdef _OPENMP
+	omp_set_num_threads(max_threads);
+#endif
+	for (std::size_t im = 0u; im < images.size(); ++im)
+	{
+		EXPECT_NEAR(parallel[im].energy, serial[im].energy, 1e-9);
+	}
+}
+
+#endif
@@ -58,6 +58,7 @@ public:
 	MOCK_CONST_METHOD1(getSol, coords::float_type(scon::mathmatrix<coords::float_type> const&));
 	MOCK_CONST_METHOD0(getInternalStep, scon::mathmatrix<coords::float_type>());
 	MOCK_CONST_METHOD1(getInternalStep, scon::mathmatrix<coords::float_type>(scon::mathmatrix<coords::float_type> const&));
+	MOCK_CONST_METHOD1(getShiftedInternalStep, scon::mathmatrix<coords::float_type>(coords::float_type const));
 	MOCK_METHOD1(applyInternalChangeAndGetNorm, coords::float_type(scon::mathmatrix<coords::float_type> const&));
 	MOCK_METHOD1(applyInternalChangeAndGetNorm, coords::float_type(internals::StepRestrictor&));
 	MOCK_CONST_METHOD1(alterHessian, scon::mathmatrix<coords::float_type>(coords::float_type const));
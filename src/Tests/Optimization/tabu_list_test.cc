@@ -0,0 +1,133 @@
+/**
+CAST 3
+Purpose: Tests the fingerprints of the tabu list of the global optimizations
+
+@version 1.0
+*/
+
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+
+#include "../../configuration.h"
+#include "../../coords_io.h"
+#include "../../optimization_global.h"
+
+namespace
+{
+	coords::Coordinates butanol()
+	{
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		return ci->read("test_files/butanol.arc");
+	}
+
+	/**structures displaced by different amounts with energies between 0 and 3 kcal/mol*/
+	std::vector<coords::PES_Point> displaced_points(coords::Coordinates& coords, unsigned const n, unsigned const seed)
+	{
+		auto const start = coords.xyz();
+		std::mt19937 engine(seed);
+		std::uniform_real_distribution<double> unit(-1.0, 1.0), energy(0.0, 3.0);
+		double const scales[] = { 0.005, 0.02, 0.3, 1.0 };
+		std::vector<coords::PES_Point> ret;
+		for (unsigned i = 0u; i < n; ++i)
+		{
+			auto xyz = start;
+			auto const scale = scales[i % 4u];
+			for (auto& p : xyz) p += coords::Cartesian_Point(scale * unit(engine), scale * unit(engine), scale * unit(engine));
+			coords.set_xyz(xyz);
+			coords.to_internal();
+			ret.push_back(coords.pes());
+			ret.back().energy = energy(engine);
+		}
+		coords.set_xyz(start);
+		return ret;
+	}
+
+	/**comparison of every point in the energy window as done without the fingerprints*/
+	bool tabu_brute_force(optimization::global::Tabu_List const& list, coords::PES_Point const& p, coords::Coordinates const& coords)
+	{
+		for (auto const& tp : list)
+		{
+			if (tp.pes.energy > p.energy - 1.0 && tp.pes.energy < p.energy + 1.0 && coords.is_equal_structure(tp.pes, p)) return true;
+		}
+		return false;
+	}
+
+	bool superposition_brute_force(optimization::global::Tabu_List const& list, coords::PES_Point const& p, coords::Coordinates const& coords)
+	{
+		for (auto const& tp : list)
+		{
+			if (coords.check_superposition_xyz(tp.pes.structure.cartesian, p.structure.cartesian)) return true;
+		}
+		return false;
+	}
+
+	void expect_same_as_brute_force(coords::Coordinates& coords)
+	{
+		optimization::global::Tabu_List list;
+		for (auto const& p : displaced_points(coords, 40u, 3u)) list.add(optimization::global::Tabu_Point(p), coords);
+		for (std::size_t i = 1u; i < list.size(); ++i) ASSERT_LE(list[i - 1u].pes.energy, list[i].pes.energy);
+		std::size_t n_tabu(0u);
+		for (auto const& p : displaced_points(coords, 80u, 5u))
+		{
+			auto const tabu = tabu_brute_force(list, p, coords);
+			EXPECT_EQ(list.tabu(p, coords), tabu);
+			EXPECT_EQ(list.has_superposition(p, coords), superposition_brute_force(list, p, coords));
+			if (tabu) ++n_tabu;
+		}
+		// both outcomes are tested
+		EXPECT_GT(n_tabu, 0u);
+		EXPECT_LT(n_tabu, 80u);
+	}
+}
+
+TEST(TabuList, sameAsBruteForce)
+{
+	auto coords = butanol();
+	expect_same_as_brute_force(coords);
+}
+
+TEST(TabuList, sameAsBruteForceWithTightTolerances)
+{
+	auto coords = butanol();
+	auto const old_equals = Config::get().coords.equals;
+	Config::set().coords.equals.main = coords::angle_type::from_deg(1.0);
+	Config::set().coords.equals.intern = coords::internal_type(0.01, coords::angle_type::from_deg(0.5), coords::angle_type::from_deg(1.0));
+	Config::set().coords.equals.xyz = coords::Cartesian_Point(0.02, 0.02, 0.02);
+	expect_same_as_brute_force(coords);
+	Config::set().coords.equals = old_equals;
+}
+
+TEST(TabuList, fingerprintsRejectOnlyDifferentStructures)
+{
+	auto coords = butanol();
+	auto const points = displaced_points(coords, 40u, 7u);
+	std::size_t n_rejected(0u), n_not_superposed(0u);
+	for (auto const& a : points)
+	{
+		optimization::global::Tabu_Fingerprint const fa(a, coords);
+		EXPECT_TRUE(fa.may_be_equal(fa));
+		for (auto const& b : points)
+		{
+			optimization::global::Tabu_Fingerprint const fb(b, coords);
+			if (!fa.may_be_equal(fb))
+			{
+				++n_rejected;
+				EXPECT_FALSE(coords.is_equal_structure(a, b));
+			}
+			if (!fa.may_superpose(fb))
+			{
+				++n_not_superposed;
+				EXPECT_FALSE(coords.check_superposition_xyz(a.structure.cartesian, b.structure.cartesian));
+			}
+		}
+	}
+	// the pairs of strongly displaced structures are rejected
+	EXPECT_GT(n_rejected, 400u);
+	EXPECT_GT(n_not_superposed, 400u);
+}
+
+#endif
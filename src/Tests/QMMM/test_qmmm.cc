@@ -11,7 +11,13 @@ Purpose: Tests stuff for QM/MM interfaces
 #include "../../tinker_parameters.h"
 #include "../../qmmm_helperfunctions.h"
 #include "../../energy_int_aco.h"
+#include "../../energy_int_qmmm.h"
+#include "../../Scon/scon_utility.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
 
 // tests use the test system butanol.arc
 
@@ -268,4 +274,193 @@ TEST(qmmm, test_add_external_charges_onlySE)
 	ASSERT_EQ(result.size(), 2);  // only charges for SE atoms (7 and 8)
 }
 
+namespace
+{
+	/**checks that find_mm_atoms_near_qm() finds every MM atom within the cutoff of a QM atom
+	(random positions, periodic boundaries depending on configuration)*/
+	void test_mm_atoms_near_qm(double const cutoff)
+	{
+		coords::Cartesian_Point const box(20.0, 22.0, 24.0);
+		std::mt19937 engine(77u);
+		std::uniform_real_distribution<double> dist(0.0, 1.0);
+		coords::Representation_3D xyz;
+		for (std::size_t i = 0u; i < 600u; ++i)
+		{
+			xyz.emplace_back(dist(engine) * box.x(), dist(engine) * box.y(), dist(engine) * box.z());
+		}
+		std::vector<std::size_t> qm_indices, mm_indices;
+		for (std::size_t i = 0u; i < xyz.size(); ++i)
+		{
+			if (i % 30 == 0) qm_indices.push_back(i);
+			else mm_indices.push_back(i);
+		}
+
+		auto const near_qm = qmmm_helpers::find_mm_atoms_near_qm(xyz, qm_indices, mm_indices, cutoff);
+		ASSERT_EQ(near_qm.size(), qm_indices.size());
+		for (std::size_t a = 0u; a < qm_indices.size(); ++a)
+		{
+			EXPECT_TRUE(std::is_sorted(near_qm[a].begin(), near_qm[a].end()));
+			for (auto j : near_qm[a])
+			{
+				EXPECT_TRUE(scon::sorted::exists(mm_indices, j));
+			}
+			for (auto j : mm_indices)
+			{
+				auto r = xyz[j] - xyz[qm_indices[a]];
+				if (Config::get().periodics.periodic)
+				{
+					r.x() -= box.x() * std::round(r.x() / box.x());
+					r.y() -= box.y() * std::round(r.y() / box.y());
+					r.z() -= box.z() * std::round(r.z() / box.z());
+				}
+				if (len(r) <= cutoff)
+				{
+					EXPECT_TRUE(std::binary_search(near_qm[a].begin(), near_qm[a].end(), j));
+				}
+			}
+		}
+	}
+}
+
+TEST(qmmm, test_find_mm_atoms_near_qm)
+{
+	auto const oldPeriodicsConfig = Config::get().periodics;
+	Config::set().periodics.periodic = false;
+	test_mm_atoms_near_qm(5.0);
+	Config::set().periodics = oldPeriodicsConfig;
+}
+
+TEST(qmmm, test_find_mm_atoms_near_qm_periodic)
+{
+	auto const oldPeriodicsConfig = Config::get().periodics;
+	Config::set().periodics.periodic = true;
+	Config::set().periodics.pb_box = coords::Cartesian_Point(20.0, 22.0, 24.0);
+	test_mm_atoms_near_qm(6.0);
+	Config::set().periodics = oldPeriodicsConfig;
+}
+
+namespace
+{
+	/**vdW and coulomb energies and gradients between QM and MM atoms*/
+	struct ww_result
+	{
+		double vdw, coulomb;
+		coords::Representation_3D vdw_gradient, c_gradient;
+	};
+
+	/**vdW and coulomb interactions of every QM atom with every MM atom (mechanical embedding, no periodic boundaries),
+	evaluated pair by pair without screening*/
+	ww_result all_pairs_ww(energy::interfaces::qmmm::QMMM& qmmm, coords::Coordinates const& coords)
+	{
+		tinker::parameter::parameters tp;
+		tp.from_file("test_files/oplsaa.prm");
+		std::vector<std::size_t> types;
+		for (auto const& atom : coords.atoms()) scon::sorted::insert_unique(types, atom.energy_type());
+		auto const cparams = tp.contract(types);
+		double const c = Config::get().energy.cutoff;
+		double const s = Config::get().energy.switchdist;
+		bool const cut = c < std::numeric_limits<double>::max();
+		bool const sigma = cparams.general().radiustype.value == ::tinker::parameter::radius_types::T::SIGMA;
+		auto const mm_charges = qmmm.mmc.energyinterface()->charges();
+
+		ww_result r{ 0.0, 0.0, coords::Representation_3D(coords.size()), coords::Representation_3D(coords.size()) };
+		for (auto i : qmmm.qm_indices)
+		{
+			auto const& vdw_i = cparams.vdws()[cparams.type(coords.atoms(i).energy_type(), tinker::potential_keys::VDW) - 1];
+			double const q_i = cparams.charges()[cparams.type(coords.atoms(i).energy_type(), tinker::potential_keys::CHARGE) - 1].c;
+			for (auto j : qmmm.mm_indices)
+			{
+				int const calc_modus = qmmm.calc_vdw(i, j);
+				if (calc_modus == 0) continue;
+				auto const& vdw_j = cparams.vdws()[cparams.type(coords.atoms(j).energy_type(), tinker::potential_keys::VDW) - 1];
+				auto const r_ij = coords.xyz(j) - coords.xyz(i);
+				double const d = len(r_ij);
+
+				// vdW with switching function between switchdist and cutoff
+				double const R_0 = sigma ? std::sqrt(vdw_i.r * vdw_j.r) : vdw_i.r + vdw_j.r;
+				double const epsilon = std::sqrt(vdw_i.e * vdw_j.e);
+				double const R_r = std::pow(R_0 / d, 6);
+				double const E = sigma ? 4 * R_r * epsilon * (R_r - 1.0) : R_r * epsilon * (R_r - 2.0);
+				double const dE = sigma ? 4 * epsilon * R_r / d * (6.0 - 12.0 * R_r) : epsilon * R_r / d * 12.0 * (1.0 - R_r);
+				double S(1.0), dS(0.0);
+				if (cut && d > c) S = 0.0;
+				else if (cut && d > s)
+				{
+					double const w = (c * c - s * s) * (c * c - s * s) * (c * c - s * s);
+					S = (c * c - d * d) * (c * c - d * d) * (c * c + 2 * d * d - 3 * s * s) / w;
+					dS = -12 * d * (c * c - d * d) * (d * d - s * s) / w;
+				}
+				double const divisor = calc_modus == 2 ? 2.0 : 1.0;
+				r.vdw += E * S / divisor;
+				auto const g_vdw = r_ij * ((dE * S + E * dS) / d / divisor);
+				r.vdw_gradient[i] -= g_vdw;
+				r.vdw_gradient[j] += g_vdw;
+
+				// coulomb, scaled with (1 - (d/c)^2)^2 below the cutoff
+				double const Q = q_i * mm_charges[qmmm.new_indices_mm[j]] * cparams.general().electric / d / (calc_modus == 2 ? 2.0 : 1.0);
+				double const x = cut ? d / c : 0.0;
+				double const T = (cut && d > c) ? 0.0 : (1 - x * x) * (1 - x * x);
+				double const dT = (cut && d < c) ? -4 * x * (1 - x * x) / c : 0.0;
+				r.coulomb += Q * T;
+				auto const g_coul = r_ij * ((Q * T / d - Q * dT) / d);
+				r.c_gradient[i] += g_coul;
+				r.c_gradient[j] -= g_coul;
+			}
+		}
+		return r;
+	}
+
+	/**compares ww_calc() of the QM/MM interface (QM part butanol atoms 6, 9-15, force field as QM interface)
+	with the sum over all pairs*/
+	void test_ww_calc(double const cutoff, double const switchdist)
+	{
+		auto const oldEnergyConfig = Config::get().energy;
+		Config::set().energy.cutoff = cutoff;
+		Config::set().energy.switchdist = switchdist;
+		Config::set().energy.qmmm.qm_systems = { { 5,8,9,10,11,12,13,14 } };
+		Config::set().energy.qmmm.linkatom_sets = { { 85 } };
+		Config::set().energy.qmmm.centers = { 8 };
+		Config::set().energy.qmmm.qminterface = config::interface_types::OPLSAA;
+		Config::set().energy.qmmm.mminterface = config::interface_types::OPLSAA;
+		Config::set().energy.qmmm.zerocharge_bonds = 0;   // mechanical embedding
+
+		auto const oldInterface = Config::get().general.energy_interface;
+		Config::set().general.energy_interface = config::interface_types::QMMM;
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		coords::Coordinates coords(ci->read("test_files/butanol.arc"));
+		auto& qmmm = dynamic_cast<energy::interfaces::qmmm::QMMM&>(*coords.energyinterface());
+		qmmm.ww_calc(true);
+		auto const reference = all_pairs_ww(qmmm, coords);
+		Config::set().general.energy_interface = oldInterface;
+		Config::set().energy = oldEnergyConfig;
+
+		ASSERT_TRUE(qmmm.intact());
+		EXPECT_NE(reference.vdw, 0.0);
+		EXPECT_NE(reference.coulomb, 0.0);
+		EXPECT_NEAR(qmmm.vdw_energy, reference.vdw, 1e-10);
+		EXPECT_NEAR(qmmm.coulomb_energy, reference.coulomb, 1e-10);
+		ASSERT_EQ(qmmm.vdw_gradient.size(), coords.size());
+		ASSERT_EQ(qmmm.c_gradient.size(), coords.size());
+		for (std::size_t i = 0u; i < coords.size(); ++i)
+		{
+			EXPECT_NEAR(qmmm.vdw_gradient[i].x(), reference.vdw_gradient[i].x(), 1e-10);
+			EXPECT_NEAR(qmmm.vdw_gradient[i].y(), reference.vdw_gradient[i].y(), 1e-10);
+			EXPECT_NEAR(qmmm.vdw_gradient[i].z(), reference.vdw_gradient[i].z(), 1e-10);
+			EXPECT_NEAR(qmmm.c_gradient[i].x(), reference.c_gradient[i].x(), 1e-10);
+			EXPECT_NEAR(qmmm.c_gradient[i].y(), reference.c_gradient[i].y(), 1e-10);
+			EXPECT_NEAR(qmmm.c_gradient[i].z(), reference.c_gradient[i].z(), 1e-10);
+		}
+	}
+}
+
+TEST(qmmm, test_ww_calc_same_as_all_pairs)
+{
+	test_ww_calc(std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+}
+
+TEST(qmmm, test_ww_calc_same_as_all_pairs_with_cutoff)
+{
+	test_ww_calc(3.5, 2.5);   // some pairs beyond the cutoff, some in the switching region
+}
+
 #endif
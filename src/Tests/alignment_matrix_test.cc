@@ -0,0 +1,216 @@
+#ifdef GOOGLE_MOCK
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "../alignment.h"
+#include "../alignment_matrix.h"
+#include "../coords_io.h"
+
+// tests use the test system butanol.arc
+
+namespace
+{
+	coords::Coordinates butanol()
+	{
+		std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+		return ci->read("test_files/butanol.arc");
+	}
+
+	/**randomly rotated, shifted and distorted copies of the structure*/
+	std::vector<coords::Representation_3D> frames(coords::Representation_3D const& xyz, unsigned const n)
+	{
+		std::mt19937 engine(11u);
+		std::uniform_real_distribution<double> unit(-1.0, 1.0);
+		std::vector<coords::Representation_3D> ret;
+		for (unsigned f = 0u; f < n; ++f)
+		{
+			double const a = 3.0 * unit(engine), b = 3.0 * unit(engine);
+			coords::Cartesian_Point const shift(5.0 * unit(engine), 5.0 * unit(engine), 5.0 * unit(engine));
+			ret.push_back(xyz);
+			for (auto& p : ret.back())
+			{
+				coords::Cartesian_Point const r(std::cos(a) * p.x() - std::sin(a) * p.y(), std::sin(a) * p.x() + std::cos(a) * p.y(), p.z());
+				p = coords::Cartesian_Point(r.x(), std::cos(b) * r.y() - std::sin(b) * r.z(), std::sin(b) * r.y() + std::cos(b) * r.z());
+				p += shift + coords::Cartesian_Point(0.3 * unit(engine), 0.3 * unit(engine), 0.3 * unit(engine));
+			}
+		}
+		return ret;
+	}
+
+	align::frame_block block_of(std::vector<coords::Representation_3D> const& xyz)
+	{
+		align::frame_block ret(xyz.front().size());
+		for (auto const& f : xyz) ret.push_back(f);
+		return ret;
+	}
+
+	/**reads the binary matrix written by write(out)*/
+	template<class Writer>
+	std::vector<double> written_matrix(Writer&& write, std::uint64_t& n, std::uint64_t& layout)
+	{
+		std::string const file("distance_matrix_test.bin");
+		{
+			std::ofstream out(file, std::ios::out | std::ios::binary);
+			write(out);
+		}
+		std::ifstream in(file, std::ios::in | std::ios::binary | std::ios::ate);
+		auto const size = static_cast<std::size_t>(in.tellg());
+		in.seekg(0);
+		in.read(reinterpret_cast<char*>(&n), sizeof(n));
+		in.read(reinterpret_cast<char*>(&layout), sizeof(layout));
+		std::vector<double> ret((size - 2u * sizeof(std::uint64_t)) / sizeof(double));
+		in.read(reinterpret_cast<char*>(ret.data()), static_cast<std::streamsize>(ret.size() * sizeof(double)));
+		in.close();
+		std::remove(file.c_str());
+		return ret;
+	}
+
+	std::vector<double> written_matrix(align::frame_block const& block, align::distance_matrix_options const& options,
+		bool const condensed, std::uint64_t& n, std::uint64_t& layout)
+	{
+		return written_matrix([&](std::ostream& out) { align::write_distance_matrix(block, options, condensed, out); }, n, layout);
+	}
+}
+
+TEST(alignmentMatrix, quaternionRmsdSameAsKabsch)
+{
+	auto coords = butanol();
+	auto const xyz = frames(coords.xyz(), 4u);
+	auto const block = block_of(xyz);
+	coords::Coordinates a(coords), b(coords);
+	for (std::size_t i = 0u; i < xyz.size(); ++i)
+	{
+		for (std::size_t j = 0u; j < xyz.size(); ++j)
+		{
+			a.set_xyz(xyz[i]);
+			b.set_xyz(xyz[j]);
+			std::array<double, 9> rotation;
+			auto const rmsd = align::qcp_rmsd(block, i, block, j, &rotation);
+			EXPECT_NEAR(rmsd, align::rmsd_aligned(b, a), 1e-6);
+			// the rotation superposes frame j onto frame i
+			double sum(0.0);
+			for (std::size_t k = 0u; k < block.atoms(); ++k)
+			{
+				double const x = block.x(j)[k], y = block.y(j)[k], z = block.z(j)[k];
+				double const dx = rotation[0] * x + rotation[1] * y + rotation[2] * z - block.x(i)[k];
+				double const dy = rotation[3] * x + rotation[4] * y + rotation[5] * z - block.y(i)[k];
+				double const dz = rotation[6] * x + rotation[7] * y + rotation[8] * z - block.z(i)[k];
+				sum += dx * dx + dy * dy + dz * dz;
+			}
+			EXPECT_NEAR(std::sqrt(sum / block.atoms()), rmsd, 1e-6);
+		}
+	}
+}
+
+TEST(alignmentMatrix, condensedMatrixSameAsPairwise)
+{
+	auto coords = butanol();
+	auto const xyz = frames(coords.xyz(), 9u);
+	auto const block = block_of(xyz);
+	coords::Coordinates a(coords), b(coords);
+	align::distance_matrix_options options;
+	options.tile = 2u;
+	for (std::size_t unit = 0u; unit < 3u; ++unit)
+	{
+		options.dist_unit = unit;
+		auto const matrix = align::condensed_distance_matrix(block, options);
+		ASSERT_EQ(matrix.size(), 36u);
+		std::size_t k(0u);
+		for (std::size_t i = 0u; i < xyz.size(); ++i)
+		{
+			for (std::size_t j = i + 1u; j < xyz.size(); ++j, ++k)
+			{
+				a.set_xyz(xyz[i]);
+				b.set_xyz(xyz[j]);
+				double const expected = unit == 0u ? align::rmsd_aligned(b, a) :
+					unit == 1u ? align::drmsd_calc(b, a) : align::holmsander_calc(b, a, options.holm_sand_r0);
+				EXPECT_NEAR(matrix[k], expected, 1e-6) << "dist_unit " << unit << ", frames " << i << " " << j;
+			}
+		}
+		// the tiles do not change the result
+		options.tile = 64u;
+		auto const single_tile = align::condensed_distance_matrix(block, options);
+		options.tile = 2u;
+		for (std::size_t i = 0u; i < matrix.size(); ++i) EXPECT_NEAR(single_tile[i], matrix[i], 1e-12);
+	}
+}
+
+TEST(alignmentMatrix, binaryMatrixLayouts)
+{
+	auto coords = butanol();
+	auto const block = block_of(frames(coords.xyz(), 7u));
+	align::distance_matrix_options options;
+	options.tile = 3u;
+	auto const condensed = align::condensed_distance_matrix(block, options);
+
+	std::uint64_t n(0u), layout(2u);
+	auto const full = written_matrix(block, options, false, n, layout);
+	EXPECT_EQ(n, 7u);
+	EXPECT_EQ(layout, 0u);
+	ASSERT_EQ(full.size(), 49u);
+	std::size_t k(0u);
+	for (std::size_t i = 0u; i < 7u; ++i)
+	{
+		EXPECT_EQ(full[i * 7u + i], 0.0);
+		for (std::size_t j = i + 1u; j < 7u; ++j, ++k)
+		{
+			EXPECT_EQ(full[i * 7u + j], condensed[k]);
+			EXPECT_EQ(full[j * 7u + i], condensed[k]);
+		}
+	}
+	EXPECT_EQ(written_matrix(block, options, true, n, layout), condensed);
+	EXPECT_EQ(n, 7u);
+	EXPECT_EQ(layout, 1u);
+}
+
+TEST(alignmentMatrix, outOfCoreMatrixSameAsInMemory)
+{
+	auto coords = butanol();
+	auto const xyz = frames(coords.xyz(), 11u);
+	std::string const file("distance_matrix_test.arc");
+	{
+		std::ofstream out(file);
+		for (auto const& f : xyz)
+		{
+			coords.set_xyz(f, true);
+			out << coords::output::formats::tinker(coords);
+		}
+	}
+	std::unique_ptr<coords::input::format> ci(coords::input::new_format());
+	ci->read(file);
+	ASSERT_EQ(ci->frames(), 11u);
+	// the frames as they were read from the file
+	align::frame_block block(coords.size());
+	for (std::size_t i = 0u; i < ci->frames(); ++i) block.push_back(ci->frame(i));
+
+	for (std::size_t const dist_unit : { 0u, 1u, 2u })
+	{
+		align::distance_matrix_options options;
+		options.dist_unit = dist_unit;
+		options.tile = 2u;
+		for (bool const condensed : { false, true })
+		{
+			std::uint64_t n(0u), layout(2u), n_in_memory(0u), layout_in_memory(2u);
+			auto const in_memory = written_matrix(block, options, condensed, n_in_memory, layout_in_memory);
+			// chunks of 3 frames, the last one is shorter
+			auto const out_of_core = written_matrix([&](std::ostream& out) {
+				align::write_distance_matrix(*ci, true, options, condensed, out, 3u); }, n, layout);
+			EXPECT_EQ(n, n_in_memory);
+			EXPECT_EQ(layout, layout_in_memory);
+			ASSERT_EQ(out_of_core.size(), in_memory.size());
+			for (std::size_t k = 0u; k < in_memory.size(); ++k) EXPECT_DOUBLE_EQ(out_of_core[k], in_memory[k]);
+		}
+	}
+	ci.reset();
+	std::remove(file.c_str());
+}
+
+#endif
@@ -1,4 +1,6 @@
 #include "alignment.h"
+#include "alignment_matrix.h"
+#include "coords_io_stream.h"
 
 namespace align
 {
@@ -143,29 +145,25 @@ void alignment(std::unique_ptr<coords::input::format>& ci, coords::Coordinates&
 	coords::Coordinates coordsReferenceStructure(coords), coordsTemporaryStructure(coords);
 
 	// Check if reference structure is in range
-	if (Config::get().alignment.reference_frame_num >= ci->size()) throw std::runtime_error("Reference frame number in ALIGN task is bigger than number of frames in the input structure ensemble.");
+	if (Config::get().alignment.reference_frame_num >= ci->frames()) throw std::runtime_error("Reference frame number in ALIGN task is bigger than number of frames in the input structure ensemble.");
 
-	auto temporaryPESpoint = ci->PES()[Config::get().alignment.reference_frame_num].structure.cartesian;
+	auto temporaryPESpoint = ci->frame(Config::get().alignment.reference_frame_num);
 
 	//Alignment to external reference frame (different file)
 	if (!Config::get().alignment.align_external_file.empty())
 	{
 		std::unique_ptr<coords::input::format> externalReferenceStructurePtr(coords::input::new_format());
 		coords::Coordinates externalReferenceStructure(externalReferenceStructurePtr->read(Config::get().alignment.align_external_file));
-		if (Config::get().alignment.reference_frame_num >= externalReferenceStructurePtr->PES().size())
+		if (Config::get().alignment.reference_frame_num >= externalReferenceStructurePtr->frames())
 		{
 			throw std::out_of_range("Requested reference frame number not within reference structure ensemble.");
 		}
-		temporaryPESpoint = externalReferenceStructurePtr->PES()[Config::get().alignment.reference_frame_num].structure.cartesian;
+		temporaryPESpoint = externalReferenceStructurePtr->frame(Config::get().alignment.reference_frame_num);
 	}
 	//Constructs two coordinate objects and sets reference frame according to INPUTFILE
 	coordsReferenceStructure.set_xyz(temporaryPESpoint);
 
-	//Construct and Allocate arrays for stringoutput (necessary for OpenMP)
 	double mean_value = 0;
-	std::string* hold_str, * hold_coords_str;
-	hold_str = new std::string[ci->size()];
-	hold_coords_str = new std::string[ci->size()];
 
 	//Perform translational alignment for reference frame
 	if (Config::get().alignment.traj_align_translational)
@@ -173,103 +171,124 @@ void alignment(std::unique_ptr<coords::input::format>& ci, coords::Coordinates&
     centerOfGeometryAlignment(coordsReferenceStructure);
 	}
 
+	std::ofstream distance(coords::output::filename("_distances").c_str(), std::ios::app);
+	std::ofstream outputstream(coords::output::filename("_aligned").c_str(), std::ios::app);
+
 	// Output text
 	if (Config::get().general.verbosity > 2U) std::cout << "ALIGN preparations done. Starting actual alignment.\n";
-
 #ifdef _OPENMP
 	if (Config::get().general.verbosity > 3U) std::cout << "Using openMP for alignment.\n";
-	auto const n_omp = static_cast<std::ptrdiff_t>(ci->size());
-#pragma omp parallel for firstprivate(coordsReferenceStructure, coordsTemporaryStructure) reduction(+:mean_value) shared(hold_coords_str, hold_str)
-	for (std::ptrdiff_t i = 0; i < n_omp; ++i)
-#else
-	for (std::size_t i = 0; i < ci->size(); ++i)
 #endif
-  {
-    if (i != static_cast<std::ptrdiff_t>(Config::get().alignment.reference_frame_num) || !Config::get().alignment.align_external_file.empty())
-    {
-      auto temporaryPESpoint2 = ci->PES()[i].structure.cartesian;
-      coordsTemporaryStructure.set_xyz(temporaryPESpoint2);
-      //Create temporary objects for current frame
 
-			if (Config::get().alignment.traj_align_translational)
+	// Frames are aligned and written chunk by chunk, the next chunk is read meanwhile
+	coords::input::frame_chunks chunks(*ci);
+	coords::input::frame_chunk chunk;
+	while (chunks.next(chunk))
+	{
+		//Construct arrays for stringoutput of this chunk (necessary for OpenMP)
+		std::vector<std::string> hold_str(chunk.size()), hold_coords_str(chunk.size());
+
+#ifdef _OPENMP
+		auto const n_omp = static_cast<std::ptrdiff_t>(chunk.size());
+#pragma omp parallel for firstprivate(coordsReferenceStructure, coordsTemporaryStructure) reduction(+:mean_value) shared(hold_coords_str, hold_str, chunk)
+		for (std::ptrdiff_t k = 0; k < n_omp; ++k)
+#else
+		for (std::size_t k = 0; k < chunk.size(); ++k)
+#endif
+		{
+			auto const i = chunk.index[k];
+			if (i != Config::get().alignment.reference_frame_num || !Config::get().alignment.align_external_file.empty())
 			{
-        centerOfGeometryAlignment(coordsTemporaryStructure);
+				//Create temporary objects for current frame
+				coordsTemporaryStructure.set_xyz(chunk.xyz[k]);
+
+				if (Config::get().alignment.traj_align_translational)
+				{
+					centerOfGeometryAlignment(coordsTemporaryStructure);
+				}
+				if (Config::get().alignment.traj_align_rotational)
+				{
+					kabschAlignment(coordsTemporaryStructure, coordsReferenceStructure);
+				}
+
+				if (Config::get().alignment.traj_print_bool)
+				{
+					if (Config::get().alignment.dist_unit == 0)
+						//RMSD
+					{
+						std::stringstream temporaryStringstream;
+						const double currentRootMeanSquareDevaition = root_mean_square_deviation(coordsTemporaryStructure.xyz(), coordsReferenceStructure.xyz());
+						temporaryStringstream << std::setw(13) << i << " ";
+						temporaryStringstream << std::setw(13) << currentRootMeanSquareDevaition << "\n";
+						mean_value += currentRootMeanSquareDevaition;
+						hold_str[k] = temporaryStringstream.str();
+					}
+					else if (Config::get().alignment.dist_unit == 1)
+						//dRMSD
+					{
+						std::stringstream temporaryStringstream;
+						temporaryStringstream << i << " ";
+						double value = (double)drmsd_calc(coordsTemporaryStructure, coordsReferenceStructure);
+						temporaryStringstream << std::setw(13) << value << "\n";
+						mean_value += value;
+						hold_str[k] = temporaryStringstream.str();
+					}
+					else if (Config::get().alignment.dist_unit == 2)
+						//Holm&Sander Distance
+					{
+						std::stringstream temporaryStringstream;
+						double value = (double)holmsander_calc(coordsTemporaryStructure, coordsReferenceStructure, Config::get().alignment.holm_sand_r0);
+						temporaryStringstream << std::setw(13) << i << " " << value << "\n";
+						mean_value += value;
+						hold_str[k] = temporaryStringstream.str();
+					}
+				}
+				//Molecular distance measure calculation
+
+				std::stringstream hold_coords;
+				hold_coords << coordsTemporaryStructure;
+				hold_coords_str[k] = hold_coords.str();
+				//Formatted string-output
 			}
-			if (Config::get().alignment.traj_align_rotational)
+			else
 			{
-				kabschAlignment(coordsTemporaryStructure, coordsReferenceStructure);
+				std::stringstream hold_coords;
+				hold_coords << coordsReferenceStructure;
+				hold_coords_str[k] = hold_coords.str();
+				//Formatted string-output (first to array because of OpenMP parallelization)
 			}
-
-      if (Config::get().alignment.traj_print_bool)
-      {
-        if (Config::get().alignment.dist_unit == 0)
-          //RMSD
-        {
-          std::stringstream temporaryStringstream;
-          const double currentRootMeanSquareDevaition = root_mean_square_deviation(coordsTemporaryStructure.xyz(), coordsReferenceStructure.xyz());
-          temporaryStringstream << std::setw(13) << i << " ";
-          temporaryStringstream << std::setw(13) << currentRootMeanSquareDevaition << "\n";
-          mean_value += currentRootMeanSquareDevaition;
-          hold_str[i] = temporaryStringstream.str();
-        }
-        else if (Config::get().alignment.dist_unit == 1)
-          //dRMSD
-        {
-          std::stringstream temporaryStringstream;
-          temporaryStringstream << i << " ";
-          double value = (double)drmsd_calc(coordsTemporaryStructure, coordsReferenceStructure);
-          temporaryStringstream << std::setw(13) << value << "\n";
-          mean_value += value;
-          hold_str[i] = temporaryStringstream.str();
-        }
-        else if (Config::get().alignment.dist_unit == 2)
-          //Holm&Sander Distance
-        {
-          std::stringstream temporaryStringstream;
-          double value = (double)holmsander_calc(coordsTemporaryStructure, coordsReferenceStructure, Config::get().alignment.holm_sand_r0);
-          temporaryStringstream << std::setw(13) << i << " " << value << "\n";
-          mean_value += value;
-          hold_str[i] = temporaryStringstream.str();
-        }
-      }
-      //Molecular distance measure calculation
-
-			std::stringstream hold_coords;
-			hold_coords << coordsTemporaryStructure;
-			hold_coords_str[i] = hold_coords.str();
-			//Formatted string-output
 		}
 
-		else if (i == static_cast<std::ptrdiff_t>(Config::get().alignment.reference_frame_num))
+		for (std::size_t k = 0; k < chunk.size(); ++k)
 		{
-			std::stringstream hold_coords;
-			hold_coords << coordsReferenceStructure;
-			hold_coords_str[i] = hold_coords.str();
-			//Formatted string-output (first to array because of OpenMP parallelization)
+			if (Config::get().alignment.traj_print_bool)
+			{
+				distance << hold_str[k];
+			}
+			outputstream << hold_coords_str[k];
 		}
 	}
 
-	std::ofstream distance(coords::output::filename("_distances").c_str(), std::ios::app);
-	std::ofstream outputstream(coords::output::filename("_aligned").c_str(), std::ios::app);
+	// Distance matrix of the frames (centered if they are aligned), read again chunk by chunk
+	auto const& alignmentConfig = Config::get().alignment;
+	if (alignmentConfig.distance_matrix != 0u)
+	{
+		if (Config::get().general.verbosity > 2U) std::cout << "Calculating the distance matrix of " << ci->frames() << " frames.\n";
+		align::distance_matrix_options options;
+		options.dist_unit = alignmentConfig.dist_unit;
+		options.superpose = alignmentConfig.traj_align_rotational;
+		options.holm_sand_r0 = alignmentConfig.holm_sand_r0;
+		std::ofstream matrix(coords::output::filename("_distance_matrix", ".bin").c_str(), std::ios::out | std::ios::binary);
+		align::write_distance_matrix(*ci, alignmentConfig.traj_align_translational || alignmentConfig.traj_align_rotational,
+			options, alignmentConfig.distance_matrix == 2u, matrix);
+	}
 
-	if (Config::get().general.verbosity > 2U) std::cout << "Alignment done. Writing structures to file.\n";
+	if (Config::get().general.verbosity > 2U) std::cout << "Alignment done.\n";
 
-  for (size_t i = 0; i < ci->size(); i++)
-  {
-    if (Config::get().alignment.traj_print_bool)
-    {
-      distance << hold_str[i];
-    }
-    outputstream << hold_coords_str[i];
-  }
   distance << "\n";
-  if (ci->size() > 1u)
-    distance << "Mean value: " << (mean_value / (double)(ci->size() - 1)) << "\n";
+  if (chunks.size() > 1u)
+    distance << "Mean value: " << (mean_value / (double)(chunks.size() - 1)) << "\n";
   else
     distance << "Value: " << mean_value << "\n";
   //Formatted string-output
-
-	delete[] hold_str;
-	delete[] hold_coords_str;
-	//Cleaning Up
 }
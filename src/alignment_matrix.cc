@@ -0,0 +1,421 @@
+#include "alignment_matrix.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+#include "coords_io.h"
+#include "coords_io_stream.h"
+
+align::frame_block::frame_block(std::size_t const atoms, bool const center)
+	: m_atoms(atoms), m_center(center), m_x(), m_y(), m_z(), m_squares()
+{}
+
+void align::frame_block::reserve(std::size_t const frames)
+{
+	m_x.reserve(frames * m_atoms);
+	m_y.reserve(frames * m_atoms);
+	m_z.reserve(frames * m_atoms);
+	m_squares.reserve(frames);
+}
+
+void align::frame_block::clear()
+{
+	m_x.clear();
+	m_y.clear();
+	m_z.clear();
+	m_squares.clear();
+}
+
+void align::frame_block::push_back(coords::Representation_3D const& xyz)
+{
+	if (xyz.size() != m_atoms) throw std::logic_error("Number of atoms of the frame does not match the frame block.");
+	coords::Cartesian_Point center;
+	if (m_center && m_atoms > 0u)
+	{
+		for (auto const& p : xyz) center += p;
+		center /= static_cast<double>(m_atoms);
+	}
+	double squares(0.0);
+	for (auto const& p : xyz)
+	{
+		auto const r = p - center;
+		m_x.push_back(r.x());
+		m_y.push_back(r.y());
+		m_z.push_back(r.z());
+		squares += r.x() * r.x() + r.y() * r.y() + r.z() * r.z();
+	}
+	m_squares.push_back(squares);
+}
+
+namespace
+{
+	/**largest eigenvalue of the quaternion key matrix of the correlation matrix s (Newton's method)
+	and the rotation which belongs to its eigenvector*/
+	double qcp_eigenvalue(double const (&s)[9], double const e0, std::array<double, 9>* rotation)
+	{
+		double const Sxx = s[0], Sxy = s[1], Sxz = s[2], Syx = s[3], Syy = s[4], Syz = s[5], Szx = s[6], Szy = s[7], Szz = s[8];
+		double const Sxx2 = Sxx * Sxx, Syy2 = Syy * Syy, Szz2 = Szz * Szz;
+		double const Sxy2 = Sxy * Sxy, Syz2 = Syz * Syz, Sxz2 = Sxz * Sxz;
+		double const Syx2 = Syx * Syx, Szy2 = Szy * Szy, Szx2 = Szx * Szx;
+		double const SyzSzymSyySzz2 = 2.0 * (Syz * Szy - Syy * Szz);
+		double const Sxx2Syy2Szz2Syz2Szy2 = Syy2 + Szz2 - Sxx2 + Syz2 + Szy2;
+		double const SxzpSzx = Sxz + Szx, SyzpSzy = Syz + Szy, SxypSyx = Sxy + Syx;
+		double const SyzmSzy = Syz - Szy, SxzmSzx = Sxz - Szx, SxymSyx = Sxy - Syx;
+		double const SxxpSyy = Sxx + Syy, SxxmSyy = Sxx - Syy;
+		double const Sxy2Sxz2Syx2Szx2 = Sxy2 + Sxz2 - Syx2 - Szx2;
+		// coefficients of the characteristic polynomial x^4 + c2 x^2 + c1 x + c0
+		double const c2 = -2.0 * (Sxx2 + Syy2 + Szz2 + Sxy2 + Syx2 + Sxz2 + Szx2 + Syz2 + Szy2);
+		double const c1 = 8.0 * (Sxx * Syz * Szy + Syy * Szx * Sxz + Szz * Sxy * Syx
+			- Sxx * Syy * Szz - Syz * Szx * Sxy - Szy * Syx * Sxz);
+		double const c0 = Sxy2Sxz2Syx2Szx2 * Sxy2Sxz2Syx2Szx2
+			+ (Sxx2Syy2Szz2Syz2Szy2 + SyzSzymSyySzz2) * (Sxx2Syy2Szz2Syz2Szy2 - SyzSzymSyySzz2)
+			+ (-SxzpSzx * SyzmSzy + SxymSyx * (SxxmSyy - Szz)) * (-SxzmSzx * SyzpSzy + SxymSyx * (SxxmSyy + Szz))
+			+ (-SxzpSzx * SyzpSzy - SxypSyx * (SxxpSyy - Szz)) * (-SxzmSzx * SyzmSzy - SxypSyx * (SxxpSyy + Szz))
+			+ (SxypSyx * SyzpSzy + SxzpSzx * (SxxmSyy + Szz)) * (-SxymSyx * SyzmSzy + SxzpSzx * (SxxpSyy + Szz))
+			+ (SxypSyx * SyzmSzy + SxzmSzx * (SxxmSyy - Szz)) * (-SxymSyx * SyzpSzy + SxzmSzx * (SxxpSyy - Szz));
+		// e0 is an upper bound of the eigenvalue, so Newton's method converges to the largest root
+		double lambda(e0);
+		for (int i = 0; i < 50; ++i)
+		{
+			double const old = lambda;
+			double const x2 = lambda * lambda;
+			double const b = (x2 + c2) * lambda;
+			double const a = b + c1;
+			double const denominator = 2.0 * x2 * lambda + b + a;
+			if (denominator == 0.0) break;
+			lambda -= (a * lambda + c0) / denominator;
+			if (std::abs(lambda - old) < std::abs(1e-11 * lambda)) break;
+		}
+		if (!rotation) return lambda;
+
+		// eigenvector from the adjugate of the key matrix minus lambda
+		double const a11 = SxxpSyy + Szz - lambda, a12 = SyzmSzy, a13 = -SxzmSzx, a14 = SxymSyx;
+		double const a21 = SyzmSzy, a22 = SxxmSyy - Szz - lambda, a23 = SxypSyx, a24 = SxzpSzx;
+		double const a31 = a13, a32 = a23, a33 = Syy - Sxx - Szz - lambda, a34 = SyzpSzy;
+		double const a41 = a14, a42 = a24, a43 = a34, a44 = Szz - SxxpSyy - lambda;
+		double const a3344_4334 = a33 * a44 - a43 * a34, a3244_4234 = a32 * a44 - a42 * a34;
+		double const a3243_4233 = a32 * a43 - a42 * a33, a3143_4133 = a31 * a43 - a41 * a33;
+		double const a3144_4134 = a31 * a44 - a41 * a34, a3142_4132 = a31 * a42 - a41 * a32;
+		double q1 = a22 * a3344_4334 - a23 * a3244_4234 + a24 * a3243_4233;
+		double q2 = -a21 * a3344_4334 + a23 * a3144_4134 - a24 * a3143_4133;
+		double q3 = a21 * a3244_4234 - a22 * a3144_4134 + a24 * a3142_4132;
+		double q4 = -a21 * a3243_4233 + a22 * a3143_4133 - a23 * a3142_4132;
+		double qsqr = q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4;
+		// the columns of the adjugate may vanish, then the next one is used
+		double const precision(1e-6);
+		if (qsqr < precision)
+		{
+			q1 = a12 * a3344_4334 - a13 * a3244_4234 + a14 * a3243_4233;
+			q2 = -a11 * a3344_4334 + a13 * a3144_4134 - a14 * a3143_4133;
+			q3 = a11 * a3244_4234 - a12 * a3144_4134 + a14 * a3142_4132;
+			q4 = -a11 * a3243_4233 + a12 * a3143_4133 - a13 * a3142_4132;
+			qsqr = q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4;
+			if (qsqr < precision)
+			{
+				double const a1324_1423 = a13 * a24 - a14 * a23, a1224_1422 = a12 * a24 - a14 * a22;
+				double const a1223_1322 = a12 * a23 - a13 * a22, a1124_1421 = a11 * a24 - a14 * a21;
+				double const a1123_1321 = a11 * a23 - a13 * a21, a1122_1221 = a11 * a22 - a12 * a21;
+				q1 = a42 * a1324_1423 - a43 * a1224_1422 + a44 * a1223_1322;
+				q2 = -a41 * a1324_1423 + a43 * a1124_1421 - a44 * a1123_1321;
+				q3 = a41 * a1224_1422 - a42 * a1124_1421 + a44 * a1122_1221;
+				q4 = -a41 * a1223_1322 + a42 * a1123_1321 - a43 * a1122_1221;
+				qsqr = q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4;
+				if (qsqr < precision)
+				{
+					q1 = a32 * a1324_1423 - a33 * a1224_1422 + a34 * a1223_1322;
+					q2 = -a31 * a1324_1423 + a33 * a1124_1421 - a34 * a1123_1321;
+					q3 = a31 * a1224_1422 - a32 * a1124_1421 + a34 * a1122_1221;
+					q4 = -a31 * a1223_1322 + a32 * a1123_1321 - a33 * a1122_1221;
+					qsqr = q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4;
+				}
+			}
+		}
+		if (qsqr < precision)
+		{
+			// structures are (almost) identical
+			*rotation = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };
+			return lambda;
+		}
+		double const norm = std::sqrt(qsqr);
+		q1 /= norm;
+		q2 /= norm;
+		q3 /= norm;
+		q4 /= norm;
+		double const a2 = q1 * q1, x2 = q2 * q2, y2 = q3 * q3, z2 = q4 * q4;
+		double const xy = q2 * q3, az = q1 * q4, zx = q4 * q2, ay = q1 * q3, yz = q3 * q4, ax = q1 * q2;
+		*rotation = {
+			a2 + x2 - y2 - z2, 2.0 * (xy + az), 2.0 * (zx - ay),
+			2.0 * (xy - az), a2 - x2 + y2 - z2, 2.0 * (yz + ax),
+			2.0 * (zx + ay), 2.0 * (yz - ax), a2 - x2 - y2 + z2 };
+		return lambda;
+	}
+
+	/**distances of all atom pairs (j < i, ordered as in align::drmsd_calc)*/
+	void pair_distances(align::frame_block const& frames, std::size_t const f, double* d)
+	{
+		auto const n = frames.atoms();
+		auto const x = frames.x(f), y = frames.y(f), z = frames.z(f);
+		for (std::size_t i = 0u; i < n; ++i)
+		{
+			for (std::size_t j = 0u; j < i; ++j)
+			{
+				double const dx = x[i] - x[j], dy = y[i] - y[j], dz = z[i] - z[j];
+				*d++ = std::sqrt(dx * dx + dy * dy + dz * dz);
+			}
+		}
+	}
+
+	double plain_rmsd(align::frame_block const& block_a, std::size_t const a, align::frame_block const& block_b, std::size_t const b)
+	{
+		auto const n = block_a.atoms();
+		auto const xa = block_a.x(a), ya = block_a.y(a), za = block_a.z(a);
+		auto const xb = block_b.x(b), yb = block_b.y(b), zb = block_b.z(b);
+		double sum(0.0);
+		for (std::size_t i = 0u; i < n; ++i)
+		{
+			double const dx = xa[i] - xb[i], dy = ya[i] - yb[i], dz = za[i] - zb[i];
+			sum += dx * dx + dy * dy + dz * dz;
+		}
+		return n > 0u ? std::sqrt(sum / n) : 0.0;
+	}
+
+	double drmsd(double const* da, double const* db, std::size_t const pairs, std::size_t const atoms)
+	{
+		double sum(0.0);
+		for (std::size_t p = 0u; p < pairs; ++p) sum += (da[p] - db[p]) * (da[p] - db[p]);
+		// same normalization as align::drmsd_calc
+		return std::sqrt(sum / static_cast<double>(atoms * (atoms + 1u)));
+	}
+
+	double holm_sander(double const* da, double const* db, std::size_t const pairs, double const r0)
+	{
+		double const f = 1.0 / (4.0 * r0 * r0);
+		double sum(0.0);
+		for (std::size_t p = 0u; p < pairs; ++p)
+		{
+			double const s = da[p] + db[p];
+			sum += std::abs(db[p] - da[p]) * std::exp(-s * s * f) / s;
+		}
+		return sum;
+	}
+
+	/**calculates the distances between the frames of rows and columns tile by tile
+	and hands every tile to the sink (one thread at a time): sink(r0, r1, c0, c1, block) for the frames [r0, r1) and [c0, c1),
+	numbered from row_offset and column_offset, block holds the (r1 - r0) * (c1 - c0) distances row by row.
+	If rows and columns are the same block, only its upper triangle of tiles is calculated (r0 <= c0),
+	otherwise all tiles of rows times columns.*/
+	template<class Sink>
+	void for_each_tile(align::frame_block const& rows, std::size_t const row_offset, align::frame_block const& columns,
+		std::size_t const column_offset, align::distance_matrix_options const& options, Sink&& sink)
+	{
+		if (options.dist_unit > 2u) throw std::logic_error("Unknown distance measure for the distance matrix.");
+		if (rows.atoms() != columns.atoms()) throw std::logic_error("Number of atoms of the frame blocks do not match.");
+		bool const same = &rows == &columns;
+		auto const n_rows = rows.size(), n_columns = columns.size(), atoms = rows.atoms();
+		bool const by_distances = options.dist_unit != 0u;
+		std::size_t const pairs = atoms * (atoms > 0u ? atoms - 1u : 0u) / 2u;
+		auto tile = std::max<std::size_t>(options.tile, 1u);
+		// the atom pair distances of two tiles are kept, at most 2^21 doubles each
+		if (by_distances) tile = std::max<std::size_t>(1u, std::min(tile, (std::size_t(1u) << 21) / std::max<std::size_t>(pairs, 1u)));
+		std::size_t const row_tiles = (n_rows + tile - 1u) / tile, column_tiles = (n_columns + tile - 1u) / tile;
+		std::vector<std::pair<std::size_t, std::size_t>> tile_pairs;
+		for (std::size_t i = 0u; i < row_tiles; ++i)
+		{
+			for (std::size_t j = same ? i : 0u; j < column_tiles; ++j) tile_pairs.emplace_back(i, j);
+		}
+		auto const n_tile_pairs = static_cast<std::ptrdiff_t>(tile_pairs.size());
+#pragma omp parallel
+		{
+			std::vector<double> block, row_distances, column_distances;
+#pragma omp for schedule(dynamic)
+			for (std::ptrdiff_t t = 0; t < n_tile_pairs; ++t)
+			{
+				auto const r0 = tile_pairs[t].first * tile, r1 = std::min(n_rows, r0 + tile);
+				auto const c0 = tile_pairs[t].second * tile, c1 = std::min(n_columns, c0 + tile);
+				auto const width = c1 - c0;
+				// the diagonal tiles are symmetric
+				bool const diagonal = same && r0 == c0;
+				block.assign((r1 - r0) * width, 0.0);
+				if (by_distances)
+				{
+					row_distances.resize((r1 - r0) * pairs);
+					column_distances.resize(width * pairs);
+					for (auto i = r0; i < r1; ++i) pair_distances(rows, i, row_distances.data() + (i - r0) * pairs);
+					for (auto j = c0; j < c1; ++j) pair_distances(columns, j, column_distances.data() + (j - c0) * pairs);
+				}
+				for (auto i = r0; i < r1; ++i)
+				{
+					for (auto j = diagonal ? i + 1u : c0; j < c1; ++j)
+					{
+						double d(0.0);
+						if (!by_distances)
+						{
+							d = options.superpose ? align::qcp_rmsd(rows, i, columns, j) : plain_rmsd(rows, i, columns, j);
+						}
+						else
+						{
+							auto const da = row_distances.data() + (i - r0) * pairs, db = column_distances.data() + (j - c0) * pairs;
+							d = options.dist_unit == 1u ? drmsd(da, db, pairs, atoms) : holm_sander(da, db, pairs, options.holm_sand_r0);
+						}
+						block[(i - r0) * width + j - c0] = d;
+						if (diagonal) block[(j - c0) * width + i - r0] = d;
+					}
+				}
+#pragma omp critical (align_distance_matrix_sink)
+				sink(row_offset + r0, row_offset + r1, column_offset + c0, column_offset + c1, block);
+			}
+		}
+	}
+
+	std::size_t condensed_index(std::size_t const n, std::size_t const i, std::size_t const j)
+	{
+		return i * n - i * (i + 1u) / 2u + j - i - 1u;
+	}
+
+	/**writes the header of the binary distance matrix (see align::write_distance_matrix)
+	and then every tile of the upper triangle at its position, the full matrix gets the transposed tile as well*/
+	class tile_writer
+	{
+	public:
+		tile_writer(std::size_t const frames, bool const condensed, std::ostream& out)
+			: n(frames), condensed(condensed), out(out), data(), transposed()
+		{
+			std::uint64_t const header[2] = { static_cast<std::uint64_t>(n), condensed ? 1u : 0u };
+			auto const start = out.tellp();
+			out.write(reinterpret_cast<char const*>(header), sizeof(header));
+			data = start + static_cast<std::streamoff>(sizeof(header));
+		}
+
+		void operator() (std::size_t const r0, std::size_t const r1, std::size_t const c0, std::size_t const c1,
+			std::vector<double> const& block)
+		{
+			auto const columns = c1 - c0;
+			for (auto i = r0; i < r1; ++i)
+			{
+				auto const row = block.data() + (i - r0) * columns;
+				if (condensed)
+				{
+					auto const j0 = std::max(c0, i + 1u);
+					if (j0 < c1) put(condensed_index(n, i, j0), row + j0 - c0, c1 - j0);
+				}
+				else put(i * n + c0, row, columns);
+			}
+			// lower triangle of the full matrix
+			if (!condensed && r0 != c0)
+			{
+				transposed.resize(r1 - r0);
+				for (auto j = c0; j < c1; ++j)
+				{
+					for (auto i = r0; i < r1; ++i) transposed[i - r0] = block[(i - r0) * columns + j - c0];
+					put(j * n + r0, transposed.data(), r1 - r0);
+				}
+			}
+		}
+
+		/**moves behind the matrix*/
+		void finish()
+		{
+			out.seekp(data + static_cast<std::streamoff>((condensed ? n * (n > 0u ? n - 1u : 0u) / 2u : n * n) * sizeof(double)));
+			if (!out) throw std::runtime_error("Writing the distance matrix failed.");
+		}
+
+	private:
+		void put(std::size_t const offset, double const* values, std::size_t const count)
+		{
+			if (count == 0u) return;
+			out.seekp(data + static_cast<std::streamoff>(offset * sizeof(double)));
+			out.write(reinterpret_cast<char const*>(values), static_cast<std::streamsize>(count * sizeof(double)));
+		}
+
+		std::size_t n;
+		bool condensed;
+		std::ostream& out;
+		std::streampos data;
+		std::vector<double> transposed;
+	};
+
+	void fill(align::frame_block& block, coords::input::frame_chunk const& chunk)
+	{
+		block.clear();
+		for (auto const& xyz : chunk.xyz) block.push_back(xyz);
+	}
+}
+
+double align::qcp_rmsd(frame_block const& block_a, std::size_t const a, frame_block const& block_b, std::size_t const b,
+	std::array<double, 9>* rotation)
+{
+	auto const n = block_a.atoms();
+	if (block_b.atoms() != n) throw std::logic_error("Number of atoms of structures passed to qcp_rmsd do not match.");
+	auto const xa = block_a.x(a), ya = block_a.y(a), za = block_a.z(a);
+	auto const xb = block_b.x(b), yb = block_b.y(b), zb = block_b.z(b);
+	// correlation matrix of the two frames
+	double s[9] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	for (std::size_t i = 0u; i < n; ++i)
+	{
+		s[0] += xa[i] * xb[i];
+		s[1] += xa[i] * yb[i];
+		s[2] += xa[i] * zb[i];
+		s[3] += ya[i] * xb[i];
+		s[4] += ya[i] * yb[i];
+		s[5] += ya[i] * zb[i];
+		s[6] += za[i] * xb[i];
+		s[7] += za[i] * yb[i];
+		s[8] += za[i] * zb[i];
+	}
+	double const e0 = 0.5 * (block_a.squares(a) + block_b.squares(b));
+	double const lambda = qcp_eigenvalue(s, e0, rotation);
+	return n > 0u ? std::sqrt(std::abs(2.0 * (e0 - lambda) / n)) : 0.0;
+}
+
+std::vector<double> align::condensed_distance_matrix(frame_block const& frames, distance_matrix_options const& options)
+{
+	auto const n = frames.size();
+	std::vector<double> ret(n > 1u ? n * (n - 1u) / 2u : 0u);
+	for_each_tile(frames, 0u, frames, 0u, options, [&](std::size_t const r0, std::size_t const r1, std::size_t const c0, std::size_t const c1,
+		std::vector<double> const& block)
+	{
+		for (auto i = r0; i < r1; ++i)
+		{
+			for (auto j = std::max(c0, i + 1u); j < c1; ++j) ret[condensed_index(n, i, j)] = block[(i - r0) * (c1 - c0) + j - c0];
+		}
+	});
+	return ret;
+}
+
+void align::write_distance_matrix(frame_block const& frames, distance_matrix_options const& options,
+	bool const condensed, std::ostream& out)
+{
+	tile_writer writer(frames.size(), condensed, out);
+	for_each_tile(frames, 0u, frames, 0u, options, writer);
+	writer.finish();
+}
+
+void align::write_distance_matrix(coords::input::format& input, bool const center, distance_matrix_options const& options,
+	bool const condensed, std::ostream& out, std::size_t const chunk_size)
+{
+	auto const n = input.frames();
+	tile_writer writer(n, condensed, out);
+	frame_block rows(n > 0u ? input.frame(0u).size() : 0u, center), columns(rows);
+	coords::input::frame_chunk chunk;
+	for (std::size_t first = 0u; first < n;)
+	{
+		// the first chunk of every pass holds the rows, the following chunks the columns behind them
+		coords::input::frame_chunks pass(input, first, 1u, static_cast<std::size_t>(-1), chunk_size);
+		pass.next(chunk);
+		fill(rows, chunk);
+		for_each_tile(rows, first, rows, first, options, writer);
+		auto column = first + rows.size();
+		while (pass.next(chunk))
+		{
+			fill(columns, chunk);
+			for_each_tile(rows, first, columns, column, options, writer);
+			column += columns.size();
+		}
+		first += rows.size();
+	}
+	writer.finish();
+}
@@ -0,0 +1,97 @@
+/**
+CAST 3
+alignment_matrix.h
+Purpose:
+Pairwise distances (RMSD, dRMSD, Holm & Sander) between all frames of a trajectory.
+The frames are packed into one block (structure of arrays) and centered once.
+Optimal superpositions use the quaternion characteristic polynomial
+(Theobald, Acta Cryst. A 61, 478 (2005); Liu et al., J. Comput. Chem. 31, 1561 (2010)),
+which gives the minimum RMSD of the Kabsch rotation without a singular value decomposition.
+Only the upper triangle is calculated, in tiles of frames which are distributed over the OpenMP threads.
+The matrix of a trajectory is calculated out of core: only two chunks of frames are held in memory.
+
+@version 1.0
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+#include "coords_rep.h"
+
+namespace coords
+{
+	namespace input
+	{
+		class format;
+	}
+}
+
+namespace align
+{
+	/**frames with the same number of atoms, packed as structure of arrays:
+	the x, y and z coordinates of frame f are x(f)[0, atoms()) etc.*/
+	class frame_block
+	{
+	public:
+		/**@param center: move the center of geometry of every frame to the origin*/
+		frame_block(std::size_t const atoms, bool const center = true);
+		void push_back(coords::Representation_3D const& xyz);
+		void reserve(std::size_t const frames);
+		/**removes all frames (the memory is kept for the next ones)*/
+		void clear();
+		std::size_t size() const { return m_squares.size(); }
+		std::size_t atoms() const { return m_atoms; }
+		double const* x(std::size_t const f) const { return m_x.data() + f * m_atoms; }
+		double const* y(std::size_t const f) const { return m_y.data() + f * m_atoms; }
+		double const* z(std::size_t const f) const { return m_z.data() + f * m_atoms; }
+		/**sum of the squared coordinates of frame f*/
+		double squares(std::size_t const f) const { return m_squares[f]; }
+	private:
+		std::size_t m_atoms;
+		bool m_center;
+		std::vector<double> m_x, m_y, m_z, m_squares;
+	};
+
+	/**minimum RMSD between frame a of block_a and frame b of block_b (both centered)
+	@param rotation: if given, set to the rotation matrix (row-major) which superposes frame b onto frame a*/
+	double qcp_rmsd(frame_block const& block_a, std::size_t const a, frame_block const& block_b, std::size_t const b,
+		std::array<double, 9>* rotation = nullptr);
+
+	/**distance measure and layout of the matrix*/
+	struct distance_matrix_options
+	{
+		/**0: RMSD, 1: dRMSD, 2: Holm & Sander (as Config::get().alignment.dist_unit)*/
+		std::size_t dist_unit;
+		/**RMSD after optimal superposition (otherwise of the given positions)*/
+		bool superpose;
+		/**contact cutoff of the Holm & Sander score*/
+		double holm_sand_r0;
+		/**frames per tile (smaller for dRMSD and Holm & Sander if the atom pair distances do not fit into memory)*/
+		std::size_t tile;
+		distance_matrix_options() : dist_unit(0u), superpose(true), holm_sand_r0(20.0), tile(64u) {}
+	};
+
+	/**distances of all pairs i < j of frames as condensed upper triangle:
+	element (i, j) is at i * n - i * (i + 1) / 2 + j - i - 1 for n frames*/
+	std::vector<double> condensed_distance_matrix(frame_block const& frames, distance_matrix_options const& options);
+
+	/**writes the distance matrix in binary form:
+	number of frames and layout (0: full n * n matrix, 1: condensed upper triangle) as 64 bit unsigned integers,
+	followed by the distances as 64 bit doubles in row-major order.
+	The tiles are written as soon as they are calculated, the matrix is never held in memory as a whole.
+	@param out: binary file stream (the tiles are written at positions behind the current end of the file)*/
+	void write_distance_matrix(frame_block const& frames, distance_matrix_options const& options,
+		bool const condensed, std::ostream& out);
+
+	/**writes the distance matrix of all frames of the input in the same form, out of core:
+	the frames are read with coords::input::frame_chunks, one chunk of rows and one chunk of columns are kept.
+	For every chunk of rows, the chunks of columns behind it are read again.
+	@param center: as for frame_block
+	@param chunk_size: frames per chunk (as for coords::input::frame_chunks)*/
+	void write_distance_matrix(coords::input::format& input, bool const center, distance_matrix_options const& options,
+		bool const condensed, std::ostream& out, std::size_t const chunk_size = 0u);
+}
@@ -409,6 +409,13 @@ void config::parse_option(std::string const option, std::string const value_stri
 	else if (option == "inputtype")
 		Config::set().general.input = enum_from_string<input_types::T, NUM_INPUT>(input_strings, value_string);
 
+	// Read trajectories in chunks of this many frames instead of loading them completely
+	// Default: 0 (load all frames)
+	else if (option == "stream_chunk")
+	{
+		cv >> Config::set().general.stream_chunk;
+	}
+
 	/////////////////////
 	//// Config::energy
 	////////////////////
@@ -428,6 +435,63 @@ void config::parse_option(std::string const option, std::string const value_stri
 		cv >> Config::set().energy.switchdist;
 	}
 
+	// Skin distance of the Verlet neighbor list (pairs are only rebuilt
+	// if an atom moved more than half of the skin)
+	// {AMBER, OPLSAA, CHARMM}
+	// Default: 0 (no Verlet list)
+	else if (option == "verlet_skin")
+	{
+		cv >> Config::set().energy.verlet_skin;
+	}
+
+	// Use the vectorized structure-of-arrays kernel for non-bonded interactions
+	// {AMBER, OPLSAA, CHARMM}
+	// Default: 0 (with several threads the sums are not bit-identical to the scalar kernel)
+	else if (option == "nonbonded_soa")
+	{
+		Config::set().energy.nb_soa = bool_from_iss(cv);
+	}
+
+	// Internal order of atoms in the structure-of-arrays kernel:
+	// 0 = input order, 1 = Morton curve, 2 = Hilbert curve
+	// (atoms are re-sorted whenever the pairlist is rebuilt)
+	// {AMBER, OPLSAA, CHARMM}
+	// Default: 0
+	else if (option == "nonbonded_order")
+	{
+		Config::set().energy.nb_order = enum_from_iss<config::energy::nb_orders::T>(cv);
+	}
+
+	// Particle-mesh Ewald for electrostatics (needs periodic boundaries,
+	// real-space part is calculated up to the cutoff)
+	// {AMBER, OPLSAA, CHARMM}
+	// Default: 0
+	else if (option == "pme")
+	{
+		Config::set().energy.pme.on = bool_from_iss(cv);
+	}
+
+	// Maximum distance between PME grid points (in angstrom)
+	// Default: 1.0
+	else if (option == "pme_spacing")
+	{
+		cv >> Config::set().energy.pme.spacing;
+	}
+
+	// Order of the B-splines for PME charge spreading
+	// Default: 4
+	else if (option == "pme_order")
+	{
+		cv >> Config::set().energy.pme.order;
+	}
+
+	// Relative size of real-space coulomb interaction at cutoff (determines Ewald coefficient)
+	// Default: 1e-5
+	else if (option == "ewald_tolerance")
+	{
+		cv >> Config::set().energy.pme.tolerance;
+	}
+
 	else if (option == "xyz_atomtypes")
 	{
 		Config::set().stuff.xyz_atomtypes = bool_from_iss(cv);
@@ -680,6 +744,21 @@ void config::parse_option(std::string const option, std::string const value_stri
 			cv >> Config::set().neb.CONN;
 	}
 
+	// Persistent QM driver options
+	else if (option.substr(0, 8) == "QMWORKER")
+	{
+		if (option.substr(8, 6) == "driver")
+			Config::set().energy.qm_worker.driver = value_string;
+		else if (option.substr(8, 7) == "timeout")
+			cv >> Config::set().energy.qm_worker.timeout;
+		else if (option.substr(8, 8) == "restarts")
+			cv >> Config::set().energy.qm_worker.restarts;
+		else if (option.substr(8, 4) == "jobs")
+			cv >> Config::set().energy.qm_worker.jobs;
+		else if (option.substr(8, 8) == "geometry")
+			Config::set().energy.qm_worker.geometry = bool_from_iss(cv);
+	}
+
 	// MOPAC options
 	else if (option.substr(0, 5) == "MOPAC")
 	{
@@ -1001,6 +1080,11 @@ void config::parse_option(std::string const option, std::string const value_stri
 	else if (option == "BFGStrace")
 		Config::set().optimization.local.bfgs.trace = bool_from_iss(cv);
 
+	// optimize in double precision instead of float?
+	// Default: 0
+	else if (option == "BFGSdouble")
+		Config::set().optimization.local.bfgs.double_precision = bool_from_iss(cv);
+
 	//! STARTOPT
 	else if (option == "SOtype")
 	{
@@ -1112,6 +1196,26 @@ void config::parse_option(std::string const option, std::string const value_stri
 		{
 			cv >> Config::set().md.max_snap_buffer;
 		}
+		// Write snapshots into compressed binary trajectory
+		else if (option.substr(2, 11) == "snap_binary")
+		{
+			Config::set().md.binary_snapshots = bool_from_iss(cv);
+		}
+		// Precision of the binary snapshots (1000 -> 0.001 Angstrom)
+		else if (option.substr(2, 14) == "snap_precision")
+		{
+			cv >> Config::set().md.snap_precision;
+		}
+		// Optimize and write snapshots in background threads
+		else if (option.substr(2, 10) == "snap_async")
+		{
+			Config::set().md.async_snapshots = bool_from_iss(cv);
+		}
+		// Number of threads optimizing snapshots in the background
+		else if (option.substr(2, 12) == "snap_threads")
+		{
+			cv >> Config::set().md.snap_threads;
+		}
 		else if (option.substr(2, 5) == "snap")
 		{
 			cv >> Config::set().md.num_snapShots;
@@ -1372,6 +1476,16 @@ void config::parse_option(std::string const option, std::string const value_stri
 			cv >> a;
 			if (a == "1") Config::set().fep.bar = true;
 		}
+		// number of FEP windows simulated at the same time
+		else if (option.substr(3, 10) == "concurrent")
+		{
+			cv >> Config::set().fep.concurrent;
+		}
+		// production steps between replica exchanges of concurrent windows
+		else if (option.substr(3, 8) == "exchange")
+		{
+			cv >> Config::set().fep.exchange;
+		}
 	}
 
 	else if (option.substr(0, 5) == "COORD")
@@ -1799,6 +1913,11 @@ void config::parse_option(std::string const option, std::string const value_stri
 	{
 		cv >> Config::set().alignment.align_external_file;
 	}
+	// Matrix of the distances between all frames (0: none, 1: full, 2: condensed)
+	else if (option == "distance_matrix")
+	{
+		cv >> Config::set().alignment.distance_matrix;
+	}
 	else if (option == "traj_align_translational")
 	{
 		std::string holder;
@@ -2119,6 +2238,12 @@ void config::parse_option(std::string const option, std::string const value_stri
 			Config::set().entropy.knnnorm = 1;
 		}
 	}
+	// File in which the joint entropies of the mutual information expansion are
+	// saved as soon as they are calculated; an aborted run resumes from it
+	else if (option == "entropy_mi_checkpoint")
+	{
+		cv >> Config::set().entropy.entropy_mi_checkpoint;
+	}
 	else if (option == "entropy_remove_dof")
 	{
 		std::string holder;
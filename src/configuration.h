@@ -101,11 +101,11 @@ namespace config
   };
 
 	/** number of Input Types */
-	static std::size_t const NUM_INPUT = 4;
+	static std::size_t const NUM_INPUT = 5;
 	/** Input Types */
 	static std::string const input_strings[NUM_INPUT] =
 	{
-		"TINKER", "AMBER", "XYZ", "PDB"
+		"TINKER", "AMBER", "XYZ", "PDB", "CTRJ"
 	};
 
 	/*! contains enum with all input_types currently supported in CAST
@@ -119,7 +119,7 @@ namespace config
 		enum T
 		{
 			ILLEGAL = -1,
-			TINKER, AMBER, XYZ, PDB
+			TINKER, AMBER, XYZ, PDB, CTRJ
 		};
 	};
 
@@ -258,6 +258,9 @@ namespace config
 		std::size_t verbosity;
 		/**are amber charges read from a seperate file?*/
 		bool chargefile;
+		/**if > 0 trajectories are not loaded completely but read in chunks of this many frames
+		(TINKER, XYZ and CTRJ input, see coords_io_stream.h)*/
+		std::size_t stream_chunk;
 
 		/// Constructor with reasonable default parameters
 		general(void) :
@@ -265,7 +268,7 @@ namespace config
 			input(input_types::TINKER), output(output_types::TINKER),
 			task(config::tasks::SP), energy_interface(interface_types::OPLSAA),
 			preopt_interface(interface_types::ILLEGAL),
-			verbosity(1U), chargefile(false)
+			verbosity(1U), chargefile(false), stream_chunk(0U)
 		{ }
 	};
 
@@ -624,11 +627,22 @@ namespace config
 		double cutoff;
 		/**radius to start switching function to kick in; scales interactions smoothly to zero at cutoff radius*/
 		double switchdist;
+		/**skin distance of the Verlet neighbor list in forcefield interfaces: pairs are collected up to cutoff + skin
+		and only rebuilt if an atom moved more than half the skin since the last build (0 = rebuild on every update)*/
+		double verlet_skin;
 
 		/**???*/
 		bool isotropic;
 		/**???*/
 		bool remove_fixed;
+		/**use the vectorized structure-of-arrays kernel for non-bonded interactions in AMBER, OPLSAA and CHARMM
+		(FEP calculations always use the scalar path)*/
+		bool nb_soa;
+		/**internal order of the atoms in the structure-of-arrays kernel*/
+		struct nb_orders { enum T { INPUT, MORTON, HILBERT }; };
+		/**atoms of the structure-of-arrays kernel are sorted along a space-filling curve (MORTON or HILBERT)
+		whenever the pairlist is rebuilt, INPUT keeps the order of the input file*/
+		nb_orders::T nb_order;
 
 		/**struct for spackman correction*/
 		struct spack
@@ -638,6 +652,20 @@ namespace config
 			spack(void) : cut(10.0), on(false), interp(true) { }
 		} spackman;
 
+		/**struct for particle-mesh Ewald electrostatics in forcefield interfaces (needs periodic boundaries)*/
+		struct pme_conf
+		{
+			/**use particle-mesh Ewald*/
+			bool on;
+			/**maximum distance between grid points in angstrom (number of grid points is rounded up to a power of two)*/
+			double spacing;
+			/**order of the B-splines used to spread the charges (4 = cubic)*/
+			std::size_t order;
+			/**erfc(alpha*cutoff) of the real-space part, determines the Ewald coefficient alpha*/
+			double tolerance;
+			pme_conf(void) : on(false), spacing(1.0), order(4u), tolerance(1e-5) { }
+		} pme;
+
 		/**struct that contains information necessary for QM/MM calculation (also with ONIOM and THREE_LAYER)*/
 		struct qmmm_conf
 		{
@@ -939,12 +967,26 @@ namespace config
 			std::string threads = "";
 		}psi4;
 
+		/**persistent driver process for the external QM programs (see qm_worker.h)*/
+		struct qm_worker_conf {
+			/**command starting the driver (empty: QM programs are started for every call)*/
+			std::string driver = "";
+			/**maximum time of one call in seconds before the driver is restarted (0: no limit)*/
+			double timeout = 0.0;
+			/**restarts of the driver per call before the call fails*/
+			std::size_t restarts = 3u;
+			/**number of concurrent jobs for batches of structures, e.g. NEB images (see qm_job_pool.h)*/
+			std::size_t jobs = 1u;
+			/**send the structures to the driver instead of input files (GEOMETRY message, DFTB+)*/
+			bool geometry = false;
+		} qm_worker;
+
 		/**default constructor for struct energy*/
 		energy() :
 			cutoff(std::numeric_limits<double>::max()), switchdist(cutoff - 4.0),
-			isotropic(true),
-			remove_fixed(false),
-			spackman(), mopac()
+			verlet_skin(0.0), isotropic(true),
+			remove_fixed(false), nb_soa(false), nb_order(nb_orders::INPUT),
+			spackman(), pme(), mopac()
 		{ }
 	};
 
@@ -1085,6 +1127,10 @@ namespace config
 		std::size_t num_snapShots;
 		/**number of snapshots in memory before written to file*/
 		std::size_t max_snap_buffer;
+		/**snapshots are stored as integers of x * snap_precision in binary snapshot files*/
+		double snap_precision;
+		/**number of threads optimizing snapshots in the background*/
+		std::size_t snap_threads;
 		/**after this number of steps the list of non-bonded interactions is generated new*/
 		std::size_t refine_offset;
 		/**after this number of steps a restart file is generated*/
@@ -1119,6 +1165,10 @@ namespace config
 		bool track;
 		/**perform local optimization with snapshots before they are written into file yes or no*/
 		bool optimize_snapshots;
+		/**write snapshots into a compressed binary trajectory (.ctrj) instead of the output format*/
+		bool binary_snapshots;
+		/**optimize and write snapshots in background threads yes or no*/
+		bool async_snapshots;
 		/**pressure control yes or no?*/
 		bool pressure;
 		/**use a restart file for starting MD yes or no (does currently not work)*/
@@ -1141,12 +1191,12 @@ namespace config
 			temp_control{ true }, timeStep{ 0.001 }, T_init{ 0.0 }, T_final{ 0.0 },
 			broken_restart{ 0 }, pcompress{ 0.000046 }, pdelay{ 2.0 }, ptarget{ 1.0 },
 			set_active_center{ 0 }, adjustment_by_step{ 0 }, inner_cutoff{ 0.0 }, outer_cutoff{ 0.0 },
-			active_center(), num_steps{ 10000 }, num_snapShots{ 100 }, max_snap_buffer{ 50 },
+			active_center(), num_steps{ 10000 }, num_snapShots{ 100 }, max_snap_buffer{ 50 }, snap_precision{ 1000.0 }, snap_threads{ 1 },
 			refine_offset{ 0 }, restart_offset{ 0 }, trackoffset{ 1 }, usequil{ 0 }, usoffset{ 0 },
 			heat_steps(), spherical{}, rattle{},
 			integrator(md_conf::integrators::VERLET),
 			hooverHeatBath{ false }, veloScale{ true }, fep{ false }, track{ true },
-			optimize_snapshots{ false }, pressure{ false },
+			optimize_snapshots{ false }, binary_snapshots{ false }, async_snapshots{ false }, pressure{ false },
 			resume{ false }, umbrella{ false }, pre_optimize{ false }, ana_pairs(), analyze_zones{ false },
 			zone_width{ 0.0 }, nosehoover_Q{ 0.1 }
 		{ }
@@ -1179,10 +1229,16 @@ namespace config
 		bool analyze;
 		/**use Bennets acceptance ratio?*/
 		bool bar;
+		/**number of windows which are simulated at the same time
+		(0 or 1: the windows are simulated one after another, each starting from the end of the previous one)*/
+		std::size_t concurrent;
+		/**number of production steps between exchanges of neighbouring windows if they are simulated concurrently
+		(Hamiltonian replica exchange, 0: no exchange)*/
+		std::size_t exchange;
 		/**constructor*/
 		fep(void) :
 			lambda(1.0), dlambda(0.1), vdwcouple(1.0), eleccouple(1.0), ljshift(1.0), cshift(1.0),
-			steps(10), equil(10), freq(1), analyze(true), bar(false)
+			steps(10), equil(10), freq(1), analyze(true), bar(false), concurrent(0u), exchange(0u)
 		{ }
 	};
 
@@ -1214,7 +1270,9 @@ namespace config
 			std::size_t maxstep;
 			/**should trace written into file?*/
 			bool trace;
-			lo(void) : grad(0.001), maxstep(10000), trace(false) { }
+			/**optimize in double precision on the cartesian representation instead of float copies?*/
+			bool double_precision;
+			lo(void) : grad(0.001), maxstep(10000), trace(false), double_precision(false) { }
 		};
 
 		/**struct that contains configuration options for monte-carlo*/
@@ -1508,7 +1566,9 @@ namespace config
 		bool traj_print_bool;
 		double holm_sand_r0;
 		std::string align_external_file;
-		align(void) : dist_unit(0), reference_frame_num(0), traj_align_translational(true), traj_align_rotational(true), traj_print_bool(true), holm_sand_r0(20), align_external_file()
+		/**matrix of the distances (dist_unit) between all frames: 0 = none, 1 = full, 2 = condensed upper triangle*/
+		size_t distance_matrix;
+		align(void) : dist_unit(0), reference_frame_num(0), traj_align_translational(true), traj_align_rotational(true), traj_print_bool(true), holm_sand_r0(20), align_external_file(), distance_matrix(0)
 		{}
 	};
 
@@ -1566,9 +1626,11 @@ namespace config
 		int knnnorm;
 		std::vector<size_t> entropy_internal_dih;
 		std::vector<size_t> entropy_trunc_atoms_num;
+		/**checkpoint file of the joint entropies of the mutual information expansion (empty = no checkpointing)*/
+		std::string entropy_mi_checkpoint;
 		entropy(void) : entropy_alignment(true), entropy_temp(300), entropy_ref_frame_num(0), entropy_start_frame_num(0), entropy_method(1, 6u),
 			entropy_method_knn_k(4), entropy_remove_dof(true), entropy_use_internal(false), entropy_trunc_atoms_bool(false), entropy_offset(1),
-			knnfunc(2), knnnorm(0), entropy_internal_dih(), entropy_trunc_atoms_num()
+			knnfunc(2), knnnorm(0), entropy_internal_dih(), entropy_trunc_atoms_num(), entropy_mi_checkpoint()
 		{}
 	};
 
@@ -4,6 +4,9 @@
 #include "coords.h"
 #include "configuration.h"
 #include "coords_io.h"
+#include "coords_cells.h"
+#include "coords_io_trajectory.h"
+#include "coords_snapshot_pipeline.h"
 #include "lbfgs.h"
 
 //REMOVE IT!!!!
@@ -315,45 +318,69 @@ coords::float_type coords::Coordinates::lbfgs()
 {
   using namespace  optimization::local;
   typedef coords::Container<scon::c3<float>> nc3_type;
-  // Create optimizer
-  auto optimizer = make_lbfgs(
-    make_more_thuente(Coords_3d_float_callback(*this)));
-  optimizer.ls.config.ignore_callback_stop = true;
-  // Create Point
-  using op_type = decltype(optimizer);
-  op_type::point_type x(nc3_type(xyz().begin(), xyz().end()));
-  // Optimize point
-  optimizer.config.max_iterations =
-    Config::get().optimization.local.bfgs.maxstep;
-  optimizer.config.epsilon =
-    (float)Config::get().optimization.local.bfgs.grad;
-  optimizer(x);  // perform optimization
-  m_representation.structure.cartesian =   // get optimized structure into coordobj
-    coords::Representation_3D(optimizer.p().x.begin(), optimizer.p().x.end());
+  status state;
+  std::size_t evaluations;
+  if (Config::get().optimization.local.bfgs.double_precision)
+  {
+    // double precision on the representation itself
+    auto optimizer = make_flat_lbfgs(
+      make_more_thuente(Coords_3d_callback(*this)));
+    optimizer.ls.config.ignore_callback_stop = true;
+    using op_type = decltype(optimizer);
+    op_type::point_type x(xyz());
+    optimizer.config.max_iterations =
+      Config::get().optimization.local.bfgs.maxstep;
+    optimizer.config.epsilon =
+      Config::get().optimization.local.bfgs.grad;
+    optimizer(x);
+    m_representation.structure.cartesian = std::move(optimizer.p().x);
+    state = optimizer.state();
+    evaluations = optimizer.iter();
+  }
+  else
+  {
+    // Create optimizer
+    auto optimizer = make_lbfgs(
+      make_more_thuente(Coords_3d_float_callback(*this)));
+    optimizer.ls.config.ignore_callback_stop = true;
+    // Create Point
+    using op_type = decltype(optimizer);
+    op_type::point_type x(nc3_type(xyz().begin(), xyz().end()));
+    // Optimize point
+    optimizer.config.max_iterations =
+      Config::get().optimization.local.bfgs.maxstep;
+    optimizer.config.epsilon =
+      (float)Config::get().optimization.local.bfgs.grad;
+    optimizer(x);  // perform optimization
+    m_representation.structure.cartesian =   // get optimized structure into coordobj
+      coords::Representation_3D(optimizer.p().x.begin(), optimizer.p().x.end());
+    state = optimizer.state();
+    evaluations = optimizer.iter();
+  }
   // calculate energy and gradients (numerical difference to the one from lbfgs)
   m_representation.energy = g();  
   m_representation.gradient.cartesian = g_xyz();
   // Output
   if (Config::get().general.verbosity >= 4 ||
-    (optimizer.state() < 0 && Config::get().general.verbosity >= 1))
+    (state < 0 && Config::get().general.verbosity >= 1))
   {
     std::cout << "Energy calculated from energy interface = " << m_representation.energy << "\n";
-    std::cout << "Optimization done (status " << optimizer.state();
-    if (optimizer.state() < 0)
+    std::cout << "Optimization done (status " << state;
+    if (state < 0)
     {
-      if (optimizer.state() == -100)
+      if (state == -100)
         std::cout << " ERROR: INVALID STEPSIZE.";
-      else if (optimizer.state() == -99)
+      else if (state == -99)
         std::cout << " ERROR: GRADIENT INCREASED.";
-      else if (optimizer.state() == -98)
+      else if (state == -98)
         std::cout << " ERROR: CALLBACK STOP.";
-      else if (optimizer.state() == -97)
+      else if (state == -97)
         std::cout << " ERROR: ROUNDING ERRORS TOO LARGE AND ACCUMULATING. ABORTING.";
-      else if (optimizer.state() == -96)
+      else if (state == -96)
         std::cout << " ERROR: MAXIMUM STEPSIZE EXCEEDED.";
-      else if (optimizer.state() == -95)
+      else if (state == -95)
         std::cout << " ERROR: MINIMUM STEPSIZE NOT REACHED.";
-      else if (optimizer.state() == -94)
+      else if (state == -94)
         std::cout << " ERROR: WIDTH TOO SMALL.";
       else 
         std::cout << " ERROR: MAXIMUM ITERATIONS REACHED.";
@@ -362,7 +389,7 @@ coords::float_type coords::Coordinates::lbfgs()
     {
       std::cout << " SUCCESS!";
     }
-    std::cout << "). Evaluations:" << optimizer.iter() << '\n';
+    std::cout << "). Evaluations:" << evaluations << '\n';
   }
   if (Config::get().general.verbosity >= 4 && integrity())
   {
@@ -378,25 +405,44 @@ double coords::Coordinates::prelbfgs()
 {
 	using namespace  optimization::local;
 	typedef coords::Container<scon::c3<float>> nc3_type;
-	// Create optimizer
-	auto optimizer = make_lbfgs(
-		make_more_thuente(Coords_3d_float_pre_callback(*this))
-	);
-	// Create Point
-	using op_type = decltype(optimizer);
-	op_type::point_type x(nc3_type(xyz().begin(), xyz().end()));
-	// Optimize point
-	optimizer(x);
-	// get optimized structure
-	m_representation.structure.cartesian =
-		coords::Representation_3D(optimizer.p().x.begin(), optimizer.p().x.end());
+	status state;
+	std::size_t evaluations;
+	if (Config::get().optimization.local.bfgs.double_precision)
+	{
+		auto optimizer = make_flat_lbfgs(
+			make_more_thuente(Coords_3d_pre_callback(*this))
+		);
+		using op_type = decltype(optimizer);
+		op_type::point_type x(xyz());
+		optimizer(x);
+		m_representation.structure.cartesian = std::move(optimizer.p().x);
+		state = optimizer.state();
+		evaluations = optimizer.iter();
+	}
+	else
+	{
+		// Create optimizer
+		auto optimizer = make_lbfgs(
+			make_more_thuente(Coords_3d_float_pre_callback(*this))
+		);
+		// Create Point
+		using op_type = decltype(optimizer);
+		op_type::point_type x(nc3_type(xyz().begin(), xyz().end()));
+		// Optimize point
+		optimizer(x);
+		// get optimized structure
+		m_representation.structure.cartesian =
+			coords::Representation_3D(optimizer.p().x.begin(), optimizer.p().x.end());
+		state = optimizer.state();
+		evaluations = optimizer.iter();
+	}
 	// calculate energy and gradients (numerical difference to the one from lbfgs)
 	m_representation.energy = g();
 	m_representation.gradient.cartesian = g_xyz();
 	if (Config::get().general.verbosity >= 4)
 	{
-		std::cout << "Optimization done (status " << optimizer.state() <<
-			"). Evaluations:" << optimizer.iter() << '\n';
+		std::cout << "Optimization done (status " << state <<
+			"). Evaluations:" << evaluations << '\n';
 	}
 	return m_representation.energy;
 }
@@ -439,14 +485,12 @@ bool coords::Coordinates::check_structure()
 
 bool coords::Coordinates::check_for_crashes() const
 {
-	for (auto i = 0u; i < this->size(); ++i)
+	std::vector<double> radii;
+	radii.reserve(size());
+	for (std::size_t i = 0; i < size(); ++i) radii.push_back(atoms(i).cov_radius());
+	for (auto const& pair : covalent_pairs(xyz(), radii))
 	{
-		for (auto j = 0u; j < i; j++)
-		{
-			auto distance = dist(xyz(i), xyz(j));
-			auto bonding_distance = 1.2 * (atoms(i).cov_radius() + atoms(j).cov_radius());
-			if (distance < bonding_distance && atoms(i).is_bound_to(j) == false) return false;
-		}
+		if (atoms(pair.first).is_bound_to(pair.second) == false) return false;
 	}
 	return true;
 }
@@ -1197,7 +1241,12 @@ coords::float_type coords::Main_Callback::operator() (coords::Gradients_Main con
 
 void coords::cartesian_logfile_drain::operator() (coords::Representation_3D&& xyz)
 {
-	if (!cp || !strm) return;
+	if (async)
+	{
+		async->push(std::move(xyz));
+		return;
+	}
+	if (!cp || (!strm && !traj)) return;
 	// Save current state
 	auto const tmp = (*cp).xyz();
 	// plug snapshot into coords
@@ -1205,15 +1254,45 @@ void coords::cartesian_logfile_drain::operator() (coords::Representation_3D&& xy
 	// optimize snapshot
 	if (opt) { (*cp).o(); }
 	// Print to stream
-	*strm << *cp;
+	if (traj) traj->write((*cp).xyz());
+	else *strm << *cp;
 	// reset state
 	(*cp).set_xyz(std::move(tmp));
 }
 
+void coords::cartesian_logfile_drain::wait()
+{
+	if (async) async->wait();
+}
+
 coords::offset_buffered_cartesian_logfile coords::make_buffered_cartesian_log(Coordinates& c,
 	std::string file_suffix, std::size_t buffer_size,
-	std::size_t log_offset, bool optimize)
+	std::size_t log_offset, bool optimize, double trajectory_precision, bool append,
+	bool asynchronous, std::size_t optimizer_threads)
 {
+	std::shared_ptr<trajectory::writer> traj;
+	if (trajectory_precision > 0.0)
+	{
+		// appending needs the file of the previous run, not a new unique name
+		auto const file = append ?
+			Config::get().general.outputFilename + file_suffix + trajectory::extension :
+			output::filename(file_suffix, trajectory::extension);
+		traj = std::make_shared<trajectory::writer>(file, c.atoms(), trajectory_precision, append);
+	}
+	if (asynchronous)
+	{
+		std::unique_ptr<std::ofstream> text;
+		if (!traj) text.reset(new std::ofstream(output::filename(file_suffix).c_str(), std::ios::out));
+		// at most buffer_size frames are in the pipeline in addition to the buffer
+		return scon::offset_call_buffer<coords::Representation_3D>(buffer_size, log_offset,
+			cartesian_logfile_drain{ std::make_shared<snapshot_pipeline>(c, std::move(text), std::move(traj),
+				optimize, optimizer_threads, buffer_size) });
+	}
+	if (traj)
+	{
+		return scon::offset_call_buffer<coords::Representation_3D>(buffer_size, log_offset,
+			cartesian_logfile_drain{ c, std::move(traj), optimize });
+	}
 	return scon::offset_call_buffer<coords::Representation_3D>(buffer_size, log_offset,
 		cartesian_logfile_drain{ c, output::filename(file_suffix).c_str(), optimize });
 }
@@ -1273,6 +1352,44 @@ float coords::Coords_3d_float_callback::operator() (scon::vector<scon::c3<float>
   return E;
 }
 
+coords::float_type coords::Coords_3d_pre_callback::operator() (coords::Representation_3D const& v,
+	coords::Gradients_3D& g, std::size_t const S, bool& go_on)
+{
+	cp->set_xyz(v);
+	if (Config::set().optimization.local.bfgs.trace)
+	{
+		std::ofstream trace("trace.arc", std::ios_base::app);
+		trace << coords::output::formats::tinker(*this->cp);
+	}
+	coords::float_type E = cp->pg();
+	go_on = cp->integrity();
+	g = cp->g_xyz();
+	if (Config::get().general.verbosity >= 4)
+		std::cout << "Optimization: Energy of step " <<
+		S << " is " << E << " integrity " << go_on << '\n';
+	return E;
+}
+
+coords::float_type coords::Coords_3d_callback::operator() (coords::Representation_3D const& v,
+	coords::Gradients_3D& g, std::size_t const S, bool& go_on)
+{
+	cp->set_xyz(v, false);
+	if (Config::set().optimization.local.bfgs.trace)
+	{
+		std::ofstream trace("trace.arc", std::ios_base::app);
+		trace << coords::output::formats::tinker(*cp);
+	}
+	coords::float_type E = cp->g();
+	go_on = cp->integrity();
+	g = cp->g_xyz();
+	if (Config::get().general.verbosity >= 3)
+	{
+		std::cout << "Optimization: Energy of step " << S;
+		std::cout << " is " << E << " integrity " << go_on << '\n';
+	}
+	return E;
+}
+
 void coords::Coordinates::adapt_indexation(std::vector<std::vector<std::pair<std::vector<size_t>, double>>> const& reference,
 	coords::Coordinates const* cPtr)
 {
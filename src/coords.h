@@ -26,6 +26,13 @@ namespace md {
 	class CoordinatesUBIAS;
 }
 
+namespace coords {
+	namespace trajectory {
+		class writer;
+	}
+	class snapshot_pipeline;
+}
+
 namespace optimization {
 	namespace global {
 		class CoordsOptimizationTS;
@@ -601,6 +608,8 @@ namespace coords
 		/**saves virial coefficients into coordinates object
 		@param V: virials coefficients*/
 		void set_virial(virial_t const& V) { m_virial = V; }
+		/**returns the virial tensor of the last gradient calculation*/
+		virial_t const& virial() const { return m_virial; }
 
 		/**calculates the center of mass*/
 		Cartesian_Point    center_of_mass() const;
@@ -1308,6 +1317,29 @@ namespace coords
 			scon::vector<scon::c3<float>>& g, std::size_t const S, bool& go_on);
 	};
 
+	/**
+	 * Purpose: Callbacks for the double precision optimizer
+	 * (BFGSdouble), working on the representation without float copies.
+	 */
+	struct Coords_3d_callback
+	{
+		coords::Coordinates* cp;
+		Coords_3d_callback(coords::Coordinates& coordpointer) :
+			cp(&coordpointer)
+		{ }
+
+		coords::float_type operator() (coords::Representation_3D const& v,
+			coords::Gradients_3D& g, std::size_t const S, bool& go_on);
+	};
+
+	struct Coords_3d_pre_callback
+	{
+		coords::Coordinates* cp;
+		Coords_3d_pre_callback(coords::Coordinates& coordpointer) : cp(&coordpointer) { }
+		coords::float_type operator() (coords::Representation_3D const& v,
+			coords::Gradients_3D& g, std::size_t const S, bool& go_on);
+	};
+
 	struct Internal_Callback
 	{
 		coords::Coordinates* cp;
@@ -1334,23 +1366,43 @@ namespace coords
 	{
 		coords::Coordinates* cp;
 		std::unique_ptr<std::ofstream> strm;
+		std::shared_ptr<trajectory::writer> traj;
+		std::shared_ptr<snapshot_pipeline> async;
 		bool opt;
 	public:
-		cartesian_logfile_drain() : cp(), strm(), opt() {}
+		cartesian_logfile_drain() : cp(), strm(), traj(), async(), opt() {}
 		cartesian_logfile_drain(coords::Coordinates& c, char const* const filename, bool optimize = false) :
-			cp(&c), strm(new std::ofstream(filename, std::ios::out)), opt(optimize)
+			cp(&c), strm(new std::ofstream(filename, std::ios::out)), traj(), async(), opt(optimize)
 		{
       *strm << std::unitbuf;
     }
+		/**snapshots are written into a compressed binary trajectory*/
+		cartesian_logfile_drain(coords::Coordinates& c, std::shared_ptr<trajectory::writer> writer, bool optimize = false) :
+			cp(&c), strm(), traj(std::move(writer)), async(), opt(optimize)
+		{ }
+		/**snapshots are optimized and written in the background (see coords_snapshot_pipeline.h)*/
+		explicit cartesian_logfile_drain(std::shared_ptr<snapshot_pipeline> pipeline) :
+			cp(), strm(), traj(), async(std::move(pipeline)), opt()
+		{ }
 		void operator() (coords::Representation_3D&& xyz);
+		/**waits until all snapshots passed to the drain are written (only background output)*/
+		void wait();
 	};
 
 	using offset_buffered_cartesian_logfile =
 		scon::vector_offset_buffered_callable<coords::Representation_3D, cartesian_logfile_drain>;
 
+	/**buffered snapshot log
+	@param trajectory_precision: if > 0 the snapshots are written into a compressed
+	binary trajectory (file_suffix + ".ctrj") storing coordinates as integers of x * trajectory_precision
+	@param append: continue the compressed trajectory of a previous run instead of creating a new file
+	@param asynchronous: snapshots are optimized and written by background threads
+	@param optimizer_threads: number of background threads optimizing snapshots*/
 	offset_buffered_cartesian_logfile make_buffered_cartesian_log(Coordinates& c,
 		std::string file_suffix, std::size_t buffer_size,
-		std::size_t log_offset, bool optimize = false);
+		std::size_t log_offset, bool optimize = false,
+		double trajectory_precision = 0.0, bool append = false,
+		bool asynchronous = false, std::size_t optimizer_threads = 1u);
 
 	inline void swap(Coordinates& a, Coordinates& b)
 	{
@@ -0,0 +1,76 @@
+#include "coords_cells.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Scon/scon_linkedcell.h"
+
+namespace
+{
+	bool all_finite(coords::Representation_3D const& xyz)
+	{
+		for (auto const& p : xyz)
+		{
+			if (!std::isfinite(p.x()) || !std::isfinite(p.y()) || !std::isfinite(p.z())) return false;
+		}
+		return true;
+	}
+
+	// number of cells with edge length edge spanning all positions
+	double number_of_cells(coords::Representation_3D const& xyz, double const edge)
+	{
+		auto lo = xyz.front(), hi = xyz.front();
+		for (auto const& p : xyz)
+		{
+			lo = min(lo, p);
+			hi = max(hi, p);
+		}
+		return (std::floor(hi.x() / edge) - std::floor(lo.x() / edge) + 1.0) *
+			(std::floor(hi.y() / edge) - std::floor(lo.y() / edge) + 1.0) *
+			(std::floor(hi.z() / edge) - std::floor(lo.z() / edge) + 1.0);
+	}
+}
+
+coords::atom_pairs coords::covalent_pairs_brute_force(Representation_3D const& xyz, std::vector<double> const& radii, double const factor)
+{
+	atom_pairs pairs;
+	for (std::size_t i = 0u; i < xyz.size(); ++i)
+	{
+		for (std::size_t j = 0u; j < i; ++j)
+		{
+			if (scon::geometric_length(xyz[i] - xyz[j]) < factor * (radii[i] + radii[j])) pairs.emplace_back(i, j);
+		}
+	}
+	return pairs;
+}
+
+coords::atom_pairs coords::covalent_pairs(Representation_3D const& xyz, std::vector<double> const& radii, double const factor)
+{
+	if (xyz.empty()) return atom_pairs();
+	double const cutoff = factor * 2.0 * *std::max_element(radii.begin(), radii.end());
+	if (!(cutoff > 0.0)) return atom_pairs();
+	// NaN positions and atoms far away from the others are handled by the loop over all pairs
+	if (!all_finite(xyz) || number_of_cells(xyz, cutoff / 2.0) > 8.0 * static_cast<double>(xyz.size()) + 1000.0)
+	{
+		return covalent_pairs_brute_force(xyz, radii, factor);
+	}
+
+	using cells_type = scon::linked::Cells<coords::float_type, coords::Cartesian_Point, coords::Representation_3D>;
+	cells_type const cells(xyz, cutoff, false, coords::Cartesian_Point(0.0), coords::float_type(0), scon::linked::fragmentation::half);
+	atom_pairs pairs;
+	std::vector<std::size_t> partners;
+	for (std::size_t i = 0u; i < xyz.size(); ++i)
+	{
+		partners.clear();
+		auto const box_of_i = cells.box_of_element(i);
+		for (auto j : box_of_i.adjacencies())
+		{
+			if (j < 0 || static_cast<std::size_t>(j) >= i) continue;
+			auto const uj = static_cast<std::size_t>(j);
+			if (scon::geometric_length(xyz[i] - xyz[uj]) < factor * (radii[i] + radii[uj])) partners.push_back(uj);
+		}
+		std::sort(partners.begin(), partners.end());
+		for (auto j : partners) pairs.emplace_back(i, j);
+	}
+	return pairs;
+}
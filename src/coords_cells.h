@@ -0,0 +1,36 @@
+/**
+CAST 3
+coords_cells.h
+Purpose:
+Atom pairs closer than a multiple of the sum of their covalent radii,
+found with linked cells (scon::linked::Cells) in O(N) instead of
+looping over all pairs. Used for the bond perception of XYZ and PDB input
+and for Coordinates::check_for_crashes.
+
+@version 1.0
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "coords_rep.h"
+
+namespace coords
+{
+	/**pairs (i, j) with j < i */
+	using atom_pairs = std::vector<std::pair<std::size_t, std::size_t>>;
+
+	/**pairs of atoms whose distance is smaller than factor * (radius_i + radius_j)
+	@param xyz: positions of the atoms
+	@param radii: covalent radius of every atom
+	@param factor: scaling of the sum of the radii
+	@return: pairs (i, j) with j < i, sorted by i and j (same order as a loop over all pairs)*/
+	atom_pairs covalent_pairs(Representation_3D const& xyz, std::vector<double> const& radii, double const factor = 1.2);
+
+	/**same as covalent_pairs but looping over all pairs,
+	used for very sparse systems where the cells would not fit into memory*/
+	atom_pairs covalent_pairs_brute_force(Representation_3D const& xyz, std::vector<double> const& radii, double const factor = 1.2);
+}
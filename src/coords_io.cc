@@ -11,6 +11,7 @@
 #include "coords_io.h"
 #include "Scon/scon_utility.h"
 #include "helperfunctions.h"
+#include "coords_io_stream.h"
 
 #if defined(_MSC_VER) && !defined(CAST_SSCANF_COORDS_IO)
 #define CAST_SSCANF_COORDS_IO sscanf_s
@@ -57,6 +58,10 @@ coords::input::format* coords::input::new_format(void)
 		//PDB
 		return new formats::pdb;
 		break;
+	case config::input_types::CTRJ:
+		//compressed trajectory
+		return new formats::ctrj;
+		break;
 	default:
 	{
 		return new formats::tinker;
@@ -143,6 +148,8 @@ coords::Coordinates coords::input::formats::tinker::read(std::string file) {
 		if (N == 0U)
 			throw std::logic_error("ERR_COORD: Expecting no atoms from '" + file +
 				"'.");
+		// further frames are read on demand
+		bool const stream = Config::get().general.stream_chunk > 0u;
 		Representation_3D positions;
 		std::vector<std::size_t> index_of_atom(N);
 		bool indexation_not_contiguous(false), has_in_out_subsystems(false);
@@ -179,6 +186,7 @@ coords::Coordinates coords::input::formats::tinker::read(std::string file) {
 				if (i == N) {
 					input_ensemble.push_back(positions);
 					positions.clear();
+					if (stream) break;
 				}
 			}
 			else {
@@ -228,6 +236,7 @@ coords::Coordinates coords::input::formats::tinker::read(std::string file) {
 
 		if (input_ensemble.empty())
 			throw std::logic_error("No structures found.");
+		if (stream) source = std::make_shared<tinker_frames>(file, N);
 		coords::PES_Point x(input_ensemble[0u]);
 		if (!Config::get().coords.fixed.empty()) {
 			for (auto fix : Config::get().coords.fixed) {
@@ -217,6 +217,8 @@ namespace coords
 			else return types::TINKER;
 		}
 
+		class frame_source;
+
 		/**general format class
 		input formats like AMBER, TINKER, PDB or XYZ inherit from this*/
 		class format
@@ -224,11 +226,18 @@ namespace coords
 		protected:
 			format(void) { }
 			coords::Ensemble_PES input_ensemble;
+			/**frames which are read on demand instead of being loaded into input_ensemble
+			(only the first structure is loaded, see coords_io_stream.h)*/
+			std::shared_ptr<frame_source> source;
 		public:
 			virtual ~format(void) { }
 			// Number of Atoms (N) and Structures (M)
 			std::size_t atoms(void) const { return input_ensemble.size() > 0 ? input_ensemble.back().size() : 0U; }
 			std::size_t size(void) const { return input_ensemble.size(); }
+			/**number of frames in the input file (including those which are not loaded into the ensemble)*/
+			std::size_t frames(void) const;
+			/**cartesian coordinates of frame i (read from file when streaming)*/
+			Representation_3D frame(std::size_t const i);
 			/** Read Structure and return coordinates (this function must be overwritten for newly implemented inputformats)*/
 			virtual Coordinates read(std::string) = 0;
 			// Get structure i
@@ -331,6 +340,15 @@ namespace coords
 				Cartesian_Point position;
 			};
 
+			/**class for reading compressed binary trajectories (see coords_io_trajectory.h)
+			atoms and bonds are taken from the header of the file, every frame is one structure*/
+			class ctrj : public coords::input::format
+			{
+			public:
+				/**reads all frames (only the first one if trajectories are streamed)*/
+				Coordinates read(std::string) override;
+			};
+
 
 			/*! Class to read from TINKER coordinate file (.arc)
 			 *
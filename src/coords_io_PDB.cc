@@ -11,6 +11,7 @@ PDB reading:
 */
 #include "coords_io.h"
 #include "helperfunctions.h"
+#include "coords_cells.h"
 
 /**function that reads the structure
 @ param file: name of the pdb-file
@@ -73,27 +74,22 @@ coords::Coordinates coords::input::formats::pdb::read(std::string file)
 	input_ensemble.push_back(positions);  // fill the positions into PES_Point
 	coords::PES_Point pes(input_ensemble[0u]);
 
-	// loop over all atompairs and bind them if they fulfill distance criterion 
+	// bind all atompairs which fulfill the distance criterion (found with linked cells)
 	// i.e. the distance is smaller than 1.2 * sum of covalent radiuses
 	// ions are not bonded to anything
-	for (unsigned i = 0; i < N; i++)
+	std::vector<double> radii;
+	for (std::size_t i = 0; i < N; i++) radii.push_back(atoms.atom(i).cov_radius());
+	for (auto const& pair : covalent_pairs(positions, radii))
 	{
-		for (unsigned j = 0; j < i; j++)
+		auto const i = pair.first, j = pair.second;
+		if (atoms.atom(i).symbol() == "Na" || atoms.atom(j).symbol() == "Na")
+		{                           // Na ions often have a small distance to their neighbors but no bonds
+			std::cout << "creating no bond between atoms " << i + 1 << " and " << j + 1 << " because one of the atoms is a Na\n";
+		}
+		else
 		{
-			double d = dist(positions[i], positions[j]);
-			double d_max = 1.2 * (atoms.atom(i).cov_radius() + atoms.atom(j).cov_radius());
-			if (d < d_max)
-			{
-				if (atoms.atom(i).symbol() == "Na" || atoms.atom(j).symbol() == "Na")
-				{                           // Na ions often have a small distance to their neighbors but no bonds
-					std::cout << "creating no bond between atoms " << i + 1 << " and " << j + 1 << " because one of the atoms is a Na\n";
-				}
-				else
-				{
-					atoms.atom(i).bind_to(j);
-					atoms.atom(j).bind_to(i);
-				}
-			}
+			atoms.atom(i).bind_to(j);
+			atoms.atom(j).bind_to(i);
 		}
 	}
 
@@ -9,6 +9,8 @@ bonds are created by distance criterion (1.2 times sum of covalent radii)
 */
 #include "coords_io.h"
 #include "helperfunctions.h"
+#include "coords_io_stream.h"
+#include "coords_cells.h"
 
 /**function that reads the structure
 @ param file: name of the xyz-file
@@ -63,7 +65,11 @@ coords::Coordinates coords::input::formats::xyz::read(std::string file)
 	input_ensemble.push_back(positions);
 	positions.clear();
 
-	while (config_file_stream.good())     // if there is still file left there are probably some more structures in it
+	// further frames are read on demand
+	bool const stream = Config::get().general.stream_chunk > 0u;
+	if (stream) source = std::make_shared<xyz_frames>(file, N);
+
+	while (!stream && config_file_stream.good())     // if there is still file left there are probably some more structures in it
 	{
 		if (check_if_integer(line))   // first line = number of atoms
 		{
@@ -94,26 +100,21 @@ coords::Coordinates coords::input::formats::xyz::read(std::string file)
 	positions = input_ensemble.at(0u).structure.cartesian;
 	coords::PES_Point pes(input_ensemble[0u]);
 
-	// loop over all atompairs and bind them if they fulfill distance criterion 
+	// bind all atompairs which fulfill the distance criterion (found with linked cells)
 	// i.e. the distance is smaller than 1.2 * sum of covalent radiuses
-	for (unsigned i = 0; i < N; i++)
+	std::vector<double> radii;
+	for (std::size_t i = 0; i < N; i++) radii.push_back(atoms.atom(i).cov_radius());
+	for (auto const& pair : covalent_pairs(positions, radii))
 	{
-		for (unsigned j = 0; j < i; j++)
+		auto const i = pair.first, j = pair.second;
+		if (atoms.atom(i).symbol() == "Na" || atoms.atom(j).symbol() == "Na")
+		{                           // Na ions often have a small distance to their neighbors but no bonds
+			std::cout << "creating no bond between atoms " << i + 1 << " and " << j + 1 << " because one of the atoms is a Na\n";
+		}
+		else
 		{
-			double d = dist(positions[i], positions[j]);
-			double d_max = 1.2 * (atoms.atom(i).cov_radius() + atoms.atom(j).cov_radius());
-			if (d < d_max)
-			{
-				if (atoms.atom(i).symbol() == "Na" || atoms.atom(j).symbol() == "Na")
-				{                           // Na ions often have a small distance to their neighbors but no bonds
-					std::cout << "creating no bond between atoms " << i + 1 << " and " << j + 1 << " because one of the atoms is a Na\n";
-				}
-				else
-				{
-					atoms.atom(i).bind_to(j);
-					atoms.atom(j).bind_to(i);
-				}
-			}
+			atoms.atom(i).bind_to(j);
+			atoms.atom(j).bind_to(i);
 		}
 	}
 
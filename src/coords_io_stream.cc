@@ -0,0 +1,157 @@
+#include "coords_io_stream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+#include "coords_io.h"
+#include "coords_io_trajectory.h"
+
+#if defined(_MSC_VER) && !defined(CAST_SSCANF_COORDS_IO)
+#define CAST_SSCANF_COORDS_IO sscanf_s
+#elif !defined(CAST_SSCANF_COORDS_IO)
+#define CAST_SSCANF_COORDS_IO sscanf
+#endif
+
+namespace
+{
+	/**positions of all complete frames with a header of header_lines lines and n_atoms atom lines*/
+	std::vector<std::streamoff> index_frames(std::ifstream& strm, std::size_t const header_lines, std::size_t const n_atoms)
+	{
+		std::vector<std::streamoff> offsets;
+		std::string line;
+		std::size_t const lines_per_frame(header_lines + n_atoms);
+		std::streamoff start(0);
+		std::size_t l(0u);
+		while (true)
+		{
+			std::streamoff const pos(strm.tellg());
+			if (!std::getline(strm, line)) break;
+			if (l == 0u)
+			{
+				if (line.find_first_not_of(" \t\r") == std::string::npos) continue;   // empty lines between frames
+				start = pos;
+			}
+			if (++l == lines_per_frame)
+			{
+				offsets.push_back(start);
+				l = 0u;
+			}
+		}
+		strm.clear();
+		return offsets;
+	}
+}
+
+coords::input::tinker_frames::tinker_frames(std::string const& file, std::size_t const atoms)
+	: strm(file, std::ios_base::in | std::ios_base::binary), n_atoms(atoms), offsets()
+{
+	if (!strm) throw std::runtime_error("Reading the structure from file '" + file + "' failed.");
+	offsets = index_frames(strm, 1u, n_atoms);
+}
+
+coords::Representation_3D coords::input::tinker_frames::frame(std::size_t const i)
+{
+	strm.seekg(offsets.at(i));
+	std::string line;
+	std::getline(strm, line);
+	Representation_3D xyz;
+	xyz.reserve(n_atoms);
+	for (std::size_t j = 0u; j < n_atoms && std::getline(strm, line); ++j)
+	{
+		double x(0), y(0), z(0);
+		CAST_SSCANF_COORDS_IO(line.c_str(), "%*u %*s %lf %lf %lf", &x, &y, &z);
+		xyz.emplace_back(x, y, z);
+	}
+	if (xyz.size() != n_atoms) throw std::runtime_error("Incomplete frame in input file.");
+	return xyz;
+}
+
+coords::input::xyz_frames::xyz_frames(std::string const& file, std::size_t const atoms)
+	: strm(file, std::ios_base::in | std::ios_base::binary), n_atoms(atoms), offsets()
+{
+	if (!strm) throw std::runtime_error("Reading the structure from file '" + file + "' failed.");
+	offsets = index_frames(strm, 2u, n_atoms);
+}
+
+coords::Representation_3D coords::input::xyz_frames::frame(std::size_t const i)
+{
+	strm.seekg(offsets.at(i));
+	std::string line, element;
+	std::getline(strm, line);
+	std::getline(strm, line);
+	Representation_3D xyz;
+	xyz.reserve(n_atoms);
+	for (std::size_t j = 0u; j < n_atoms && std::getline(strm, line); ++j)
+	{
+		double x(0), y(0), z(0);
+		std::istringstream linestream(line);
+		linestream >> element >> x >> y >> z;
+		xyz.emplace_back(x, y, z);
+	}
+	if (xyz.size() != n_atoms) throw std::runtime_error("Incomplete frame in input file.");
+	return xyz;
+}
+
+coords::input::ctrj_frames::ctrj_frames(std::string const& file)
+	: traj(new trajectory::reader(file))
+{ }
+
+coords::input::ctrj_frames::~ctrj_frames() = default;
+
+std::size_t coords::input::ctrj_frames::size() const
+{
+	return traj->size();
+}
+
+coords::Representation_3D coords::input::ctrj_frames::frame(std::size_t const i)
+{
+	return traj->frame(i);
+}
+
+std::size_t coords::input::format::frames(void) const
+{
+	return source ? source->size() : input_ensemble.size();
+}
+
+coords::Representation_3D coords::input::format::frame(std::size_t const i)
+{
+	if (source) return source->frame(i);
+	return input_ensemble.at(i).structure.cartesian;
+}
+
+coords::input::frame_chunks::frame_chunks(format& input, std::size_t const first_frame, std::size_t const frame_step,
+	std::size_t const max_frames, std::size_t const chunk_size)
+	: in(&input), first(first_frame), step(std::max<std::size_t>(frame_step, 1u)), count(),
+	chunk(chunk_size), begin(), prefetch()
+{
+	std::size_t const n(input.frames());
+	count = first < n ? std::min(max_frames, (n - first + step - 1u) / step) : 0u;
+	if (chunk == 0u) chunk = Config::get().general.stream_chunk;
+	if (chunk == 0u) chunk = 1024u;
+	if (count > 0u) prefetch = std::async(std::launch::async, &frame_chunks::load, this, 0u);
+}
+
+coords::input::frame_chunk coords::input::frame_chunks::load(std::size_t const b) const
+{
+	frame_chunk c;
+	std::size_t const e(std::min(count, b + chunk));
+	c.index.reserve(e - b);
+	c.xyz.reserve(e - b);
+	for (std::size_t k = b; k < e; ++k)
+	{
+		c.index.push_back(first + k * step);
+		c.xyz.push_back(in->frame(first + k * step));
+	}
+	return c;
+}
+
+bool coords::input::frame_chunks::next(frame_chunk& c)
+{
+	if (begin >= count) return false;
+	c = prefetch.get();
+	begin += chunk;
+	if (begin < count) prefetch = std::async(std::launch::async, &frame_chunks::load, this, begin);
+	return true;
+}
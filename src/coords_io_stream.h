@@ -0,0 +1,121 @@
+/**
+CAST 3
+coords_io_stream.h
+Purpose:
+Streaming access to the frames of trajectory input files.
+If Config::get().general.stream_chunk is set, the input formats only load
+the first structure into their ensemble and index the file instead.
+Tasks walking through trajectories (ALIGN, PCAgen, ENTROPY, REMOVE_EXPLICIT_WATER)
+read the frames in chunks, the next chunk is read in the background while
+the current one is processed. The memory needed is therefore bounded
+by two chunks instead of the length of the trajectory.
+
+@version 1.0
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "coords.h"
+
+namespace coords
+{
+	namespace trajectory
+	{
+		class reader;
+	}
+
+	namespace input
+	{
+		class format;
+
+		/**frames of an input file which are read on demand*/
+		class frame_source
+		{
+		public:
+			virtual ~frame_source() { }
+			/**number of frames*/
+			virtual std::size_t size() const = 0;
+			/**cartesian coordinates of frame i*/
+			virtual Representation_3D frame(std::size_t const i) = 0;
+		};
+
+		/**frames of a TINKER file (N + 1 lines each), the positions of the frames are indexed once*/
+		class tinker_frames : public frame_source
+		{
+		public:
+			tinker_frames(std::string const& file, std::size_t const atoms);
+			std::size_t size() const override { return offsets.size(); }
+			Representation_3D frame(std::size_t const i) override;
+		private:
+			std::ifstream strm;
+			std::size_t n_atoms;
+			std::vector<std::streamoff> offsets;
+		};
+
+		/**frames of an XYZ file (number of atoms, comment line and N atom lines each)*/
+		class xyz_frames : public frame_source
+		{
+		public:
+			xyz_frames(std::string const& file, std::size_t const atoms);
+			std::size_t size() const override { return offsets.size(); }
+			Representation_3D frame(std::size_t const i) override;
+		private:
+			std::ifstream strm;
+			std::size_t n_atoms;
+			std::vector<std::streamoff> offsets;
+		};
+
+		/**frames of a compressed trajectory (see coords_io_trajectory.h)*/
+		class ctrj_frames : public frame_source
+		{
+		public:
+			explicit ctrj_frames(std::string const& file);
+			~ctrj_frames();
+			std::size_t size() const override;
+			Representation_3D frame(std::size_t const i) override;
+		private:
+			std::unique_ptr<trajectory::reader> traj;
+		};
+
+		/**consecutive frames of a trajectory*/
+		struct frame_chunk
+		{
+			/**number of the frames in the input*/
+			std::vector<std::size_t> index;
+			std::vector<Representation_3D> xyz;
+			std::size_t size() const { return index.size(); }
+		};
+
+		/**reads the frames first, first + step, first + 2 * step, ... of an input in chunks
+		usage: frame_chunk c; while (chunks.next(c)) { ... }
+		the following chunk is read in the background while the current one is processed*/
+		class frame_chunks
+		{
+		public:
+			/**@param max_frames: maximum number of frames (all remaining frames if larger than that)
+			@param chunk_size: frames per chunk (Config::get().general.stream_chunk if 0,
+			1024 if that is 0 as well)*/
+			frame_chunks(format& input, std::size_t const first_frame = 0u, std::size_t const frame_step = 1u,
+				std::size_t const max_frames = static_cast<std::size_t>(-1), std::size_t const chunk_size = 0u);
+			frame_chunks(frame_chunks const&) = delete;
+			frame_chunks& operator=(frame_chunks const&) = delete;
+			/**replaces c by the next chunk, false if all frames were read*/
+			bool next(frame_chunk& c);
+			/**number of frames which are read*/
+			std::size_t size() const { return count; }
+		private:
+			frame_chunk load(std::size_t const begin) const;
+
+			format* in;
+			std::size_t first, step, count, chunk, begin;
+			std::future<frame_chunk> prefetch;
+		};
+	}
+}
@@ -0,0 +1,307 @@
+#include "coords_io_trajectory.h"
+#include "coords_io.h"
+#include "coords_io_stream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <experimental/filesystem>
+#include <limits>
+#include <stdexcept>
+
+#include "Scon/scon_serialization.h"
+
+namespace fs = std::experimental::filesystem;
+
+namespace
+{
+	char const magic[4] = { 'C', 'T', 'R', 'J' };
+	std::uint32_t const version = 1u;
+	std::uint32_t const frame_tag = 0x4D415246u;
+	/**number of atoms sharing the bit widths*/
+	std::size_t const block_size = 64u;
+	/**bits used to store a bit width*/
+	unsigned const width_bits = 6u;
+
+	class bit_writer
+	{
+		std::vector<unsigned char>& out;
+		std::uint64_t acc;
+		unsigned n;
+	public:
+		bit_writer(std::vector<unsigned char>& o) : out(o), acc(), n() {}
+		// v < 2^w, w <= 34
+		void put(std::uint64_t const v, unsigned const w)
+		{
+			if (w == 0u) return;
+			acc |= v << n;
+			n += w;
+			while (n >= 8u)
+			{
+				out.push_back(static_cast<unsigned char>(acc & 0xFFu));
+				acc >>= 8u;
+				n -= 8u;
+			}
+		}
+		void flush()
+		{
+			if (n > 0u) out.push_back(static_cast<unsigned char>(acc & 0xFFu));
+			acc = 0u;
+			n = 0u;
+		}
+	};
+
+	class bit_reader
+	{
+		std::vector<unsigned char> const& in;
+		std::size_t pos;
+		std::uint64_t acc;
+		unsigned n;
+	public:
+		bit_reader(std::vector<unsigned char> const& i) : in(i), pos(), acc(), n() {}
+		std::uint64_t get(unsigned const w)
+		{
+			if (w == 0u) return 0u;
+			while (n < w)
+			{
+				if (pos == in.size()) throw std::runtime_error("Corrupted frame in compressed trajectory.");
+				acc |= static_cast<std::uint64_t>(in[pos++]) << n;
+				n += 8u;
+			}
+			std::uint64_t const v = acc & ((std::uint64_t(1u) << w) - 1u);
+			acc >>= w;
+			n -= w;
+			return v;
+		}
+	};
+
+	std::uint64_t zigzag(std::int64_t const v)
+	{
+		return (static_cast<std::uint64_t>(v) << 1u) ^ static_cast<std::uint64_t>(v >> 63);
+	}
+
+	std::int64_t unzigzag(std::uint64_t const v)
+	{
+		return static_cast<std::int64_t>(v >> 1u) ^ -static_cast<std::int64_t>(v & 1u);
+	}
+
+	unsigned bit_width(std::uint64_t v)
+	{
+		unsigned w(0u);
+		while (v > 0u)
+		{
+			v >>= 1u;
+			++w;
+		}
+		return w;
+	}
+}
+
+std::vector<unsigned char> coords::trajectory::encode(Representation_3D const& xyz, double const precision)
+{
+	double const limit(static_cast<double>(std::numeric_limits<std::int32_t>::max()));
+	std::vector<std::int64_t> q(xyz.size() * 3u);
+	for (std::size_t i = 0u; i < xyz.size(); ++i)
+	{
+		double const c[3] = { xyz[i].x(), xyz[i].y(), xyz[i].z() };
+		for (std::size_t d = 0u; d < 3u; ++d)
+		{
+			double const scaled(std::round(c[d] * precision));
+			if (!(std::abs(scaled) < limit))
+				throw std::runtime_error("Coordinate can not be stored in compressed trajectory (too large or NaN).");
+			q[i * 3u + d] = static_cast<std::int64_t>(scaled);
+		}
+	}
+	std::vector<unsigned char> payload;
+	payload.reserve(xyz.size() * 6u);
+	bit_writer bits(payload);
+	std::vector<std::uint64_t> z(block_size * 3u);
+	for (std::size_t begin = 0u; begin < xyz.size(); begin += block_size)
+	{
+		std::size_t const end(std::min(xyz.size(), begin + block_size));
+		unsigned width[3] = { 0u, 0u, 0u };
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			for (std::size_t d = 0u; d < 3u; ++d)
+			{
+				std::int64_t const previous(i > 0u ? q[(i - 1u) * 3u + d] : 0);
+				auto const v = zigzag(q[i * 3u + d] - previous);
+				z[(i - begin) * 3u + d] = v;
+				width[d] = std::max(width[d], bit_width(v));
+			}
+		}
+		for (std::size_t d = 0u; d < 3u; ++d) bits.put(width[d], width_bits);
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			for (std::size_t d = 0u; d < 3u; ++d) bits.put(z[(i - begin) * 3u + d], width[d]);
+		}
+	}
+	bits.flush();
+	return payload;
+}
+
+coords::Representation_3D coords::trajectory::decode(std::vector<unsigned char> const& payload,
+	std::size_t const n_atoms, double const precision)
+{
+	Representation_3D xyz;
+	xyz.reserve(n_atoms);
+	bit_reader bits(payload);
+	std::int64_t q[3] = { 0, 0, 0 };
+	for (std::size_t begin = 0u; begin < n_atoms; begin += block_size)
+	{
+		std::size_t const end(std::min(n_atoms, begin + block_size));
+		unsigned width[3];
+		for (std::size_t d = 0u; d < 3u; ++d) width[d] = static_cast<unsigned>(bits.get(width_bits));
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			for (std::size_t d = 0u; d < 3u; ++d) q[d] += unzigzag(bits.get(width[d]));
+			xyz.emplace_back(q[0] / precision, q[1] / precision, q[2] / precision);
+		}
+	}
+	return xyz;
+}
+
+coords::trajectory::writer::writer(std::string const& filename, Atoms const& atoms,
+	double const precision_, bool const append)
+	: strm(), n_atoms(atoms.size()), precision(precision_), n_frames()
+{
+	if (!(precision > 0.0)) throw std::runtime_error("Precision of compressed trajectory has to be positive.");
+	if (append && fs::exists(filename) && fs::file_size(filename) > 0u)
+	{
+		std::streamoff end(0);
+		{
+			reader existing(filename);
+			if (existing.atoms() != n_atoms || existing.get_precision() != precision)
+				throw std::runtime_error("Trajectory '" + filename + "' can not be continued: different number of atoms or precision.");
+			n_frames = existing.size();
+			end = existing.end();
+		}
+		if (static_cast<std::streamoff>(fs::file_size(filename)) > end) fs::resize_file(filename, static_cast<std::uintmax_t>(end));
+		strm.open(filename, std::ios_base::out | std::ios_base::app | std::ios_base::binary);
+		if (!strm) throw std::runtime_error("Cannot open trajectory '" + filename + "'.");
+		return;
+	}
+	strm.open(filename, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+	if (!strm) throw std::runtime_error("Cannot open trajectory '" + filename + "'.");
+	scon::bostream out(strm);
+	out.write(magic, sizeof(magic));
+	out << version << static_cast<std::uint64_t>(n_atoms) << precision;
+	for (std::size_t i = 0u; i < n_atoms; ++i)
+	{
+		auto const& atom = atoms.atom(i);
+		out << static_cast<std::uint32_t>(atom.symbol().size());
+		out.write(atom.symbol().data(), atom.symbol().size());
+		out << static_cast<std::uint64_t>(atom.energy_type()) << static_cast<std::uint32_t>(atom.bonds().size());
+		for (auto const b : atom.bonds()) out << static_cast<std::uint64_t>(b);
+	}
+	strm.flush();
+}
+
+void coords::trajectory::writer::write(Representation_3D const& xyz)
+{
+	if (xyz.size() != n_atoms) throw std::logic_error("Frame with wrong number of atoms for compressed trajectory.");
+	auto const payload = encode(xyz, precision);
+	scon::bostream out(strm);
+	out << frame_tag << static_cast<std::uint32_t>(payload.size());
+	if (!payload.empty()) out.write(reinterpret_cast<char const*>(payload.data()), payload.size());
+	strm.flush();
+	++n_frames;
+}
+
+coords::trajectory::reader::reader(std::string const& filename)
+	: strm(filename, std::ios_base::in | std::ios_base::binary), precision(), topology(),
+	offsets(), sizes(), data_end()
+{
+	if (!strm) throw std::runtime_error("Cannot open trajectory '" + filename + "'.");
+	scon::bistream in(strm);
+	char m[4];
+	std::uint32_t v(0u);
+	std::uint64_t n(0u);
+	in.read(m, sizeof(m));
+	in >> v >> n >> precision;
+	if (!in || !std::equal(m, m + 4, magic) || v != version)
+		throw std::runtime_error("'" + filename + "' is not a compressed trajectory of this version.");
+	for (std::uint64_t i = 0u; i < n && in; ++i)
+	{
+		std::uint32_t length(0u), n_bonds(0u);
+		std::uint64_t type(0u);
+		in >> length;
+		std::string symbol(length, ' ');
+		if (length > 0u) in.read(&symbol[0], length);
+		in >> type >> n_bonds;
+		Atom atom(symbol);
+		atom.set_energy_type(static_cast<std::size_t>(type));
+		for (std::uint32_t b = 0u; b < n_bonds && in; ++b)
+		{
+			std::uint64_t partner(0u);
+			in >> partner;
+			atom.bind_to(static_cast<std::size_t>(partner));
+		}
+		topology.add(atom);
+	}
+	if (!in) throw std::runtime_error("Incomplete header in trajectory '" + filename + "'.");
+	data_end = strm.tellg();
+
+	// index of the frames, an incomplete last frame is ignored
+	strm.seekg(0, std::ios_base::end);
+	std::streamoff const file_size(strm.tellg());
+	for (std::streamoff pos = data_end; pos + 8 <= file_size; )
+	{
+		strm.seekg(pos);
+		std::uint32_t tag(0u), size(0u);
+		in >> tag >> size;
+		if (!in || tag != frame_tag || pos + 8 + static_cast<std::streamoff>(size) > file_size) break;
+		offsets.push_back(pos + 8);
+		sizes.push_back(size);
+		pos += 8 + static_cast<std::streamoff>(size);
+		data_end = pos;
+	}
+	strm.clear();
+}
+
+coords::Representation_3D coords::trajectory::reader::frame(std::size_t const i)
+{
+	if (i >= size()) throw std::out_of_range("Frame not found in compressed trajectory.");
+	std::vector<unsigned char> payload(sizes[i]);
+	strm.seekg(offsets[i]);
+	scon::bistream in(strm);
+	if (!payload.empty()) in.read(reinterpret_cast<char*>(payload.data()), payload.size());
+	if (!in) throw std::runtime_error("Cannot read frame of compressed trajectory.");
+	return decode(payload, atoms(), precision);
+}
+
+/**reads a compressed trajectory
+@param file: name of the .ctrj file
+@return: Coordinates object, all frames are in the input ensemble*/
+coords::Coordinates coords::input::formats::ctrj::read(std::string file)
+{
+	trajectory::reader traj(file);
+	if (traj.size() == 0u) throw std::logic_error("No frames found in trajectory '" + file + "'.");
+	// further frames are read on demand
+	bool const stream = Config::get().general.stream_chunk > 0u;
+	for (std::size_t i = 0u; i < (stream ? 1u : traj.size()); ++i)
+	{
+		input_ensemble.push_back(traj.frame(i));
+	}
+	if (stream) source = std::make_shared<ctrj_frames>(file);
+
+	Atoms atoms(traj.get_topology());
+	if (!Config::get().coords.fixed.empty())
+	{
+		for (auto fix : Config::get().coords.fixed)
+		{
+			if (fix < atoms.size()) atoms.atom(fix).fix(true);
+		}
+	}
+
+	Coordinates coord_object;
+	coords::PES_Point x(input_ensemble[0u]);
+	coord_object.init_swap_in(atoms, x);
+	for (auto& p : input_ensemble)
+	{
+		p.gradient.cartesian.resize(p.structure.cartesian.size());
+		coord_object.set_xyz(p.structure.cartesian, true);
+		coord_object.to_internal_light();
+		p = coord_object.pes();
+	}
+	return coord_object;
+}
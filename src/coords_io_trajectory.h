@@ -0,0 +1,101 @@
+/**
+CAST 3
+coords_io_trajectory.h
+Purpose:
+Compressed binary trajectories (.ctrj) with random access to the frames.
+
+File layout (native byte order):
+header: "CTRJ", uint32 version, uint64 number of atoms, double precision,
+        for every atom: uint32 length and characters of the symbol,
+        uint64 energy type, uint32 number of bonds and uint64 bonding partners
+frames: uint32 frame tag, uint32 size of the payload, payload
+
+Coordinates are stored as integers (x * precision rounded, i.e. a precision
+of 1000 keeps 0.001 Angstrom). Inside a frame the differences to the
+coordinates of the preceding atom are zigzag encoded and bit-packed with a
+common bit width per axis for every block of atoms, so bonded neighbours
+which follow each other in the atom list cost only a few bits.
+
+@version 1.0
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "coords.h"
+
+namespace coords
+{
+	namespace trajectory
+	{
+		/**default extension of compressed trajectories*/
+		static std::string const extension = ".ctrj";
+
+		/**writes frames into a compressed trajectory*/
+		class writer
+		{
+		public:
+			/**opens a new trajectory
+			if append is true and the file already exists it is continued after
+			its last complete frame (an incomplete frame of a killed run is cut off),
+			number of atoms and precision of the existing file have to be the same
+			@param atoms: topology that is stored in the header
+			@param precision: coordinates are stored as integers of x * precision*/
+			writer(std::string const& filename, Atoms const& atoms,
+				double const precision, bool const append = false);
+
+			/**appends a frame (written to the file immediately)*/
+			void write(Representation_3D const& xyz);
+
+			/**number of frames in the file*/
+			std::size_t size() const { return n_frames; }
+
+		private:
+			std::ofstream strm;
+			std::size_t n_atoms;
+			double precision;
+			std::size_t n_frames;
+		};
+
+		/**reads a compressed trajectory
+		the frames are indexed when the file is opened, so every frame can be read in constant time*/
+		class reader
+		{
+		public:
+			explicit reader(std::string const& filename);
+
+			/**number of complete frames*/
+			std::size_t size() const { return offsets.size(); }
+			/**number of atoms*/
+			std::size_t atoms() const { return topology.size(); }
+			/**precision the file was written with*/
+			double get_precision() const { return precision; }
+			/**atoms (symbols, energy types and bonds) stored in the header*/
+			Atoms const& get_topology() const { return topology; }
+			/**position directly behind the last complete frame*/
+			std::streamoff end() const { return data_end; }
+
+			/**coordinates of frame i*/
+			Representation_3D frame(std::size_t const i);
+
+		private:
+			std::ifstream strm;
+			double precision;
+			Atoms topology;
+			/**positions of the payloads of all complete frames and their sizes*/
+			std::vector<std::streamoff> offsets;
+			std::vector<std::uint32_t> sizes;
+			std::streamoff data_end;
+		};
+
+		/**encodes the coordinates of a frame (payload without tag and size)*/
+		std::vector<unsigned char> encode(Representation_3D const& xyz, double const precision);
+		/**decodes a payload written by encode()*/
+		Representation_3D decode(std::vector<unsigned char> const& payload, std::size_t const n_atoms, double const precision);
+	}
+}
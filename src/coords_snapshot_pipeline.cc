@@ -0,0 +1,173 @@
+#include "coords_snapshot_pipeline.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "coords_io.h"
+#include "coords_io_trajectory.h"
+
+coords::snapshot_pipeline::snapshot_pipeline(Coordinates const& c, std::unique_ptr<std::ofstream> text,
+	std::shared_ptr<trajectory::writer> trajectory_file, bool const optimize,
+	std::size_t const optimizer_threads, std::size_t const max_frames)
+	: strm(std::move(text)), traj(std::move(trajectory_file)), opt(optimize),
+	capacity(std::max<std::size_t>(max_frames, 1u)), out_coords(), opt_coords(),
+	next_in(), next_out(), stop(false), reported(false)
+{
+	if (!strm && !traj) throw std::logic_error("Snapshot pipeline without output.");
+	if (strm) out_coords.reset(new Coordinates(c));
+	if (opt)
+	{
+		for (std::size_t t = 0u; t < std::max<std::size_t>(optimizer_threads, 1u); ++t)
+		{
+			opt_coords.emplace_back(new Coordinates(c));
+		}
+		for (std::size_t t = 0u; t < opt_coords.size(); ++t)
+		{
+			threads.emplace_back(&snapshot_pipeline::optimizer_loop, this, t);
+		}
+	}
+	threads.emplace_back(&snapshot_pipeline::writer_loop, this);
+}
+
+coords::snapshot_pipeline::~snapshot_pipeline()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	changed.notify_all();
+	for (auto& t : threads) t.join();
+	if (error && !reported)
+	{
+		try
+		{
+			std::rethrow_exception(error);
+		}
+		catch (std::exception const& e)
+		{
+			std::cout << "Writing snapshots failed: " << e.what() << '\n';
+		}
+		catch (...)
+		{
+			std::cout << "Writing snapshots failed.\n";
+		}
+	}
+}
+
+void coords::snapshot_pipeline::push(Representation_3D&& xyz)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	changed.wait(lock, [this] { return error || next_in - next_out < capacity; });
+	if (error)
+	{
+		rethrow();
+		return;   // frames are dropped after the error was reported
+	}
+	queued.emplace_back(next_in++, std::move(xyz));
+	lock.unlock();
+	changed.notify_all();
+}
+
+void coords::snapshot_pipeline::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	changed.wait(lock, [this] { return error || next_out == next_in; });
+	rethrow();
+}
+
+void coords::snapshot_pipeline::fail(std::exception_ptr e)
+{
+	if (!error) error = e;
+	changed.notify_all();
+}
+
+void coords::snapshot_pipeline::rethrow()
+{
+	// never from a destructor which is called during stack unwinding
+	if (error && !reported && std::uncaught_exceptions() == 0)
+	{
+		reported = true;
+		std::rethrow_exception(error);
+	}
+}
+
+void coords::snapshot_pipeline::optimizer_loop(std::size_t const t)
+{
+	for (;;)
+	{
+		std::pair<std::size_t, Representation_3D> frame;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [this] { return error || stop || !queued.empty(); });
+			if (error || queued.empty()) return;
+			frame = std::move(queued.front());
+			queued.pop_front();
+		}
+		try
+		{
+			auto& c = *opt_coords[t];
+			c.set_xyz(std::move(frame.second));
+			c.o();
+			frame.second = c.xyz();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			fail(std::current_exception());
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			optimized.emplace(frame.first, std::move(frame.second));
+		}
+		changed.notify_all();
+	}
+}
+
+void coords::snapshot_pipeline::writer_loop()
+{
+	for (;;)
+	{
+		Representation_3D xyz;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (opt)
+			{
+				// frames are written in order, the optimizers may finish them in any order
+				changed.wait(lock, [this] { return error || optimized.count(next_out) > 0 || (stop && next_out == next_in); });
+				auto const it = optimized.find(next_out);
+				if (error || it == optimized.end()) return;
+				xyz = std::move(it->second);
+				optimized.erase(it);
+			}
+			else
+			{
+				changed.wait(lock, [this] { return error || stop || !queued.empty(); });
+				if (error || queued.empty()) return;
+				xyz = std::move(queued.front().second);
+				queued.pop_front();
+			}
+		}
+		try
+		{
+			if (traj) traj->write(xyz);
+			else
+			{
+				out_coords->set_xyz(std::move(xyz));
+				*strm << *out_coords;
+			}
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			fail(std::current_exception());
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			++next_out;
+		}
+		changed.notify_all();
+	}
+}
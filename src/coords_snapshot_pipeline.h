@@ -0,0 +1,90 @@
+/**
+CAST 3
+coords_snapshot_pipeline.h
+Purpose:
+Background output of snapshots (see cartesian_logfile_drain in coords.h).
+Frames are queued by the simulation and optimized and written by
+worker threads which use their own copies of the coordinates object,
+so the integrator does not wait for file output or optimizations.
+
+@version 1.0
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "coords.h"
+
+namespace coords
+{
+	/**bounded queue of snapshots consumed by optimizer threads (if snapshots are optimized)
+	and one writer thread which writes the frames in the order they were pushed*/
+	class snapshot_pipeline
+	{
+	public:
+		/**@param c: coordinates the workers are copied from (atoms, energy interface)
+		@param text: stream for snapshots in output format (if no trajectory is given)
+		@param trajectory_file: compressed trajectory for the snapshots
+		@param optimize: locally optimize the snapshots before they are written
+		@param optimizer_threads: number of threads optimizing snapshots at the same time
+		@param max_frames: maximum number of frames which are queued or in progress*/
+		snapshot_pipeline(Coordinates const& c, std::unique_ptr<std::ofstream> text,
+			std::shared_ptr<trajectory::writer> trajectory_file, bool const optimize,
+			std::size_t const optimizer_threads, std::size_t const max_frames);
+		/**writes all remaining frames and stops the threads (errors are printed)*/
+		~snapshot_pipeline();
+
+		snapshot_pipeline(snapshot_pipeline const&) = delete;
+		snapshot_pipeline& operator=(snapshot_pipeline const&) = delete;
+
+		/**queues a frame, waits while the pipeline is full
+		throws the first error of a worker thread*/
+		void push(Representation_3D&& xyz);
+		/**waits until all queued frames are written
+		throws the first error of a worker thread*/
+		void wait();
+
+	private:
+		void optimizer_loop(std::size_t const t);
+		void writer_loop();
+		/**stores the first error and stops the pipeline (mutex must be locked)*/
+		void fail(std::exception_ptr e);
+		/**throws the error if it was not thrown before (mutex must be locked)*/
+		void rethrow();
+
+		std::unique_ptr<std::ofstream> strm;
+		std::shared_ptr<trajectory::writer> traj;
+		bool opt;
+		std::size_t capacity;
+		/**coordinates used for text output*/
+		std::unique_ptr<Coordinates> out_coords;
+		/**coordinates of the optimizer threads*/
+		std::vector<std::unique_ptr<Coordinates>> opt_coords;
+
+		std::mutex mutex;
+		/**notified when frames are queued, optimized or written and on shutdown*/
+		std::condition_variable changed;
+		/**frames waiting for a worker with their sequence numbers*/
+		std::deque<std::pair<std::size_t, Representation_3D>> queued;
+		/**optimized frames waiting for the writer*/
+		std::map<std::size_t, Representation_3D> optimized;
+		/**sequence numbers of the next pushed and the next written frame*/
+		std::size_t next_in, next_out;
+		bool stop;
+		std::exception_ptr error;
+		/**error was thrown by push() or wait()*/
+		bool reported;
+		std::vector<std::thread> threads;
+	};
+}
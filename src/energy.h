@@ -209,6 +209,8 @@ namespace energy
 		virtual void print_E_short(std::ostream&, bool const endline = true) const = 0;
 		/**print gradients*/
 		virtual void print_G_tinkerlike(std::ostream& S, bool const endline = true) const;
+		/**print statistics of the nonbonded neighbor list (if the interface has one)*/
+		virtual void print_nb_stats(std::ostream&) const { }
 
 		virtual void to_stream(std::ostream&) const = 0;
 
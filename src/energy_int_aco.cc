@@ -3,6 +3,7 @@
 #include "energy_int_aco.h"
 #include "configuration.h"
 #include "Scon/scon_utility.h"
+#include "Scon/scon_spacefilling.h"
 
 ::tinker::parameter::parameters energy::interfaces::aco::aco_ff::tp;
 ::tinker::parameter::parameters energy::interfaces::aco::aco_ff::cparams;
@@ -44,6 +45,10 @@ energy::interfaces::aco::aco_ff::aco_ff(coords::Coordinates* cobj)
 	{
 		std::cout << "\n!!! WARNING! Forcefield cutoff too big! Your cutoff should be smaller than " << min_cut << "! !!!\n\n";
 	}
+	if (Config::get().energy.nb_order != config::energy::nb_orders::INPUT && !Config::get().energy.nb_soa)
+	{
+		std::cout << "\n!!! WARNING! nonbonded_order is only used by the structure-of-arrays kernel (nonbonded_soa 1) and is ignored! !!!\n\n";
+	}
 }
 
 
@@ -170,7 +175,7 @@ void energy::interfaces::aco::restrainInternals(coords::Coordinates const& coord
 
 
 energy::interfaces::aco::aco_ff::aco_ff (aco_ff const & rhs, 
-  coords::Coordinates *cobj) : interface_base(cobj), refined(rhs.refined),
+  coords::Coordinates *cobj) : interface_base(cobj), refined(rhs.refined), soa_pairs(rhs.soa_pairs), soa_order(rhs.soa_order),
   part_energy(rhs.part_energy), part_grad(rhs.part_grad) 
 {
 	interface_base::operator=(rhs);
@@ -178,7 +183,7 @@ energy::interfaces::aco::aco_ff::aco_ff (aco_ff const & rhs,
 
 energy::interfaces::aco::aco_ff::aco_ff(aco_ff&& rhs,
 	coords::Coordinates* cobj) : interface_base(cobj), refined(std::move(rhs.refined)),
-	part_energy(std::move(rhs.part_energy)), part_grad(std::move(rhs.part_grad))
+	soa_pairs(std::move(rhs.soa_pairs)), soa_order(std::move(rhs.soa_order)), part_energy(std::move(rhs.part_energy)), part_grad(std::move(rhs.part_grad))
 {
   interface_base::swap(rhs);
 }
@@ -192,6 +197,8 @@ void energy::interfaces::aco::aco_ff::swap(aco_ff& rhs)
 {
 	interface_base::swap(rhs);
 	refined.swap_data(rhs.refined);
+	soa_pairs.swap(rhs.soa_pairs);
+	soa_order.swap(rhs.soa_order);
 	std::swap(cparams, rhs.cparams);
 	std::swap(part_energy, rhs.part_energy);
 	for (std::size_t i(0u); i < part_grad.size(); ++i)
@@ -232,13 +239,61 @@ void energy::interfaces::aco::aco_ff::update(bool const skip_topology)
   {
     cparams = tp.contract(types);
     refined = ::tinker::refine::refined((*coords), cparams);
+    pme_charges.clear();
     //restrainInternals(*coords, refined);
     //purge_nb_at_same_molecule(*coords, refined);
   }
+  else if (Config::get().energy.verlet_skin > 0.0)
+  {
+    if (!refined.update_nb(*coords)) return;   // Verlet list is still valid
+  }
   else 
   {
     refined.refine_nb(*coords);
   }
+  soa_pairs.clear();   // rebuilt with next energy calculation
+}
+
+/**resolves charge products and vdW parameters of all non-bonded pairs
+and saves them in structure-of-arrays pairlists for the SoA kernel
+(if requested the atoms are renumbered along a space-filling curve so that the atoms
+of consecutive pairs are close in memory; the order is renewed with every new pairlist)*/
+void energy::interfaces::aco::aco_ff::update_soa_pairs(void)
+{
+  bool const amber_charges = Config::get().general.input == config::input_types::AMBER || Config::get().general.chargefile;
+  std::size_t const N(coords->interactions().size());
+  auto const nb_order = Config::get().energy.nb_order;
+  soa_order.clear();
+  std::vector<std::size_t> rank;
+  if (nb_order != config::energy::nb_orders::INPUT)
+  {
+    soa_order = scon::spacefilling::order(coords->xyz(), nb_order == config::energy::nb_orders::HILBERT ?
+      scon::spacefilling::curves::HILBERT : scon::spacefilling::curves::MORTON);
+    rank.resize(soa_order.size());
+    for (std::size_t k(0u); k < soa_order.size(); ++k) rank[soa_order[k]] = k;
+  }
+  soa_pairs.clear();
+  soa_pairs.reserve(refined.pair_matrices().size() * N);
+  for (auto const& pairmatrix : refined.pair_matrices())
+  {
+    scon::matrix< ::tinker::parameter::combi::vdwc, true> const& par(refined.vdwcm(pairmatrix.param_matrix_id));
+    for (std::size_t sub_ia_index(0u); sub_ia_index < N; ++sub_ia_index)
+    {
+      std::vector< ::tinker::refine::types::nbpair> const& pl(pairmatrix.pair_matrix(sub_ia_index));
+      nb_soa_pairs soa;
+      soa.reserve(pl.size());
+      for (auto const& pair : pl)
+      {
+        ::tinker::parameter::combi::vdwc const& p(par(refined.type(pair.a), refined.type(pair.b)));
+        coords::float_type const C = amber_charges ?   // Q_a * Q_b from AMBER charges
+          Config::get().coords.amber_charges[pair.a] * Config::get().coords.amber_charges[pair.b] : p.C;
+        if (rank.empty()) soa.push_back(pair.a, pair.b, C, p.E, p.R);
+        else soa.push_back(std::min(rank[pair.a], rank[pair.b]), std::max(rank[pair.a], rank[pair.b]), C, p.E, p.R);
+      }
+      if (!rank.empty()) soa.sort();
+      soa_pairs.push_back(std::move(soa));
+    }
+  }
 }
 
 std::vector<coords::float_type> energy::interfaces::aco::aco_ff::charges() const
@@ -285,6 +340,11 @@ void energy::interfaces::aco::aco_ff::print_E(std::ostream&) const
 
 }
 
+void energy::interfaces::aco::aco_ff::print_nb_stats(std::ostream& S) const
+{
+	S << refined.nb_stats() << '\n';
+}
+
 void energy::interfaces::aco::aco_ff::print_E_head(std::ostream& S, bool const endline) const
 {
 	S << "Potentials\n";
@@ -474,6 +534,11 @@ void energy::interfaces::aco::aco_ff::print_G_tinkerlike(std::ostream& S, bool c
 
 void energy::interfaces::aco::aco_ff::pre(void)
 {
+	// rebuild Verlet list if atoms moved too far
+	if (Config::get().energy.verlet_skin > 0.0 && refined.update_nb(*coords))
+	{
+		soa_pairs.clear();
+	}
 	for (auto& e : part_energy) e = 0.0;
 	for (auto& g : part_grad) g.assign(coords->size(), coords::Cartesian_Point(0.0, 0.0, 0.0));
 	std::array<coords::float_type, 3> za;
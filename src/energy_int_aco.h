@@ -3,6 +3,9 @@
 #include "tinker_parameters.h"
 #include "tinker_refine.h"
 #include "coords.h"
+#include "energy_int_aco_soa.h"
+#include "energy_int_aco_accumulator.h"
+#include "energy_int_aco_pme.h"
 #define private public //for testing reasons
 
 namespace energy
@@ -80,6 +83,7 @@ namespace energy
 				void print_E_head(std::ostream&, bool const endline = true) const;
 				void print_E_short(std::ostream&, bool const endline = true) const;
 				void print_G_tinkerlike(std::ostream&, bool const aggregate = false) const final override;
+				void print_nb_stats(std::ostream&) const override;
 				void to_stream(std::ostream&) const;
 				void swap(interface_base&);
 				void swap(aco_ff&);
@@ -109,8 +113,28 @@ namespace energy
 				static ::tinker::parameter::parameters cparams;
 				/** refined parameters */
 				::tinker::refine::refined refined;
+				/** pairlists with resolved parameters for the SoA kernel
+				(one for every combination of pair matrix and subsystem interaction,
+				index: pair matrix * number of interactions + interaction) */
+				std::vector<nb_soa_pairs> soa_pairs;
+				/** builds soa_pairs from the pair matrices in refined */
+				void update_soa_pairs(void);
+				/** order of the atoms in soa_pairs along a space-filling curve
+				(soa_order[k] = atom at position k, empty if atoms are in input order) */
+				std::vector<std::size_t> soa_order;
+				/** coordinates and gradients of the SoA kernel in the order of soa_order (scratch space) */
+				coords::Representation_3D soa_xyz, soa_grad;
+				/** thread-local gradient buffers of the non-bonded kernels
+				(scratch space which is reused between calculations, not copied) */
+				nb_grad_accumulator nb_accumulator;
 				/** selection of the correct nonbonded function*/
 				template< ::tinker::parameter::radius_types::T RADIUS_TYPE > void   g_nb(void);
+				/** grid of the reciprocal part of particle-mesh Ewald (set up with the first calculation) */
+				pme::reciprocal pme_grid;
+				/** charges in amber units for particle-mesh Ewald (determined with the first calculation) */
+				std::vector<coords::float_type> pme_charges;
+				/** reciprocal part of particle-mesh Ewald and correction for excluded and scaled pairs */
+				void g_pme(void);
 
 				/** Partial Energies for every atom */
 				std::array<coords::float_type, TYPENUM>  part_energy;
@@ -224,6 +248,14 @@ namespace energy
 					std::vector< ::tinker::refine::types::nbpair> const& pairs,
 					scon::matrix< ::tinker::parameter::combi::vdwc, true> const& parameters);
 
+				/** gradient function for non-bonded pairs using the SoA kernel
+				@param CUTOFF: cutoff applied true/false
+				@param PERIODIC: periodic boundaries true/false (needs CUTOFF)
+				@param EWALD: real-space coulomb of particle-mesh Ewald true/false (needs PERIODIC)*/
+				template< ::tinker::parameter::radius_types::T T_RADIUS_TYPE, bool CUTOFF, bool PERIODIC, bool EWALD>
+				void g_nb_QV_pairs_soa(coords::float_type& e_nb, coords::Representation_3D& grad_vector,
+					nb_soa_pairs const& pairs);
+
         /** FEP gradient function for non-bonded pairs
         depends on the fact if the current atom is appearing or disappearing
         @param T_RADIUS_TYPE: r_min or sigma
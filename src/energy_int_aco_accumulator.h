@@ -0,0 +1,134 @@
+/**
+This file contains the gradient accumulator used by the non-bonded kernels
+of amber, oplsaa and charmm forcefield.
+
+Every OpenMP thread adds the gradients of its pairs into a thread-local buffer.
+The buffers are allocated once (when the number of atoms or threads changes) and reused
+for all following energy calculations. After the pair loop the buffers are reduced in parallel:
+every thread sums one contiguous range of atoms over all buffers (in thread order)
+and zeroes that range again, so no thread waits in a critical section and the
+result does not depend on the order in which the threads finish.
+The virial tensors of the threads are merged in the same step.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "coords.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace energy
+{
+	namespace interfaces
+	{
+		namespace aco
+		{
+			class nb_grad_accumulator
+			{
+			public:
+
+				/**makes sure that there is one zeroed buffer of size atoms for every thread,
+				has to be called outside of the parallel region
+				@param atoms: number of atoms*/
+				void prepare(std::size_t const atoms)
+				{
+#if defined(_OPENMP)
+					std::size_t const threads(static_cast<std::size_t>(omp_get_max_threads()));
+#else
+					std::size_t const threads(1u);
+#endif
+					if (m_grad.size() != threads)
+					{
+						m_grad.resize(threads);
+						m_virial.assign(threads, coords::empty_virial());
+					}
+					for (auto& g : m_grad)
+					{
+						if (g.size() != atoms) g.assign(atoms, coords::Cartesian_Point(0.0, 0.0, 0.0));
+					}
+				}
+
+				/**gradient buffer of the calling thread*/
+				coords::Representation_3D& local()
+				{
+					return m_grad[thread()];
+				}
+
+				/**adds the buffers of all threads of the current team to grad and zeroes them,
+				has to be called by all threads of the team after the pair loop
+				@param grad: gradients (are increased)*/
+				void reduce(coords::Representation_3D& grad)
+				{
+					std::ptrdiff_t const N(grad.size());
+					std::size_t const T(team_size());
+#if defined(_OPENMP)
+#pragma omp barrier
+#pragma omp for schedule(static)
+#endif
+					for (std::ptrdiff_t i = 0; i < N; ++i)
+					{
+						for (std::size_t t = 0; t < T; ++t)
+						{
+							grad[i] += m_grad[t][i];
+							m_grad[t][i] = coords::Cartesian_Point(0.0, 0.0, 0.0);
+						}
+					}
+				}
+
+				/**same as reduce(grad), additionally the virial tensors of all threads are added to virial
+				@param grad: gradients (are increased)
+				@param local_virial: virial tensor of the calling thread
+				@param virial: total virial tensor (is increased)*/
+				template<class VIRIAL>
+				void reduce(coords::Representation_3D& grad, coords::virial_t const& local_virial, VIRIAL& virial)
+				{
+					m_virial[thread()] = local_virial;
+					reduce(grad);
+#if defined(_OPENMP)
+#pragma omp single
+#endif
+					{
+						std::size_t const T(team_size());
+						for (std::size_t t = 0; t < T; ++t)
+						{
+							for (int i = 0; i <= 2; i++) {
+								for (int k = 0; k <= 2; k++) {
+									virial[i][k] += m_virial[t][i][k];
+								}
+							}
+						}
+					}
+				}
+
+			private:
+
+				static std::size_t thread()
+				{
+#if defined(_OPENMP)
+					return static_cast<std::size_t>(omp_get_thread_num());
+#else
+					return 0u;
+#endif
+				}
+
+				static std::size_t team_size()
+				{
+#if defined(_OPENMP)
+					return static_cast<std::size_t>(omp_get_num_threads());
+#else
+					return 1u;
+#endif
+				}
+
+				/**one gradient buffer for every thread*/
+				std::vector<coords::Representation_3D> m_grad;
+				/**one virial tensor for every thread*/
+				std::vector<coords::virial_t> m_virial;
+			};
+		}
+	}
+}
@@ -0,0 +1,248 @@
+#include "energy_int_aco_pme.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "Scon/scon_angle.h"
+#include "Scon/scon_fft.h"
+
+coords::float_type energy::interfaces::aco::pme::ewald_coefficient(coords::float_type const cutoff,
+	coords::float_type const tolerance)
+{
+	if (!(cutoff > 0.0) || !(tolerance > 0.0) || !(tolerance < 1.0))
+		throw std::runtime_error("PME needs a positive cutoff and an Ewald tolerance between 0 and 1.");
+	coords::float_type low(0.0), high(1.0);
+	while (std::erfc(high * cutoff) > tolerance) high *= 2.0;
+	for (std::size_t i = 0u; i < 100u; ++i)   // bisection
+	{
+		coords::float_type const mid((low + high) / 2.0);
+		if (std::erfc(mid * cutoff) > tolerance) low = mid;
+		else high = mid;
+	}
+	return (low + high) / 2.0;
+}
+
+namespace
+{
+	/**cardinal B-spline M_n(x) (recursive definition)*/
+	coords::float_type bspline(std::size_t const n, coords::float_type const x)
+	{
+		if (n == 2u) return (x < 0.0 || x > 2.0) ? 0.0 : 1.0 - std::abs(x - 1.0);
+		coords::float_type const k(static_cast<coords::float_type>(n));
+		return (x * bspline(n - 1u, x) + (k - x) * bspline(n - 1u, x - 1.0)) / (k - 1.0);
+	}
+}
+
+void energy::interfaces::aco::pme::reciprocal::setup(coords::Cartesian_Point const& box, coords::float_type const alpha,
+	coords::float_type const spacing, std::size_t const order)
+{
+	if (box == m_box && alpha == m_alpha && spacing == m_spacing && order == m_order) return;
+	if (order < 3u) throw std::runtime_error("PME needs B-splines of at least order 3.");
+	if (!(spacing > 0.0)) throw std::runtime_error("PME grid spacing has to be positive.");
+	m_box = box;
+	m_alpha = alpha;
+	m_spacing = spacing;
+	m_order = order;
+	std::array<coords::float_type, 3u> const L{ { box.x(), box.y(), box.z() } };
+	for (std::size_t d = 0u; d < 3u; ++d)
+	{
+		std::size_t const points(static_cast<std::size_t>(std::ceil(L[d] / spacing)));
+		m_dim[d] = scon::fft::next_pow2(std::max(points, 2u * order));
+		// b-moduli: |sum_j M_n(j+1) exp(2 pi i jk/K)|^2
+		std::size_t const K(m_dim[d]);
+		m_moduli[d].assign(K, 0.0);
+		for (std::size_t k = 0u; k < K; ++k)
+		{
+			coords::float_type sc(0.0), ss(0.0);
+			for (std::size_t j = 0u; j + 1u < order; ++j)
+			{
+				coords::float_type const arg(2.0 * SCON_PI * static_cast<coords::float_type>(j * k) / static_cast<coords::float_type>(K));
+				coords::float_type const M(bspline(order, static_cast<coords::float_type>(j + 1u)));
+				sc += M * std::cos(arg);
+				ss += M * std::sin(arg);
+			}
+			m_moduli[d][k] = sc * sc + ss * ss;
+		}
+		// modulus vanishes at the nyquist frequency for odd orders
+		for (std::size_t k = 0u; k < K; ++k)
+		{
+			if (m_moduli[d][k] < 1e-7) m_moduli[d][k] = (m_moduli[d][(k + K - 1u) % K] + m_moduli[d][(k + 1u) % K]) / 2.0;
+		}
+	}
+	m_grid.assign(m_dim[0] * m_dim[1] * m_dim[2], std::complex<coords::float_type>());
+}
+
+/**weights theta[j] = M_n(fr + j) of the grid points first - j and their derivatives with respect to u
+where u is the position in grid units and fr its fractional part*/
+void energy::interfaces::aco::pme::reciprocal::splines(coords::float_type const u, std::size_t const d,
+	coords::float_type* theta, coords::float_type* dtheta, std::ptrdiff_t& first) const
+{
+	std::ptrdiff_t const K(static_cast<std::ptrdiff_t>(m_dim[d]));
+	coords::float_type const fl(std::floor(u));
+	coords::float_type const fr(u - fl);
+	first = static_cast<std::ptrdiff_t>(fl) % K;
+	if (first < 0) first += K;
+	std::size_t const n(m_order);
+	// order 2
+	for (std::size_t j = 0u; j < n; ++j) theta[j] = 0.0;
+	theta[0] = fr;
+	theta[1] = 1.0 - fr;
+	for (std::size_t k = 3u; k <= n; ++k)
+	{
+		if (k == n)
+		{
+			dtheta[0] = theta[0];
+			for (std::size_t j = 1u; j < n; ++j) dtheta[j] = theta[j] - theta[j - 1u];
+		}
+		// M_k(x) = (x*M_(k-1)(x) + (k-x)*M_(k-1)(x-1))/(k-1), from the back to use old values
+		coords::float_type const div(1.0 / static_cast<coords::float_type>(k - 1u));
+		for (std::size_t j = k - 1u; j > 0u; --j)
+		{
+			coords::float_type const x(fr + static_cast<coords::float_type>(j));
+			theta[j] = div * (x * theta[j] + (static_cast<coords::float_type>(k) - x) * theta[j - 1u]);
+		}
+		theta[0] = div * fr * theta[0];
+	}
+}
+
+coords::float_type energy::interfaces::aco::pme::reciprocal::energy(coords::Representation_3D const& xyz,
+	std::vector<coords::float_type> const& q, coords::Representation_3D& grad, coords::virial_t& virial)
+{
+	if (m_order == 0u) throw std::logic_error("PME grid is not set up.");
+	std::size_t const N(xyz.size()), n(m_order);
+	std::array<coords::float_type, 3u> const L{ { m_box.x(), m_box.y(), m_box.z() } };
+	std::array<std::ptrdiff_t, 3u> const K{ { static_cast<std::ptrdiff_t>(m_dim[0]),
+		static_cast<std::ptrdiff_t>(m_dim[1]), static_cast<std::ptrdiff_t>(m_dim[2]) } };
+	coords::float_type const V(L[0] * L[1] * L[2]);
+
+	// B-splines of all atoms
+	std::vector<coords::float_type> theta(N * 3u * n), dtheta(N * 3u * n);
+	std::vector<std::ptrdiff_t> first(N * 3u);
+#pragma omp parallel for
+	for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(N); ++i)
+	{
+		std::array<coords::float_type, 3u> const r{ { xyz[i].x(), xyz[i].y(), xyz[i].z() } };
+		for (std::size_t d = 0u; d < 3u; ++d)
+		{
+			coords::float_type const frac(r[d] / L[d] - std::floor(r[d] / L[d]));
+			std::size_t const offset((i * 3u + d) * n);
+			splines(frac * static_cast<coords::float_type>(K[d]), d, &theta[offset], &dtheta[offset], first[i * 3u + d]);
+		}
+	}
+
+	// spread charges onto the grid
+	std::fill(m_grid.begin(), m_grid.end(), std::complex<coords::float_type>());
+	for (std::size_t i = 0u; i < N; ++i)
+	{
+		coords::float_type const* tx(&theta[(i * 3u) * n]);
+		coords::float_type const* ty(&theta[(i * 3u + 1u) * n]);
+		coords::float_type const* tz(&theta[(i * 3u + 2u) * n]);
+		for (std::size_t jx = 0u; jx < n; ++jx)
+		{
+			std::ptrdiff_t const gx((first[i * 3u] - static_cast<std::ptrdiff_t>(jx) + K[0]) % K[0]);
+			for (std::size_t jy = 0u; jy < n; ++jy)
+			{
+				std::ptrdiff_t const gy((first[i * 3u + 1u] - static_cast<std::ptrdiff_t>(jy) + K[1]) % K[1]);
+				coords::float_type const qxy(q[i] * tx[jx] * ty[jy]);
+				for (std::size_t jz = 0u; jz < n; ++jz)
+				{
+					std::ptrdiff_t const gz((first[i * 3u + 2u] - static_cast<std::ptrdiff_t>(jz) + K[2]) % K[2]);
+					m_grid[(gx * K[1] + gy) * K[2] + gz] += qxy * tz[jz];
+				}
+			}
+		}
+	}
+
+	scon::fft::transform_3d(m_grid, m_dim, false);
+
+	// energy and virial, multiply structure factors with influence function
+	coords::float_type const fac(SCON_PI * SCON_PI / (m_alpha * m_alpha));
+	coords::float_type e_rec(0.0), vxx(0.0), vxy(0.0), vxz(0.0), vyy(0.0), vyz(0.0), vzz(0.0);
+#pragma omp parallel for reduction (+: e_rec, vxx, vxy, vxz, vyy, vyz, vzz)
+	for (std::ptrdiff_t kx = 0; kx < K[0]; ++kx)
+	{
+		coords::float_type const mx(static_cast<coords::float_type>(kx < (K[0] + 1) / 2 ? kx : kx - K[0]) / L[0]);
+		for (std::ptrdiff_t ky = 0; ky < K[1]; ++ky)
+		{
+			coords::float_type const my(static_cast<coords::float_type>(ky < (K[1] + 1) / 2 ? ky : ky - K[1]) / L[1]);
+			for (std::ptrdiff_t kz = 0; kz < K[2]; ++kz)
+			{
+				std::complex<coords::float_type>& s(m_grid[(kx * K[1] + ky) * K[2] + kz]);
+				if (kx == 0 && ky == 0 && kz == 0)
+				{
+					s = 0.0;
+					continue;
+				}
+				coords::float_type const mz(static_cast<coords::float_type>(kz < (K[2] + 1) / 2 ? kz : kz - K[2]) / L[2]);
+				coords::float_type const m2(mx * mx + my * my + mz * mz);
+				coords::float_type const denom(SCON_PI * V * m2 * m_moduli[0][kx] * m_moduli[1][ky] * m_moduli[2][kz]);
+				coords::float_type const eterm(std::exp(-fac * m2) / denom);
+				coords::float_type const ek(0.5 * eterm * std::norm(s));
+				coords::float_type const vterm(2.0 * (1.0 + fac * m2) / m2);
+				e_rec += ek;
+				vxx += ek * (vterm * mx * mx - 1.0);
+				vxy += ek * vterm * mx * my;
+				vxz += ek * vterm * mx * mz;
+				vyy += ek * (vterm * my * my - 1.0);
+				vyz += ek * vterm * my * mz;
+				vzz += ek * (vterm * mz * mz - 1.0);
+				s *= eterm;
+			}
+		}
+	}
+
+	scon::fft::transform_3d(m_grid, m_dim, true);
+
+	// gradients: derivative of the spread charges times convoluted grid
+#pragma omp parallel for
+	for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(N); ++i)
+	{
+		coords::float_type const* tx(&theta[(i * 3u) * n]);
+		coords::float_type const* ty(&theta[(i * 3u + 1u) * n]);
+		coords::float_type const* tz(&theta[(i * 3u + 2u) * n]);
+		coords::float_type const* dx(&dtheta[(i * 3u) * n]);
+		coords::float_type const* dy(&dtheta[(i * 3u + 1u) * n]);
+		coords::float_type const* dz(&dtheta[(i * 3u + 2u) * n]);
+		coords::float_type gx(0.0), gy(0.0), gz(0.0);
+		for (std::size_t jx = 0u; jx < n; ++jx)
+		{
+			std::ptrdiff_t const ix((first[i * 3u] - static_cast<std::ptrdiff_t>(jx) + K[0]) % K[0]);
+			for (std::size_t jy = 0u; jy < n; ++jy)
+			{
+				std::ptrdiff_t const iy((first[i * 3u + 1u] - static_cast<std::ptrdiff_t>(jy) + K[1]) % K[1]);
+				for (std::size_t jz = 0u; jz < n; ++jz)
+				{
+					std::ptrdiff_t const iz((first[i * 3u + 2u] - static_cast<std::ptrdiff_t>(jz) + K[2]) % K[2]);
+					coords::float_type const g(m_grid[(ix * K[1] + iy) * K[2] + iz].real());
+					gx += dx[jx] * ty[jy] * tz[jz] * g;
+					gy += tx[jx] * dy[jy] * tz[jz] * g;
+					gz += tx[jx] * ty[jy] * dz[jz] * g;
+				}
+			}
+		}
+		grad[i] += coords::Cartesian_Point(q[i] * gx * static_cast<coords::float_type>(K[0]) / L[0],
+			q[i] * gy * static_cast<coords::float_type>(K[1]) / L[1], q[i] * gz * static_cast<coords::float_type>(K[2]) / L[2]);
+	}
+
+	// self energy and energy of the neutralizing background
+	coords::float_type qq(0.0), qsum(0.0);
+	for (auto const c : q)
+	{
+		qq += c * c;
+		qsum += c;
+	}
+	coords::float_type const e_self(-m_alpha / std::sqrt(SCON_PI) * qq);
+	coords::float_type const e_net(-SCON_PI * qsum * qsum / (2.0 * V * m_alpha * m_alpha));
+
+	virial[0][0] += vxx - e_net;
+	virial[1][1] += vyy - e_net;
+	virial[2][2] += vzz - e_net;
+	virial[0][1] += vxy;
+	virial[1][0] += vxy;
+	virial[0][2] += vxz;
+	virial[2][0] += vxz;
+	virial[1][2] += vyz;
+	virial[2][1] += vyz;
+	return e_rec + e_self + e_net;
+}
@@ -0,0 +1,78 @@
+/**
+This file contains the smooth particle-mesh Ewald (PME) summation for the
+electrostatic interactions of amber, oplsaa and charmm forcefield
+(Essmann et al., J. Chem. Phys. 103, 8577 (1995)).
+
+The coulomb energy of a periodic system is split into
+- a real-space part q_i*q_j*erfc(alpha*r)/r which is calculated for all pairs within
+  the cutoff by the non-bonded kernel (see energy_int_aco_soa.h),
+- a reciprocal-space part which is calculated here: the charges are spread onto a grid with
+  cardinal B-splines, the grid is transformed with a 3D FFT (see Scon/scon_fft.h),
+  multiplied with the influence function and transformed back to get the gradients,
+- a self term -alpha/sqrt(pi) * sum q_i^2 and a correction for systems with net charge,
+- a correction for the excluded and scaled bonded pairs (done by aco_ff::g_pme).
+
+Only orthorhombic boxes are supported (like everywhere else in CAST).
+Charges are given in "amber units", i.e. q_i*q_j is the coulomb prefactor in kcal/mol*angstrom.
+*/
+
+#pragma once
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include "coords.h"
+
+namespace energy
+{
+	namespace interfaces
+	{
+		namespace aco
+		{
+			namespace pme
+			{
+				/**Ewald coefficient alpha for which erfc(alpha*cutoff) equals tolerance*/
+				coords::float_type ewald_coefficient(coords::float_type const cutoff, coords::float_type const tolerance);
+
+				/**reciprocal-space part of the PME summation on an orthorhombic box*/
+				class reciprocal
+				{
+				public:
+					/**prepares the grid (does nothing if all parameters are unchanged)
+					@param box: periodic box
+					@param alpha: Ewald coefficient
+					@param spacing: maximum distance of grid points (grid sizes are rounded up to powers of two)
+					@param order: order of the B-splines (4 = cubic)*/
+					void setup(coords::Cartesian_Point const& box, coords::float_type const alpha,
+						coords::float_type const spacing, std::size_t const order);
+
+					/**reciprocal energy including self and net charge terms
+					@param xyz: cartesian coordinates
+					@param q: charges in amber units
+					@param grad: gradients (are increased)
+					@param virial: virial (is increased)*/
+					coords::float_type energy(coords::Representation_3D const& xyz, std::vector<coords::float_type> const& q,
+						coords::Representation_3D& grad, coords::virial_t& virial);
+
+					/**number of grid points in every direction*/
+					std::array<std::size_t, 3u> const& dimensions() const { return m_dim; }
+
+				private:
+					/**B-spline weights and their derivatives of one atom in one direction*/
+					void splines(coords::float_type const u, std::size_t const d,
+						coords::float_type* theta, coords::float_type* dtheta, std::ptrdiff_t& first) const;
+
+					coords::Cartesian_Point m_box;
+					coords::float_type m_alpha{ 0.0 }, m_spacing{ 0.0 };
+					std::size_t m_order{ 0u };
+					std::array<std::size_t, 3u> m_dim{ { 0u, 0u, 0u } };
+					/**squared absolute values of the B-spline structure factors (b-moduli) for every direction*/
+					std::array<std::vector<coords::float_type>, 3u> m_moduli;
+					/**charge grid, index = (x*ny + y)*nz + z */
+					std::vector<std::complex<coords::float_type>> m_grid;
+				};
+			}
+		}
+	}
+}
@@ -2,6 +2,7 @@
 This file contains the calculation of energy and gradients for amber, oplsaa and charmm forcefield.
 */
 
+#include <algorithm>
 #include <cmath>
 #include <stddef.h>
 #include <stdexcept>
@@ -86,6 +87,10 @@ void energy::interfaces::aco::aco_ff::calc(void)
   {
     g_nb< ::tinker::parameter::radius_types::SIGMA>();
   }
+  if (Config::get().energy.pme.on)
+  {
+    g_pme();   // adds to part_energy[CHARGE] and part_grad[CHARGE]
+  }
 
 	if (Config::get().energy.qmmm.mm_charges.size() != 0)
 	{
@@ -1231,8 +1236,26 @@ namespace energy
 				coords->getFep().feptemp = energy::fepvect();
 				for (auto& ia : coords->interactions()) ia.energy = 0.0;
 
-        for (auto const &pairmatrix : refined.pair_matrices())
+        // particle-mesh Ewald: real-space part is always calculated by the SoA kernel
+        bool const use_pme = Config::get().energy.pme.on;
+        if (use_pme && (!Config::get().periodics.periodic || Config::get().md.fep))
         {
+          throw std::runtime_error("Particle-mesh Ewald needs periodic boundaries and is not available for FEP calculations.");
+        }
+        bool const use_soa = (Config::get().energy.nb_soa || use_pme) && !Config::get().md.fep;
+        if (use_soa && soa_pairs.size() != refined.pair_matrices().size() * coords->interactions().size())
+        {
+          update_soa_pairs();
+        }
+        if (use_soa && !soa_order.empty())
+        {   // coordinates in the order of the SoA pairlists
+          soa_xyz.resize(soa_order.size());
+          for (std::size_t k(0u); k < soa_order.size(); ++k) soa_xyz[k] = coords->xyz(soa_order[k]);
+        }
+
+        for (size_t pm_index(0u); pm_index < refined.pair_matrices().size(); ++pm_index)
+        {
+          auto const &pairmatrix = refined.pair_matrices()[pm_index];
           size_t const N(coords->interactions().size());
           for (size_t sub_ia_index(0u), row(0u), col(0u); sub_ia_index < N; ++sub_ia_index)
           {
@@ -1264,6 +1287,18 @@ namespace energy
                   g_nb_QV_pairs<RT>(e, g, pl, par);
               }
             }
+            else if (use_soa)
+            {
+              nb_soa_pairs const & soa(soa_pairs[pm_index * N + sub_ia_index]);
+              if (use_pme)
+                g_nb_QV_pairs_soa<RT, true, true, true>(e, g, soa);
+              else if (Config::get().periodics.periodic)
+                g_nb_QV_pairs_soa<RT, true, true, false>(e, g, soa);
+              else if (Config::get().energy.cutoff < 1000.0)
+                g_nb_QV_pairs_soa<RT, true, false, false>(e, g, soa);
+              else
+                g_nb_QV_pairs_soa<RT, false, false, false>(e, g, soa);
+            }
             else   // no fep
             {
               if (Config::get().periodics.periodic)
@@ -1588,9 +1623,10 @@ namespace energy
 			{
 				std::ptrdiff_t const M(pairlist.size());
 				coords::float_type e_c(0.0), e_v(0.0);
+				nb_accumulator.prepare(grad_vector.size());
 #pragma omp parallel
 				{
-					coords::Representation_3D tmp_grad(grad_vector.size());
+					coords::Representation_3D& tmp_grad = nb_accumulator.local();
 #pragma omp for reduction (+: e_c, e_v)
 					for (std::ptrdiff_t i = 0; i < M; ++i)       // for every pair in pairlist
 					{
@@ -1617,10 +1653,7 @@ namespace energy
 						tmp_grad[pairlist[i].a] += b;
 						tmp_grad[pairlist[i].b] -= b;
 					}
-#pragma omp critical (nb_g_sum)
-					{
-						grad_vector += tmp_grad;
-					}
+					nb_accumulator.reduce(grad_vector);
 				}
 				e_nb += e_c + e_v;
 
@@ -1639,9 +1672,10 @@ namespace energy
 				nb_cutoff cutob(Config::get().energy.cutoff, Config::get().energy.switchdist);
 				coords::float_type e_c(0.0), e_v(0.0);
 				std::ptrdiff_t const M(pairlist.size());
+				nb_accumulator.prepare(grad_vector.size());
 #pragma omp parallel
 				{
-					coords::Representation_3D tmp_grad(grad_vector.size());
+					coords::Representation_3D& tmp_grad = nb_accumulator.local();
 					coords::virial_t tempvir(coords::empty_virial());
 #pragma omp for reduction (+: e_c, e_v)
 					for (std::ptrdiff_t i = 0; i < M; ++i)  //for every pair in pairlist
@@ -1694,15 +1728,7 @@ namespace energy
 						tempvir[1][2] += vzy;
 						tempvir[2][2] += vzz;
 					}
-#pragma omp critical (nb_g_sum)
-					{
-						grad_vector += tmp_grad;
-						for (int i = 0; i <= 2; i++) {
-							for (int k = 0; k <= 2; k++) {
-								part_virial[VDWC][i][k] += tempvir[i][k];
-							}
-						}
-					}
+					nb_accumulator.reduce(grad_vector, tempvir, part_virial[VDWC]);
 				}
 				e_nb += e_c + e_v;
 				part_energy[types::CHARGE] += e_c;
@@ -1721,9 +1747,10 @@ namespace energy
 				coords::float_type e_c(0.0), e_v(0.0), e_c_l(0.0), e_vdw_l(0.0), e_c_dl(0.0), e_vdw_dl(0.0), e_c_ml(0.0), e_vdw_ml(0.0);
 				fepvar const& fep = coords->getFep().window[coords->getFep().window[0].step];
 				std::ptrdiff_t const M(pairlist.size());
+				nb_accumulator.prepare(grad_vector.size());
 #pragma omp parallel
 				{
-					coords::Representation_3D tmp_grad(grad_vector.size());
+					coords::Representation_3D& tmp_grad = nb_accumulator.local();
 					coords::virial_t tempvir(coords::empty_virial());
 #pragma omp for reduction (+: e_c, e_v, e_c_l, e_c_dl, e_vdw_l, e_vdw_dl, e_c_ml, e_vdw_ml)
 					for (std::ptrdiff_t i = 0; i < M; ++i)      //for every pair in pairlist
@@ -1846,15 +1873,7 @@ namespace energy
 						tempvir[1][2] += vzy;
 						tempvir[2][2] += vzz;
 					}
-#pragma omp critical (nb_g_sum)
-					{
-						grad_vector += tmp_grad;
-						for (int i = 0; i <= 2; i++) {
-							for (int k = 0; k <= 2; k++) {
-								part_virial[VDWC][i][k] += tempvir[i][k];
-							}
-						}
-					}
+					nb_accumulator.reduce(grad_vector, tempvir, part_virial[VDWC]);
 				}
 				e_nb += e_c + e_v;
 				coords->getFep().feptemp.e_c_l1 += e_c_l;    //lambda (Coulomb energy)
@@ -1869,6 +1888,108 @@ namespace energy
 
 #endif
 
+			/**non-bonded energies and gradients with the structure-of-arrays kernel (see energy_int_aco_soa.h)*/
+			template< ::tinker::parameter::radius_types::T RT, bool CUTOFF, bool PERIODIC, bool EWALD>
+			void energy::interfaces::aco::aco_ff::g_nb_QV_pairs_soa
+			(
+				coords::float_type& e_nb, coords::Representation_3D& grad_vector,
+				nb_soa_pairs const& pairlist
+			)
+			{
+				nb_soa::geometry const geo(Config::get().energy.cutoff, Config::get().energy.switchdist, Config::get().periodics.pb_box,
+					EWALD ? pme::ewald_coefficient(Config::get().energy.cutoff, Config::get().energy.pme.tolerance) : 0.0);
+				// atoms of the pairlist are renumbered if they are sorted along a space-filling curve
+				bool const reordered(!soa_order.empty());
+				coords::Representation_3D const& xyz = reordered ? soa_xyz : coords->xyz();
+				if (reordered) soa_grad.assign(grad_vector.size(), coords::Cartesian_Point(0.0, 0.0, 0.0));
+				coords::Representation_3D& target = reordered ? soa_grad : grad_vector;
+				std::ptrdiff_t const M(pairlist.size());
+				std::ptrdiff_t const L(nb_soa::lanes);
+				std::ptrdiff_t const blocks((M + L - 1) / L);
+				coords::float_type e_c(0.0), e_v(0.0);
+				nb_accumulator.prepare(grad_vector.size());
+#pragma omp parallel
+				{
+					coords::Representation_3D& tmp_grad = nb_accumulator.local();
+					coords::virial_t tempvir(coords::empty_virial());
+#pragma omp for reduction (+: e_c, e_v)
+					for (std::ptrdiff_t i = 0; i < blocks; ++i)   // for every block of pairs
+					{
+						std::ptrdiff_t const first = i * L;
+						nb_soa::block<RT, CUTOFF, PERIODIC, EWALD>(pairlist, first, std::min(L, M - first),
+							xyz, geo, e_c, e_v, tmp_grad, tempvir);
+					}
+					if (CUTOFF) nb_accumulator.reduce(target, tempvir, part_virial[VDWC]);
+					else nb_accumulator.reduce(target);
+				}
+				if (reordered)
+				{
+					for (std::size_t k = 0u; k < soa_order.size(); ++k) grad_vector[soa_order[k]] += soa_grad[k];
+				}
+				e_nb += e_c + e_v;
+				part_energy[types::CHARGE] += e_c;
+				part_energy[types::VDW] += e_v;
+			}
+
+			/**reciprocal-space part of particle-mesh Ewald (see energy_int_aco_pme.h)
+			and correction for the pairs that are excluded or scaled in the real-space part*/
+			void energy::interfaces::aco::aco_ff::g_pme(void)
+			{
+				auto const& box = Config::get().periodics.pb_box;
+				coords::float_type const alpha = pme::ewald_coefficient(Config::get().energy.cutoff, Config::get().energy.pme.tolerance);
+				pme_grid.setup(box, alpha, Config::get().energy.pme.spacing, Config::get().energy.pme.order);
+				bool const amber_charges = Config::get().general.input == config::input_types::AMBER || Config::get().general.chargefile;
+				if (pme_charges.size() != coords->size())
+				{
+					// charges in amber units (i.e. q_a*q_b is the coulomb prefactor)
+					pme_charges = charges();
+					for (auto& q : pme_charges) q *= amber_charges ? 18.2223 : std::sqrt(cparams.general().electric);
+				}
+				part_energy[types::CHARGE] += pme_grid.energy(coords->xyz(), pme_charges, part_grad[types::CHARGE], part_virial[types::CHARGE]);
+
+				// the reciprocal part contains q_a*q_b*erf(alpha*r)/r of every pair
+				// which has to be removed for excluded pairs (s = 0) and scaled for scaled pairs
+				coords::float_type e_corr(0.0);
+				coords::float_type const alpha_pi(2.0 * alpha / std::sqrt(SCON_PI));
+				for (std::size_t a = 0u; a < coords->size(); ++a)
+				{
+					for (std::size_t rel = ::tinker::refine::refined::R12; rel < ::tinker::refine::refined::R1N; ++rel)
+					{
+						coords::float_type scale(1.0);
+						if (!cparams.vdwc_used(rel)) scale = 0.0;
+						else if (!amber_charges && !refined.vdwcm(rel).empty()) scale = cparams.general().chg_scale.factor(rel);
+						for (auto const b : refined.relations(rel, a))
+						{
+							coords::float_type const s = scon::sorted::exists(refined.remove_relations(a), b) ? 0.0 : scale;
+							if (s == 1.0) continue;
+							coords::Cartesian_Point d(coords->xyz(a) - coords->xyz(b));
+							d.x() -= box.x() * std::round(d.x() / box.x());
+							d.y() -= box.y() * std::round(d.y() / box.y());
+							d.z() -= box.z() * std::round(d.z() / box.z());
+							coords::float_type const r = std::sqrt(dot(d, d));
+							coords::float_type const C = (s - 1.0) * pme_charges[a] * pme_charges[b];
+							coords::float_type const erf_ar = std::erf(alpha * r);
+							e_corr += C * erf_ar / r;
+							coords::float_type const dE = C * (alpha_pi * std::exp(-alpha * alpha * r * r) / r - erf_ar / (r * r)) / r;
+							coords::Cartesian_Point const g(d * dE);
+							part_grad[types::CHARGE][a] += g;
+							part_grad[types::CHARGE][b] -= g;
+							auto& vir = part_virial[types::CHARGE];
+							vir[0][0] += g.x() * d.x();
+							vir[1][0] += g.x() * d.y();
+							vir[2][0] += g.x() * d.z();
+							vir[0][1] += g.y() * d.x();
+							vir[1][1] += g.y() * d.y();
+							vir[2][1] += g.y() * d.z();
+							vir[0][2] += g.z() * d.x();
+							vir[1][2] += g.z() * d.y();
+							vir[2][2] += g.z() * d.z();
+						}
+					}
+				}
+				part_energy[types::CHARGE] += e_corr;
+			}
+
 		}
 	}
 }
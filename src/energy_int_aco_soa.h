@@ -0,0 +1,272 @@
+/**
+This file contains the structure-of-arrays (SoA) kernel for the non-bonded
+interactions of amber, oplsaa and charmm forcefield.
+
+The pair list of one interaction matrix is stored as separate arrays of atom indices,
+charge products and Lennard-Jones parameters which are resolved once when the list is built.
+The kernel works on blocks of nb_soa::lanes pairs: coordinates are gathered into
+block-local arrays, the coulomb and vdW math is done in a loop over the lanes that
+the compiler can map onto AVX2/AVX-512 registers (depending on the target architecture)
+and the results are scattered back pair by pair.
+
+The arithmetic of every pair is exactly the one of aco_ff::g_QV and aco_ff::g_QV_cutoff,
+and energies, gradients and virials are accumulated in pair order, so the results
+are identical to the scalar path (for the same distribution of pairs onto threads).
+With particle-mesh Ewald the kernel calculates the real-space coulomb part C*erfc(alpha*r)/r
+(without switching function) instead, see energy_int_aco_pme.h.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "coords.h"
+#include "tinker_parameters.h"
+#include "Scon/scon_angle.h"
+
+namespace energy
+{
+	namespace interfaces
+	{
+		namespace aco
+		{
+			/**non-bonded pair list of one interaction matrix in structure-of-arrays layout*/
+			struct nb_soa_pairs
+			{
+				/**index of first atom of every pair*/
+				std::vector<std::size_t> a;
+				/**index of second atom of every pair*/
+				std::vector<std::size_t> b;
+				/**charge product (in amber units)*/
+				std::vector<coords::float_type> C;
+				/**epsilon-parameter or 4*epsilon-parameter*/
+				std::vector<coords::float_type> E;
+				/**r_min- or sigma-parameter*/
+				std::vector<coords::float_type> R;
+
+				std::size_t size() const { return a.size(); }
+				bool empty() const { return a.empty(); }
+				void reserve(std::size_t const n)
+				{
+					a.reserve(n);
+					b.reserve(n);
+					C.reserve(n);
+					E.reserve(n);
+					R.reserve(n);
+				}
+				void push_back(std::size_t const ia, std::size_t const ib, coords::float_type const c,
+					coords::float_type const e, coords::float_type const r)
+				{
+					a.push_back(ia);
+					b.push_back(ib);
+					C.push_back(c);
+					E.push_back(e);
+					R.push_back(r);
+				}
+				/**sorts the pairs by first and second atom index*/
+				void sort()
+				{
+					std::vector<std::size_t> index(size());
+					for (std::size_t i = 0u; i < index.size(); ++i) index[i] = i;
+					std::sort(index.begin(), index.end(), [this](std::size_t const i, std::size_t const j) {
+						return a[i] < a[j] || (a[i] == a[j] && b[i] < b[j]); });
+					nb_soa_pairs sorted;
+					sorted.reserve(size());
+					for (auto const i : index) sorted.push_back(a[i], b[i], C[i], E[i], R[i]);
+					*this = std::move(sorted);
+				}
+			};
+
+			namespace nb_soa
+			{
+				/**number of pairs which are processed together
+				(8 doubles fill one AVX-512 register or two AVX2 registers)*/
+				std::size_t constexpr lanes = 8u;
+
+				/**cutoff and box information needed by the kernel*/
+				struct geometry
+				{
+					/**cutoff distance*/
+					coords::float_type c;
+					/**switchdist*/
+					coords::float_type s;
+					/**c*c, 3*s*s and (cc-s*s)^3 (same as in nb_cutoff)*/
+					coords::float_type cc, ss, cs;
+					/**periodic box and half of it*/
+					coords::Cartesian_Point box, halfbox;
+					/**Ewald coefficient and 2*alpha/sqrt(pi) (only used with particle-mesh Ewald)*/
+					coords::float_type alpha, alpha_pi;
+
+					geometry(coords::float_type const cutoff, coords::float_type const switchdist,
+						coords::Cartesian_Point const& pb_box, coords::float_type const ewald_alpha = 0.0)
+						: c(cutoff), s(switchdist), cc(c* c), ss(3.0 * s * s),
+						cs((cc - s * s)* (cc - s * s)* (cc - s * s)),
+						box(pb_box), halfbox(pb_box / 2.0),
+						alpha(ewald_alpha), alpha_pi(2.0 * ewald_alpha / std::sqrt(SCON_PI))
+					{ }
+				};
+
+				/**lennard-jones energy and gradient (same as aco_ff::gV)
+				@param E: epsilon-parameter or 4*epsilon-parameter
+				@param R: r_min- or sigma-parameter
+				@param d: inverse distance
+				@param dV: absolute value of gradient*/
+				template< ::tinker::parameter::radius_types::T RT>
+				inline coords::float_type lj(coords::float_type const E, coords::float_type const R,
+					coords::float_type const d, coords::float_type& dV);
+
+				template<>
+				inline coords::float_type lj< ::tinker::parameter::radius_types::R_MIN>(coords::float_type const E,
+					coords::float_type const R, coords::float_type const d, coords::float_type& dV)
+				{
+					coords::float_type T = R * d;
+					T = T * T * T; // T^3
+					T = T * T; // T^6
+					coords::float_type const V = E * T;
+					dV = 12.0 * V * d * (1.0 - T);
+					return V * (T - 2.0);
+				}
+
+				template<>
+				inline coords::float_type lj< ::tinker::parameter::radius_types::SIGMA>(coords::float_type const E,
+					coords::float_type const R, coords::float_type const d, coords::float_type& dV)
+				{
+					coords::float_type T = R * d;
+					T = T * T * T; // T^3
+					T = T * T; // T^6
+					coords::float_type const V = E * T;
+					dV = V * d * (6.0 - 12.0 * T);
+					return V * (T - 1.0);
+				}
+
+				/**calculates coulomb and vdW energies, gradients and (if CUTOFF) the virial
+				for the pairs [first, first+n) of the pairlist with n <= lanes
+				@param pairs: pairlist
+				@param xyz: cartesian coordinates
+				@param geo: cutoff and box
+				@param e_c: coulomb energy (is increased)
+				@param e_v: vdW energy (is increased)
+				@param grad: gradients (are increased)
+				@param virial: virial tensor (is increased if CUTOFF)
+				@param EWALD: real-space part of particle-mesh Ewald for coulomb (needs PERIODIC)*/
+				template< ::tinker::parameter::radius_types::T RT, bool CUTOFF, bool PERIODIC, bool EWALD>
+				inline void block(nb_soa_pairs const& pairs, std::size_t const first, std::size_t const n,
+					coords::Representation_3D const& xyz, geometry const& geo,
+					coords::float_type& e_c, coords::float_type& e_v,
+					coords::Representation_3D& grad, coords::virial_t& virial)
+				{
+					static_assert(CUTOFF || !PERIODIC, "Periodic boundaries always need a cutoff.");
+					static_assert(PERIODIC || !EWALD, "Ewald summation needs periodic boundaries.");
+
+					coords::float_type dx[lanes], dy[lanes], dz[lanes];
+					coords::float_type C[lanes], E[lanes], R[lanes];
+					coords::float_type ec[lanes], ev[lanes], dE[lanes];
+					bool in[lanes];
+
+					// gather
+					for (std::size_t k = 0; k < n; ++k)
+					{
+						auto const& pa = xyz[pairs.a[first + k]];
+						auto const& pb = xyz[pairs.b[first + k]];
+						dx[k] = pa.x() - pb.x();
+						dy[k] = pa.y() - pb.y();
+						dz[k] = pa.z() - pb.z();
+						C[k] = pairs.C[first + k];
+						E[k] = pairs.E[first + k];
+						R[k] = pairs.R[first + k];
+					}
+
+					// math
+#pragma omp simd
+					for (std::size_t k = 0; k < n; ++k)
+					{
+						if (PERIODIC)
+						{
+							dx[k] = dx[k] > geo.halfbox.x() ? dx[k] - geo.box.x() : (dx[k] < -geo.halfbox.x() ? dx[k] + geo.box.x() : dx[k]);
+							dy[k] = dy[k] > geo.halfbox.y() ? dy[k] - geo.box.y() : (dy[k] < -geo.halfbox.y() ? dy[k] + geo.box.y() : dy[k]);
+							dz[k] = dz[k] > geo.halfbox.z() ? dz[k] - geo.box.z() : (dz[k] < -geo.halfbox.z() ? dz[k] + geo.box.z() : dz[k]);
+						}
+						coords::float_type const rr = dx[k] * dx[k] + dy[k] * dy[k] + dz[k] * dz[k];
+						if (CUTOFF)
+						{
+							// scaling factors (see nb_cutoff::factors)
+							coords::float_type const r = std::sqrt(rr);
+							in[k] = !(r > geo.c) && std::abs(r) > 0.0;
+							coords::float_type const cr(geo.cc - rr);
+							coords::float_type const fV = r < geo.s ? 1.0 : (cr * cr * (geo.cc + 2.0 * rr - geo.ss)) / geo.cs;
+							coords::float_type const fQ = (1.0 - rr / geo.cc) * (1.0 - rr / geo.cc);
+							// energies and gradients (see aco_ff::g_QV_cutoff)
+							coords::float_type const d = 1.0 / r;
+							coords::float_type const rd = 1.0 / d;
+							coords::float_type const c = geo.c, s = geo.s;
+							coords::float_type dV(0.0);
+							coords::float_type const Q = C[k] * d;
+							coords::float_type const dQ = -Q * d;
+							coords::float_type const V = lj<RT>(E[k], R[k], d, dV);
+							coords::float_type dE_Q = dQ * fQ;
+							coords::float_type dE_V = dV * fV;
+							if (rd < c) {                 // scaling factor is not constant but also changes with r
+								if (!EWALD) dE_Q += Q * (4.0 * rd * (rd * rd - c * c)) / (c * c * c * c);
+								if (rd > s) dE_V += V * (-12.0 * rd * (c * c - rd * rd) * (rd * rd - s * s)) / ((c * c - s * s) * (c * c - s * s) * (c * c - s * s));
+							}
+							if (EWALD)
+							{
+								// real-space part: C*erfc(alpha*r)/r
+								coords::float_type const ar = geo.alpha * rd;
+								coords::float_type const erfc_ar = std::erfc(ar);
+								ec[k] = Q * erfc_ar;
+								dE_Q = dQ * erfc_ar - C[k] * d * geo.alpha_pi * std::exp(-ar * ar);
+							}
+							else ec[k] = Q * fQ;
+							ev[k] = V * fV;
+							dE[k] = (dE_Q + dE_V) * d;
+						}
+						else
+						{
+							// energies and gradients (see aco_ff::g_QV)
+							in[k] = true;
+							coords::float_type const d = 1.0 / std::sqrt(rr);
+							coords::float_type dV(0.0);
+							coords::float_type const Q = C[k] * d;
+							coords::float_type const dQ = -Q * d;
+							ec[k] = Q;
+							ev[k] = lj<RT>(E[k], R[k], d, dV);
+							dE[k] = (dQ + dV) * d;
+						}
+					}
+
+					// scatter
+					for (std::size_t k = 0; k < n; ++k)
+					{
+						if (!in[k]) continue;
+						e_c += ec[k];
+						e_v += ev[k];
+						coords::Cartesian_Point const b(dx[k] * dE[k], dy[k] * dE[k], dz[k] * dE[k]);
+						grad[pairs.a[first + k]] += b;
+						grad[pairs.b[first + k]] -= b;
+						if (CUTOFF)
+						{
+							coords::float_type const vxx = b.x() * dx[k];
+							coords::float_type const vyx = b.x() * dy[k];
+							coords::float_type const vzx = b.x() * dz[k];
+							coords::float_type const vyy = b.y() * dy[k];
+							coords::float_type const vzy = b.y() * dz[k];
+							coords::float_type const vzz = b.z() * dz[k];
+							virial[0][0] += vxx;
+							virial[1][0] += vyx;
+							virial[2][0] += vzx;
+							virial[0][1] += vyx;
+							virial[1][1] += vyy;
+							virial[2][1] += vzy;
+							virial[0][2] += vzx;
+							virial[1][2] += vzy;
+							virial[2][2] += vzz;
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -14,8 +14,6 @@ energy::interfaces::amoeba::amoeba_ff::amoeba_ff(coords::Coordinates* cobj)
 	for (auto atom : (*cobj).atoms()) scon::sorted::insert_unique(ntypes, atom.energy_type());
 	cparams = tp.contract(ntypes);
 	refined = ::tinker::refine::refined(*cobj, cparams);
-	parameters();
-	Spackman_list_analytical1();
 
 }
 
@@ -23,14 +21,14 @@ energy::interfaces::amoeba::amoeba_ff::amoeba_ff(coords::Coordinates* cobj)
 
 energy::interfaces::amoeba::amoeba_ff::amoeba_ff(amoeba_ff const& rhs, coords::Coordinates* cobj)
 	: interface_base(cobj), part_grad(rhs.part_grad), part_energy(rhs.part_energy),
-	cparams(rhs.cparams), refined(rhs.refined)
+	cparams(rhs.cparams), refined(rhs.refined), spackman(rhs.spackman)
 {
 	interface_base::operator=(rhs);
 }
 
 energy::interfaces::amoeba::amoeba_ff::amoeba_ff(amoeba_ff&& rhs, coords::Coordinates* cobj)
 	: interface_base(cobj), part_grad(std::move(rhs.part_grad)), part_energy(std::move(rhs.part_energy)),
-	cparams(std::move(rhs.cparams)), refined(std::move(rhs.refined))
+	cparams(std::move(rhs.cparams)), refined(std::move(rhs.refined)), spackman(std::move(rhs.spackman))
 {
 	interface_base::swap(rhs);
 }
@@ -46,6 +44,7 @@ void energy::interfaces::amoeba::amoeba_ff::swap(amoeba_ff& rhs)
 	refined.swap_data(rhs.refined);
 	std::swap(cparams, rhs.cparams);
 	std::swap(part_energy, rhs.part_energy);
+	spackman.swap(rhs.spackman);
 	for (size_t i(0u); i < part_grad.size(); ++i) part_grad[i].swap(rhs.part_grad[i]);
 }
 
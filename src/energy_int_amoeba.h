@@ -4,6 +4,9 @@
 #include "tinker_refine.h"
 #include "coords.h"
 #include "interpolation.h"
+#include "energy_int_aco_accumulator.h"
+#include "energy_int_amoeba_polarization.h"
+#include "energy_int_amoeba_spackman.h"
 
 namespace energy
 {
@@ -67,6 +70,13 @@ namespace energy
 				void swap(interface_base&);
 				void swap(amoeba_ff&);
 
+				/**energy of the permanent multipoles and of the polarization of the last evaluation*/
+				double multipole_energy() const { return em; }
+				double polarization_energy() const { return ep; }
+				/**gradients of the permanent multipoles and of the polarization of the last evaluation*/
+				coords::Representation_3D const& multipole_gradients() const { return part_grad[MULTIPOLE]; }
+				coords::Representation_3D const& polarization_gradients() const { return part_grad[POLARIZE]; }
+
 
 
 				//!Definition of SPACKMAN-Variables and Functions
@@ -127,19 +137,12 @@ namespace energy
 				double energy_short_analytical;
 				double energy_total;
 				double fff;
-				bool SPACKrefine;
-				std::vector<double> dex11, dex22, dex33, exa11, exa22, exa33;
-				std::vector<double> dex44, dex55, dex66, exa44, exa55, exa66;
-				std::vector<double> dex77, dex88, dex99, dex1010, exa77, exa88, exa99, exa1010;
-				std::vector<double> dex0, xvec1, evec1, eveca1;
+				std::vector<double> dex0, xvec1, evec1;
 
 				std::vector<atom>     atoms;
 				std::vector<bond>     bonds;
 				std::vector<n>        nij1;
 				std::vector<z>        zeta;
-				std::vector <std::vector <float> > zetax, cs;
-				std::vector <double> kappan;
-				std::vector <std::vector <ptrdiff_t> > nijx, occ;
 
 
 				std::vector <std::vector<float> > zetan;
@@ -178,14 +181,12 @@ namespace energy
 				std::vector < ccoord > ccenter;
 
 				void Spackman_mol(void);
-				void parameters();
 
 				void SpackmanGrad_3(void);
 				void Spackman_GRAD(void);
 
 				void Spackman_vec(void);
 				void Spackman_list(void);
-				void Spackman_list_analytical1(void);
 				double fvalue_f(ptrdiff_t, ptrdiff_t);
 				double fvalue_f_2(ptrdiff_t, double, ptrdiff_t);
 				double fff_f1(size_t, double, double);
@@ -214,6 +215,8 @@ namespace energy
 				static ::tinker::parameter::parameters tp;
 				::tinker::parameter::parameters cparams;
 				::tinker::refine::refined refined;
+				/**tables of the Spackman correction, shared by all instances (read when the correction is switched on)*/
+				std::shared_ptr<spackman_tables const> spackman;
 				::tinker::parameter::multipole multi;
 				::tinker::refine::types::multipole types;
 				::tinker::refine::types::binary_quadratic binary;
@@ -256,10 +259,20 @@ namespace energy
 
 				// multipole gradients and energies
 				void e_perm(void);
+				/**adds the multipole and polarization energies and gradients of the rows first, first + step, ...
+				to the buffers of one thread*/
+				void e_perm_rows(std::size_t const first, std::size_t const step, double const cutoff, double const cc,
+					std::vector <std::vector <double> >& local_dem, std::vector <std::vector <double> >& local_dep,
+					double& local_em, double& local_ep) const;
 
 
 
 				void e_ind(void);
+				/**adds the direct fields of the rows first, first + step, ... to the buffers of one thread
+				and collects the pairs of the mutual induction which are not scaled by one*/
+				void e_ind_rows(std::size_t const first, std::size_t const step, std::size_t const alloc, double const cutoff,
+					std::vector <std::vector <double> >& local_field, std::vector <std::vector <double> >& local_fieldp,
+					std::vector <polarization_solver::scaled_pair>& local_scaled) const;
 				inline size_t multipole_sites(void);
 				void rot_matrix(coords::Representation_3D const& pos);
 				//std::std::vector <double> ci, dx, dy, dz, qxx, qyy, qzz, qxy, qxz, qyx, qyz, qzx, qzy;
@@ -285,9 +298,14 @@ namespace energy
 				//multipole rotation into coordinate framework
 
 				std::vector < std::vector <double> > uind, uinp;
+				/**solver for uind and uinp, keeps the dipoles of the previous calls for the starting guess*/
+				polarization_solver polarization;
+				/**thread-local gradient buffers of the van der Waals loops
+				(scratch space which is reused between calculations, not copied)*/
+				aco::nb_grad_accumulator nb_accumulator;
 				std::vector < size_t > ipole, xaxis, zaxis, yaxis, axistype;
 				std::vector < std::vector < size_t >  > plrgrp;
-				std::vector <double> pdamp, thole, pscale, dscale, polarity, mscale, uscale;
+				std::vector <double> pdamp, thole, polarity;
 
 				//pair lists for multipoles
 
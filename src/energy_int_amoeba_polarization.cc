@@ -0,0 +1,377 @@
+#include "energy_int_amoeba_polarization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace
+{
+	/**conversion of e * Angstrom to Debye*/
+	double const debye = 4.803210;
+
+	/**coefficients of the always stable predictor (k = 2) for the latest four dipoles*/
+	double const aspc[4] = { 2.8, -2.8, 1.2, -0.2 };
+
+	/**smaller pair lists are not worth starting the threads*/
+	std::size_t const parallel_pairs = 2048u;
+
+	/**adds the field of the dipoles of the pair at i and k (first components) to e*/
+	void add_pair_field(std::size_t const i, std::size_t const k, double const xr, double const yr, double const zr,
+		double const rr3, double const rr5, std::vector<double> const& u, std::vector<double>& e)
+	{
+		double const uir = xr * u[i] + yr * u[i + 1u] + zr * u[i + 2u];
+		double const ukr = xr * u[k] + yr * u[k + 1u] + zr * u[k + 2u];
+		e[i] += -rr3 * u[k] + rr5 * ukr * xr;
+		e[i + 1u] += -rr3 * u[k + 1u] + rr5 * ukr * yr;
+		e[i + 2u] += -rr3 * u[k + 2u] + rr5 * ukr * zr;
+		e[k] += -rr3 * u[i] + rr5 * uir * xr;
+		e[k + 1u] += -rr3 * u[i + 1u] + rr5 * uir * yr;
+		e[k + 2u] += -rr3 * u[i + 2u] + rr5 * uir * zr;
+	}
+
+	double dot(std::vector<double> const& a, std::vector<double> const& b)
+	{
+		double sum(0.0);
+		for (std::size_t i = 0u; i < a.size(); ++i) sum += a[i] * b[i];
+		return sum;
+	}
+}
+
+energy::interfaces::amoeba::polarization_solver::polarization_solver()
+	: tolerance(0.000001), max_iterations(500u), memory_budget(std::size_t(256u) << 20u),
+	n_sites(0u), n_pairs(0u), m_stored(true), m_cutoff(0.0), m_box(), n_iterations(0u), m_rms(0.0), m_predicted(false)
+{}
+
+void energy::interfaces::amoeba::polarization_solver::clear_pairs(std::vector<double> const& xyz, std::vector<double> const& damp,
+	std::vector<double> const& thole, double const cutoff, std::array<double, 3> const& box)
+{
+	std::size_t const sites = damp.size();
+	if (xyz.size() != 3u * sites || thole.size() != sites)
+	{
+		throw std::logic_error("Sizes of positions and damping do not match the sites of the polarization solver.");
+	}
+	if (sites > std::numeric_limits<std::uint32_t>::max())
+	{
+		throw std::logic_error("Too many sites for the polarization solver.");
+	}
+	if (sites != n_sites) history.clear();
+	n_sites = sites;
+	n_pairs = 0u;
+	site_xyz = xyz;
+	site_damp = damp;
+	site_thole = thole;
+	m_cutoff = cutoff;
+	m_box = box;
+	pair_list.clear();
+	scaled_pairs.clear();
+	m_stored = true;
+}
+
+void energy::interfaces::amoeba::polarization_solver::scale_pairs(std::vector<scaled_pair> const& pairs)
+{
+	scaled_pairs.insert(scaled_pairs.end(), pairs.begin(), pairs.end());
+}
+
+template<class F>
+void energy::interfaces::amoeba::polarization_solver::row_pairs(std::size_t const i, F&& add) const
+{
+	auto scaled = std::lower_bound(scaled_pairs.begin(), scaled_pairs.end(), i,
+		[](scaled_pair const& p, std::size_t const site) { return p.i < site; });
+	for (std::size_t k = i + 1u; k < n_sites; ++k)
+	{
+		double xr, yr, zr;
+		distance(i, k, xr, yr, zr);
+		double const r2 = xr * xr + yr * yr + zr * zr, r = std::sqrt(r2);
+		if (!(r < m_cutoff)) continue;
+		double scale(1.0);
+		while (scaled != scaled_pairs.end() && scaled->i == i && scaled->k < k) ++scaled;
+		if (scaled != scaled_pairs.end() && scaled->i == i && scaled->k == k) scale = scaled->scale;
+		// Thole damping as in amoeba_ff::e_ind
+		double scale3(1.0), scale5(1.0), damp(site_damp[i] * site_damp[k]);
+		if (damp != 0.0)
+		{
+			double const pgamma = std::min(site_thole[i], site_thole[k]);
+			damp = -pgamma * ((r / damp) * (r / damp) * (r / damp));
+			if (damp > -50.0)
+			{
+				double const expdamp = std::exp(damp);
+				scale3 = 1.0 - expdamp;
+				scale5 = 1.0 - expdamp * (1.0 - damp);
+			}
+		}
+		double const rr3 = scale3 / (r * r2), rr5 = 3.0 * scale5 / (r * r2 * r2);
+		add(k, xr, yr, zr, scale * rr3, scale * rr5);
+	}
+}
+
+void energy::interfaces::amoeba::polarization_solver::build_pairs()
+{
+	std::sort(scaled_pairs.begin(), scaled_pairs.end(), [](scaled_pair const& a, scaled_pair const& b)
+	{
+		return a.i < b.i || (a.i == b.i && a.k < b.k);
+	});
+	// pairs of every row, the rows are distributed cyclically (the pairs per row decrease with i)
+	std::ptrdiff_t const rows(static_cast<std::ptrdiff_t>(n_sites));
+#if defined(_OPENMP)
+	bool const parallel(n_sites * n_sites / 2u > parallel_pairs);
+#endif
+	std::vector<std::size_t> offset(n_sites + 1u, 0u);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) if (parallel)
+#endif
+	for (std::ptrdiff_t i = 0; i < rows; ++i)
+	{
+		for (std::size_t k = static_cast<std::size_t>(i) + 1u; k < n_sites; ++k)
+		{
+			double xr, yr, zr;
+			distance(static_cast<std::size_t>(i), k, xr, yr, zr);
+			if (std::sqrt(xr * xr + yr * yr + zr * zr) < m_cutoff) ++offset[i + 1];
+		}
+	}
+	for (std::size_t i = 0u; i < n_sites; ++i) offset[i + 1u] += offset[i];
+	n_pairs = offset.back();
+	m_stored = n_pairs <= memory_budget / sizeof(pair);
+	if (!m_stored)
+	{
+		// over the budget: no pairs are kept, the field recomputes them
+		std::vector<pair>().swap(pair_list);
+		return;
+	}
+	pair_list.resize(n_pairs);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) if (parallel)
+#endif
+	for (std::ptrdiff_t i = 0; i < rows; ++i)
+	{
+		pair* p = pair_list.data() + offset[i];
+		row_pairs(static_cast<std::size_t>(i), [&](std::size_t const k, double, double, double, double const rr3, double const rr5)
+		{
+			*p++ = { static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(k), rr3, rr5 };
+		});
+	}
+}
+
+void energy::interfaces::amoeba::polarization_solver::field(std::vector<double> const& u, std::vector<double>& e) const
+{
+	std::size_t const n = pair_list.size(), n3 = 3u * n_sites;
+	e.assign(n3, 0.0);
+#if defined(_OPENMP)
+	std::size_t const threads(n_pairs > parallel_pairs ? static_cast<std::size_t>(omp_get_max_threads()) : 1u);
+#else
+	std::size_t const threads(1u);
+#endif
+	if (threads < 2u)
+	{
+		if (m_stored) add_field(0u, n, u, e);
+		else add_field_recomputed(0u, 1u, u, e);
+		return;
+	}
+	// every thread adds the field of one contiguous range of stored pairs
+	// (or of every team-th site if they are recomputed) into its own buffer,
+	// the buffers are summed in the order of the threads
+	std::vector<std::vector<double>> thread_fields(threads);
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(static_cast<int>(threads))
+#endif
+	{
+#if defined(_OPENMP)
+		std::size_t const t(static_cast<std::size_t>(omp_get_thread_num())), team(static_cast<std::size_t>(omp_get_num_threads()));
+#else
+		std::size_t const t(0u), team(1u);
+#endif
+		std::vector<double>& local = thread_fields[t];
+		local.assign(n3, 0.0);
+		if (m_stored) add_field(n * t / team, n * (t + 1u) / team, u, local);
+		else add_field_recomputed(t, team, u, local);
+#if defined(_OPENMP)
+#pragma omp barrier
+#pragma omp for schedule(static)
+#endif
+		for (std::ptrdiff_t j = 0; j < static_cast<std::ptrdiff_t>(n3); ++j)
+		{
+			for (std::size_t s = 0u; s < team; ++s) e[j] += thread_fields[s][j];
+		}
+	}
+}
+
+void energy::interfaces::amoeba::polarization_solver::distance(std::size_t const i, std::size_t const k,
+	double& xr, double& yr, double& zr) const
+{
+	double* const r[3] = { &xr, &yr, &zr };
+	for (std::size_t d = 0u; d < 3u; ++d)
+	{
+		double& x = *r[d];
+		x = site_xyz[3u * k + d] - site_xyz[3u * i + d];
+		if (m_box[d] > 0.0)
+		{
+			if (x > m_box[d] / 2.0) x -= m_box[d];
+			else if (x < -m_box[d] / 2.0) x += m_box[d];
+		}
+	}
+}
+
+void energy::interfaces::amoeba::polarization_solver::add_field(std::size_t const begin, std::size_t const end,
+	std::vector<double> const& u, std::vector<double>& e) const
+{
+	for (std::size_t p = begin; p < end; ++p)
+	{
+		double xr, yr, zr;
+		distance(pair_list[p].i, pair_list[p].k, xr, yr, zr);
+		add_pair_field(3u * pair_list[p].i, 3u * pair_list[p].k, xr, yr, zr, pair_list[p].rr3, pair_list[p].rr5, u, e);
+	}
+}
+
+void energy::interfaces::amoeba::polarization_solver::add_field_recomputed(std::size_t const first, std::size_t const team,
+	std::vector<double> const& u, std::vector<double>& e) const
+{
+	for (std::size_t i = first; i + 1u < n_sites; i += team)
+	{
+		row_pairs(i, [&](std::size_t const k, double const xr, double const yr, double const zr, double const rr3, double const rr5)
+		{
+			add_pair_field(3u * i, 3u * k, xr, yr, zr, rr3, rr5, u, e);
+		});
+	}
+}
+
+void energy::interfaces::amoeba::polarization_solver::apply(std::vector<double> const& polarity,
+	std::vector<double> const& u, std::vector<double>& q) const
+{
+	field(u, q);
+	for (std::size_t i = 0u; i < n_sites; ++i)
+	{
+		for (std::size_t j = 3u * i; j < 3u * i + 3u; ++j)
+		{
+			q[j] = polarity[i] != 0.0 ? u[j] / polarity[i] - q[j] : 0.0;
+		}
+	}
+}
+
+void energy::interfaces::amoeba::polarization_solver::residual(std::vector<double> const& polarity,
+	std::vector<double> const& e, std::vector<double> const& u, std::vector<double>& r) const
+{
+	apply(polarity, u, r);
+	for (std::size_t i = 0u; i < n_sites; ++i)
+	{
+		for (std::size_t j = 3u * i; j < 3u * i + 3u; ++j)
+		{
+			r[j] = polarity[i] != 0.0 ? e[j] - r[j] : 0.0;
+		}
+	}
+}
+
+bool energy::interfaces::amoeba::polarization_solver::predict(std::vector<double>& ud, std::vector<double>& up) const
+{
+	if (history.size() < 4u) return false;
+	ud.assign(3u * n_sites, 0.0);
+	up.assign(3u * n_sites, 0.0);
+	for (std::size_t h = 0u; h < 4u; ++h)
+	{
+		if (history[h].first.size() != ud.size()) return false;
+		for (std::size_t j = 0u; j < ud.size(); ++j)
+		{
+			ud[j] += aspc[h] * history[h].first[j];
+			up[j] += aspc[h] * history[h].second[j];
+		}
+	}
+	return true;
+}
+
+bool energy::interfaces::amoeba::polarization_solver::solve(std::vector<double> const& polarity,
+	std::vector<double> const& field_d, std::vector<double> const& field_p,
+	std::vector<double>& ud, std::vector<double>& up)
+{
+	std::size_t const n3 = 3u * n_sites;
+	if (polarity.size() != n_sites || field_d.size() != n3 || field_p.size() != n3)
+	{
+		throw std::logic_error("Sizes of polarities and fields do not match the sites of the polarization solver.");
+	}
+	auto const rms_of = [this](std::vector<double> const& a, std::vector<double> const& b)
+	{
+		return n_sites > 0u ? debye * std::sqrt(std::max(dot(a, a), dot(b, b)) / static_cast<double>(n_sites)) : 0.0;
+	};
+	auto const precondition = [&](std::vector<double> const& r, std::vector<double>& z)
+	{
+		z.resize(n3);
+		for (std::size_t j = 0u; j < n3; ++j) z[j] = polarity[j / 3u] * r[j];
+	};
+
+	// starting guess: direct dipoles or the extrapolation of the previous ones, whichever is better
+	ud.resize(n3);
+	up.resize(n3);
+	for (std::size_t j = 0u; j < n3; ++j)
+	{
+		ud[j] = polarity[j / 3u] * field_d[j];
+		up[j] = polarity[j / 3u] * field_p[j];
+	}
+	residual(polarity, field_d, ud, rd);
+	residual(polarity, field_p, up, rp);
+	precondition(rd, zd);
+	precondition(rp, zp);
+	m_rms = rms_of(zd, zp);
+	m_predicted = false;
+	std::vector<double> guess_d, guess_p;
+	if (predict(guess_d, guess_p))
+	{
+		residual(polarity, field_d, guess_d, qd);
+		residual(polarity, field_p, guess_p, qp);
+		precondition(qd, pd);
+		precondition(qp, pp);
+		auto const predicted_rms = rms_of(pd, pp);
+		if (predicted_rms < m_rms)
+		{
+			m_rms = predicted_rms;
+			m_predicted = true;
+			ud.swap(guess_d);
+			up.swap(guess_p);
+			rd.swap(qd);
+			rp.swap(qp);
+			zd.swap(pd);
+			zp.swap(pp);
+		}
+	}
+
+	// conjugate gradients, both systems share the matrix
+	pd = zd;
+	pp = zp;
+	double rzd = dot(rd, zd), rzp = dot(rp, zp);
+	auto const step = [&](std::vector<double>& u, std::vector<double>& r, std::vector<double>& z,
+		std::vector<double>& p, std::vector<double>& q, double& rz)
+	{
+		apply(polarity, p, q);
+		double const pq = dot(p, q);
+		if (pq == 0.0 || rz == 0.0) return;
+		double const a = rz / pq;
+		for (std::size_t j = 0u; j < n3; ++j)
+		{
+			u[j] += a * p[j];
+			r[j] -= a * q[j];
+		}
+		precondition(r, z);
+		double const rz_new = dot(r, z);
+		double const b = rz_new / rz;
+		for (std::size_t j = 0u; j < n3; ++j) p[j] = z[j] + b * p[j];
+		rz = rz_new;
+	};
+	n_iterations = 0u;
+	while (m_rms > tolerance && n_iterations < max_iterations)
+	{
+		step(ud, rd, zd, pd, qd, rzd);
+		step(up, rp, zp, pp, qp, rzp);
+		++n_iterations;
+		m_rms = rms_of(zd, zp);
+		if (!std::isfinite(m_rms)) break;
+	}
+	bool const converged = m_rms <= tolerance;
+	if (converged)
+	{
+		history.emplace_front(ud, up);
+		if (history.size() > 4u) history.pop_back();
+	}
+	else history.clear();
+	return converged;
+}
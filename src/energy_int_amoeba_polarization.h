@@ -0,0 +1,136 @@
+/**
+CAST 3
+energy_int_amoeba_polarization.h
+Purpose:
+Induced dipoles of the AMOEBA force field.
+The dipoles u of the polarizable sites follow from the permanent field E and the
+Thole-damped dipole interaction tensor T as (1 / alpha - T) u = E.
+The system is solved with conjugate gradients, preconditioned by the polarities,
+over a pair list of the site pairs within the cutoff, which is built once per structure
+from the positions and the Thole damping of the sites (only the scale of bonded pairs is passed in).
+The pairs are stored with 32-bit site indices and their damped factors only, the distance
+vectors are recomputed from the positions. Above a memory budget no pairs are stored at all
+and the field is recomputed from the positions and the damping of the sites in every iteration.
+The dipoles of the previous calls are extrapolated to the starting guess
+(always stable predictor, Kolafa, J. Comput. Chem. 25, 335 (2004)).
+
+@version 1.0
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace energy
+{
+	namespace interfaces
+	{
+		namespace amoeba
+		{
+			/**solver for the two sets of induced dipoles of AMOEBA
+			(d: induced by the field scaled with dscale, p: with pscale),
+			vectors of dipoles and fields hold x, y and z of every site one after another*/
+			class polarization_solver
+			{
+			public:
+				polarization_solver();
+
+				/**pair of sites i < k whose interaction is scaled by scale (one for all other pairs)*/
+				struct scaled_pair
+				{
+					std::uint32_t i, k;
+					double scale;
+				};
+
+				/**removes all pairs of the previous structure and sets the sites of the next one:
+				positions xyz, Thole damping factor and Thole parameter of every site,
+				the cutoff of the pairs and the edges of the periodic box (zero if not periodic)*/
+				void clear_pairs(std::vector<double> const& xyz, std::vector<double> const& damp,
+					std::vector<double> const& thole, double const cutoff, std::array<double, 3> const& box = {});
+				/**adds pairs with a scale other than one (in any order)*/
+				void scale_pairs(std::vector<scaled_pair> const& pairs);
+				/**finds the pairs within the cutoff after all scaled pairs are added,
+				they are stored if they fit into the memory budget*/
+				void build_pairs();
+				std::size_t sites() const { return n_sites; }
+				/**pairs within the cutoff*/
+				std::size_t pairs() const { return n_pairs; }
+				/**true if the pairs are stored, false if they are recomputed in every field*/
+				bool stored() const { return m_stored; }
+				/**bytes allocated for the stored pairs*/
+				std::size_t storage() const { return pair_list.capacity() * sizeof(pair); }
+
+				/**field T u of the dipoles u at every site (larger pair lists are split over the OpenMP threads)*/
+				void field(std::vector<double> const& u, std::vector<double>& e) const;
+
+				/**solves for the induced dipoles ud and up from the direct fields
+				@return: true if the dipoles converged*/
+				bool solve(std::vector<double> const& polarity,
+					std::vector<double> const& field_d, std::vector<double> const& field_p,
+					std::vector<double>& ud, std::vector<double>& up);
+
+				/**forgets the dipoles of the previous calls (no extrapolation in the next call)*/
+				void clear_history() { history.clear(); }
+				/**iterations of the last call*/
+				std::size_t iterations() const { return n_iterations; }
+				/**root mean square of the preconditioned residual of the last call (Debye)*/
+				double rms() const { return m_rms; }
+				/**true if the starting guess of the last call was extrapolated from the previous dipoles*/
+				bool predicted() const { return m_predicted; }
+
+				/**convergence criterion of the residual (Debye)*/
+				double tolerance;
+				std::size_t max_iterations;
+				/**largest storage of the pairs in bytes, larger pair lists are recomputed in every field*/
+				std::size_t memory_budget;
+
+			private:
+				/**stored pair, the distance vector follows from the positions*/
+				struct pair
+				{
+					std::uint32_t i, k;
+					double rr3, rr5;
+				};
+
+				/**r = position of k - position of i, closest periodic image*/
+				void distance(std::size_t const i, std::size_t const k, double& xr, double& yr, double& zr) const;
+				/**adds the field of the stored pairs [begin, end) to e*/
+				void add_field(std::size_t const begin, std::size_t const end,
+					std::vector<double> const& u, std::vector<double>& e) const;
+				/**calls add(k, xr, yr, zr, rr3, rr5) with the scaled and damped factors of every pair i, k > i within the cutoff*/
+				template<class F>
+				void row_pairs(std::size_t const i, F&& add) const;
+				/**adds the field of the recomputed pairs of every team-th site starting at first to e*/
+				void add_field_recomputed(std::size_t const first, std::size_t const team,
+					std::vector<double> const& u, std::vector<double>& e) const;
+				/**(1 / alpha - T) u, zero for sites without polarity*/
+				void apply(std::vector<double> const& polarity, std::vector<double> const& u, std::vector<double>& q) const;
+				/**residual E - (1 / alpha - T) u*/
+				void residual(std::vector<double> const& polarity, std::vector<double> const& e,
+					std::vector<double> const& u, std::vector<double>& r) const;
+				/**starting guesses from the history, false if there is not enough of it*/
+				bool predict(std::vector<double>& ud, std::vector<double>& up) const;
+
+				std::size_t n_sites, n_pairs;
+				bool m_stored;
+				std::vector<pair> pair_list;
+				std::vector<scaled_pair> scaled_pairs;
+				std::vector<double> site_xyz, site_damp, site_thole;
+				double m_cutoff;
+				std::array<double, 3> m_box;
+				/**dipoles of the previous calls, latest first*/
+				std::deque<std::pair<std::vector<double>, std::vector<double>>> history;
+				/**work vectors of the conjugate gradients (residual, preconditioned residual, direction, T direction)*/
+				std::vector<double> rd, rp, zd, zp, pd, pp, qd, qp;
+				std::size_t n_iterations;
+				double m_rms;
+				bool m_predicted;
+			};
+		}
+	}
+}
@@ -1,3 +1,4 @@
+#include <array>
 #include <cmath>
 #include <stddef.h>
 #include <stdexcept>
@@ -10,6 +11,53 @@
 #include <algorithm>
 #include "math.h"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace
+{
+	/**threads of the next parallel region*/
+	std::size_t max_threads()
+	{
+#if defined(_OPENMP)
+		return static_cast<std::size_t>(omp_get_max_threads());
+#else
+		return 1u;
+#endif
+	}
+
+	/**number of the calling thread*/
+	std::size_t thread_number()
+	{
+#if defined(_OPENMP)
+		return static_cast<std::size_t>(omp_get_thread_num());
+#else
+		return 0u;
+#endif
+	}
+
+	/**adds the virial of the gradient b of a pair at distance r*/
+	void add_virial(coords::virial_t& virial, coords::Cartesian_Point const& b, coords::Cartesian_Point const& r)
+	{
+		coords::float_type const vxx = b.x() * r.x();
+		coords::float_type const vyx = b.x() * r.y();
+		coords::float_type const vzx = b.x() * r.z();
+		coords::float_type const vyy = b.y() * r.y();
+		coords::float_type const vzy = b.y() * r.z();
+		coords::float_type const vzz = b.z() * r.z();
+		virial[0][0] += vxx;
+		virial[1][0] += vyx;
+		virial[2][0] += vzx;
+		virial[0][1] += vyx;
+		virial[1][1] += vyy;
+		virial[2][1] += vzy;
+		virial[0][2] += vzx;
+		virial[1][2] += vzy;
+		virial[2][2] += vzz;
+	}
+}
+
 
 #ifdef _MSC_VER
 #pragma warning(disable: 4996)
@@ -32,6 +80,7 @@ double energy::interfaces::amoeba::amoeba_ff::e(void)
 	if (Config::get().energy.spackman.on)
 
 	{
+		if (!spackman) spackman = spackman_tables::shared();
 		Spackman_mol();
 		Spackman_vec();
 		Spackman1();
@@ -68,6 +117,7 @@ double energy::interfaces::amoeba::amoeba_ff::g(void)
 	pre();
 	if (Config::get().energy.spackman.on)
 	{
+		if (!spackman) spackman = spackman_tables::shared();
 		Spackman_mol();
 		Spackman_vec();
 		Spackman1();
@@ -1296,30 +1346,37 @@ namespace energy
 				scon::matrix< ::tinker::parameter::combi::vdwc, true> const& params
 			)
 			{
-				coords::float_type  e_v(0.0);
-				for (auto const& pair : pairlist)
+				// every thread adds one contiguous range of pairs into its own buffers,
+				// gradients and energies are added in the order of the threads
+				std::ptrdiff_t const M(pairlist.size());
+				std::vector<coords::float_type> thread_e(max_threads(), 0.0);
+				nb_accumulator.prepare(grad_vector.size());
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
 				{
-					::tinker::parameter::combi::vdwc const& p(params(refined.type(pair.a), refined.type(pair.b)));
-					coords::Cartesian_Point b(vdwnew[pair.a] - vdwnew[pair.b]);
-
-
-
-					coords::float_type r = len(b), dE(0.0);
-					//std::cout << r << '\n';
-					// std::cout << "Atoms: " << std::endl;
-					// std::cout << pair.a + 1 << "  " << pair.b + 1 << std::endl;
-
-					g_QV<RT>(p.E, p.R, r, e_v, dE);
-					b *= dE;
-					//charge_vector[pair.a] +=eQ(p.C,r)/r;
-					//charge_vector[pair.b] +=eQ(p.C,r)/r;
-					grad_vector[pair.a] += b;
-					grad_vector[pair.b] -= b;
+					coords::Representation_3D& tmp_grad = nb_accumulator.local();
+					coords::float_type  e_v(0.0);
+#if defined(_OPENMP)
+#pragma omp for schedule(static)
+#endif
+					for (std::ptrdiff_t i = 0; i < M; ++i)
+					{
+						::tinker::refine::types::nbpair const& pair(pairlist[i]);
+						::tinker::parameter::combi::vdwc const& p(params(refined.type(pair.a), refined.type(pair.b)));
+						coords::Cartesian_Point b(vdwnew[pair.a] - vdwnew[pair.b]);
+						coords::float_type r = len(b), dE(0.0);
+						g_QV<RT>(p.E, p.R, r, e_v, dE);
+						b *= dE;
+						tmp_grad[pair.a] += b;
+						tmp_grad[pair.b] -= b;
+					}
+					thread_e[thread_number()] = e_v;
+					nb_accumulator.reduce(grad_vector);
 				}
-				//std::cout << "e_nb=" << e_c + e_v << std::endl;
+				coords::float_type e_v(0.0);
+				for (auto const te : thread_e) e_v += te;
 				e_nb += e_v;
-				//part_energy[types::VDWC] += e_c+e_v;
-				//part_energy[types::CHARGE] += e_c;
 				part_energy[VDW] += e_v;
 			}
 
@@ -1332,51 +1389,48 @@ namespace energy
 			)
 			{
 				nb_cutoff cutob(Config::get().energy.cutoff, Config::get().energy.switchdist);
-				coords::float_type  e_v(0.0);
-				//size_t ia(0u);
-				for (auto const& pair : pairlist)
+				// every thread adds one contiguous range of pairs into its own buffers,
+				// gradients, virial and energies are added in the order of the threads
+				std::ptrdiff_t const M(pairlist.size());
+				std::vector<coords::float_type> thread_e(max_threads(), 0.0);
+				nb_accumulator.prepare(grad_vector.size());
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
 				{
-					coords::Cartesian_Point b(coords->xyz(pair.a) - coords->xyz(pair.b));
-					coords::Cartesian_Point dist;
-					::tinker::parameter::combi::vdwc const& p(params(refined.type(pair.a), refined.type(pair.b)));
-
-					if (PERIODIC) boundary(b.x(), b.y(), b.z());
-					coords::float_type const rr = dot(b, b);
-					coords::float_type r(0.0), fQ(0.0), fV(0.0), dE(0.0);
-					if (!cutob.factors(rr, r, fQ, fV))
+					coords::Representation_3D& tmp_grad = nb_accumulator.local();
+					coords::virial_t local_virial(coords::empty_virial());
+					coords::float_type  e_v(0.0);
+#if defined(_OPENMP)
+#pragma omp for schedule(static)
+#endif
+					for (std::ptrdiff_t i = 0; i < M; ++i)
 					{
-						continue;
+						::tinker::refine::types::nbpair const& pair(pairlist[i]);
+						coords::Cartesian_Point b(coords->xyz(pair.a) - coords->xyz(pair.b));
+						coords::Cartesian_Point dist;
+						::tinker::parameter::combi::vdwc const& p(params(refined.type(pair.a), refined.type(pair.b)));
+
+						if (PERIODIC) boundary(b.x(), b.y(), b.z());
+						coords::float_type const rr = dot(b, b);
+						coords::float_type r(0.0), fQ(0.0), fV(0.0), dE(0.0);
+						if (!cutob.factors(rr, r, fQ, fV))
+						{
+							continue;
+						}
+						g_QV_cutoff<RT>(p.E, p.R, r, fV, e_v, dE);
+						dist = b;
+						b *= dE;
+						tmp_grad[pair.a] += b;
+						tmp_grad[pair.b] -= b;
+						add_virial(local_virial, b, dist);
 					}
-					//++ia;
-					r = r;
-
-
-					g_QV_cutoff<RT>(p.E, p.R, r, fV, e_v, dE);
-					dist = b;
-					b *= dE;
-					grad_vector[pair.a] += b;
-					grad_vector[pair.b] -= b;
-					//Increment internal virial tensor
-					coords::float_type const vxx = b.x() * dist.x();
-					coords::float_type const vyx = b.x() * dist.y();
-					coords::float_type const vzx = b.x() * dist.z();
-					coords::float_type const vyy = b.y() * dist.y();
-					coords::float_type const vzy = b.y() * dist.z();
-					coords::float_type const vzz = b.z() * dist.z();
-					part_virial[VDWC][0][0] += vxx;
-					part_virial[VDWC][1][0] += vyx;
-					part_virial[VDWC][2][0] += vzx;
-					part_virial[VDWC][0][1] += vyx;
-					part_virial[VDWC][1][1] += vyy;
-					part_virial[VDWC][2][1] += vzy;
-					part_virial[VDWC][0][2] += vzx;
-					part_virial[VDWC][1][2] += vzy;
-					part_virial[VDWC][2][2] += vzz;
+					thread_e[thread_number()] = e_v;
+					nb_accumulator.reduce(grad_vector, local_virial, part_virial[VDWC]);
 				}
-				//std::cout << "IAs of " << &pairlist << " : " << ia << "\n";
+				coords::float_type e_v(0.0);
+				for (auto const te : thread_e) e_v += te;
 				e_nb += e_v;
-				//part_energy[types::VDWC] += e_c+e_v;
-				//part_energy[types::CHARGE] += e_c;
 				part_energy[VDW] += e_v;
 			}
 
@@ -1389,77 +1443,88 @@ namespace energy
 			)
 			{
 				nb_cutoff cutob(Config::get().energy.cutoff, Config::get().energy.switchdist);
-				double e_c(0.0), e_v(0.0), e_c_l(0.0), e_vdw_l(0.0), e_c_dl(0.0), e_vdw_dl(0.0);
-				double vxx, vyx, vzx, vyy, vzy, vzz;
 				fepvar const& fep = coords->getFep().window[coords->getFep().window[0].step];
-				for (auto const& pair : pairlist)
+				// every thread adds one contiguous range of pairs into its own buffers,
+				// gradients, virial and energies are added in the order of the threads
+				// (energies: e_c, e_v, e_c_l, e_vdw_l, e_c_dl, e_vdw_dl)
+				std::ptrdiff_t const M(pairlist.size());
+				std::vector<std::array<double, 6>> thread_e(max_threads(), std::array<double, 6>{});
+				nb_accumulator.prepare(grad_vector.size());
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
 				{
-					coords::Cartesian_Point b(coords->xyz(pair.a) - coords->xyz(pair.b));
-					coords::Cartesian_Point dist;
+					coords::Representation_3D& tmp_grad = nb_accumulator.local();
+					coords::virial_t local_virial(coords::empty_virial());
+					double e_c(0.0), e_v(0.0), e_c_l(0.0), e_vdw_l(0.0), e_c_dl(0.0), e_vdw_dl(0.0);
+#if defined(_OPENMP)
+#pragma omp for schedule(static)
+#endif
+					for (std::ptrdiff_t i = 0; i < M; ++i)
+					{
+						::tinker::refine::types::nbpair const& pair(pairlist[i]);
+						coords::Cartesian_Point b(coords->xyz(pair.a) - coords->xyz(pair.b));
+						coords::Cartesian_Point dist;
 
 
-					if (PERIODIC) boundary(b.x(), b.y(), b.z());
-					double const rr(dot(b, b));
-					double dE(0.0), Q(0.0), V(0.0);
-					::tinker::parameter::combi::vdwc const& p(params(refined.type(pair.a), refined.type(pair.b)));
+						if (PERIODIC) boundary(b.x(), b.y(), b.z());
+						double const rr(dot(b, b));
+						double dE(0.0), Q(0.0), V(0.0);
+						::tinker::parameter::combi::vdwc const& p(params(refined.type(pair.a), refined.type(pair.b)));
 
-					if (PERIODIC)
-					{
-						double fQ(0.0), fV(0.0);
-						double r(0.0);
-						if (!cutob.factors(rr, r, fQ, fV)) continue;
-						g_QV_fep_cutoff<RT>(p.E, p.R, r, (ALCH_OUT ? fep.vin : fep.vout), fV, V, dE);
-						double trash(0.0);
-						g_QV_fep_cutoff<RT>(p.E, p.R, r, (ALCH_OUT ? fep.dvin : fep.dvout), fV, e_vdw_dl, trash);
-					}
-					else
-					{
-						if (Config::get().energy.cutoff < 1000.0) {
-							double fV(0.0);
+						if (PERIODIC)
+						{
+							double fQ(0.0), fV(0.0);
 							double r(0.0);
+							if (!cutob.factors(rr, r, fQ, fV)) continue;
 							g_QV_fep_cutoff<RT>(p.E, p.R, r, (ALCH_OUT ? fep.vin : fep.vout), fV, V, dE);
 							double trash(0.0);
 							g_QV_fep_cutoff<RT>(p.E, p.R, r, (ALCH_OUT ? fep.dvin : fep.dvout), fV, e_vdw_dl, trash);
 						}
-						else {
-							double const r = sqrt(rr);
-							g_QV_fep<RT>(p.E, p.R, r, (ALCH_OUT ? fep.vin : fep.vout), V, dE);
-							double trash(0.0);
-							g_QV_fep<RT>(p.E, p.R, r, (ALCH_OUT ? fep.dvin : fep.dvout), e_vdw_dl, trash);
+						else
+						{
+							if (Config::get().energy.cutoff < 1000.0) {
+								double fV(0.0);
+								double r(0.0);
+								g_QV_fep_cutoff<RT>(p.E, p.R, r, (ALCH_OUT ? fep.vin : fep.vout), fV, V, dE);
+								double trash(0.0);
+								g_QV_fep_cutoff<RT>(p.E, p.R, r, (ALCH_OUT ? fep.dvin : fep.dvout), fV, e_vdw_dl, trash);
+							}
+							else {
+								double const r = sqrt(rr);
+								g_QV_fep<RT>(p.E, p.R, r, (ALCH_OUT ? fep.vin : fep.vout), V, dE);
+								double trash(0.0);
+								g_QV_fep<RT>(p.E, p.R, r, (ALCH_OUT ? fep.dvin : fep.dvout), e_vdw_dl, trash);
+							}
 						}
+						dist = b;
+						b *= dE;
+						e_c_l += Q;
+						e_vdw_l += V;
+						e_c += Q;
+						e_v += V;
+						tmp_grad[pair.a] += b;
+						tmp_grad[pair.b] -= b;
+						add_virial(local_virial, b, dist);
 					}
-					dist = b;
-					b *= dE;
-					e_c_l += Q;
-					e_vdw_l += V;
-					e_c += Q;
-					e_v += V;
-					grad_vector[pair.a] += b;
-					grad_vector[pair.b] -= b;
-					//Increment internal virial tensor
-					vxx = b.x() * dist.x();
-					vyx = b.x() * dist.y();
-					vzx = b.x() * dist.z();
-					vyy = b.y() * dist.y();
-					vzy = b.y() * dist.z();
-					vzz = b.z() * dist.z();
-					part_virial[VDWC][0][0] += vxx;
-					part_virial[VDWC][1][0] += vyx;
-					part_virial[VDWC][2][0] += vzx;
-					part_virial[VDWC][0][1] += vyx;
-					part_virial[VDWC][1][1] += vyy;
-					part_virial[VDWC][2][1] += vzy;
-					part_virial[VDWC][0][2] += vzx;
-					part_virial[VDWC][1][2] += vzy;
-					part_virial[VDWC][2][2] += vzz;
+					thread_e[thread_number()] = { e_c, e_v, e_c_l, e_vdw_l, e_c_dl, e_vdw_dl };
+					nb_accumulator.reduce(grad_vector, local_virial, part_virial[VDWC]);
+				}
+				double e_c(0.0), e_v(0.0), e_c_l(0.0), e_vdw_l(0.0), e_c_dl(0.0), e_vdw_dl(0.0);
+				for (auto const& te : thread_e)
+				{
+					e_c += te[0];
+					e_v += te[1];
+					e_c_l += te[2];
+					e_vdw_l += te[3];
+					e_c_dl += te[4];
+					e_vdw_dl += te[5];
 				}
 				e_nb += e_c + e_v;
 				coords->getFep().feptemp.e_c_l1 += e_c_l;
 				coords->getFep().feptemp.e_c_l2 += e_c_dl;
 				coords->getFep().feptemp.e_vdw_l1 += e_vdw_l;
 				coords->getFep().feptemp.e_vdw_l2 += e_vdw_dl;
-				//part_energy[types::VDWC] += e_c+e_v;
-				//part_energy[types::CHARGE] += e_c;
 				part_energy[VDW] += e_v;
 			}
 
@@ -1775,31 +1840,8 @@ namespace energy
 
 void energy::interfaces::amoeba::amoeba_ff::e_ind(void)
 {
-	std::vector <std::vector <double> > field, fieldp, udir, uold, uoldp, udirp;
-	size_t i, k, j;
-	size_t ii, kk;
-	size_t iter, maxiter;
-	double xr, yr, zr, r2, r;
-	double ci, dix, diy, diz;
-	double qixx, qixy, qixz;
-	double qiyy, qiyz, qizz;
-	double ck, dkx, dky, dkz;
-	double qkxx, qkxy, qkxz;
-	double qkyy, qkyz, qkzz;
-	double duix, duiy, duiz;
-	double dukx, duky, dukz;
-	double pukx, puky, pukz;
-	double puix, puiy, puiz;
-	double duir, puir;
-	double dukr, pukr;
-	double scale3, scale5, scale7;
-	double damp, expdamp;
-	double rr3, rr5, rr7, dir;
-	double qix, qiy, qiz, qir, dkr, qkx, qky, qkz, qkr;
-	std::vector <double> fid, fkd, fip, fkp;
-	bool done;
-	double eps, epsold, epsd, epsp;
-	double debye = 4.803210, poleps = 0.000001;
+	std::vector <std::vector <double> > field, fieldp;
+	size_t i, j;
 	size_t n, alloc(multipole_sites());
 	pscale2 = 0.0; pscale3 = 0.0; pscale4 = 1.0; pscale5 = 1.0;
 	mscale2 = 0.0; mscale3 = 0.0; mscale4 = 0.4; mscale5 = 0.8;
@@ -1814,20 +1856,11 @@ void energy::interfaces::amoeba::amoeba_ff::e_ind(void)
 	}
 	else cutoff = Config::get().energy.cutoff;
 
-	double pdi, pti, pgamma;
-
 
   //    npole=npole-1;
   auto const & positions = coords->xyz();
-  coords::Cartesian_Point bv, b, gv;
   uind.resize(5);
   uinp.resize(5);
-  pscale.resize(alloc + 100);
-  dscale.resize(alloc + 100);
-  fid.resize(5);
-  fkd.resize(5);
-  fip.resize(5);
-  fkp.resize(5);
 
 
 	for (n = 0; n < uind.size(); n++) {
@@ -1839,10 +1872,6 @@ void energy::interfaces::amoeba::amoeba_ff::e_ind(void)
 
 	field.resize(5);
 	fieldp.resize(5);
-	udir.resize(5);
-	udirp.resize(5);
-	uold.resize(5);
-	uoldp.resize(5);
 
 
 
@@ -1853,18 +1882,6 @@ void energy::interfaces::amoeba::amoeba_ff::e_ind(void)
 	for (n = 0; n < fieldp.size(); n++) {
 		fieldp[n].resize(alloc + 1);
 	}
-	for (n = 0; n < udir.size(); n++) {
-		udir[n].resize(alloc + 1);
-	}
-	for (n = 0; n < udirp.size(); n++) {
-		udirp[n].resize(alloc + 1);
-	}
-	for (n = 0; n < uold.size(); n++) {
-		uold[n].resize(alloc + 1);
-	}
-	for (n = 0; n < uoldp.size(); n++) {
-		uoldp[n].resize(alloc + 1);
-	}
 
 
 
@@ -1884,7 +1901,115 @@ void energy::interfaces::amoeba::amoeba_ff::e_ind(void)
 		}
 	}
 
-	for (i = 1; i <= alloc - 1; i++) {
+	// sites of the mutual induction, the solver finds the pairs within the cutoff
+	{
+		std::vector <double> site_xyz(3 * alloc), site_damp(alloc), site_thole(alloc);
+		std::array<double, 3> box = {};
+		for (i = 1; i <= alloc; i++) {
+			auto const & site = positions[ipole[i]];
+			site_xyz[3 * (i - 1)] = site.x();
+			site_xyz[3 * (i - 1) + 1] = site.y();
+			site_xyz[3 * (i - 1) + 2] = site.z();
+			site_damp[i - 1] = pdamp[i];
+			site_thole[i - 1] = thole[i];
+		}
+		if (Config::get().periodics.periodic == true)
+		{
+			box = { Config::get().periodics.pb_box.x(), Config::get().periodics.pb_box.y(), Config::get().periodics.pb_box.z() };
+		}
+		polarization.clear_pairs(site_xyz, site_damp, site_thole, cutoff, box);
+	}
+
+	// direct fields: the rows i are distributed cyclically over the threads as in e_perm,
+	// the fields of the threads are added in the order of the threads
+#if defined(_OPENMP)
+	std::size_t const threads(static_cast<std::size_t>(omp_get_max_threads()));
+#else
+	std::size_t const threads(1u);
+#endif
+	std::vector<std::vector<std::vector<double>>> thread_field(threads), thread_fieldp(threads);
+	std::vector<std::vector<polarization_solver::scaled_pair>> thread_scaled(threads);
+
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+	{
+#if defined(_OPENMP)
+		std::size_t const thread(static_cast<std::size_t>(omp_get_thread_num())), team(static_cast<std::size_t>(omp_get_num_threads()));
+#else
+		std::size_t const thread(0u), team(1u);
+#endif
+		std::vector<std::vector<double>> local_field(4, std::vector<double>(alloc + 1, 0.0)), local_fieldp(local_field);
+		e_ind_rows(1u + thread, team, alloc, cutoff, local_field, local_fieldp, thread_scaled[thread]);
+		thread_field[thread].swap(local_field);
+		thread_fieldp[thread].swap(local_fieldp);
+#if defined(_OPENMP)
+#pragma omp barrier
+#pragma omp for schedule(static)
+#endif
+		for (std::ptrdiff_t m = 1; m <= static_cast<std::ptrdiff_t>(alloc); m++) {
+			for (std::size_t t = 0; t < team; t++) {
+				for (size_t jj = 1; jj <= 3; jj++) {
+					field[jj][m] += thread_field[t][jj][m];
+					fieldp[jj][m] += thread_fieldp[t][jj][m];
+				}
+			}
+		}
+	}
+	for (std::size_t t = 0; t < threads; t++) {
+		polarization.scale_pairs(thread_scaled[t]);
+	}
+	polarization.build_pairs();
+
+	// induced dipoles: (1 / polarity - T) u = field with preconditioned conjugate gradients
+	std::vector <double> alpha(alloc), ed(3 * alloc), ep(3 * alloc), ud, up;
+	for (i = 1; i <= alloc; i++) {
+		alpha[i - 1] = polarity[i];
+		for (j = 1; j <= 3; j++) {
+			ed[3 * (i - 1) + j - 1] = field[j][i];
+			ep[3 * (i - 1) + j - 1] = fieldp[j][i];
+		}
+	}
+	bool const converged = polarization.solve(alpha, ed, ep, ud, up);
+	for (i = 1; i <= alloc; i++) {
+		for (j = 1; j <= 3; j++) {
+			uind[j][i] = ud[3 * (i - 1) + j - 1];
+			uinp[j][i] = up[3 * (i - 1) + j - 1];
+		}
+	}
+	if (Config::get().general.verbosity > 3U)
+	{
+		std::cout << "Induced dipoles: " << polarization.iterations() << " iterations"
+			<< (polarization.predicted() ? " from predicted dipoles" : "")
+			<< ", rms residual " << polarization.rms() << " Debye\n";
+	}
+	if (!converged) std::cout << "induced dipoles may not converged\n";
+}
+
+void energy::interfaces::amoeba::amoeba_ff::e_ind_rows(std::size_t const first, std::size_t const step, std::size_t const alloc, double const cutoff,
+	std::vector <std::vector <double> >& local_field, std::vector <std::vector <double> >& local_fieldp,
+	std::vector <polarization_solver::scaled_pair>& local_scaled) const
+{
+	size_t i, k, j;
+	size_t ii, kk;
+	double xr, yr, zr, r2, r;
+	double ci, dix, diy, diz;
+	double qixx, qixy, qixz;
+	double qiyy, qiyz, qizz;
+	double ck, dkx, dky, dkz;
+	double qkxx, qkxy, qkxz;
+	double qkyy, qkyz, qkzz;
+	double scale3, scale5, scale7;
+	double damp, expdamp;
+	double rr3, rr5, rr7, dir;
+	double qix, qiy, qiz, qir, dkr, qkx, qky, qkz, qkr;
+	std::vector <double> fid(5), fkd(5);
+	std::vector <double> local_pscale(alloc + 100), local_dscale(alloc + 100), local_uscale(alloc + 100);
+	double pdi, pti, pgamma;
+	auto const & positions = coords->xyz();
+
+	for (i = first; i <= alloc - 1; i += step) {
+
 
 		if (alloc == 0) break;
 		ii = ipole[i] + 1;
@@ -1909,41 +2034,45 @@ void energy::interfaces::amoeba::amoeba_ff::e_ind(void)
 
 		for (j = i + 1; j <= alloc; j++) {
 
-			pscale[ipole[j] + 1] = 1.0;
-			dscale[ipole[j] + 1] = 1.0;
+			local_pscale[ipole[j] + 1] = 1.0;
+			local_dscale[ipole[j] + 1] = 1.0;
+			local_uscale[ipole[j] + 1] = 1.0;
 
 		}
 		//std::cout << "n13.size" << n13[ii] << '\n';
 		for (j = 1; j <= n13[ii]; j++) {
-			pscale[i13[j][ii]] = pscale3;
+			local_pscale[i13[j][ii]] = pscale3;
 			//std::cout << "i13 " << i13[j][ii] << " " << pscale3<< '\n';
 
 		}
 		for (j = 1; j <= n14[ii]; j++) {
-			pscale[i14[j][ii]] = pscale4;
+			local_pscale[i14[j][ii]] = pscale4;
 			for (k = 1; k <= np11[ii]; k++) {
-				if (i14[j][ii] == ip11[k][ii]) pscale[i14[j][ii]] = pscale4 * p4scale;
+				if (i14[j][ii] == ip11[k][ii]) local_pscale[i14[j][ii]] = pscale4 * p4scale;
 
 			}
 		}
 
 		for (j = 1; j <= n15[ii]; j++) {
-			pscale[i15[j][ii]] = pscale5;
+			local_pscale[i15[j][ii]] = pscale5;
 
 		}
 		for (j = 1; j <= np11[ii]; j++) {
-			dscale[ip11[j][ii]] = dscale1;
-
+			local_dscale[ip11[j][ii]] = dscale1;
+			local_uscale[ip11[j][ii]] = uscale1;
 		}
 
 		for (j = 1; j <= np12[ii]; j++) {
-			dscale[ip12[j][ii]] = dscale2;
+			local_dscale[ip12[j][ii]] = dscale2;
+			local_uscale[ip12[j][ii]] = uscale2;
 		}
 		for (j = 1; j <= np13[ii]; j++) {
-			dscale[ip13[j][ii]] = dscale3;
+			local_dscale[ip13[j][ii]] = dscale3;
+			local_uscale[ip13[j][ii]] = uscale3;
 		}
 		for (j = 1; j <= np14[ii]; j++) {
-			dscale[ip14[j][ii]] = dscale4;
+			local_dscale[ip14[j][ii]] = dscale4;
+			local_uscale[ip14[j][ii]] = uscale4;
 		}
 
 
@@ -2019,6 +2148,9 @@ void energy::interfaces::amoeba::amoeba_ff::e_ind(void)
 
 				rr7 = 15.0 * scale7 / (r * r2 * r2 * r2);
 
+				// pairs of the mutual induction with another scale than one
+				if (local_uscale[kk] != 1.0) local_scaled.push_back({ static_cast<std::uint32_t>(i - 1), static_cast<std::uint32_t>(k - 1), local_uscale[kk] });
+
 				dir = dix * xr + diy * yr + diz * zr;
 
 				qix = qixx * xr + qixy * yr + qixz * zr;
@@ -2045,11 +2177,11 @@ void energy::interfaces::amoeba::amoeba_ff::e_ind(void)
 
 
 				for (j = 1; j <= 3; j++) {
-					field[j][i] = field[j][i] + fid[j - 1] * dscale[kk];
-					field[j][k] = field[j][k] + fkd[j - 1] * dscale[kk];
-					fieldp[j][i] = fieldp[j][i] + fid[j - 1] * pscale[kk];
-					fieldp[j][k] = fieldp[j][k] + fkd[j - 1] * pscale[kk];
-					//std::cout << dscale[kk] << '\n';
+					local_field[j][i] = local_field[j][i] + fid[j - 1] * local_dscale[kk];
+					local_field[j][k] = local_field[j][k] + fkd[j - 1] * local_dscale[kk];
+					local_fieldp[j][i] = local_fieldp[j][i] + fid[j - 1] * local_pscale[kk];
+					local_fieldp[j][k] = local_fieldp[j][k] + fkd[j - 1] * local_pscale[kk];
+					//std::cout << local_dscale[kk] << '\n';
 
 				}
 
@@ -2063,221 +2195,118 @@ void energy::interfaces::amoeba::amoeba_ff::e_ind(void)
 
 
 	}
+}
 
-	for (i = 1; i <= alloc; i++) {
-		if (alloc == 0) break;
-		for (j = 1; j <= 3; j++) {
-			udir[j][i] = polarity[i] * field[j][i];
-			udirp[j][i] = polarity[i] * fieldp[j][i];
-			uind[j][i] = udir[j][i];
-			uinp[j][i] = udirp[j][i];
-
-
-		}
+void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
+{
+	double cutoff(0.0), cc(0.0);
+	if (Config::get().periodics.periodic == true)
+	{
+		cutoff = len(Config::get().periodics.pb_box);
 	}
+	else  cutoff = Config::get().energy.cutoff;
+	cc = cutoff * cutoff;
 
-	done = false;
-	maxiter = 10000;
-	iter = 0;
-	eps = 100.0;
+	dem.resize(5);
+	dep.resize(5);
+	const size_t N = alloc_glob;
+	coords::Cartesian_Point gv_multipole, gv_polarization;
+	//scon::v3d &gradients = part_grad[energy::interfaces::amoeba::types::mpp];
 
+	for (size_t i = 0; i < dem.size(); i++) {
+		dem[i].resize(N + 1);
+	}
+	for (size_t i = 0; i < dep.size(); i++) {
+		dep[i].resize(N + 1);
+	}
 
 
-	while (!done) {
-		if (alloc == 0) break;
+	em = 0.0;
+	ep = 0.0;
+	//   npole=npole-1;
 
-		// cout << "Hallo" << endl;
-		for (i = 1; i <= alloc; i++) {
-			for (j = 1; j <= 3; j++) {
 
-				field[j][i] = 0.0;
-				fieldp[j][i] = 0.0;
-			}
+	for (size_t i = 1; i <= N; i++) {
+		for (size_t j = 1; j <= 3; j++) {
+			dem[j][i] = 0.0;
+			dep[j][i] = 0.0;
 		}
-		for (i = 1; i <= alloc - 1; i++) {
-
-			ii = ipole[i] + 1;
-			if (ii == 0)continue;
-			pdi = pdamp[i];
-			pti = thole[i];
-			duix = uind[1][i];
-			duiy = uind[2][i];
-			duiz = uind[3][i];
-			puix = uinp[1][i];
-			puiy = uinp[2][i];
-			puiz = uinp[3][i];
-
-
-			for (j = i + 1; j <= alloc; j++) {
-				dscale[ipole[j - 1] + 1] = 1.0;
-			}
-
-			for (j = 1; j <= np11[ii]; j++) {
-				dscale[ip11[j][ii]] = uscale1;
-				//std::cout << ip11[j][ii] << "  " << uscale1 << '\n';
-			}
-			for (j = 1; j <= np12[ii]; j++) {
-				dscale[ip12[j][ii]] = uscale2;
-			}
-			for (j = 1; j <= np13[ii]; j++) {
-				dscale[ip13[j][ii]] = uscale3;
-			}
-			for (j = 1; j <= np14[ii]; j++) {
-				dscale[ip14[j][ii]] = uscale4;
-			}
-
-			for (k = i + 1; k <= alloc; k++) {
-				kk = ipole[k] + 1;
-
-
-				if (kk == 0) continue;
-				//              bool proceed =true;
-				//         //      
-				//             if(proceed) {
-				xr = positions[kk - 1].x() - positions[ii - 1].x();
-				yr = positions[kk - 1].y() - positions[ii - 1].y();
-				zr = positions[kk - 1].z() - positions[ii - 1].z();
-
-				/*if (configuration::e.periodic == true){
-				boundary(xr, yr, zr);
-				}
-				*/
-				r2 = xr * xr + yr * yr + zr * zr;
-				r = sqrt(r2);
-
-				if (r < cutoff) {
-
-
-					dukx = uind[1][k];
-					duky = uind[2][k];
-					dukz = uind[3][k];
-					pukx = uinp[1][k];
-					puky = uinp[2][k];
-					pukz = uinp[3][k];
-
-
-					scale3 = dscale[kk];
-					scale5 = dscale[kk];
-
-					damp = pdi * pdamp[k];
-					if (damp != 0.0) {
-						pgamma = std::min(pti, thole[k]);
-
-						damp = -pgamma * ((r / damp) * (r / damp) * (r / damp));
-
-						if (damp > -50.0) {
-							expdamp = exp(damp);
-							scale3 = scale3 * (1.0 - expdamp);
-							scale5 = scale5 * (1.0 - expdamp * (1.0 - damp));
-
-						}
-
-					}
-
-					rr3 = scale3 / (r * r2);
-
-					rr5 = 3.0 * scale5 / (r * r2 * r2);
-
-
-
-					duir = xr * duix + yr * duiy + zr * duiz;
-					dukr = xr * dukx + yr * duky + zr * dukz;
-					puir = xr * puix + yr * puiy + zr * puiz;
-					pukr = xr * pukx + yr * puky + zr * pukz;
-					fid[0] = -rr3 * dukx + rr5 * dukr * xr;
-					fid[1] = -rr3 * duky + rr5 * dukr * yr;
-					fid[2] = -rr3 * dukz + rr5 * dukr * zr;
-					fkd[0] = -rr3 * duix + rr5 * duir * xr;
-					fkd[1] = -rr3 * duiy + rr5 * duir * yr;
-					fkd[2] = -rr3 * duiz + rr5 * duir * zr;
-					fip[0] = -rr3 * pukx + rr5 * pukr * xr;
-					fip[1] = -rr3 * puky + rr5 * pukr * yr;
-					fip[2] = -rr3 * pukz + rr5 * pukr * zr;
-					fkp[0] = -rr3 * puix + rr5 * puir * xr;
-					fkp[1] = -rr3 * puiy + rr5 * puir * yr;
-					fkp[2] = -rr3 * puiz + rr5 * puir * zr;
-
-					for (j = 1; j <= 3; j++) {
+	}
 
-						field[j][i] = field[j][i] + fid[j - 1];
-						field[j][k] = field[j][k] + fkd[j - 1];
-						fieldp[j][i] = fieldp[j][i] + fip[j - 1];
-						fieldp[j][k] = fieldp[j][k] + fkp[j - 1];
+	// The rows i are distributed cyclically over the threads (the pairs per row decrease with i).
+	// Every thread has its own scale factors, gradients and energies,
+	// which are added in the order of the threads, so the result does not depend on the timing.
+#if defined(_OPENMP)
+	std::size_t const threads(static_cast<std::size_t>(omp_get_max_threads()));
+#else
+	std::size_t const threads(1u);
+#endif
+	std::vector<std::vector<std::vector<double>>> thread_dem(threads), thread_dep(threads);
+	std::vector<double> thread_em(threads, 0.0), thread_ep(threads, 0.0);
 
-					}
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+	{
+#if defined(_OPENMP)
+		std::size_t const thread(static_cast<std::size_t>(omp_get_thread_num())), team(static_cast<std::size_t>(omp_get_num_threads()));
+#else
+		std::size_t const thread(0u), team(1u);
+#endif
+		std::vector<std::vector<double>> local_dem(4, std::vector<double>(N + 1, 0.0)), local_dep(local_dem);
+		double local_em(0.0), local_ep(0.0);
+		e_perm_rows(1u + thread, team, cutoff, cc, local_dem, local_dep, local_em, local_ep);
+		thread_dem[thread].swap(local_dem);
+		thread_dep[thread].swap(local_dep);
+		thread_em[thread] = local_em;
+		thread_ep[thread] = local_ep;
+#if defined(_OPENMP)
+#pragma omp barrier
+#pragma omp for schedule(static)
+#endif
+		for (std::ptrdiff_t n = 1; n <= static_cast<std::ptrdiff_t>(N); n++) {
+			for (std::size_t t = 0; t < threads; t++) {
+				if (thread_dem[t].empty()) continue;
+				for (size_t jj = 1; jj <= 3; jj++) {
+					dem[jj][n] += thread_dem[t][jj][n];
+					dep[jj][n] += thread_dep[t][jj][n];
 				}
-
-
-
-
-
-
-
-
-
-				//            }
 			}
 		}
-
-		iter++;
-		epsold = eps;
-		epsd = 0.0;
-		epsp = 0.0;
-
-		for (i = 1; i <= alloc; i++) {
-			if (alloc == 0) break;
-			for (j = 1; j <= 3; j++) {
-				uold[j][i] = uind[j][i];
-				uoldp[j][i] = uinp[j][i];
-				uind[j][i] = udir[j][i] + polarity[i] * field[j][i];
-				uinp[j][i] = udirp[j][i] + polarity[i] * fieldp[j][i];
-				uind[j][i] = uold[j][i] + 0.55 * (uind[j][i] - uold[j][i]);
-				uinp[j][i] = uoldp[j][i] + 0.55 * (uinp[j][i] - uoldp[j][i]);
-				epsd = epsd + (uind[j][i] - uold[j][i]) * (uind[j][i] - uold[j][i]);
-				epsp = epsp + (uinp[j][i] - uoldp[j][i]) * (uinp[j][i] - uoldp[j][i]);
-
-
-
-
-			}
-		}
-		eps = std::max(epsd, epsp);
-
-		eps = debye * sqrt(eps / (alloc));
-
-		// cout << npole << endl;
-		if (eps < poleps) done = true;
-		if (eps > epsold) done = true;
-		if (iter >= maxiter) done = true;
 	}
-	if (eps > poleps) std::cout << "induced dipoles may not converged\n";
-
-	//for (i = 1; i <= alloc; i++){
-	//	if (alloc == 0) break;
-	//	for (j = 1; j <= 3; j++){
-	//		std::cout << field[j][i] << '\n';
-	//		std::cout << fieldp[j][i] << '\n';
-	//	}
-	//}
+	for (std::size_t t = 0; t < threads; t++) {
+		em += thread_em[t];
+		ep += thread_ep[t];
+	}
 
+	for (size_t n = 1; n <= N; n++)
+	{
+		gv_multipole.x() = dem[1][n];
+		gv_multipole.y() = dem[2][n];
+		gv_multipole.z() = dem[3][n];
+		gv_polarization.x() = dep[1][n];
+		gv_polarization.y() = dep[2][n];
+		gv_polarization.z() = dep[3][n];
 
+		part_grad[MULTIPOLE][n - 1] = gv_multipole;
+		part_grad[POLARIZE][n - 1] = gv_polarization;
 
 
+	}
 
 
 
-	//
 
 
 }
-void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
-{
-
 
+void energy::interfaces::amoeba::amoeba_ff::e_perm_rows(std::size_t const first, std::size_t const step, double const cutoff, double const cc,
+	std::vector <std::vector <double> >& local_dem, std::vector <std::vector <double> >& local_dep, double& local_em, double& local_ep) const
+{
 	size_t i, j, k;
 	size_t ii, kk;
 
-	double e(0.0), ei(0.0), f(0.0);
+	double e(0.0), ei(0.0);
 	double damp(0.0), expdamp(0.0);
 	double pdi(0.0), pti(0.0), pgamma(0.0);
 	double scale3(0.0), scale3i(0.0), scale7(0.0), scale5(0.0), scale5i(0.0);
@@ -2286,15 +2315,7 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 	double xr(0.0), yr(0.0), zr(0.0);
 	double r1(0.0), r2(0.0), rr1(0.0), rr3(0.0), rr5(0.0), rr7(0.0), rr9(0.0), rr11(0.0);
 	double ci(0.0), ck(0.0);
-	double cutoff(0.0), dd(0.0), cc(0.0), fQ(0.0);
-
-
-	if (Config::get().periodics.periodic == true)
-	{
-		cutoff = len(Config::get().periodics.pb_box);
-	}
-	else  cutoff = Config::get().energy.cutoff;
-	cc = cutoff * cutoff;
+	double dd(0.0), fQ(0.0);
 
 	std::vector <double> di(3), qi(9), dk(3), qk(9);
 	std::vector <double> frcxi(4), frcxk(4), frcyi(4), frcyk(4), frczi(4), frczk(4);
@@ -2305,49 +2326,17 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 	std::vector <double> sc(11), sci(9), scip(9), gli(8), glip(8), gf(8), gfi(8), gti(8);
 	std::vector <double> gl(9);
 	double dielec = 332.063714000;
-	dem.resize(5);
-	dep.resize(5);
+	double const f = dielec / 1.0;
 	const size_t N = alloc_glob;
 	auto const& positions = coords->xyz();
-	coords::Cartesian_Point bv, b, gv_multipole, gv_polarization;
-	//scon::v3d &gradients = part_grad[energy::interfaces::amoeba::types::mpp];
-
-	pscale.resize(N + 1);
-	dscale.resize(N + 1);
-	mscale.resize(N + 1);
-	uscale.resize(N + 1);
-	//  cout << "chekc8" << endl;
-	f = dielec / 1.0;
-	for (i = 0; i < dem.size(); i++) {
-		dem[i].resize(N + 1);
-	}
-	for (i = 0; i < dep.size(); i++) {
-		dep[i].resize(N + 1);
-	}
-
-
-	em = 0.0;
-	ep = 0.0;
-	//   npole=npole-1;
-
-
-	for (i = 1; i <= N; i++) {
-		for (j = 1; j <= 3; j++) {
-			dem[j][i] = 0.0;
-			dep[j][i] = 0.0;
-		}
-	}
+	std::vector<double> local_mscale(N + 1, 1.0), local_pscale(N + 1, 1.0), local_dscale(N + 1, 1.0), local_uscale(N + 1, 1.0);
 
-	for (i = 1; i <= N; i++) {
-		mscale[i] = 1.0;
-		pscale[i] = 1.0;
-		dscale[i] = 1.0;
-		uscale[i] = 1.0;
-	}
 	//std::cout << "ANFANG  " << N << '\n';
-	for (i = 1; i <= N - 1; i++) {
+	for (i = first; i <= N - 1; i += step) {
 		if (N == 0) break;
 
+
+
 		ii = ipole[i] + 1;
 		if (ii == 0)continue;
 		//auto iz = zaxis[i];
@@ -2373,45 +2362,45 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 
 
 		for (j = 0; j < coords->atoms(ii - 1).bonds().size(); j++) {
-			pscale[coords->atoms(ii - 1).bonds()[j] + 1] = pscale2;
-			mscale[coords->atoms(ii - 1).bonds()[j] + 1] = mscale2;
+			local_pscale[coords->atoms(ii - 1).bonds()[j] + 1] = pscale2;
+			local_mscale[coords->atoms(ii - 1).bonds()[j] + 1] = mscale2;
 
 		}
 		for (j = 1; j <= n13[ii]; j++) {
-			pscale[i13[j][ii]] = pscale3;
-			mscale[i13[j][ii]] = mscale3;
+			local_pscale[i13[j][ii]] = pscale3;
+			local_mscale[i13[j][ii]] = mscale3;
 
 		}
 		for (j = 1; j <= n14[ii]; j++) {
-			pscale[i14[j][ii]] = pscale4;
-			mscale[i14[j][ii]] = mscale4;
+			local_pscale[i14[j][ii]] = pscale4;
+			local_mscale[i14[j][ii]] = mscale4;
 
 			for (k = 1; k <= np11[ii]; k++) {
-				if (i14[j][ii] == ip11[k][ii]) pscale[i14[j][ii]] = pscale4 * p4scale;
+				if (i14[j][ii] == ip11[k][ii]) local_pscale[i14[j][ii]] = pscale4 * p4scale;
 
 			}
 		}
 
 		for (j = 1; j <= n15[ii]; j++) {
-			pscale[i15[j][ii]] = pscale5;
-			mscale[i15[j][ii]] = mscale5;
+			local_pscale[i15[j][ii]] = pscale5;
+			local_mscale[i15[j][ii]] = mscale5;
 		}
 		for (j = 1; j <= np11[ii]; j++) {
-			dscale[ip11[j][ii]] = dscale1;
-			uscale[ip11[j][ii]] = uscale1;
+			local_dscale[ip11[j][ii]] = dscale1;
+			local_uscale[ip11[j][ii]] = uscale1;
 		}
 		for (j = 1; j <= np12[ii]; j++) {
-			dscale[ip12[j][ii]] = dscale2;
-			uscale[ip12[j][ii]] = uscale2;
+			local_dscale[ip12[j][ii]] = dscale2;
+			local_uscale[ip12[j][ii]] = uscale2;
 		}
 		for (j = 1; j <= np13[ii]; j++) {
-			dscale[ip13[j][ii]] = dscale3;
-			uscale[ip13[j][ii]] = uscale3;
+			local_dscale[ip13[j][ii]] = dscale3;
+			local_uscale[ip13[j][ii]] = uscale3;
 		}
 		for (j = 1; j <= np14[ii]; j++) {
 
-			dscale[ip14[j][ii]] = dscale4;
-			uscale[ip14[j][ii]] = uscale4;
+			local_dscale[ip14[j][ii]] = dscale4;
+			local_uscale[ip14[j][ii]] = uscale4;
 		}
 		//    cout << "chekc8" << endl;
 		for (k = i + 1; k <= N; k++) {
@@ -2501,17 +2490,17 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 
 					}
 				}
-				scale3i = scale3 * uscale[kk];
-				scale5i = scale5 * uscale[kk];
-				//scale7i = scale7 * uscale[kk];
+				scale3i = scale3 * local_uscale[kk];
+				scale5i = scale5 * local_uscale[kk];
+				//scale7i = scale7 * local_uscale[kk];
 
-				dsc3 = scale3 * dscale[kk];
-				dsc5 = scale5 * dscale[kk];
-				dsc7 = scale7 * dscale[kk];
+				dsc3 = scale3 * local_dscale[kk];
+				dsc5 = scale5 * local_dscale[kk];
+				dsc7 = scale7 * local_dscale[kk];
 
-				psc3 = scale3 * pscale[kk];
-				psc5 = scale5 * pscale[kk];
-				psc7 = scale7 * pscale[kk];
+				psc3 = scale3 * local_pscale[kk];
+				psc5 = scale5 * local_pscale[kk];
+				psc7 = scale7 * local_pscale[kk];
 
 				//!construction of necessary auxilliary vectors	
 
@@ -2717,19 +2706,19 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 				{
 					e = rr1 * gl[0] + rr3 * (gl[1] + gl[6]) + rr5 * (gl[2] + gl[7] + gl[8]) + rr7 * (gl[3] + gl[5]) + rr9 * gl[4];
 					ei = 0.50 * (rr3 * (gli[1] + gli[6]) * psc3 + rr5 * (gli[2] + gli[7]) * psc5 + rr7 * gli[3] * psc7);
-					e = f * mscale[kk] * e * fQ;
+					e = f * local_mscale[kk] * e * fQ;
 					ei = f * ei * fQ;
 				}
 				else {
 					e = rr1 * gl[0] + rr3 * (gl[1] + gl[6]) + rr5 * (gl[2] + gl[7] + gl[8]) + rr7 * (gl[3] + gl[5]) + rr9 * gl[4];
 					ei = 0.50 * (rr3 * (gli[1] + gli[6]) * psc3 + rr5 * (gli[2] + gli[7]) * psc5 + rr7 * gli[3] * psc7);
-					e = f * mscale[kk] * e;
+					e = f * local_mscale[kk] * e;
 					ei = f * ei;
 				}
 
 
-				em = em + e;
-				ep = ep + ei;
+				local_em = local_em + e;
+				local_ep = local_ep + ei;
 
 
 
@@ -2787,9 +2776,9 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 
 				//! account for part. excluded induced interactions
 
-				temp3 = 0.5 * rr3 * ((gli[1] + gli[6]) * pscale[kk] + (glip[1] + glip[6]) * dscale[kk]);
-				temp5 = 0.5 * rr5 * ((gli[2] + gli[7]) * pscale[kk] + (glip[2] + glip[7]) * dscale[kk]);
-				temp7 = 0.5 * rr7 * (gli[3] * pscale[kk] + glip[3] * dscale[kk]);
+				temp3 = 0.5 * rr3 * ((gli[1] + gli[6]) * local_pscale[kk] + (glip[1] + glip[6]) * local_dscale[kk]);
+				temp5 = 0.5 * rr5 * ((gli[2] + gli[7]) * local_pscale[kk] + (glip[2] + glip[7]) * local_dscale[kk]);
+				temp7 = 0.5 * rr7 * (gli[3] * local_pscale[kk] + glip[3] * local_dscale[kk]);
 
 				fridmp[1] = temp3 * ddsc3[0] + temp5 * ddsc5[0] + temp7 * ddsc7[0];
 				fridmp[2] = temp3 * ddsc3[1] + temp5 * ddsc5[1] + temp7 * ddsc7[1];
@@ -2797,8 +2786,8 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 
 				//! find some scaling for induced-induced force
 
-				temp3 = 0.5 * rr3 * uscale[kk] * scip[2];
-				temp5 = -0.5 * rr5 * uscale[kk] * (sci[3] * scip[4] + scip[3] * sci[4]);
+				temp3 = 0.5 * rr3 * local_uscale[kk] * scip[2];
+				temp5 = -0.5 * rr5 * local_uscale[kk] * (sci[3] * scip[4] + scip[3] * sci[4]);
 
 				findmp[1] = temp3 * ddsc3[0] + temp5 * ddsc5[0];
 				findmp[2] = temp3 * ddsc3[1] + temp5 * ddsc5[1];
@@ -2847,11 +2836,11 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 				//! handle the case were scaling is used
 
 				for (j = 1; j <= 3; j++) {
-					ftm2[j] = f * ftm2[j] * mscale[kk];
+					ftm2[j] = f * ftm2[j] * local_mscale[kk];
 					ftm2i[j] = f * ftm2i[j];
-					ttm2[j] = f * ttm2[j] * mscale[kk];
+					ttm2[j] = f * ttm2[j] * local_mscale[kk];
 					ttm2i[j] = f * ttm2i[j];
-					ttm3[j] = f * ttm3[j] * mscale[kk];
+					ttm3[j] = f * ttm3[j] * local_mscale[kk];
 					ttm3i[j] = f * ttm3i[j];
 
 				}
@@ -2860,14 +2849,14 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 			/*	vector <double> test;
 				test.reserve(n_atom + 100);*/
 
-				dem[1][ii] += ftm2[1];
-				dem[2][ii] += ftm2[2];
-				dem[3][ii] += ftm2[3];
+				local_dem[1][ii] += ftm2[1];
+				local_dem[2][ii] += ftm2[2];
+				local_dem[3][ii] += ftm2[3];
 
 
-				dep[1][ii] += ftm2i[1];
-				dep[2][ii] += ftm2i[2];
-				dep[3][ii] += ftm2i[3];
+				local_dep[1][ii] += ftm2i[1];
+				local_dep[2][ii] += ftm2i[2];
+				local_dep[3][ii] += ftm2i[3];
 
 
 
@@ -2877,10 +2866,10 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 
 				//! calling torque: convert single site torque to force
 
-				std::vector <double> frcx(4), frcy(4), frcz(4);
+				std::array<double, 4> frcx{}, frcy{}, frcz{};
 				ptrdiff_t ia, ic, ib, id;
-				std::vector<double> u(4), v(4), w(4), r(4), s(4), t(4), t1(4), t2(4);
-				std::vector<double> uv(4), uw(4), vw(4), ur(4), us(4), vs(4), ws(4);
+				std::array<double, 4> u{}, v{}, w{}, r{}, s{}, t1{}, t2{};
+				std::array<double, 4> uv{}, uw{}, vw{}, ur{}, us{}, vs{}, ws{};
 				double du(0.0), dv(0.0), dw(0.0), usiz(0.0), vsiz(0.0), wsiz(0.0), rsiz(0.0), ssiz(0.0);
 				double t1siz(0.0), t2siz(0.0), uvsiz(0.0), uwsiz(0.0), vwsiz(0.0), ursiz(0.0), ussiz(0.0), vssiz(0.0), wssiz(0.0);
 				double uvcos(0.0), uwcos(0.0), vwcos(0.0), urcos(0.0), vscos(0.0), wscos(0.0);
@@ -2896,345 +2885,346 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 					frcy[j] = 0.0;
 				}
 				//std::cout << "Test5\n";
-				ia = zaxis[i] + 1;
-				ib = ipole[i] + 1;
-				if (ib == 0)continue;
-				ic = xaxis[i] + 1;
-				id = yaxis[i] + 1;
+				//! sites without local axes (global frame) carry no torque
+				if (axistype[i] != 0) {
+					ia = zaxis[i] + 1;
+					ib = ipole[i] + 1;
+					ic = xaxis[i] + 1;
+					id = yaxis[i] + 1;
 
 
-				if (axistype[i] == 0) continue;
 
-				u[1] = positions[ia - 1].x() - positions[ib - 1].x();
-				u[2] = positions[ia - 1].y() - positions[ib - 1].y();
-				u[3] = positions[ia - 1].z() - positions[ib - 1].z();
+					u[1] = positions[ia - 1].x() - positions[ib - 1].x();
+					u[2] = positions[ia - 1].y() - positions[ib - 1].y();
+					u[3] = positions[ia - 1].z() - positions[ib - 1].z();
 
 
-				if (axistype[i] != 1) {
-					v[1] = positions[ic - 1].x() - positions[ib - 1].x();
-					v[2] = positions[ic - 1].y() - positions[ib - 1].y();
-					v[3] = positions[ic - 1].z() - positions[ib - 1].z();
+					if (axistype[i] != 1) {
+						v[1] = positions[ic - 1].x() - positions[ib - 1].x();
+						v[2] = positions[ic - 1].y() - positions[ib - 1].y();
+						v[3] = positions[ic - 1].z() - positions[ib - 1].z();
 
-				}
-				if (axistype[i] == 4 || axistype[i] == 5) {
-					w[1] = positions[id - 1].x() - positions[ib - 1].x();
-					w[2] = positions[id - 1].y() - positions[ib - 1].y();
-					w[3] = positions[id - 1].z() - positions[ib - 1].z();
-				}
-				else {
-					w[1] = u[2] * v[3] - u[3] * v[2];
-					w[2] = u[3] * v[1] - u[1] * v[3];
-					w[3] = u[1] * v[2] - u[2] * v[1];
-					// 	  cout<< w[1] << endl;
-				}
+					}
+					if (axistype[i] == 4 || axistype[i] == 5) {
+						w[1] = positions[id - 1].x() - positions[ib - 1].x();
+						w[2] = positions[id - 1].y() - positions[ib - 1].y();
+						w[3] = positions[id - 1].z() - positions[ib - 1].z();
+					}
+					else {
+						w[1] = u[2] * v[3] - u[3] * v[2];
+						w[2] = u[3] * v[1] - u[1] * v[3];
+						w[3] = u[1] * v[2] - u[2] * v[1];
+						// 	  cout<< w[1] << endl;
+					}
 
-				usiz = sqrt(u[1] * u[1] + u[2] * u[2] + u[3] * u[3]);
-				vsiz = sqrt(v[1] * v[1] + v[2] * v[2] + v[3] * v[3]);
-				wsiz = sqrt(w[1] * w[1] + w[2] * w[2] + w[3] * w[3]);
-				if (usiz == 0.0) usiz = 1.0;
-				if (vsiz == 0.0) vsiz = 1.0;
-				if (wsiz == 0.0) wsiz = 1.0;
-				// 	cout<< usiz << endl;
-				for (j = 1; j <= 3; j++) {
-					u[j] = u[j] / usiz;
-					v[j] = v[j] / vsiz;
-					w[j] = w[j] / wsiz;
+					usiz = sqrt(u[1] * u[1] + u[2] * u[2] + u[3] * u[3]);
+					vsiz = sqrt(v[1] * v[1] + v[2] * v[2] + v[3] * v[3]);
+					wsiz = sqrt(w[1] * w[1] + w[2] * w[2] + w[3] * w[3]);
+					if (usiz == 0.0) usiz = 1.0;
+					if (vsiz == 0.0) vsiz = 1.0;
+					if (wsiz == 0.0) wsiz = 1.0;
+					// 	cout<< usiz << endl;
+					for (j = 1; j <= 3; j++) {
+						u[j] = u[j] / usiz;
+						v[j] = v[j] / vsiz;
+						w[j] = w[j] / wsiz;
 
-				}
+					}
 
-				if (axistype[i] == 4) {
-					r[1] = v[1] + w[1];
-					r[2] = v[2] + w[2];
-					r[3] = v[3] + w[3];
+					if (axistype[i] == 4) {
+						r[1] = v[1] + w[1];
+						r[2] = v[2] + w[2];
+						r[3] = v[3] + w[3];
 
-					s[1] = u[2] * r[3] - u[3] * r[2];
-					s[2] = u[3] * r[1] - u[1] * r[3];
-					s[3] = u[1] * r[2] - u[2] * r[1];
+						s[1] = u[2] * r[3] - u[3] * r[2];
+						s[2] = u[3] * r[1] - u[1] * r[3];
+						s[3] = u[1] * r[2] - u[2] * r[1];
 
-					rsiz = sqrt(r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
-					ssiz = sqrt(s[1] * s[1] + s[2] * s[2] + s[3] * s[3]);
-					if (rsiz == 0.0) rsiz = 1.0;
-					if (ssiz == 0.0) ssiz = 1.0;
+						rsiz = sqrt(r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+						ssiz = sqrt(s[1] * s[1] + s[2] * s[2] + s[3] * s[3]);
+						if (rsiz == 0.0) rsiz = 1.0;
+						if (ssiz == 0.0) ssiz = 1.0;
 
 
-					for (j = 1; j <= 3; j++) {
-						r[j] = r[j] / rsiz;
-						s[j] = s[j] / ssiz;
+						for (j = 1; j <= 3; j++) {
+							r[j] = r[j] / rsiz;
+							s[j] = s[j] / ssiz;
+						}
 					}
-				}
-				//! find the perpendicularand angle for each pair of axes    
-
-				uv[1] = v[2] * u[3] - v[3] * u[2];
-				uv[2] = v[3] * u[1] - v[1] * u[3];
-				uv[3] = v[1] * u[2] - v[2] * u[1];
-
-				uw[1] = w[2] * u[3] - w[3] * u[2];
-				uw[2] = w[3] * u[1] - w[1] * u[3];
-				uw[3] = w[1] * u[2] - w[2] * u[1];
-
-				vw[1] = w[2] * v[3] - w[3] * v[2];
-				vw[2] = w[3] * v[1] - w[1] * v[3];
-				vw[3] = w[1] * v[2] - w[2] * v[1];
-
-				uvsiz = sqrt(uv[1] * uv[1] + uv[2] * uv[2] + uv[3] * uv[3]);
-				uwsiz = sqrt(uw[1] * uw[1] + uw[2] * uw[2] + uw[3] * uw[3]);
-				vwsiz = sqrt(vw[1] * vw[1] + vw[2] * vw[2] + vw[3] * vw[3]);
-				if (uvsiz == 0.0) uvsiz = 1.0;
-				if (uwsiz == 0.0) uwsiz = 1.0;
-				if (vwsiz == 0.0) vwsiz = 1.0;
+					//! find the perpendicularand angle for each pair of axes    
 
-				for (j = 1; j <= 3; j++) {
-					uv[j] = uv[j] / uvsiz;
-					uw[j] = uw[j] / uwsiz;
-					vw[j] = vw[j] / vwsiz;
-				}
+					uv[1] = v[2] * u[3] - v[3] * u[2];
+					uv[2] = v[3] * u[1] - v[1] * u[3];
+					uv[3] = v[1] * u[2] - v[2] * u[1];
 
+					uw[1] = w[2] * u[3] - w[3] * u[2];
+					uw[2] = w[3] * u[1] - w[1] * u[3];
+					uw[3] = w[1] * u[2] - w[2] * u[1];
 
-				if (axistype[i] == 4) {
-					ur[1] = r[2] * u[3] - r[3] * u[2];
-					ur[2] = r[3] * u[1] - r[1] * u[3];
-					ur[3] = r[1] * u[2] - r[2] * u[1];
-					us[1] = s[2] * u[3] - s[3] * u[2];
-					us[2] = s[3] * u[1] - s[1] * u[3];
-					us[3] = s[1] * u[2] - s[2] * u[1];
-					vs[1] = s[2] * v[3] - s[3] * v[2];
-					vs[2] = s[3] * v[1] - s[1] * v[3];
-					vs[3] = s[1] * v[2] - s[2] * v[1];
-					ws[1] = s[2] * w[3] - s[3] * w[2];
-					ws[2] = s[3] * w[1] - s[1] * w[3];
-					ws[3] = s[1] * w[2] - s[2] * w[1];
+					vw[1] = w[2] * v[3] - w[3] * v[2];
+					vw[2] = w[3] * v[1] - w[1] * v[3];
+					vw[3] = w[1] * v[2] - w[2] * v[1];
 
-					ursiz = sqrt(ur[1] * ur[1] + ur[2] * ur[2] + ur[3] * ur[3]);
-					ussiz = sqrt(us[1] * us[1] + us[2] * us[2] + us[3] * us[3]);
-					vssiz = sqrt(vs[1] * vs[1] + vs[2] * vs[2] + vs[3] * vs[3]);
-					wssiz = sqrt(ws[1] * ws[1] + ws[2] * ws[2] + ws[3] * ws[3]);
+					uvsiz = sqrt(uv[1] * uv[1] + uv[2] * uv[2] + uv[3] * uv[3]);
+					uwsiz = sqrt(uw[1] * uw[1] + uw[2] * uw[2] + uw[3] * uw[3]);
+					vwsiz = sqrt(vw[1] * vw[1] + vw[2] * vw[2] + vw[3] * vw[3]);
+					if (uvsiz == 0.0) uvsiz = 1.0;
+					if (uwsiz == 0.0) uwsiz = 1.0;
+					if (vwsiz == 0.0) vwsiz = 1.0;
 
-					if (ursiz == 0.0) ursiz = 1.0;
-					if (ussiz == 0.0) ussiz = 1.0;
-					if (vssiz == 0.0) vssiz = 1.0;
-					if (wssiz == 0.0) wssiz = 1.0;
 					for (j = 1; j <= 3; j++) {
-						ur[j] = ur[j] / ursiz;
-						us[j] = us[j] / ussiz;
-						vs[j] = vs[j] / vssiz;
-						ws[j] = ws[j] / wssiz;
+						uv[j] = uv[j] / uvsiz;
+						uw[j] = uw[j] / uwsiz;
+						vw[j] = vw[j] / vwsiz;
 					}
-				}
 
-				uvcos = u[1] * v[1] + u[2] * v[2] + u[3] * v[3];
-				uvsin = sqrt(1.0 - uvcos * uvcos);
-				uwcos = u[1] * w[1] + u[2] * w[2] + u[3] * w[3];
-				uwsin = sqrt(1.0 - uwcos * uwcos);
-				vwcos = v[1] * w[1] + v[2] * w[2] + v[3] * w[3];
-				vwsin = sqrt(1.0 - vwcos * vwcos);
-				// 	cout << u[1] << endl;
-				if (axistype[i] == 4) {
-					urcos = u[1] * r[1] + u[2] * r[2] + u[3] * r[3];
-					ursin = sqrt(1.0 - urcos * urcos);
-					//uscos = u[1] * s[1] + u[2] * s[2] + u[3] * s[3];
-					//ussin = sqrt(1.0 - uscos*uscos);
-					vscos = v[1] * s[1] + v[2] * s[2] + v[3] * s[3];
-					vssin = sqrt(1.0 - vscos * vscos);
-					wscos = w[1] * s[1] + w[2] * s[2] + w[3] * s[3];
-					wssin = sqrt(1.0 - wscos * wscos);
-				}
 
-				//!compute the projection of v and w onto the ru-plane
+					if (axistype[i] == 4) {
+						ur[1] = r[2] * u[3] - r[3] * u[2];
+						ur[2] = r[3] * u[1] - r[1] * u[3];
+						ur[3] = r[1] * u[2] - r[2] * u[1];
+						us[1] = s[2] * u[3] - s[3] * u[2];
+						us[2] = s[3] * u[1] - s[1] * u[3];
+						us[3] = s[1] * u[2] - s[2] * u[1];
+						vs[1] = s[2] * v[3] - s[3] * v[2];
+						vs[2] = s[3] * v[1] - s[1] * v[3];
+						vs[3] = s[1] * v[2] - s[2] * v[1];
+						ws[1] = s[2] * w[3] - s[3] * w[2];
+						ws[2] = s[3] * w[1] - s[1] * w[3];
+						ws[3] = s[1] * w[2] - s[2] * w[1];
+
+						ursiz = sqrt(ur[1] * ur[1] + ur[2] * ur[2] + ur[3] * ur[3]);
+						ussiz = sqrt(us[1] * us[1] + us[2] * us[2] + us[3] * us[3]);
+						vssiz = sqrt(vs[1] * vs[1] + vs[2] * vs[2] + vs[3] * vs[3]);
+						wssiz = sqrt(ws[1] * ws[1] + ws[2] * ws[2] + ws[3] * ws[3]);
+
+						if (ursiz == 0.0) ursiz = 1.0;
+						if (ussiz == 0.0) ussiz = 1.0;
+						if (vssiz == 0.0) vssiz = 1.0;
+						if (wssiz == 0.0) wssiz = 1.0;
+						for (j = 1; j <= 3; j++) {
+							ur[j] = ur[j] / ursiz;
+							us[j] = us[j] / ussiz;
+							vs[j] = vs[j] / vssiz;
+							ws[j] = ws[j] / wssiz;
+						}
+					}
 
-				if (axistype[i] == 4) {
-					for (j = 1; j <= 3; j++) {
-						t1[j] = v[j] - s[j] * vscos;
-						t2[j] = w[j] - s[j] * wscos;
+					uvcos = u[1] * v[1] + u[2] * v[2] + u[3] * v[3];
+					uvsin = sqrt(1.0 - uvcos * uvcos);
+					uwcos = u[1] * w[1] + u[2] * w[2] + u[3] * w[3];
+					uwsin = sqrt(1.0 - uwcos * uwcos);
+					vwcos = v[1] * w[1] + v[2] * w[2] + v[3] * w[3];
+					vwsin = sqrt(1.0 - vwcos * vwcos);
+					// 	cout << u[1] << endl;
+					if (axistype[i] == 4) {
+						urcos = u[1] * r[1] + u[2] * r[2] + u[3] * r[3];
+						ursin = sqrt(1.0 - urcos * urcos);
+						//uscos = u[1] * s[1] + u[2] * s[2] + u[3] * s[3];
+						//ussin = sqrt(1.0 - uscos*uscos);
+						vscos = v[1] * s[1] + v[2] * s[2] + v[3] * s[3];
+						vssin = sqrt(1.0 - vscos * vscos);
+						wscos = w[1] * s[1] + w[2] * s[2] + w[3] * s[3];
+						wssin = sqrt(1.0 - wscos * wscos);
 					}
-					t1siz = sqrt(t1[1] * t1[1] + t1[2] * t1[2] + t1[3] * t1[3]);
-					t2siz = sqrt(t2[1] * t2[1] + t2[2] * t2[2] + t2[3] * t2[3]);
-					if (t1siz == 0.0) t1siz = 1.0;
-					if (t2siz == 0.0) t2siz = 1.0;
-					for (j = 1; j <= 3; j++) {
-						t1[j] = t1[j] / t1siz;
-						t2[j] = t2[j] / t2siz;
+
+					//!compute the projection of v and w onto the ru-plane
+
+					if (axistype[i] == 4) {
+						for (j = 1; j <= 3; j++) {
+							t1[j] = v[j] - s[j] * vscos;
+							t2[j] = w[j] - s[j] * wscos;
+						}
+						t1siz = sqrt(t1[1] * t1[1] + t1[2] * t1[2] + t1[3] * t1[3]);
+						t2siz = sqrt(t2[1] * t2[1] + t2[2] * t2[2] + t2[3] * t2[3]);
+						if (t1siz == 0.0) t1siz = 1.0;
+						if (t2siz == 0.0) t2siz = 1.0;
+						for (j = 1; j <= 3; j++) {
+							t1[j] = t1[j] / t1siz;
+							t2[j] = t2[j] / t2siz;
+						}
+						ut1cos = u[1] * t1[1] + u[2] * t1[2] + u[3] * t1[3];
+						ut1sin = sqrt(1.0 - ut1cos * ut1cos);
+						ut2cos = u[1] * t2[1] + u[2] * t2[2] + u[3] * t2[3];
+						ut2sin = sqrt(1.0 - ut2cos * ut2cos);
 					}
-					ut1cos = u[1] * t1[1] + u[2] * t1[2] + u[3] * t1[3];
-					ut1sin = sqrt(1.0 - ut1cos * ut1cos);
-					ut2cos = u[1] * t2[1] + u[2] * t2[2] + u[3] * t2[3];
-					ut2sin = sqrt(1.0 - ut2cos * ut2cos);
-				}
 
-				//! negative of dot product of torque with unit vectors gives
-				//! result of the infinitesimal rotation along the rot vectors
+					//! negative of dot product of torque with unit vectors gives
+					//! result of the infinitesimal rotation along the rot vectors
 
-				dphidu = -ttm2[1] * u[1] - ttm2[2] * u[2] - ttm2[3] * u[3];
-				dphidv = -ttm2[1] * v[1] - ttm2[2] * v[2] - ttm2[3] * v[3];
-				dphidw = -ttm2[1] * w[1] - ttm2[2] * w[2] - ttm2[3] * w[3];
+					dphidu = -ttm2[1] * u[1] - ttm2[2] * u[2] - ttm2[3] * u[3];
+					dphidv = -ttm2[1] * v[1] - ttm2[2] * v[2] - ttm2[3] * v[3];
+					dphidw = -ttm2[1] * w[1] - ttm2[2] * w[2] - ttm2[3] * w[3];
 
-				if (axistype[i] == 4) {
-					dphidr = ttm2[1] * r[1] - ttm2[2] * r[2] - ttm2[3] * r[3];
-					dphids = ttm2[1] * s[1] - ttm2[2] * s[2] - ttm2[3] * s[3];
-				}
-				//! force distribution for the z-only local coordinate frame	
-				if (axistype[i] == 1) {
-					for (j = 1; j <= 3; j++) {
-						du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
-						dem[j][ia] = dem[j][ia] + du;
-						dem[j][ib] = dem[j][ib] - du;
+					if (axistype[i] == 4) {
+						dphidr = ttm2[1] * r[1] - ttm2[2] * r[2] - ttm2[3] * r[3];
+						dphids = ttm2[1] * s[1] - ttm2[2] * s[2] - ttm2[3] * s[3];
 					}
-					//! force distribution for the z-thenx local coordinate method    
-				}
-				else if (axistype[i] == 2) {
-					for (j = 1; j <= 3; j++) {
-						du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
-						dv = -uv[j] * dphidu / (vsiz * uvsin);
-						dem[j][ia] = dem[j][ia] + du;
-						dem[j][ic] = dem[j][ic] + dv;
-						dem[j][ib] = dem[j][ib] - du - dv;
-						frcz[j] = frcz[j] + du;
-						frcx[j] = frcx[j] + dv;
-						// 	  cout << dem[j][ia] << endl;
+					//! force distribution for the z-only local coordinate frame	
+					if (axistype[i] == 1) {
+						for (j = 1; j <= 3; j++) {
+							du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
+							local_dem[j][ia] = local_dem[j][ia] + du;
+							local_dem[j][ib] = local_dem[j][ib] - du;
+						}
+						//! force distribution for the z-thenx local coordinate method    
+					}
+					else if (axistype[i] == 2) {
+						for (j = 1; j <= 3; j++) {
+							du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
+							dv = -uv[j] * dphidu / (vsiz * uvsin);
+							local_dem[j][ia] = local_dem[j][ia] + du;
+							local_dem[j][ic] = local_dem[j][ic] + dv;
+							local_dem[j][ib] = local_dem[j][ib] - du - dv;
+							frcz[j] = frcz[j] + du;
+							frcx[j] = frcx[j] + dv;
+							// 	  cout << local_dem[j][ia] << endl;
 
 
+						}
 					}
-				}
-				else if (axistype[i] == 3) {
-					for (j = 1; j <= 3; j++) {
-						du = uv[j] * dphidv / (usiz * uvsin) + 0.5 * uw[j] * dphidw / usiz;
-						dv = -uv[j] * dphidu / (vsiz * uvsin) + 0.5 * vw[j] * dphidw / vsiz;
-						dem[j][ia] = dem[j][ia] + du;
-						dem[j][ic] = dem[j][ic] + dv;
-						dem[j][ib] = dem[j][ib] - du - dv;
-						frcz[j] = frcz[j] + du;
-						frcx[j] = frcx[j] + dv;
+					else if (axistype[i] == 3) {
+						for (j = 1; j <= 3; j++) {
+							du = uv[j] * dphidv / (usiz * uvsin) + 0.5 * uw[j] * dphidw / usiz;
+							dv = -uv[j] * dphidu / (vsiz * uvsin) + 0.5 * vw[j] * dphidw / vsiz;
+							local_dem[j][ia] = local_dem[j][ia] + du;
+							local_dem[j][ic] = local_dem[j][ic] + dv;
+							local_dem[j][ib] = local_dem[j][ib] - du - dv;
+							frcz[j] = frcz[j] + du;
+							frcx[j] = frcx[j] + dv;
 
 
+						}
 					}
-				}
-				else if (axistype[i] == 4) {
-					for (j = 1; j <= 3; j++) {
-						du = ur[j] * dphidr / (usiz * ursin) + us[j] * dphids / usiz;
-						dv = (vssin * s[j] - vscos * t1[j]) * dphidu / (vsiz * (ut1sin + ut2sin));
-						dw = (wssin * s[j] - wscos * t2[j]) * dphidu / (wsiz * (ut1sin + ut2sin));
-						dem[j][ia] = dem[j][ia] + du;
-						dem[j][ic] = dem[j][ic] + dv;
-						dem[j][id] = dem[j][id] + dw;
-						dem[j][ib] = dem[j][ib] - du - dv - dw;
-						frcz[j] = frcz[j] + du;
-						frcx[j] = frcx[j] + dv;
-						frcy[j] = frcy[j] + dw;
+					else if (axistype[i] == 4) {
+						for (j = 1; j <= 3; j++) {
+							du = ur[j] * dphidr / (usiz * ursin) + us[j] * dphids / usiz;
+							dv = (vssin * s[j] - vscos * t1[j]) * dphidu / (vsiz * (ut1sin + ut2sin));
+							dw = (wssin * s[j] - wscos * t2[j]) * dphidu / (wsiz * (ut1sin + ut2sin));
+							local_dem[j][ia] = local_dem[j][ia] + du;
+							local_dem[j][ic] = local_dem[j][ic] + dv;
+							local_dem[j][id] = local_dem[j][id] + dw;
+							local_dem[j][ib] = local_dem[j][ib] - du - dv - dw;
+							frcz[j] = frcz[j] + du;
+							frcx[j] = frcx[j] + dv;
+							frcy[j] = frcy[j] + dw;
+						}
 					}
-				}
-				else if (axistype[i] == 5) {
-					for (j = 1; j <= 3; j++) {
-						du = uw[j] * dphidw / (usiz * uwsin) + uv[j] * dphidv / (usiz * uvsin) - uw[j] * dphidu / (usiz * uwsin) - uv[j] * dphidu / (usiz * uvsin);
-						dv = vw[j] * dphidw / (vsiz * vwsin) - uv[j] * dphidu / (vsiz * uvsin) - vw[j] * dphidv / (vsiz * vwsin) + uv[j] * dphidv / (vsiz * uvsin);
-						dw = -uw[j] * dphidu / (wsiz * uwsin) - vw[j] * dphidv / (wsiz * vwsin) + uw[j] * dphidw / (wsiz * uwsin) + vw[j] * dphidw / (wsiz * vwsin);
-						du = du / 3.0;
-						dv = dv / 3.0;
-						dw = dw / 3.0;
-
-						dem[j][ia] = dem[j][ia] + du;
-						dem[j][ic] = dem[j][ic] + dv;
-						dem[j][id] = dem[j][id] + dw;
-						dem[j][ib] = dem[j][ib] - du - dv - dw;
-						frcz[j] = frcz[j] + du;
-						frcx[j] = frcx[j] + dv;
-						frcy[j] = frcy[j] + dw;
+					else if (axistype[i] == 5) {
+						for (j = 1; j <= 3; j++) {
+							du = uw[j] * dphidw / (usiz * uwsin) + uv[j] * dphidv / (usiz * uvsin) - uw[j] * dphidu / (usiz * uwsin) - uv[j] * dphidu / (usiz * uvsin);
+							dv = vw[j] * dphidw / (vsiz * vwsin) - uv[j] * dphidu / (vsiz * uvsin) - vw[j] * dphidv / (vsiz * vwsin) + uv[j] * dphidv / (vsiz * uvsin);
+							dw = -uw[j] * dphidu / (wsiz * uwsin) - vw[j] * dphidv / (wsiz * vwsin) + uw[j] * dphidw / (wsiz * uwsin) + vw[j] * dphidw / (wsiz * vwsin);
+							du = du / 3.0;
+							dv = dv / 3.0;
+							dw = dw / 3.0;
+
+							local_dem[j][ia] = local_dem[j][ia] + du;
+							local_dem[j][ic] = local_dem[j][ic] + dv;
+							local_dem[j][id] = local_dem[j][id] + dw;
+							local_dem[j][ib] = local_dem[j][ib] - du - dv - dw;
+							frcz[j] = frcz[j] + du;
+							frcx[j] = frcx[j] + dv;
+							frcy[j] = frcy[j] + dw;
+						}
 					}
-				}
-				//! negative of dot product of torque with unit vectors gives
-				//! result of infinitesimal rotation along these vectors
+					//! negative of dot product of torque with unit vectors gives
+					//! result of infinitesimal rotation along these vectors
 
-				dphidu = -ttm2i[1] * u[1] - ttm2i[2] * u[2] - ttm2i[3] * u[3];
-				dphidv = -ttm2i[1] * v[1] - ttm2i[2] * v[2] - ttm2i[3] * v[3];
-				dphidw = -ttm2i[1] * w[1] - ttm2i[2] * w[2] - ttm2i[3] * w[3];
+					dphidu = -ttm2i[1] * u[1] - ttm2i[2] * u[2] - ttm2i[3] * u[3];
+					dphidv = -ttm2i[1] * v[1] - ttm2i[2] * v[2] - ttm2i[3] * v[3];
+					dphidw = -ttm2i[1] * w[1] - ttm2i[2] * w[2] - ttm2i[3] * w[3];
 
-				if (axistype[i] == 4) {
-					dphidr = ttm2i[1] * r[1] - ttm2i[2] * r[2] - ttm2i[3] * r[3];
-					dphids = ttm2i[1] * s[1] - ttm2i[2] * s[2] - ttm2i[3] * s[3];
+					if (axistype[i] == 4) {
+						dphidr = ttm2i[1] * r[1] - ttm2i[2] * r[2] - ttm2i[3] * r[3];
+						dphids = ttm2i[1] * s[1] - ttm2i[2] * s[2] - ttm2i[3] * s[3];
 
-				}
+					}
 
-				//! force distribution for the z-only local coordinate frame	
-				if (axistype[i] == 1) {
-					for (j = 1; j <= 3; j++) {
-						du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
-						dep[j][ia] = dep[j][ia] + du;
-						dep[j][ib] = dep[j][ib] - du;
-						frcz[j] = frcz[j] + du;
+					//! force distribution for the z-only local coordinate frame	
+					if (axistype[i] == 1) {
+						for (j = 1; j <= 3; j++) {
+							du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
+							local_dep[j][ia] = local_dep[j][ia] + du;
+							local_dep[j][ib] = local_dep[j][ib] - du;
+							frcz[j] = frcz[j] + du;
+						}
+						//! force distribution for the z-thenx local coordinate method    
 					}
-					//! force distribution for the z-thenx local coordinate method    
-				}
-				else if (axistype[i] == 2) {
-					for (j = 1; j <= 3; j++) {
-						du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
-						dv = -uv[j] * dphidu / (vsiz * uvsin);
+					else if (axistype[i] == 2) {
+						for (j = 1; j <= 3; j++) {
+							du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
+							dv = -uv[j] * dphidu / (vsiz * uvsin);
 
-						dep[j][ia] = dep[j][ia] + du;
-						dep[j][ic] = dep[j][ic] + dv;
-						dep[j][ib] = dep[j][ib] - du - dv;
-						// 	cout<<dep[j][ic] << endl;
-						frcz[j] = frcz[j] + du;
-						frcx[j] = frcx[j] + dv;
+							local_dep[j][ia] = local_dep[j][ia] + du;
+							local_dep[j][ic] = local_dep[j][ic] + dv;
+							local_dep[j][ib] = local_dep[j][ib] - du - dv;
+							// 	cout<<local_dep[j][ic] << endl;
+							frcz[j] = frcz[j] + du;
+							frcx[j] = frcx[j] + dv;
 
 
+						}
 					}
-				}
-				else if (axistype[i] == 3) {
-					for (j = 1; j <= 3; j++) {
-						du = uv[j] * dphidv / (usiz * uvsin) + 0.5 * uw[j] * dphidw / usiz;
-						dv = -uv[j] * dphidu / (vsiz * uvsin) + 0.5 * vw[j] * dphidw / vsiz;
+					else if (axistype[i] == 3) {
+						for (j = 1; j <= 3; j++) {
+							du = uv[j] * dphidv / (usiz * uvsin) + 0.5 * uw[j] * dphidw / usiz;
+							dv = -uv[j] * dphidu / (vsiz * uvsin) + 0.5 * vw[j] * dphidw / vsiz;
 
-						dep[j][ia] = dep[j][ia] + du;
-						dep[j][ic] = dep[j][ic] + dv;
-						dep[j][ib] = dep[j][ib] - du - dv;
+							local_dep[j][ia] = local_dep[j][ia] + du;
+							local_dep[j][ic] = local_dep[j][ic] + dv;
+							local_dep[j][ib] = local_dep[j][ib] - du - dv;
 
-						frcz[j] = frcz[j] + du;
-						frcx[j] = frcx[j] + dv;
+							frcz[j] = frcz[j] + du;
+							frcx[j] = frcx[j] + dv;
 
 
+						}
 					}
-				}
-				else if (axistype[i] == 4) {
-					for (j = 1; j <= 3; j++) {
-						du = ur[j] * dphidr / (usiz * ursin) + us[j] * dphids / usiz;
-						dv = (vssin * s[j] - vscos * t1[j]) * dphidu / (vsiz * (ut1sin + ut2sin));
-						dw = (wssin * s[j] - wscos * t2[j]) * dphidu / (wsiz * (ut1sin + ut2sin));
-						dep[j][ia] = dep[j][ia] + du;
-						dep[j][ic] = dep[j][ic] + dv;
-						dep[j][id] = dep[j][id] + dw;
-						dep[j][ib] = dep[j][ib] - du - dv - dw;
-						frcz[j] = frcz[j] + du;
-						frcx[j] = frcx[j] + dv;
-						frcy[j] = frcy[j] + dw;
+					else if (axistype[i] == 4) {
+						for (j = 1; j <= 3; j++) {
+							du = ur[j] * dphidr / (usiz * ursin) + us[j] * dphids / usiz;
+							dv = (vssin * s[j] - vscos * t1[j]) * dphidu / (vsiz * (ut1sin + ut2sin));
+							dw = (wssin * s[j] - wscos * t2[j]) * dphidu / (wsiz * (ut1sin + ut2sin));
+							local_dep[j][ia] = local_dep[j][ia] + du;
+							local_dep[j][ic] = local_dep[j][ic] + dv;
+							local_dep[j][id] = local_dep[j][id] + dw;
+							local_dep[j][ib] = local_dep[j][ib] - du - dv - dw;
+							frcz[j] = frcz[j] + du;
+							frcx[j] = frcx[j] + dv;
+							frcy[j] = frcy[j] + dw;
+						}
 					}
-				}
-				else if (axistype[i] == 5) {
-					for (j = 1; j <= 3; j++) {
-						du = uw[j] * dphidw / (usiz * uwsin) + uv[j] * dphidv / (usiz * uvsin) - uw[j] * dphidu / (usiz * uwsin) - uv[j] * dphidu / (usiz * uvsin);
-						dv = vw[j] * dphidw / (vsiz * vwsin) - uv[j] * dphidu / (vsiz * uvsin) - vw[j] * dphidv / (vsiz * vwsin) + uv[j] * dphidv / (vsiz * uvsin);
-						dw = -uw[j] * dphidu / (wsiz * uwsin) - vw[j] * dphidv / (wsiz * vwsin) + uw[j] * dphidw / (wsiz * uwsin) + vw[j] * dphidw / (wsiz * vwsin);
-						du = du / 3.0;
-						dv = dv / 3.0;
-						dw = dw / 3.0;
-
-						dep[j][ia] = dep[j][ia] + du;
-						dep[j][ic] = dep[j][ic] + dv;
-						dep[j][id] = dep[j][id] + dw;
-						dep[j][ib] = dep[j][ib] - du - dv - dw;
-						frcz[j] = frcz[j] + du;
-						frcx[j] = frcx[j] + dv;
-						frcy[j] = frcy[j] + dw;
+					else if (axistype[i] == 5) {
+						for (j = 1; j <= 3; j++) {
+							du = uw[j] * dphidw / (usiz * uwsin) + uv[j] * dphidv / (usiz * uvsin) - uw[j] * dphidu / (usiz * uwsin) - uv[j] * dphidu / (usiz * uvsin);
+							dv = vw[j] * dphidw / (vsiz * vwsin) - uv[j] * dphidu / (vsiz * uvsin) - vw[j] * dphidv / (vsiz * vwsin) + uv[j] * dphidv / (vsiz * uvsin);
+							dw = -uw[j] * dphidu / (wsiz * uwsin) - vw[j] * dphidv / (wsiz * vwsin) + uw[j] * dphidw / (wsiz * uwsin) + vw[j] * dphidw / (wsiz * vwsin);
+							du = du / 3.0;
+							dv = dv / 3.0;
+							dw = dw / 3.0;
+
+							local_dep[j][ia] = local_dep[j][ia] + du;
+							local_dep[j][ic] = local_dep[j][ic] + dv;
+							local_dep[j][id] = local_dep[j][id] + dw;
+							local_dep[j][ib] = local_dep[j][ib] - du - dv - dw;
+							frcz[j] = frcz[j] + du;
+							frcx[j] = frcx[j] + dv;
+							frcy[j] = frcy[j] + dw;
+						}
 					}
 				}
 
 
 				//! increment gradients due to force and torque on the second sites
 
-				dem[1][kk] -= ftm2[1];
-				dem[2][kk] -= ftm2[2];
-				dem[3][kk] -= ftm2[3];
+				local_dem[1][kk] -= ftm2[1];
+				local_dem[2][kk] -= ftm2[2];
+				local_dem[3][kk] -= ftm2[3];
 
-				dep[1][kk] -= ftm2i[1];
-				dep[2][kk] -= ftm2i[2];
-				dep[3][kk] -= ftm2i[3];
+				local_dep[1][kk] -= ftm2i[1];
+				local_dep[2][kk] -= ftm2i[2];
+				local_dep[3][kk] -= ftm2i[3];
 
 
 
@@ -3443,8 +3433,8 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 				if (axistype[k] == 1) {
 					for (j = 1; j <= 3; j++) {
 						du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
-						dem[j][ia] = dem[j][ia] + du;
-						dem[j][ib] = dem[j][ib] - du;
+						local_dem[j][ia] = local_dem[j][ia] + du;
+						local_dem[j][ib] = local_dem[j][ib] - du;
 					}
 					//! force distribution for the z-thenx local coordinate method    
 				}
@@ -3452,9 +3442,9 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 					for (j = 1; j <= 3; j++) {
 						du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
 						dv = -uv[j] * dphidu / (vsiz * uvsin);
-						dem[j][ia] = dem[j][ia] + du;
-						dem[j][ic] = dem[j][ic] + dv;
-						dem[j][ib] = dem[j][ib] - du - dv;
+						local_dem[j][ia] = local_dem[j][ia] + du;
+						local_dem[j][ic] = local_dem[j][ic] + dv;
+						local_dem[j][ib] = local_dem[j][ib] - du - dv;
 						frczk[j] = frczk[j] + du;
 						frcxk[j] = frcxk[j] + dv;
 
@@ -3465,9 +3455,9 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 					for (j = 1; j <= 3; j++) {
 						du = uv[j] * dphidv / (usiz * uvsin) + 0.5 * uw[j] * dphidw / usiz;
 						dv = -uv[j] * dphidu / (vsiz * uvsin) + 0.5 * vw[j] * dphidw / vsiz;
-						dem[j][ia] = dem[j][ia] + du;
-						dem[j][ic] = dem[j][ic] + dv;
-						dem[j][ib] = dem[j][ib] - du - dv;
+						local_dem[j][ia] = local_dem[j][ia] + du;
+						local_dem[j][ic] = local_dem[j][ic] + dv;
+						local_dem[j][ib] = local_dem[j][ib] - du - dv;
 						frczk[j] = frczk[j] + du;
 						frcxk[j] = frcxk[j] + dv;
 
@@ -3479,10 +3469,10 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 						du = ur[j] * dphidr / (usiz * ursin) + us[j] * dphids / usiz;
 						dv = (vssin * s[j] - vscos * t1[j]) * dphidu / (vsiz * (ut1sin + ut2sin));
 						dw = (wssin * s[j] - wscos * t2[j]) * dphidu / (wsiz * (ut1sin + ut2sin));
-						dem[j][ia] = dem[j][ia] + du;
-						dem[j][ic] = dem[j][ic] + dv;
-						dem[j][id] = dem[j][id] + dw;
-						dem[j][ib] = dem[j][ib] - du - dv - dw;
+						local_dem[j][ia] = local_dem[j][ia] + du;
+						local_dem[j][ic] = local_dem[j][ic] + dv;
+						local_dem[j][id] = local_dem[j][id] + dw;
+						local_dem[j][ib] = local_dem[j][ib] - du - dv - dw;
 						frczk[j] = frczk[j] + du;
 						frcxk[j] = frcxk[j] + dv;
 						frcyk[j] = frcyk[j] + dw;
@@ -3497,10 +3487,10 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 						dv = dv / 3.0;
 						dw = dw / 3.0;
 
-						dem[j][ia] = dem[j][ia] + du;
-						dem[j][ic] = dem[j][ic] + dv;
-						dem[j][id] = dem[j][id] + dw;
-						dem[j][ib] = dem[j][ib] - du - dv - dw;
+						local_dem[j][ia] = local_dem[j][ia] + du;
+						local_dem[j][ic] = local_dem[j][ic] + dv;
+						local_dem[j][id] = local_dem[j][id] + dw;
+						local_dem[j][ib] = local_dem[j][ib] - du - dv - dw;
 						frczk[j] = frczk[j] + du;
 						frcxk[j] = frcxk[j] + dv;
 						frcyk[j] = frcyk[j] + dw;
@@ -3523,8 +3513,8 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 				if (axistype[k] == 1) {
 					for (j = 1; j <= 3; j++) {
 						du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
-						dep[j][ia] = dep[j][ia] + du;
-						dep[j][ib] = dep[j][ib] - du;
+						local_dep[j][ia] = local_dep[j][ia] + du;
+						local_dep[j][ib] = local_dep[j][ib] - du;
 					}
 					//! force distribution for the z-thenx local coordinate method    
 				}
@@ -3532,9 +3522,9 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 					for (j = 1; j <= 3; j++) {
 						du = uv[j] * dphidv / (usiz * uvsin) + uw[j] * dphidw / usiz;
 						dv = -uv[j] * dphidu / (vsiz * uvsin);
-						dep[j][ia] = dep[j][ia] + du;
-						dep[j][ic] = dep[j][ic] + dv;
-						dep[j][ib] = dep[j][ib] - du - dv;
+						local_dep[j][ia] = local_dep[j][ia] + du;
+						local_dep[j][ic] = local_dep[j][ic] + dv;
+						local_dep[j][ib] = local_dep[j][ib] - du - dv;
 						frczk[j] = frczk[j] + du;
 						frcxk[j] = frcxk[j] + dv;
 
@@ -3545,9 +3535,9 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 					for (j = 1; j <= 3; j++) {
 						du = uv[j] * dphidv / (usiz * uvsin) + 0.5 * uw[j] * dphidw / usiz;
 						dv = -uv[j] * dphidu / (vsiz * uvsin) + 0.5 * vw[j] * dphidw / vsiz;
-						dep[j][ia] = dep[j][ia] + du;
-						dep[j][ic] = dep[j][ic] + dv;
-						dep[j][ib] = dep[j][ib] - du - dv;
+						local_dep[j][ia] = local_dep[j][ia] + du;
+						local_dep[j][ic] = local_dep[j][ic] + dv;
+						local_dep[j][ib] = local_dep[j][ib] - du - dv;
 						frczk[j] = frczk[j] + du;
 						frcxk[j] = frcxk[j] + dv;
 
@@ -3559,10 +3549,10 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 						du = ur[j] * dphidr / (usiz * ursin) + us[j] * dphids / usiz;
 						dv = (vssin * s[j] - vscos * t1[j]) * dphidu / (vsiz * (ut1sin + ut2sin));
 						dw = (wssin * s[j] - wscos * t2[j]) * dphidu / (wsiz * (ut1sin + ut2sin));
-						dep[j][ia] = dep[j][ia] + du;
-						dep[j][ic] = dep[j][ic] + dv;
-						dep[j][id] = dep[j][id] + dw;
-						dep[j][ib] = dep[j][ib] - du - dv - dw;
+						local_dep[j][ia] = local_dep[j][ia] + du;
+						local_dep[j][ic] = local_dep[j][ic] + dv;
+						local_dep[j][id] = local_dep[j][id] + dw;
+						local_dep[j][ib] = local_dep[j][ib] - du - dv - dw;
 						frczk[j] = frczk[j] + du;
 						frcxk[j] = frcxk[j] + dv;
 						frcyk[j] = frcyk[j] + dw;
@@ -3577,10 +3567,10 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 						dv = dv / 3.0;
 						dw = dw / 3.0;
 
-						dep[j][ia] = dep[j][ia] + du;
-						dep[j][ic] = dep[j][ic] + dv;
-						dep[j][id] = dep[j][id] + dw;
-						dep[j][ib] = dep[j][ib] - du - dv - dw;
+						local_dep[j][ia] = local_dep[j][ia] + du;
+						local_dep[j][ic] = local_dep[j][ic] + dv;
+						local_dep[j][id] = local_dep[j][id] + dw;
+						local_dep[j][ib] = local_dep[j][ib] - du - dv - dw;
 						frczk[j] = frczk[j] + du;
 						frcxk[j] = frcxk[j] + dv;
 						frcyk[j] = frcyk[j] + dw;
@@ -3593,43 +3583,43 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 
 
 		for (j = 0; j < coords->atoms(ii - 1).bonds().size(); j++) {
-			pscale[coords->atoms(ii - 1).bonds()[j] + 1] = 1.0;
-			mscale[coords->atoms(ii - 1).bonds()[j] + 1] = 1.0;
+			local_pscale[coords->atoms(ii - 1).bonds()[j] + 1] = 1.0;
+			local_mscale[coords->atoms(ii - 1).bonds()[j] + 1] = 1.0;
 
 		}
 		for (j = 1; j <= n13[ii]; j++) {
-			pscale[i13[j][ii]] = 1.0;
-			mscale[i13[j][ii]] = 1.0;
+			local_pscale[i13[j][ii]] = 1.0;
+			local_mscale[i13[j][ii]] = 1.0;
 
 		}
 		for (j = 1; j <= n14[ii]; j++) {
-			pscale[i14[j][ii]] = 1.0;
-			mscale[i14[j][ii]] = 1.0;
+			local_pscale[i14[j][ii]] = 1.0;
+			local_mscale[i14[j][ii]] = 1.0;
 
 
 		}
 
 		for (j = 1; j <= n15[ii]; j++) {
-			pscale[i15[j][ii]] = 1.0;
-			mscale[i15[j][ii]] = 1.0;
+			local_pscale[i15[j][ii]] = 1.0;
+			local_mscale[i15[j][ii]] = 1.0;
 
 		}
 		for (j = 1; j <= np11[ii]; j++) {
-			dscale[ip11[j][ii]] = 1.0;
-			uscale[ip11[j][ii]] = 1.0;
+			local_dscale[ip11[j][ii]] = 1.0;
+			local_uscale[ip11[j][ii]] = 1.0;
 		}
 		for (j = 1; j <= np12[ii]; j++) {
-			dscale[ip12[j][ii]] = 1.0;
-			uscale[ip12[j][ii]] = 1.0;
+			local_dscale[ip12[j][ii]] = 1.0;
+			local_uscale[ip12[j][ii]] = 1.0;
 		}
 		for (j = 1; j <= np13[ii]; j++) {
-			dscale[ip13[j][ii]] = 1.0;
-			uscale[ip13[j][ii]] = 1.0;
+			local_dscale[ip13[j][ii]] = 1.0;
+			local_uscale[ip13[j][ii]] = 1.0;
 		}
 		for (j = 1; j <= np14[ii]; j++) {
 
-			dscale[ip14[j][ii]] = 1.0;
-			uscale[ip14[j][ii]] = 1.0;
+			local_dscale[ip14[j][ii]] = 1.0;
+			local_uscale[ip14[j][ii]] = 1.0;
 		}
 
 
@@ -3637,28 +3627,9 @@ void energy::interfaces::amoeba::amoeba_ff::e_perm(void)
 
 
 	}
-
-	for (size_t n = 1; n <= N; n++)
-	{
-		gv_multipole.x() = dem[1][n];
-		gv_multipole.y() = dem[2][n];
-		gv_multipole.z() = dem[3][n];
-		gv_polarization.x() = dep[1][n];
-		gv_polarization.y() = dep[2][n];
-		gv_polarization.z() = dep[3][n];
-
-		part_grad[MULTIPOLE][n - 1] = gv_multipole;
-		part_grad[POLARIZE][n - 1] = gv_polarization;
-
-
-	}
-
-
-
-
-
 }
 
+
 size_t energy::interfaces::amoeba::amoeba_ff::multipole_sites(void)
 {
 
@@ -4216,14 +4187,8 @@ void energy::interfaces::amoeba::amoeba_ff::refine_pair_lists(void)
 }
 void energy::interfaces::amoeba::amoeba_ff::rot_matrix(coords::Representation_3D const& pos)
 {
-	scon::c3<scon::c3<double>> am;
-	std::vector <std::vector<double> > m2, r2;
-	std::array<std::array<double, 3>, 3> am2;
-	size_t n(1U);
-
-
-
-
+	using tinker::parameter::multipole;
+	using site = tinker::refine::types::multipole;
 
 	rp.resize(14);
 
@@ -4231,181 +4196,181 @@ void energy::interfaces::amoeba::amoeba_ff::rot_matrix(coords::Representation_3D
 		rp[i].resize(alloc_glob + 1);
 	}
 
-	m2.resize(14);
-	for (size_t i = 0; i < m2.size(); i++) {
-		m2[i].resize(alloc_glob + 1);
-	}
-	r2.resize(14);
-	for (size_t i = 0; i < r2.size(); i++) {
-		r2[i].resize(alloc_glob + 1);
+	// Sites in the order of the multipole numbers n (starting from 1).
+	// The random direction of z-only frames is drawn here, in the same order as before,
+	// so the sites can be rotated independently of each other.
+	std::vector<site const*> sites;
+	std::vector<coords::Cartesian_Point> random_x;
+	for (auto const& axes : refined.multipole_vecs())
+	{
+		for (auto const& mult : axes)
+		{
+			sites.push_back(&mult);
+			random_x.push_back(mult.p_rot.axt == multipole::axtype::Z_AXIS ?
+				scon::randomized<coords::Cartesian_Point>() : coords::Cartesian_Point());
+		}
 	}
 
-	am2[0][0] = 1.0;
-	am2[1][0] = 0.0;
-	am2[2][0] = 0.0;
-	am2[0][2] = 0.0;
-	am2[1][2] = 0.0;
-	am2[2][2] = 1.0;
+	std::ptrdiff_t const n_sites(static_cast<std::ptrdiff_t>(sites.size()));
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static)
+#endif
+	for (std::ptrdiff_t s = 0; s < n_sites; s++)
+	{
+		site const& mult = *sites[s];
+		size_t const n(static_cast<size_t>(s) + 1U);
+		scon::c3<scon::c3<double>> am;
+		std::array<std::array<double, 3>, 3> am2;
+		std::array<std::array<double, 4>, 4> m2, r2;
 
-	using tinker::parameter::multipole;
+		//std::cout <<pos[mult.center].x() << "   " << pos[mult.center].y() << "   " <<pos[mult.center].z() << '\n';
+		//std::cout << mult.p_rot.axt << '\n';
 
-	for (auto axes : refined.multipole_vecs())
-	{
-		for (auto mult : axes)
+		switch (mult.p_rot.axt)
 		{
 
-			//std::cout <<pos[mult.center].x() << "   " << pos[mult.center].y() << "   " <<pos[mult.center].z() << '\n';
-			//std::cout << mult.p_rot.axt << '\n';
+		case multipole::axtype::NONE: // 0
+		{
+			am.x().x() = 1.0;
+			am.z().z() = 1.0;
+			break;
+		}
 
-			switch (mult.p_rot.axt)
-			{
+		case multipole::axtype::Z_AXIS: // 1
+		{
+			am.z() = normalized(pos[mult.axes.z()] - pos[mult.center]);
+			coords::Cartesian_Point d = random_x[s];
+			d -= am.z() * dot(d, am.z());
+			am.x() = normalized(d);
+			break;
+		}
 
-			case multipole::axtype::NONE: // 0
-			{
-				am.x().x() = 1.0;
-				am.z().z() = 1.0;
-				break;
-			}
+		case multipole::axtype::Z_THEN_X: // 2
+		{
+			am.z() = normalized(pos[mult.axes.z()] - pos[mult.center]);
+			coords::Cartesian_Point d(pos[mult.axes.x()] - pos[mult.center]);
+			d -= am.z() * dot(d, am.z());
+			am.x() = normalized(d);
+			break;
+		}
 
-			case multipole::axtype::Z_AXIS: // 1
-			{
-				am.z() = normalized(pos[mult.axes.z()] - pos[mult.center]);
-				coords::Cartesian_Point d = scon::randomized<coords::Cartesian_Point>();
-				d -= am.z() * dot(d, am.z());
-				am.x() = normalized(d);
-				break;
-			}
+		case multipole::axtype::BISECTOR: // 3
+		{
+			coords::Cartesian_Point const d1(normalized(pos[mult.axes.z()] - pos[mult.center]));
+			coords::Cartesian_Point const d2(normalized(pos[mult.axes.x()] - pos[mult.center]));
+			am.z() = normalized(d1 + d2);
+			am.x() = normalized(d2 - (am.z() * scon::dot(d2, am.z())));
+			break;
+		}
 
-			case multipole::axtype::Z_THEN_X: // 2
-			{
-				am.z() = normalized(pos[mult.axes.z()] - pos[mult.center]);
-				coords::Cartesian_Point d(pos[mult.axes.x()] - pos[mult.center]);
-				d -= am.z() * dot(d, am.z());
-				am.x() = normalized(d);
-				break;
-			}
+		case multipole::axtype::Z_BISECTOR: // 4
+		{
+			am.z() = normalized(pos[mult.axes.z()] - pos[mult.center]);
+			coords::Cartesian_Point const d1(normalized(pos[mult.axes.x()] - pos[mult.center]));
+			coords::Cartesian_Point const d2(normalized(pos[mult.axes.y()] - pos[mult.center]));
+			coords::Cartesian_Point d(normalized(d1 + d2));
+			d -= am.z() * dot(d, am.z());
+			am.x() = normalized(d);
+			break;
+		}
 
-			case multipole::axtype::BISECTOR: // 3
-			{
-				coords::Cartesian_Point const d1(normalized(pos[mult.axes.z()] - pos[mult.center]));
-				coords::Cartesian_Point const d2(normalized(pos[mult.axes.x()] - pos[mult.center]));
-				am.z() = normalized(d1 + d2);
-				am.x() = normalized(d2 - (am.z() * scon::dot(d2, am.z())));
-				break;
-			}
-
-			case multipole::axtype::Z_BISECTOR: // 4
-			{
-				am.z() = normalized(pos[mult.axes.z()] - pos[mult.center]);
-				coords::Cartesian_Point const d1(normalized(pos[mult.axes.x()] - pos[mult.center]));
-				coords::Cartesian_Point const d2(normalized(pos[mult.axes.y()] - pos[mult.center]));
-				coords::Cartesian_Point d(normalized(d1 + d2));
-				d -= am.z() * dot(d, am.z());
-				am.x() = normalized(d);
-				break;
-			}
-
-			case multipole::axtype::THREEFOLD: // 5
-			{
-				coords::Cartesian_Point const d1(normalized(pos[mult.axes.z()] - pos[mult.center]));
-				coords::Cartesian_Point const d2(normalized(pos[mult.axes.x()] - pos[mult.center]));
-				coords::Cartesian_Point const d3(normalized(pos[mult.axes.y()] - pos[mult.center]));
-				am.z() = normalized(d1 + d2 + d3);
-				am.x() = normalized(d2 - am.z() * scon::dot(d2, am.z()));
-				break;
+		case multipole::axtype::THREEFOLD: // 5
+		{
+			coords::Cartesian_Point const d1(normalized(pos[mult.axes.z()] - pos[mult.center]));
+			coords::Cartesian_Point const d2(normalized(pos[mult.axes.x()] - pos[mult.center]));
+			coords::Cartesian_Point const d3(normalized(pos[mult.axes.y()] - pos[mult.center]));
+			am.z() = normalized(d1 + d2 + d3);
+			am.x() = normalized(d2 - am.z() * scon::dot(d2, am.z()));
+			break;
 
-			}
+		}
 
-			}
+		}
 
-			am.y() = cross(am.z(), am.x());
+		am.y() = cross(am.z(), am.x());
 
-			am2[0][0] = am.x().x();
-			am2[0][1] = am.y().x();
-			am2[0][2] = am.z().x();
-			am2[1][0] = am.x().y();
-			am2[1][1] = am.y().y();
-			am2[1][2] = am.z().y();
-			am2[2][0] = am.x().z();
-			am2[2][1] = am.y().z();
-			am2[2][2] = am.z().z();
+		am2[0][0] = am.x().x();
+		am2[0][1] = am.y().x();
+		am2[0][2] = am.z().x();
+		am2[1][0] = am.x().y();
+		am2[1][1] = am.y().y();
+		am2[1][2] = am.z().y();
+		am2[2][0] = am.x().z();
+		am2[2][1] = am.y().z();
+		am2[2][2] = am.z().z();
 
 
 
-			//ROTATION of MONOPOLES
+		//ROTATION of MONOPOLES
 
 
-			rp[0][n] = m_charges[n];
+		rp[0][n] = m_charges[n];
 
 
 
-			//ROTATION of DIPOLES
+		//ROTATION of DIPOLES
 
 
-			for (size_t i = 1; i < 4; i++)
+		for (size_t i = 1; i < 4; i++)
+		{
+			rp[i][n] = 0.0;
+			for (size_t j = 0; j < 3; j++)
 			{
-				rp[i][n] = 0.0;
-				for (size_t j = 0; j < 3; j++)
-				{
-					rp[i][n] = rp[i][n] + dipole[n][j] * am2[i - 1][j];
+				rp[i][n] = rp[i][n] + dipole[n][j] * am2[i - 1][j];
 
-				}
 			}
+		}
 
 
 
 
 
-			//ROTATION OF QUADRUPOLES	
+		//ROTATION OF QUADRUPOLES	
 
 
-			size_t k = 0;
+		size_t k = 0;
 
-			for (size_t i = 1; i < 4; i++) {
-				for (size_t j = 1; j < 4; j++) {
-					m2[i][j] = quadro[n][k];
-					r2[i][j] = 0.0;
+		for (size_t i = 1; i < 4; i++) {
+			for (size_t j = 1; j < 4; j++) {
+				m2[i][j] = quadro[n][k];
+				r2[i][j] = 0.0;
 
-					k++;
+				k++;
 
 
 
-				}
 			}
+		}
 
 
 
-			for (size_t i = 1; i < 4; i++) {
-				for (size_t j = 1; j < 4; j++) {
+		for (size_t i = 1; i < 4; i++) {
+			for (size_t j = 1; j < 4; j++) {
 
-					if (j < i) {
-						r2[i][j] = r2[j][i];
+				if (j < i) {
+					r2[i][j] = r2[j][i];
 
-					}
-					else {
-						for (k = 1; k < 4; k++) {
+				}
+				else {
+					for (k = 1; k < 4; k++) {
 
-							for (size_t m = 1; m < 4; m++) {
+						for (size_t m = 1; m < 4; m++) {
 
-								r2[i][j] = r2[i][j] + (am2[i - 1][k - 1] * am2[j - 1][m - 1] * m2[k][m]);
-								//std::cout << am2[i - 1][k - 1] << '\n';
-							}
+							r2[i][j] = r2[i][j] + (am2[i - 1][k - 1] * am2[j - 1][m - 1] * m2[k][m]);
+							//std::cout << am2[i - 1][k - 1] << '\n';
 						}
 					}
 				}
 			}
-			k = 4;
-			for (size_t i = 1; i < 4; i++) {
-				for (size_t j = 1; j < 4; j++) {
-					rp[k][n] = r2[i][j];
-					k++;
-				}
+		}
+		k = 4;
+		for (size_t i = 1; i < 4; i++) {
+			for (size_t j = 1; j < 4; j++) {
+				rp[k][n] = r2[i][j];
+				k++;
 			}
-
-			//}
-			n++;
-
 		}
+
 	}
 
 
@@ -4555,792 +4520,6 @@ double energy::interfaces::amoeba::amoeba_ff::fff_f1(size_t n, double s, double
 	return fff;
 }
 
-void energy::interfaces::amoeba::amoeba_ff::parameters()
-{
-
-
-	char control;
-	nijx.clear();
-	zetax.clear();
-	char buffer[200];
-	std::ifstream nijf("spackman.prm", std::ios::in);
-
-
-	while (!nijf.eof())
-	{
-
-		nijf.getline(buffer, 200);
-		sscanf(buffer, "%c", &control);
-
-		k kbuffer;
-		hh hbuffer;
-		oo oobuffer;
-		nn nnbuffer;
-
-
-		std::string forcefield;
-
-
-
-
-
-
-
-		if (control == 'n') {
-			std::vector <ptrdiff_t> tempn(19);
-			sscanf(buffer, "%*s %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td",
-				&tempn[0], &tempn[1], &tempn[2], &tempn[3], &tempn[4], &tempn[5], &tempn[6], &tempn[7], &tempn[8], &tempn[9], &tempn[10], &tempn[11], &tempn[12], &tempn[13], &tempn[14], &tempn[15], &tempn[16], &tempn[17], &tempn[18]);
-			nijx.push_back(tempn);
-		}
-
-
-		else if (control == 'z') {
-			std::vector <float> tempx(19);
-
-			sscanf(buffer, "%*s %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f",
-				&tempx[0], &tempx[1], &tempx[2], &tempx[3], &tempx[4], &tempx[5], &tempx[6], &tempx[7], &tempx[8], &tempx[9], &tempx[10], &tempx[11], &tempx[12], &tempx[13], &tempx[14], &tempx[15], &tempx[16], &tempx[17], &tempx[18]);
-
-
-			zetax.push_back(tempx);
-
-		}
-
-		else if (control == 'c') {
-			std::vector <float> tempc(19);
-			sscanf(buffer, "%*s %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f",
-				&tempc[0], &tempc[1], &tempc[2], &tempc[3], &tempc[4], &tempc[5], &tempc[6], &tempc[7], &tempc[8], &tempc[9], &tempc[10], &tempc[11], &tempc[12], &tempc[13], &tempc[14], &tempc[15], &tempc[16], &tempc[17], &tempc[18]);
-			//if (!cf.eof())
-			cs.push_back(tempc);
-
-		}
-
-		else if (control == 'o') {
-			std::vector <ptrdiff_t> tempo(3);
-			sscanf(buffer, "%*s  %td  %td  %td ",
-				&tempo[0], &tempo[1], &tempo[2]);
-			occ.push_back(tempo);
-
-		}
-
-
-		else if (control == '6') {
-
-			sscanf(buffer, "%*s %lf ", &kbuffer.temp5);
-			kappan.push_back(kbuffer.temp5);
-
-		}
-		else if (control == '1') {
-
-			sscanf(buffer, "%*s %lf ", &hbuffer.temp6);
-			kappan.push_back(hbuffer.temp6);
-
-		}
-		else if (control == '5') {
-
-			sscanf(buffer, "%*s %lf ", &nnbuffer.temp7);
-			kappan.push_back(nnbuffer.temp7);
-		}
-		else if (control == '8') {
-
-			sscanf(buffer, "%*s %lf ", &oobuffer.temp8);
-			kappan.push_back(oobuffer.temp8);
-
-		}
-		else if (control == 'e') break;
-	}
-
-
-
-
-
-
-}
-void energy::interfaces::amoeba::amoeba_ff::Spackman_list_analytical1() {
-
-
-
-
-	//size_t i,j,i1,j1,j2,k,it,ia,n,kk;
-	//		  ptrdiff_t nbas=19;
-	//		  ptrdiff_t nat=10;
-	//		  ptrdiff_t nref=7;
-	//double bohr=0.52917720859;
-	//double pi=3.141592653589793238;
-	//double coulomb=332.063709;
-	//		  std::vector <std::vector<double> > coef;
-	//		  std::vector <std::vector<std::vector<double> > > pij;
-	//		  std::vector <double> sscat;
-	//		  double aLimes,bLimes,fak,smax;
-	//double sum1, sum2, tnm,del,ddel,sum,kap,f,argBessel0,e,q,qsum=0,esum=0;
-	//double zz,pp;
-	//		  //ptrdiff_t n_atom=24;
-	//		 // vector <double> kappa/*atomic(24)*/;
-	//std::vector <size_t>  atomic;		
-	//		  double distx=0, disty=0, distz=0, dist=0, dist_3=0;
-	//std::vector <double> kappa;
-	//size_t n_atom=2;
-
-	//const scon::c3<double> &positions = coords->xyz();
-
-
-
-
-	//double dextemp1;
-	//Coord::vect gradient;
-	//std::ofstream fout1("grad1.in");
-	//std::ofstream fout2("grad2.in");
-	//std::ofstream fout3("grad3.in");
-	//std::ofstream fout4("grad4.in");
-	//std::ofstream fout5("grad5.in");
-	//std::ofstream fout6("grad6.in");
-	/* size_t kappamax=2;  */
-	double dist;
-	int cut = 11002;
-	//double cut=(10.0*1000)+1001;  
-
-	exa11.resize(cut);
-	exa22.resize(cut);
-	exa33.resize(cut);
-	eveca1.resize(cut);
-	dex11.resize(cut);
-	dex22.resize(cut);
-	dex33.resize(cut);
-
-	exa44.resize(cut);
-	exa55.resize(cut);
-	exa66.resize(cut);
-	dex44.resize(cut);
-	dex55.resize(cut);
-	dex66.resize(cut);
-
-	exa77.resize(cut);
-	exa88.resize(cut);
-	exa99.resize(cut);
-	exa1010.resize(cut);
-	dex77.resize(cut);
-	dex88.resize(cut);
-	dex99.resize(cut);
-	dex1010.resize(cut);
-
-
-	std::ifstream in1("HH_GRAD.in", std::ios::in);
-	std::ifstream in2("CC_GRAD.in", std::ios::in);
-	std::ifstream in3("CH_GRAD.in", std::ios::in);
-	std::ifstream in4("HH_EN.in", std::ios::in);
-	std::ifstream in5("CC_EN.in", std::ios::in);
-	std::ifstream in6("CH_EN.in", std::ios::in);
-
-	std::ifstream in7("OH_GRAD.in", std::ios::in);
-	std::ifstream in8("OC_GRAD.in", std::ios::in);
-	std::ifstream in9("OO_GRAD.in", std::ios::in);
-	std::ifstream in10("OH_EN.in", std::ios::in);
-	std::ifstream in11("OC_EN.in", std::ios::in);
-	std::ifstream in12("OO_EN.in", std::ios::in);
-
-	std::ifstream in13("NH_GRAD.in", std::ios::in);
-	std::ifstream in14("NC_GRAD.in", std::ios::in);
-	std::ifstream in15("NN_GRAD.in", std::ios::in);
-	std::ifstream in16("NO_GRAD.in", std::ios::in);
-	std::ifstream in17("NH_EN.in", std::ios::in);
-	std::ifstream in18("NC_EN.in", std::ios::in);
-	std::ifstream in19("NN_EN.in", std::ios::in);
-	std::ifstream in20("NO_EN.in", std::ios::in);
-
-	char buffer[200];
-	double temp;
-
-	size_t i = 0;
-	while (!in1.eof())
-	{
-		in1.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		exa11[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in2.eof())
-	{
-		in2.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		exa22[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in3.eof())
-	{
-		in3.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		exa33[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in4.eof())
-	{
-		in4.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		dex11[i] = temp;
-
-		i++;
-	}
-	i = 0;
-	while (!in5.eof())
-	{
-		in5.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		dex22[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in6.eof())
-	{
-		in6.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		dex33[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in7.eof())
-	{
-		in7.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		exa44[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in8.eof())
-	{
-		in8.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		exa55[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in9.eof())
-	{
-		in9.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		exa66[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in10.eof())
-	{
-		in10.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		dex44[i] = temp;
-
-		i++;
-	}
-	i = 0;
-	while (!in11.eof())
-	{
-		in11.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		dex55[i] = temp;
-
-		i++;
-	}
-	i = 0;
-	while (!in12.eof())
-	{
-		in12.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		dex66[i] = temp;
-
-		i++;
-	}
-	i = 0;
-
-
-
-	while (!in13.eof())
-	{
-		in13.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		exa77[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in14.eof())
-	{
-		in14.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		exa88[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in15.eof())
-	{
-		in15.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		exa99[i] = temp;
-		i++;
-	}
-	i = 0;
-	while (!in16.eof())
-	{
-		in16.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		exa1010[i] = temp;
-		i++;
-	}
-	i = 0;
-
-
-	while (!in17.eof())
-	{
-		in17.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		dex77[i] = temp;
-
-		i++;
-	}
-	i = 0;
-	while (!in18.eof())
-	{
-		in18.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		dex88[i] = temp;
-
-		i++;
-	}
-	i = 0;
-	while (!in19.eof())
-	{
-		in19.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		dex99[i] = temp;
-
-		i++;
-	}
-	i = 0;
-	while (!in20.eof())
-	{
-		in20.getline(buffer, 200);
-		sscanf(buffer, "%lf", &temp);
-		dex1010[i] = temp;
-
-		i++;
-	}
-
-
-
-
-
-	for (i = 1; i <= 11002; i++) {
-		dist = i * 0.001;
-		eveca1[i - 1] = dist;
-
-	}
-
-	// 	//	!Initialisierung	
-
-	//
-	// //!Initialsisierung	
-	// atomic.clear();
-	// kappa.clear();
-	// pij.resize(20);
-	// for(i=0;i<pij.size();i++){
-	//   pij[i].resize(20);
-	//   for(j=0;j<pij[i].size();j++){
-	//     pij[i][j].resize(20);
-
-	//   }
-	// }
-
-
-
-
-	// coef.resize(400);
-	// for(i=0;i<coef.size();i++){
-	//   coef[i].resize(400);
-	// }
-	// fscat.resize(n_atom+1000);
-	// for(i=0;i<fscat.size();i++){
-	//   fscat[i].resize(n_atom+1000);
-	// }
-	// sscat.resize(730);
-	// kappa.resize(n_atom+1);
-	// energy_short =4.0;
-
-
-
-
-
-	// smax=10.0;
-	// aLimes=0.0;
-	// bLimes=smax*4*pi;
-
-
-
-
-
-	// //! calculate the coefficients for scattering vector
-
-
-
-	// for (i1=0;i1<nat;i1++){
-
-	//   if (i1 == 9) continue;
-	//   if((i1 > 3 ) && (i1 < 5)) continue;
-
-	//   for(j=0;j<nbas;j++){
-
-	//     if(nijx[i1][j] == 0) continue;
-	//     coef[i1][j]=(pow(2.0*zetax[i1][j]/bohr,(int)nijx[i1][j])*sqrt(2.0*zetax[i1][j]/bohr)/sqrt(double(fak_iter1(2*nijx[i1][j]))));
-
-	//   }
-	// } 
-
-	// //!atomic density matrix
-
-	// for (i1=0;i1<nat;i1++){
-	//   if (i1 == 9) continue;
-	//   if((i1 > 3) && (i1 < 5)) continue;
-	//   //!1s	
-	//   for(i=0;i<7;i++){
-	//     for(j=i;j<7;j++){
-	//       pij[i][j][i1]+=occ[i1][0]*cs[i1][i]*cs[i1][j];
-
-
-
-	//     }
-	//   }
-	//   //!2s				
-	//   for(i=7;i<14;i++){
-	//     for(j=i;j<14;j++){
-	//       pij[i][j][i1]+=occ[i1][1]*cs[i1][i]*cs[i1][j];
-
-
-	//     }
-	//   }	
-
-	//   for(i=14;i<19;i++){
-	//     for(j=i;j<19;j++){
-	//       pij[i][j][i1]+=occ[i1][2]*cs[i1][i]*cs[i1][j];
-	//     }
-	//   }
-	// }
-
-
-
-	// //!get integration points
-
-	// kp=1;
-	// sscat[kp]=0.50*(aLimes+bLimes);
-	// for (i=2;i<=7;i++){
-	//   it=(size_t)pow(3.0,double(i-2));
-	//   tnm=it;
-	//   del=(bLimes-aLimes)/(3.0*tnm);
-	//   ddel=del+del;
-	//   kp++;
-	//   sscat[kp]=aLimes+0.5*del;
-	//   for (j=1;j<=it;j++){
-	//     kp++;
-	//     sscat[kp]=sscat[kp-1]+ddel;
-	//     if (j == it) continue;
-	//     kp++;
-
-	//     sscat[kp]=sscat[kp-1]+del;
-	//   }
-	// }
-
-
-
-
-
-
-
-
-
-	//
-	// for( size_t nn=0;nn<=2;nn++){
-
-	//   /* n=0;*/  
-
-
-	//   for (size_t ii=1; ii<cut; ii++){  
-	//     kappa.clear();
-	//     atomic.clear();
-	//     dextemp1=0.0;
-	//     esum=0.0;
-	//     qsum=0.0;
-	//   //  !Definition of atomic parameters
-	//   //  !H-H
-	//     if (nn == 0 ){ for (i=1;i<2;i++){
-	//       atomic.push_back(1);
-	//       kappa.push_back(kappan[1]); 
-	//     }
-	//     for (i=1;i<2;i++){
-	//       		
-	//       atomic.push_back(7);
-	//       kappa.push_back(1.0);
-	//     }
-
-
-	//     }
-	//   //  !C-C
-	//     else if (nn == 1 ){ for (i=1;i<2;i++){
-	//       atomic.push_back(7);
-	//       kappa.push_back(1.0);
-	//     }
-	//     for (i=1;i<2;i++){
-	//       	
-	//       atomic.push_back(8);
-	//       kappa.push_back(1.0);
-	//     }
-
-
-
-	//     }
-
-
-
-
-	//   //  !c-H
-	//     else if (nn == 2 ){ for (i=1;i<2;i++){
-	//       atomic.push_back(7);
-	//       kappa.push_back(1.0); 
-	//     }
-	//     for (i=1;i<2;i++){
-	//   
-	//       atomic.push_back(6);
-	//       kappa.push_back(kappan[0]);
-	//     }
-
-
-	//     }	
-
-	//
-
-	// //   //// !definition of further interactions here
-
-	// //   //  else if (nn == 3 ){ for (i=1;i<2;i++){
-	// //   //  				   atomic.push_back(X);
-	// //   //  				   kappa.push_back(X); 
-	// //   //  				  }
-	// //   //  			for (i=1;i<2;i++){
-	// //   //  				  // cout<<"Hallo3"<<endl;
-	// //   //  		                 atomic.push_back(X);
-	// //   //  				 kappa.push_back(X);
-	// //   //  				}
-	// //   //// !......
-
-	//     for( ia=0; ia <2 ; ia++){
-	//       i1=atomic[ia];
-	//       kap=1.0;
-	//       //!Core
-	//       if( (i1 == 1) && (kappa[ia] != 0.0)) kap=kappa[ia]; 			
-	//       for (i=0;i<this->kp;i++){
-	//         sum1=0.0;
-	//         for(j1=0;j1<7;j1++){
-	//           for(j2=j1;j2<7;j2++){
-	//             zz=(zetax[i1-1][j1]+zetax[i1-1][j2])/bohr;
-
-	//             k=nijx[i1-1][j1]+nijx[i1-1][j2];
-	//             /* kk++;*/		
-
-	//             pp=pij[j1][j2][i1-1];
-
-	//             if(j1 != j2) {pp=2.0*pp;}
-	//             sum1+= pp*coef[i1-1][j1]*coef[i1-1][j2]*(fff_f1(k,(this->sscat[i+1]/kap),zz)); //!function
-
-	//           }
-	//         }
-	//         fscat[ia][i]=sum1;
-
-	//       }
-
-	//       if (i1 == 1) continue;
-
-
-	//       kap=1.0;
-	//       if (kappa[ia] != 0.0) kap= kappa[ia];
-	//       //!Valence			   
-	//       for (i=0;i<this->kp;i++){
-	//         sum2=0.0;
-	//         for(j1=7;j1<nbas;j1++){
-	//           for(j2=j1;j2<nbas;j2++){
-	//             zz=(zetax[i1-1][j1]+zetax[i1-1][j2])/bohr;
-	//             k=nijx[i1-1][j1]+nijx[i1-1][j2];
-	//             pp=pij[j1][j2][i1-1];
-	//             if(j1 != j2) {pp=2.0*pp;}
-	//             sum2+= pp*coef[i1-1][j1]*coef[i1-1][j2]*(fff_f1(k,(this->sscat[i+1]/kap),zz)); //!function
-	//           }
-	//         }
-	//         fscat[ia][i]+=sum2;	
-
-	//       }
-
-	//     }
-
-
-
-	//     dist=(ii*0.001);
-	//     eveca1[ii]=((ii)*0.001);
-
-	//     n_atom=1;
-
-
-	//     for(size_t i=1; i<2;i++){
-	//       kk=2;
-
-	//       k=1;
-
-	//       // 		
-	//       f=fscat[i-1][k-1]*fscat[kk-1][k-1]-atomic[i-1]*fscat[kk-1][k-1]-atomic[kk-1]*fscat[i-1][k-1];
-
-	//	
-	//       argBessel0=sscat[k]*dist;
-
-	//      
-	//       f=f*((argBessel0*cos(argBessel0)-sin(argBessel0))/(sscat[k]*(dist*dist)));
-	//       e=(bLimes-aLimes)*f;
-
-	//       for(j=2; j <=nref; j++){
-	//         it=(size_t)pow(3.0,double(j-2));
-	//         // cout<<"Test2"<<endl;
-	//         tnm=it;
-
-	//         sum=0.0;
-
-	//         for(n=1;n<=it;n++){
-	//           k++;
-	//           f=fscat[i-1][k-1]*fscat[kk-1][k-1]-atomic[i-1]*fscat[kk-1][k-1]-atomic[kk-1]*fscat[i-1][k-1];
-	//           argBessel0=sscat[k]*dist;
-
-	//           f=f*((argBessel0*cos(argBessel0)-sin(argBessel0))/(sscat[k]*(dist*dist)));
-
-	//           sum=sum+f;
-
-	//           k++;
-	//           f=fscat[i-1][k-1]*fscat[kk-1][k-1]-atomic[i-1]*fscat[kk-1][k-1]-atomic[kk-1]*fscat[i-1][k-1];
-	//           argBessel0=sscat[k]*dist;
-	//           f=f*((argBessel0*cos(argBessel0)-sin(argBessel0))/(sscat[k]*(dist*dist)));
-
-	//           sum=sum+f;
-
-	//         }
-	//         e=(e+(bLimes-aLimes)*sum/tnm)/3.0;
-	//         //cout<<e<<endl;
-	//       }
-	//       q=-double(atomic[i-1]*atomic[kk-1])/(dist*dist);
-
-	//       esum=esum+e;
-
-	//       qsum=qsum+q;   
-	//       // cout<<esum<<endl;  
-
-
-
-	//       e=(qsum+((2.0*esum)/pi))*coulomb;
-
-
-
-
-
-
-	//       if ( nn == 0) {
-	//         exa11[ii]=e;
-	//         fout1<<std::setprecision(16)<<exa11[ii]<<std::endl;
-	//       }
-
-	//       else if ( nn == 1) {
-	//         exa22[ii]=e;
-	//	  fout2<<std::setprecision(16)<<exa22[ii]<<std::endl;
-	//       }
-	//       else if ( nn == 2 ) {
-	//         exa33[ii]=e;
-	//	  fout3<<std::setprecision(16)<<exa33[ii]<<std::endl;
-	//       }
-	//  }
-	//  
-	////  }
-	//  
-
-	//  n_atom=1;
-	//        dist=(ii*0.001);
-	//     eveca1[ii]=((ii)*0.001);
-
-	//	  for(size_t i=1; i<2;i++){
-	//       kk=2;
-
-	//       k=1;
-
-	//       // 		
-	//       f=fscat[i-1][k-1]*fscat[kk-1][k-1]-atomic[i-1]*fscat[kk-1][k-1]-atomic[kk-1]*fscat[i-1][k-1];
-
-	//	
-	//       argBessel0=sscat[k]*dist;
-
-	//      
-	//      f=f*sin(argBessel0)/argBessel0;
-	//       e=(bLimes-aLimes)*f;
-
-	//       for(j=2; j <=nref; j++){
-	//         it=(size_t)pow(3.0,double(j-2));
-	//         // cout<<"Test2"<<endl;
-	//         tnm=it;
-
-	//         sum=0.0;
-
-	//         for(n=1;n<=it;n++){
-	//           k++;
-	//           f=fscat[i-1][k-1]*fscat[kk-1][k-1]-atomic[i-1]*fscat[kk-1][k-1]-atomic[kk-1]*fscat[i-1][k-1];
-	//           argBessel0=sscat[k]*dist;
-
-	//           f=f*sin(argBessel0)/argBessel0;
-
-	//           sum=sum+f;
-
-	//           k++;
-	//           f=fscat[i-1][k-1]*fscat[kk-1][k-1]-atomic[i-1]*fscat[kk-1][k-1]-atomic[kk-1]*fscat[i-1][k-1];
-	//           argBessel0=sscat[k]*dist;
-	//            f=f*sin(argBessel0)/argBessel0;
-
-	//           sum=sum+f;
-
-	//         }
-	//         e=(e+(bLimes-aLimes)*sum/tnm)/3.0;
-	//         //cout<<e<<endl;
-	//       }
-	//       q=double(atomic[i-1]*atomic[kk-1])/dist;
-	//	
-	//       esum=esum+e;
-
-	//       qsum=qsum+q;   
-	//       // cout<<esum<<endl;  
-
-	//	  
-
-	//       e=(qsum+((2.0*esum)/pi))*coulomb;
-
-	//	  if ( nn == 0) {
-	//         dex11[ii]=e;
-	//        fout4<<std::setprecision(16)<<dex11[ii]<<std::endl;
-	//       }
-
-	//       else if ( nn == 1) {
-	//         dex22[ii]=e;
-	//       fout5<<std::setprecision(16)<<dex22[ii]<<std::endl;
-	//       }
-	//       else if ( nn == 2 ) {
-	//         dex33[ii]=e;
-	//	fout6<<std::setprecision(16)<<dex33[ii]<<std::endl;
-	//       }
-	//  
-	//	  }
-
-	//       }
-	//	
-	//	
-
-	//   }
-
-	SPACKrefine = true;
-}
-
-
 void energy::interfaces::amoeba::amoeba_ff::Spackman1() {
 
 
@@ -5415,8 +4594,8 @@ void energy::interfaces::amoeba::amoeba_ff::Spackman1() {
 
 		for (j = 0; j < nbas; j++) {
 
-			if (nijx[i1][j] == 0) continue;
-			coef[i1][j] = (pow(2.0 * zetax[i1][j] / bohr, (int)nijx[i1][j]) * sqrt(2.0 * zetax[i1][j] / bohr) / sqrt(double(fak_iter1(2 * nijx[i1][j]))));
+			if (spackman->nijx[i1][j] == 0) continue;
+			coef[i1][j] = (pow(2.0 * spackman->zetax[i1][j] / bohr, (int)spackman->nijx[i1][j]) * sqrt(2.0 * spackman->zetax[i1][j] / bohr) / sqrt(double(fak_iter1(2 * spackman->nijx[i1][j]))));
 
 		}
 	}
@@ -5428,7 +4607,7 @@ void energy::interfaces::amoeba::amoeba_ff::Spackman1() {
 		//!1s	
 		for (i = 0; i < 7; i++) {
 			for (j = i; j < 7; j++) {
-				pij[i][j][i1] += occ[i1][0] * cs[i1][i] * cs[i1][j];
+				pij[i][j][i1] += spackman->occ[i1][0] * spackman->cs[i1][i] * spackman->cs[i1][j];
 
 
 
@@ -5437,7 +4616,7 @@ void energy::interfaces::amoeba::amoeba_ff::Spackman1() {
 		//!2s				
 		for (i = 7; i < 14; i++) {
 			for (j = i; j < 14; j++) {
-				pij[i][j][i1] += occ[i1][1] * cs[i1][i] * cs[i1][j];
+				pij[i][j][i1] += spackman->occ[i1][1] * spackman->cs[i1][i] * spackman->cs[i1][j];
 
 
 			}
@@ -5445,7 +4624,7 @@ void energy::interfaces::amoeba::amoeba_ff::Spackman1() {
 
 		for (i = 14; i < 19; i++) {
 			for (j = i; j < 19; j++) {
-				pij[i][j][i1] += occ[i1][2] * cs[i1][i] * cs[i1][j];
+				pij[i][j][i1] += spackman->occ[i1][2] * spackman->cs[i1][i] * spackman->cs[i1][j];
 			}
 		}
 	}
@@ -5476,10 +4655,10 @@ void energy::interfaces::amoeba::amoeba_ff::Spackman1() {
 
 	for (i = 0; i < n_atom; i++) {
 		atomic.push_back(coords->atoms(i).number());
-		if (coords->atoms(i).symbol() == "h" || coords->atoms(i).symbol() == "H") kappa[i] = kappan[1];
-		else if (coords->atoms(i).symbol() == "c" || coords->atoms(i).symbol() == "C") kappa[i] = kappan[0];
-		else if (coords->atoms(i).symbol() == "n" || coords->atoms(i).symbol() == "N") kappa[i] = kappan[2];
-		else if (coords->atoms(i).symbol() == "o" || coords->atoms(i).symbol() == "O") kappa[i] = kappan[3];
+		if (coords->atoms(i).symbol() == "h" || coords->atoms(i).symbol() == "H") kappa[i] = spackman->kappan[1];
+		else if (coords->atoms(i).symbol() == "c" || coords->atoms(i).symbol() == "C") kappa[i] = spackman->kappan[0];
+		else if (coords->atoms(i).symbol() == "n" || coords->atoms(i).symbol() == "N") kappa[i] = spackman->kappan[2];
+		else if (coords->atoms(i).symbol() == "o" || coords->atoms(i).symbol() == "O") kappa[i] = spackman->kappan[3];
 	}
 
 	//!getting atomic charges
@@ -5516,9 +4695,9 @@ void energy::interfaces::amoeba::amoeba_ff::Spackman1() {
 			sum1 = 0.0;
 			for (j1 = 0; j1 < 7; j1++) {
 				for (j2 = j1; j2 < 7; j2++) {
-					zz = (zetax[i1 - 1][j1] + zetax[i1 - 1][j2]) / bohr;
+					zz = (spackman->zetax[i1 - 1][j1] + spackman->zetax[i1 - 1][j2]) / bohr;
 
-					k = nijx[i1 - 1][j1] + nijx[i1 - 1][j2];
+					k = spackman->nijx[i1 - 1][j1] + spackman->nijx[i1 - 1][j2];
 					/* kk++;*/
 
 					pp = pij[j1][j2][i1 - 1];
@@ -5543,8 +4722,8 @@ void energy::interfaces::amoeba::amoeba_ff::Spackman1() {
 			sum2 = 0.0;
 			for (j1 = 7; j1 < nbas; j1++) {
 				for (j2 = j1; j2 < nbas; j2++) {
-					zz = (zetax[i1 - 1][j1] + zetax[i1 - 1][j2]) / bohr;
-					k = nijx[i1 - 1][j1] + nijx[i1 - 1][j2];
+					zz = (spackman->zetax[i1 - 1][j1] + spackman->zetax[i1 - 1][j2]) / bohr;
+					k = spackman->nijx[i1 - 1][j1] + spackman->nijx[i1 - 1][j2];
 					//cout<<zz<<endl;
 					pp = pij[j1][j2][i1 - 1];
 					if (j1 != j2) { pp = 2.0 * pp; }
@@ -5769,25 +4948,25 @@ void energy::interfaces::amoeba::amoeba_ff::SpackmanGrad_3()
 	//!Poly_interp == polynominal spline
 	//!Linear_interp == linear spline	    
 	///CC-interaction
-	Linear_interp_sorted myfunc11(eveca1, exa22);
+	Linear_interp_sorted myfunc11(spackman->eveca1, spackman->exa22);
 	///HH-interaction
-	Linear_interp_sorted myfunc22(eveca1, exa11);
+	Linear_interp_sorted myfunc22(spackman->eveca1, spackman->exa11);
 	///CH-interaction
-	Linear_interp_sorted myfunc33(eveca1, exa33);
+	Linear_interp_sorted myfunc33(spackman->eveca1, spackman->exa33);
 	///OH-interaction
-	Linear_interp_sorted myfunc44(eveca1, exa44);
+	Linear_interp_sorted myfunc44(spackman->eveca1, spackman->exa44);
 	///OO-interaction
-	Linear_interp_sorted myfunc55(eveca1, exa55);
+	Linear_interp_sorted myfunc55(spackman->eveca1, spackman->exa55);
 	///OC-interaction
-	Linear_interp_sorted myfunc66(eveca1, exa66);
+	Linear_interp_sorted myfunc66(spackman->eveca1, spackman->exa66);
 	///NH-interaction
-	Linear_interp_sorted myfunc77(eveca1, exa77);
+	Linear_interp_sorted myfunc77(spackman->eveca1, spackman->exa77);
 	///NN-interaction
-	Linear_interp_sorted myfunc88(eveca1, exa88);
+	Linear_interp_sorted myfunc88(spackman->eveca1, spackman->exa88);
 	///NC-interaction
-	Linear_interp_sorted myfunc99(eveca1, exa99);
+	Linear_interp_sorted myfunc99(spackman->eveca1, spackman->exa99);
 	///NO-interaction
-	Linear_interp_sorted myfunc1010(eveca1, exa1010);
+	Linear_interp_sorted myfunc1010(spackman->eveca1, spackman->exa1010);
 	//
 	//
 	////!loop over monomer interactions 	    
@@ -5963,25 +5142,25 @@ double energy::interfaces::amoeba::amoeba_ff::Spackman_energy_analytical()
 	//!Poly_interp == polynominal spline
 	//!Linear_interp == linear spline
 	///CC-interaction
-	Linear_interp_sorted myfunc11(eveca1, dex22);
+	Linear_interp_sorted myfunc11(spackman->eveca1, spackman->dex22);
 	///HH-interaction
-	Linear_interp_sorted myfunc22(eveca1, dex11);
+	Linear_interp_sorted myfunc22(spackman->eveca1, spackman->dex11);
 	///CH-interaction
-	Linear_interp_sorted myfunc33(eveca1, dex33);
+	Linear_interp_sorted myfunc33(spackman->eveca1, spackman->dex33);
 	///OH-interaction
-	Linear_interp_sorted myfunc44(eveca1, dex44);
+	Linear_interp_sorted myfunc44(spackman->eveca1, spackman->dex44);
 	///OO-interaction
-	Linear_interp_sorted myfunc55(eveca1, dex55);
+	Linear_interp_sorted myfunc55(spackman->eveca1, spackman->dex55);
 	///OC-interaction
-	Linear_interp_sorted myfunc66(eveca1, dex66);
+	Linear_interp_sorted myfunc66(spackman->eveca1, spackman->dex66);
 	///NH-interaction
-	Linear_interp_sorted myfunc77(eveca1, dex77);
+	Linear_interp_sorted myfunc77(spackman->eveca1, spackman->dex77);
 	///NN-interaction
-	Linear_interp_sorted myfunc88(eveca1, dex88);
+	Linear_interp_sorted myfunc88(spackman->eveca1, spackman->dex88);
 	///NC-interaction
-	Linear_interp_sorted myfunc99(eveca1, dex99);
+	Linear_interp_sorted myfunc99(spackman->eveca1, spackman->dex99);
 	///NO-interaction
-	Linear_interp_sorted myfunc1010(eveca1, dex1010);
+	Linear_interp_sorted myfunc1010(spackman->eveca1, spackman->dex1010);
 	//
 	//
 	////!loop over monomer interactions 	    
@@ -0,0 +1,138 @@
+#include "energy_int_amoeba_spackman.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4996)
+#endif
+
+std::size_t const energy::interfaces::amoeba::spackman_tables::grid_points;
+std::size_t const energy::interfaces::amoeba::spackman_tables::required_points;
+std::size_t const energy::interfaces::amoeba::spackman_tables::elements;
+std::size_t const energy::interfaces::amoeba::spackman_tables::kappas;
+
+namespace
+{
+	/**one value per line, as many as there are grid points
+	(a line which cannot be read repeats the previous value)*/
+	std::vector<double> column(std::string const& file)
+	{
+		using energy::interfaces::amoeba::spackman_tables;
+		std::size_t const n = spackman_tables::grid_points;
+		std::vector<double> ret(n, 0.0);
+		std::ifstream in(file, std::ios::in);
+		if (!in) throw std::runtime_error("Cannot open the Spackman table '" + file + "'.");
+		std::string line;
+		double temp(0.0);
+		std::size_t values(0u);
+		for (std::size_t i = 0u; i < n && !in.eof(); ++i)
+		{
+			std::getline(in, line);
+			if (sscanf(line.c_str(), "%lf", &temp) == 1) ++values;
+			ret[i] = temp;
+		}
+		if (values < spackman_tables::required_points)
+		{
+			throw std::runtime_error("The Spackman table '" + file + "' has " + std::to_string(values) +
+				" values, " + std::to_string(spackman_tables::required_points) + " are needed.");
+		}
+		return ret;
+	}
+
+	/**throws if a block of spackman.prm has less than the needed rows*/
+	void check_rows(std::string const& file, char const block, std::size_t const rows, std::size_t const needed)
+	{
+		if (rows < needed)
+		{
+			throw std::runtime_error("The Spackman parameters '" + file + "' have " + std::to_string(rows) +
+				" rows '" + block + "', " + std::to_string(needed) + " are needed.");
+		}
+	}
+}
+
+energy::interfaces::amoeba::spackman_tables energy::interfaces::amoeba::spackman_tables::from_files(std::string const& directory)
+{
+	spackman_tables t;
+
+	std::string const prm(directory + "spackman.prm");
+	std::ifstream nijf(prm, std::ios::in);
+	if (!nijf) throw std::runtime_error("Cannot open the Spackman parameters '" + prm + "'.");
+	std::string buffer;
+	while (std::getline(nijf, buffer))
+	{
+		char control('\0');
+		sscanf(buffer.c_str(), "%c", &control);
+		if (control == 'n') {
+			std::vector <ptrdiff_t> tempn(19);
+			sscanf(buffer.c_str(), "%*s %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td  %td",
+				&tempn[0], &tempn[1], &tempn[2], &tempn[3], &tempn[4], &tempn[5], &tempn[6], &tempn[7], &tempn[8], &tempn[9], &tempn[10], &tempn[11], &tempn[12], &tempn[13], &tempn[14], &tempn[15], &tempn[16], &tempn[17], &tempn[18]);
+			t.nijx.push_back(tempn);
+		}
+		else if (control == 'z' || control == 'c') {
+			std::vector <float> tempx(19);
+			sscanf(buffer.c_str(), "%*s %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f",
+				&tempx[0], &tempx[1], &tempx[2], &tempx[3], &tempx[4], &tempx[5], &tempx[6], &tempx[7], &tempx[8], &tempx[9], &tempx[10], &tempx[11], &tempx[12], &tempx[13], &tempx[14], &tempx[15], &tempx[16], &tempx[17], &tempx[18]);
+			(control == 'z' ? t.zetax : t.cs).push_back(tempx);
+		}
+		else if (control == 'o') {
+			std::vector <ptrdiff_t> tempo(3);
+			sscanf(buffer.c_str(), "%*s  %td  %td  %td ", &tempo[0], &tempo[1], &tempo[2]);
+			t.occ.push_back(tempo);
+		}
+		// kappa of C (6), H (1), N (5) and O (8)
+		else if (control == '6' || control == '1' || control == '5' || control == '8') {
+			double kappa(0.0);
+			sscanf(buffer.c_str(), "%*s %lf ", &kappa);
+			t.kappan.push_back(kappa);
+		}
+		else if (control == 'e') break;
+	}
+	check_rows(prm, 'n', t.nijx.size(), elements);
+	check_rows(prm, 'z', t.zetax.size(), elements);
+	check_rows(prm, 'c', t.cs.size(), elements);
+	check_rows(prm, 'o', t.occ.size(), elements);
+	if (t.kappan.size() < kappas)
+	{
+		throw std::runtime_error("The Spackman parameters '" + prm + "' have " + std::to_string(t.kappan.size()) +
+			" kappas, " + std::to_string(kappas) + " (C, H, N and O) are needed.");
+	}
+
+	t.exa11 = column(directory + "HH_GRAD.in");
+	t.exa22 = column(directory + "CC_GRAD.in");
+	t.exa33 = column(directory + "CH_GRAD.in");
+	t.dex11 = column(directory + "HH_EN.in");
+	t.dex22 = column(directory + "CC_EN.in");
+	t.dex33 = column(directory + "CH_EN.in");
+
+	t.exa44 = column(directory + "OH_GRAD.in");
+	t.exa55 = column(directory + "OC_GRAD.in");
+	t.exa66 = column(directory + "OO_GRAD.in");
+	t.dex44 = column(directory + "OH_EN.in");
+	t.dex55 = column(directory + "OC_EN.in");
+	t.dex66 = column(directory + "OO_EN.in");
+
+	t.exa77 = column(directory + "NH_GRAD.in");
+	t.exa88 = column(directory + "NC_GRAD.in");
+	t.exa99 = column(directory + "NN_GRAD.in");
+	t.exa1010 = column(directory + "NO_GRAD.in");
+	t.dex77 = column(directory + "NH_EN.in");
+	t.dex88 = column(directory + "NC_EN.in");
+	t.dex99 = column(directory + "NN_EN.in");
+	t.dex1010 = column(directory + "NO_EN.in");
+
+	t.eveca1.resize(grid_points);
+	for (std::size_t i = 1; i <= grid_points; i++) {
+		t.eveca1[i - 1] = i * grid_step;
+	}
+	return t;
+}
+
+std::shared_ptr<energy::interfaces::amoeba::spackman_tables const> energy::interfaces::amoeba::spackman_tables::shared()
+{
+	// initialized by the first caller, the other threads wait for it
+	// (if reading throws, the next caller tries again)
+	static std::shared_ptr<spackman_tables const> const tables(std::make_shared<spackman_tables const>(from_files()));
+	return tables;
+}
@@ -0,0 +1,62 @@
+/**
+CAST 3
+energy_int_amoeba_spackman.h
+Purpose:
+Parameters and tabulated pair functions of the Spackman short-range correction of AMOEBA.
+The tables (spackman.prm and the *_GRAD.in / *_EN.in files of the working directory)
+are parsed once per process and shared read-only by all amoeba_ff instances,
+so clones for NEB images, MC walkers or MD do not read or copy them again.
+
+@version 1.0
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace energy
+{
+	namespace interfaces
+	{
+		namespace amoeba
+		{
+			struct spackman_tables
+			{
+				/**number of grid points of the tabulated pair functions*/
+				static std::size_t const grid_points = 11002u;
+				/**distance between the grid points (Angstrom)*/
+				static double constexpr grid_step = 0.001;
+				/**values every table file has to provide (up to 11 Angstrom),
+				the grid points behind them repeat the last value once and are zero after that*/
+				static std::size_t const required_points = 11000u;
+				/**rows of every block of spackman.prm (one per element up to neon) and kappas (C, H, N and O)*/
+				static std::size_t const elements = 10u, kappas = 4u;
+
+				/**grid of the tabulated pair functions*/
+				std::vector<double> eveca1;
+				/**energies (exa) and gradients (dex) of the element pairs:
+				11: H-H, 22: C-C, 33: C-H, 44: O-H, 55: O-C, 66: O-O, 77: N-H, 88: N-C, 99: N-N, 1010: N-O*/
+				std::vector<double> dex11, dex22, dex33, exa11, exa22, exa33;
+				std::vector<double> dex44, dex55, dex66, exa44, exa55, exa66;
+				std::vector<double> dex77, dex88, dex99, dex1010, exa77, exa88, exa99, exa1010;
+
+				/**basis exponents (z), coefficients (c), principal quantum numbers (n) and occupations (o) of spackman.prm*/
+				std::vector <std::vector <float> > zetax, cs;
+				std::vector <std::vector <ptrdiff_t> > nijx, occ;
+				/**kappa of C, H, N and O*/
+				std::vector <double> kappan;
+
+				/**reads the tables from the files in directory
+				@param directory: empty or ending with a path separator
+				@throw std::runtime_error if a file is missing or has too few entries*/
+				static spackman_tables from_files(std::string const& directory = std::string());
+
+				/**tables of the working directory, read on the first successful call*/
+				static std::shared_ptr<spackman_tables const> shared();
+			};
+		}
+	}
+}
@@ -1,4 +1,5 @@
 #include "energy_int_chemshell.h"
+#include "qm_worker.h"
 #include "helperfunctions.h"
 
 template<typename T, typename U>
@@ -550,7 +551,7 @@ void energy::interfaces::chemshell::sysCallInterface::actual_call()const {
 	auto failcount = 0;
 
 	for (; failcount <= 10; ++failcount) {
-		auto ret = scon::system_call(chemshell_stream.str());
+		auto ret = energy::qm_call(chemshell_stream.str());
 		if (ret == 0) {
 			break;
 		}
@@ -1,4 +1,5 @@
 #include "energy_int_dftb.h"
+#include "qm_worker.h"
 
 energy::interfaces::dftb::sysCallInterface::sysCallInterface(coords::Coordinates* cp) :
 	energy::interface_base(cp), energy(0.0)
@@ -377,14 +378,67 @@ double energy::interfaces::dftb::sysCallInterface::read_output(int t)
 Energy class functions that need to be overloaded
 */
 
+bool energy::interfaces::dftb::sysCallInterface::use_driver_geometry() const
+{
+	// the GEOMETRY message has no box, periodic calculations use the inputfile
+	return Config::get().energy.qm_worker.geometry && !Config::get().energy.qm_worker.driver.empty()
+		&& !Config::get().periodics.periodic;
+}
+
+double energy::interfaces::dftb::sysCallInterface::driver_call(bool const gradients)
+{
+	energy::qm_geometry geometry;
+	for (std::size_t i = 0u; i < coords->size(); ++i)
+	{
+		auto const& p = coords->xyz(i);
+		geometry.symbols.push_back(coords->atoms(i).symbol());
+		geometry.xyz.push_back({ { p.x(), p.y(), p.z() } });
+	}
+	for (auto const& q : Config::get().energy.qmmm.mm_charges)
+	{
+		geometry.point_charges.push_back({ { q.x, q.y, q.z, q.scaled_charge } });
+	}
+	geometry.charge = charge;
+	geometry.gradients = gradients;
+
+	energy::qm_result result;
+	if (energy::qm_evaluate(geometry, result) != 0)
+	{
+		std::cout << "DFTB+ driver failed. Treating structure as broken.\n";
+		integrity = false;
+		return 0.0;
+	}
+	energy = result.energy * energy::au2kcal_mol; // convert hartree to kcal/mol
+	if (gradients)
+	{
+		coords::Representation_3D g_tmp;
+		for (auto const& g : result.gradients)    // hartree/bohr -> kcal/(mol*A)
+		{
+			g_tmp.emplace_back(g[0] * energy::Hartree_Bohr2Kcal_MolAng, g[1] * energy::Hartree_Bohr2Kcal_MolAng, g[2] * energy::Hartree_Bohr2Kcal_MolAng);
+		}
+		coords->swap_g_xyz(g_tmp);
+		grad_ext_charges.clear();
+		for (auto const& g : result.charge_gradients)
+		{
+			grad_ext_charges.emplace_back(g[0] * energy::Hartree_Bohr2Kcal_MolAng, g[1] * energy::Hartree_Bohr2Kcal_MolAng, g[2] * energy::Hartree_Bohr2Kcal_MolAng);
+		}
+	}
+	if (!result.partial_charges.empty()) partial_charges = result.partial_charges;
+	return energy;
+}
+
 // Energy function
 double energy::interfaces::dftb::sysCallInterface::e(void)
 {
 	integrity = coords->check_structure();
+	if (integrity == true && use_driver_geometry())
+	{
+		return driver_call(false);
+	}
 	if (integrity == true)
 	{
 		write_inputfile(0);
-		scon::system_call(Config::get().energy.dftb.path + " > output_dftb.txt");
+		energy::qm_call(Config::get().energy.dftb.path + " > output_dftb.txt");
 		energy = read_output(0);
 		return energy;
 	}
@@ -395,10 +449,14 @@ double energy::interfaces::dftb::sysCallInterface::e(void)
 double energy::interfaces::dftb::sysCallInterface::g(void)
 {
 	integrity = coords->check_structure();
+	if (integrity == true && use_driver_geometry())
+	{
+		return driver_call(true);
+	}
 	if (integrity == true)
 	{
 		write_inputfile(1);
-		scon::system_call(Config::get().energy.dftb.path + " > output_dftb.txt");
+		energy::qm_call(Config::get().energy.dftb.path + " > output_dftb.txt");
 		energy = read_output(1);
 		return energy;
 	}
@@ -412,7 +470,7 @@ double energy::interfaces::dftb::sysCallInterface::h(void)
 	if (integrity == true)
 	{
 		write_inputfile(2);
-		scon::system_call(Config::get().energy.dftb.path + " > output_dftb.txt");
+		energy::qm_call(Config::get().energy.dftb.path + " > output_dftb.txt");
 		energy = read_output(2);
 		return energy;
 	}
@@ -426,7 +484,7 @@ double energy::interfaces::dftb::sysCallInterface::o(void)
 	if (integrity == true)
 	{
 		write_inputfile(3);
-		scon::system_call(Config::get().energy.dftb.path + " > output_dftb.txt");
+		energy::qm_call(Config::get().energy.dftb.path + " > output_dftb.txt");
 		energy = read_output(3);
 		return energy;
 	}
@@ -107,6 +107,11 @@ namespace energy
 				/**reads dftb+ outputfile (results.tag)
 				@param t: type of calculation (0 = energy, 1 = gradient, 2 = hessian, 3 = optimize)*/
 				double read_output(int t);
+				/**are energies and gradients calculated by sending the structure to the QM driver?*/
+				bool use_driver_geometry() const;
+				/**sends the structure to the QM driver instead of writing an inputfile (see qm_worker.h)
+				@param gradients: are gradients needed?*/
+				double driver_call(bool const gradients);
 
 				/**total energy*/
 				double energy;
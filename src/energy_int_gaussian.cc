@@ -8,6 +8,7 @@
 #include <utility>
 #include "atomic.h"
 #include "energy_int_gaussian.h"
+#include "qm_worker.h"
 #include "configuration.h"
 #include "coords.h"
 #include "coords_io.h"
@@ -524,7 +525,7 @@ int energy::interfaces::gaussian::sysCallInterfaceGauss::callGaussian()
 {
 	std::string gaussian_call = "export GAUSS_SCRDIR=" + fs::current_path().string() + " && " + Config::get().energy.gaussian.path + " " + id + ".gjf";
 
-	const int ret = scon::system_call(gaussian_call);
+	const int ret = energy::qm_call(gaussian_call);
 	if (ret != 0)
 	{
 		++failcounter;
@@ -10,6 +10,7 @@
 
 #include "atomic.h"
 #include "energy_int_mopac.h"
+#include "qm_worker.h"
 #include "configuration.h"
 #include "coords.h"
 #include "coords_io.h"
@@ -603,7 +604,7 @@ int energy::interfaces::mopac::sysCallInterface::callMopac()
 {
 	auto mopac_call = Config::get().energy.mopac.path + " " + id + ".xyz";
 	mopac_call.append(" > output_mopac.txt 2>&1");
-	auto ret = scon::system_call(mopac_call);
+	auto ret = energy::qm_call(mopac_call);
 	if (ret != 0)
 	{
 		++failcounter;
@@ -1,4 +1,5 @@
 #include "energy_int_orca.h"
+#include "qm_worker.h"
 
 energy::interfaces::orca::sysCallInterface::sysCallInterface(coords::Coordinates* cp) :
 	energy::interface_base(cp), energy(0.0), nuc_rep(0.0), elec_en(0.0), one_elec(0.0), two_elec(0.0)
@@ -379,7 +380,7 @@ double energy::interfaces::orca::sysCallInterface::e(void)
 	if (integrity == true)
 	{
 		write_inputfile(0);
-		int res = scon::system_call(Config::get().energy.orca.path + " orca.inp > output_orca.txt");
+		int res = energy::qm_call(Config::get().energy.orca.path + " orca.inp > output_orca.txt");
 		if (res == 0) energy = read_output(0);
 		else
 		{
@@ -401,7 +402,7 @@ double energy::interfaces::orca::sysCallInterface::g(void)
 	if (integrity == true)
 	{
 		write_inputfile(1);
-		int res = scon::system_call(Config::get().energy.orca.path + " orca.inp > output_orca.txt");
+		int res = energy::qm_call(Config::get().energy.orca.path + " orca.inp > output_orca.txt");
 		if (res == 0) energy = read_output(1);
 		else
 		{
@@ -423,7 +424,7 @@ double energy::interfaces::orca::sysCallInterface::h(void)
 	if (integrity == true)
 	{
 		write_inputfile(2);
-		int res = scon::system_call(Config::get().energy.orca.path + " orca.inp > output_orca.txt");
+		int res = energy::qm_call(Config::get().energy.orca.path + " orca.inp > output_orca.txt");
 		if (res == 0) energy = read_output(2);
 		else
 		{
@@ -445,7 +446,7 @@ double energy::interfaces::orca::sysCallInterface::o(void)
 	if (integrity == true)
 	{
 		write_inputfile(3);
-		int res = scon::system_call(Config::get().energy.orca.path + " orca.inp > output_orca.txt");
+		int res = energy::qm_call(Config::get().energy.orca.path + " orca.inp > output_orca.txt");
 		if (res == 0) energy = read_output(3);
 		else
 		{
@@ -1,4 +1,5 @@
 #include "energy_int_psi4.h"
+#include "qm_worker.h"
 
 void energy::interfaces::psi4::sysCallInterface::swap(interface_base& other) {
 	auto casted = dynamic_cast<sysCallInterface*>(&other);
@@ -173,7 +174,7 @@ void energy::interfaces::psi4::sysCallInterface::make_call()const {
 
 	auto failcount = 0u;
 	for (; failcount < 3u; ++failcount) {
-		auto ret = scon::system_call(call_stream.str());
+		auto ret = energy::qm_call(call_stream.str());
 		if (ret == 0) {
 			break;
 		}
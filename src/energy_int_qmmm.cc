@@ -1,10 +1,81 @@
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <limits>
 
 #include "energy_int_qmmm.h"
 #include "Scon/scon_utility.h"
 
 ::tinker::parameter::parameters energy::interfaces::qmmm::QMMM::tp;
 
+namespace
+{
+	/**vdW interactions of one QM atom with n MM atoms (loop without branches that can be vectorized)
+	@param rx, ry, rz: distance vectors (MM - QM)
+	@param R0, epsilon: combined vdW parameters
+	@param divisor: 2 if the interaction is scaled down by 1/2, else 1
+	@param gs: gradient of every pair divided by the distance (is filled),
+	gradient on MM atom = r * gs, gradient on QM atom = -r * gs
+	@param c: cutoff distance
+	@param s: distance where switching function starts
+	@param cut: true if a cutoff is used
+	returns vdW energy*/
+	template<bool SIGMA>
+	double ww_vdw_pairs(std::size_t const n, double const* rx, double const* ry, double const* rz,
+		double const* R0, double const* epsilon, double const* divisor, double* gs, double const c, double const s, bool const cut)
+	{
+		double const c2 = c * c, s2 = s * s, cs3 = (c2 - s2) * (c2 - s2) * (c2 - s2);
+		double e(0.0);
+#pragma omp simd reduction(+: e)
+		for (std::size_t k = 0; k < n; ++k)
+		{
+			double const d2 = rx[k] * rx[k] + ry[k] * ry[k] + rz[k] * rz[k];
+			double const d = std::sqrt(d2);
+			double const x = R0[k] / d;
+			double const R_r = x * x * x * x * x * x;
+			// unscaled energy and its derivative
+			double const E = SIGMA ? 4 * R_r * epsilon[k] * (R_r - 1.0) : R_r * epsilon[k] * (R_r - 2.0);
+			double const dE = SIGMA ? (4 * epsilon[k] * R_r / d) * (6.0 - 12.0 * R_r) : (epsilon[k] * R_r / d) * 12 * (1.0 - R_r);
+			// switching function and its derivative (gradient of switching function between switchdist and cutoff)
+			double const scaling = !cut ? 1.0 : (d > c ? 0.0 : (d > s ? ((c2 - d2) * (c2 - d2) * (c2 + 2 * d2 - 3 * s2)) / cs3 : 1.0));
+			double const deriv_S = (cut && d > s && d <= c) ? (-12 * d * (c2 - d2) * (d2 - s2)) / cs3 : 0.0;
+			e += E * scaling / divisor[k];
+			gs[k] = (dE * scaling + E * deriv_S) / (d * divisor[k]);
+		}
+		return e;
+	}
+
+	/**coulomb interactions of one QM atom with n MM atoms for mechanical embedding (loop without branches that can be vectorized)
+	@param rx, ry, rz: distance vectors (MM - QM)
+	@param qq: product of charges and electric factor
+	@param divisor: factor by which the interaction is scaled down (1 if not scaled)
+	@param gs: gradient of every pair divided by the distance (is filled),
+	gradient on QM atom = r * gs, gradient on MM atom = -r * gs
+	@param c: cutoff distance
+	@param cut: true if a cutoff is used
+	returns coulomb energy*/
+	double ww_coulomb_pairs(std::size_t const n, double const* rx, double const* ry, double const* rz,
+		double const* qq, double const* divisor, double* gs, double const c, bool const cut)
+	{
+		double const c2 = c * c;
+		double e(0.0);
+#pragma omp simd reduction(+: e)
+		for (std::size_t k = 0; k < n; ++k)
+		{
+			double const d2 = rx[k] * rx[k] + ry[k] * ry[k] + rz[k] * rz[k];
+			double const d = std::sqrt(d2);
+			double const E = (qq[k] / d) / divisor[k];   // unscaled energy
+			double const scaling = !cut ? 1.0 : (d > c ? 0.0 : (1 - (d / c) * (d / c)) * (1 - (d / c) * (d / c)));
+			double const scaled_energy = E * scaling;
+			e += scaled_energy;
+			// additional gradient because charge changes with distance (minus because the vector r_ij is the other way round)
+			double const deriv_S = (cut && d < c) ? E * 4 * d * (d2 - c2) / (c2 * c2) : 0.0;
+			gs[k] = (scaled_energy / d - deriv_S) / d;
+		}
+		return e;
+	}
+}
+
 energy::interfaces::qmmm::QMMM::QMMM(coords::Coordinates* cp) :
 	interface_base(cp),
 	qm_indices(Config::get().energy.qmmm.qm_systems[0]),
@@ -15,7 +86,8 @@ energy::interfaces::qmmm::QMMM::QMMM(coords::Coordinates* cp) :
 	qmc(qmmm_helpers::make_small_coords(cp, qm_indices, new_indices_qm, Config::get().energy.qmmm.qminterface, "QM system: ", Config::get().energy.qmmm.qm_to_file, link_atoms)),
 	mmc(qmmm_helpers::make_small_coords(cp, mm_indices, new_indices_mm, Config::get().energy.qmmm.mminterface, "MM system: ")),
 	index_of_QM_center(qmmm_helpers::get_index_of_QM_center(Config::get().energy.qmmm.centers[0], qm_indices, coords)),
-	qm_energy(0.0), mm_energy(0.0), vdw_energy(0.0), bonded_energy(0.0), coulomb_energy(0.0)
+	qm_energy(0.0), mm_energy(0.0), vdw_energy(0.0), bonded_energy(0.0), coulomb_energy(0.0),
+	ww_sigma(false), ww_vdw_types(0u)
 {
 	if (!tp.valid())
 	{
@@ -49,6 +121,7 @@ energy::interfaces::qmmm::QMMM::QMMM(coords::Coordinates* cp) :
 	cparams = tp.contract(types);
 	torsionunit = cparams.torsionunit();
 	prepare_bonded_qmmm();
+	prepare_ww();
 }
 
 energy::interfaces::qmmm::QMMM::QMMM(QMMM const& rhs,
@@ -57,7 +130,9 @@ energy::interfaces::qmmm::QMMM::QMMM(QMMM const& rhs,
 	new_indices_qm(rhs.new_indices_qm), new_indices_mm(rhs.new_indices_mm), link_atoms(rhs.link_atoms),
 	qmc(rhs.qmc), mmc(rhs.mmc), qm_energy(rhs.qm_energy), mm_energy(rhs.mm_energy),
 	vdw_energy(rhs.vdw_energy), bonded_energy(rhs.bonded_energy), coulomb_energy(rhs.coulomb_energy),
-	c_gradient(rhs.c_gradient), vdw_gradient(rhs.vdw_gradient), bonded_gradient(rhs.bonded_gradient)
+	c_gradient(rhs.c_gradient), vdw_gradient(rhs.vdw_gradient), bonded_gradient(rhs.bonded_gradient),
+	ww_sigma(rhs.ww_sigma), ww_vdw_types(rhs.ww_vdw_types), ww_vdw_type(rhs.ww_vdw_type),
+	ww_R0(rhs.ww_R0), ww_epsilon(rhs.ww_epsilon), ww_exceptions(rhs.ww_exceptions)
 {
 	interface_base::operator=(rhs);
 }
@@ -73,7 +148,9 @@ energy::interfaces::qmmm::QMMM::QMMM(QMMM&& rhs, coords::Coordinates* cobj)
 	qm_energy(std::move(rhs.qm_energy)), mm_energy(std::move(rhs.mm_energy)), vdw_energy(std::move(rhs.vdw_energy)),
 	bonded_energy(std::move(rhs.bonded_energy)), coulomb_energy(std::move(rhs.coulomb_energy)),
 	c_gradient(std::move(rhs.c_gradient)),
-	vdw_gradient(std::move(rhs.vdw_gradient)), bonded_gradient(std::move(rhs.bonded_gradient))
+	vdw_gradient(std::move(rhs.vdw_gradient)), bonded_gradient(std::move(rhs.bonded_gradient)),
+	ww_sigma(rhs.ww_sigma), ww_vdw_types(rhs.ww_vdw_types), ww_vdw_type(std::move(rhs.ww_vdw_type)),
+	ww_R0(std::move(rhs.ww_R0)), ww_epsilon(std::move(rhs.ww_epsilon)), ww_exceptions(std::move(rhs.ww_exceptions))
 {
 	interface_base::operator=(rhs);
 }
@@ -521,6 +598,95 @@ int energy::interfaces::qmmm::QMMM::calc_vdw(unsigned qm, unsigned mm)
 	return 1;
 }
 
+void energy::interfaces::qmmm::QMMM::prepare_ww()
+{
+	// vdW parameters for every combination of atom types
+	ww_sigma = cparams.general().radiustype.value == ::tinker::parameter::radius_types::T::SIGMA;
+	auto const& vdw_params = cparams.vdws();
+	ww_vdw_types = vdw_params.size();
+	ww_R0.resize(ww_vdw_types * ww_vdw_types);
+	ww_epsilon.resize(ww_vdw_types * ww_vdw_types);
+	for (std::size_t p = 0u; p < ww_vdw_types; ++p)
+	{
+		for (std::size_t q = 0u; q < ww_vdw_types; ++q)
+		{
+			if (ww_sigma) ww_R0[p * ww_vdw_types + q] = sqrt(vdw_params[p].r * vdw_params[q].r);  // sigma
+			else ww_R0[p * ww_vdw_types + q] = vdw_params[p].r + vdw_params[q].r;                 // r_min
+			ww_epsilon[p * ww_vdw_types + q] = sqrt(vdw_params[p].e * vdw_params[q].e);
+		}
+	}
+	ww_vdw_type.resize(coords->size());
+	for (std::size_t i = 0u; i < coords->size(); ++i)
+	{
+		ww_vdw_type[i] = cparams.type(coords->atoms().atom(i).energy_type(), tinker::potential_keys::VDW) - 1u;
+	}
+
+	// only MM atoms that are part of a bond, angle or dihedral with a QM atom can have calc_vdw() != 1
+	ww_exceptions.assign(qm_indices.size(), std::vector<std::pair<std::size_t, int>>());
+	for (std::size_t a = 0u; a < qm_indices.size(); ++a)
+	{
+		auto const i = qm_indices[a];
+		std::vector<std::size_t> candidates;
+		for (auto const& b : qmmm_bonds)
+		{
+			if (b.b == i) candidates.push_back(b.a);
+		}
+		for (auto const& an : qmmm_angles)
+		{
+			if (an.a == i) candidates.push_back(an.b);
+			else if (an.b == i) candidates.push_back(an.a);
+		}
+		for (auto const& d : qmmm_dihedrals)
+		{
+			if (d.a == i) candidates.push_back(d.b);
+			else if (d.b == i) candidates.push_back(d.a);
+		}
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+		for (auto j : candidates)
+		{
+			if (!scon::sorted::exists(mm_indices, j)) continue;
+			int const calc_modus = calc_vdw(i, j);
+			if (Config::get().general.verbosity > 4)
+			{
+				std::cout << "VdW calc_modus between atoms " << i + 1 << " and " << j + 1 << " is " << calc_modus << ".\n";
+			}
+			if (calc_modus != 1) ww_exceptions[a].emplace_back(j, calc_modus);
+		}
+	}
+}
+
+std::vector<std::vector<std::pair<std::size_t, bool>>> energy::interfaces::qmmm::QMMM::ww_partners()
+{
+	double const c = Config::get().energy.cutoff;
+	bool const cut = c < std::numeric_limits<double>::max();
+	auto const near_qm = cut ? qmmm_helpers::find_mm_atoms_near_qm(coords->xyz(), qm_indices, mm_indices, c)
+		: std::vector<std::vector<std::size_t>>(qm_indices.size(), mm_indices);
+
+	std::vector<std::vector<std::pair<std::size_t, bool>>> result(qm_indices.size());
+	std::ptrdiff_t const Q(qm_indices.size());
+#pragma omp parallel for schedule(dynamic)
+	for (std::ptrdiff_t a = 0; a < Q; ++a)
+	{
+		auto const i = qm_indices[a];
+		auto const& exceptions = ww_exceptions[a];
+		for (auto j : near_qm[a])
+		{
+			if (cut)   // interactions beyond the cutoff are zero (energy and gradient)
+			{
+				auto r_ij = coords->xyz(j) - coords->xyz(i);
+				if (Config::get().periodics.periodic) boundary(r_ij);
+				if (len(r_ij) > c) continue;
+			}
+			int calc_modus = 1;
+			auto const e = std::lower_bound(exceptions.begin(), exceptions.end(), std::make_pair(j, 0));
+			if (e != exceptions.end() && e->first == j) calc_modus = e->second;
+			if (calc_modus != 0) result[a].emplace_back(j, calc_modus == 2);
+		}
+	}
+	return result;
+}
+
 /**calculates interaction between QM and MM part
 energy is only vdW interactions
 for MOPAC gradients are coulomb and vdW
@@ -555,139 +721,65 @@ void energy::interfaces::qmmm::QMMM::ww_calc(bool if_gradient)
 
 		// ########## calculate vdw interactions ##########################################
 
-		auto vdw_params = cparams.vdws();  // get vdw parameters
+		double const cutoff = Config::get().energy.cutoff;          // cutoff distance
+		double const switchdist = Config::get().energy.switchdist;  // distance where cutoff starts to kick in (only vdW)
+		bool const cut = cutoff < std::numeric_limits<double>::max();
+		bool const periodic = Config::get().periodics.periodic;
+		auto const partners = ww_partners();   // MM atoms that interact with every QM atom
+		std::ptrdiff_t const Q(qm_indices.size());
 
-		std::size_t i2 = 0u;
-		for (auto i : qm_indices)  // for every QM atom
+		coords::float_type e_vdw(0.0);
+		ww_accumulator.prepare(coords->size());
+#pragma omp parallel
 		{
-			auto z = qmc.atoms(i2).energy_type();  // get atom type
-			std::size_t i_vdw = cparams.type(z, tinker::potential_keys::VDW);  // get index to find this atom type in vdw parameters
-			auto vparams_i = vdw_params[i_vdw - 1];  // get vdw parameters for QM atom
-			std::size_t j2 = 0u;
-			for (auto j : mm_indices)  // for every MM atom
+			coords::Representation_3D& tmp_grad = ww_accumulator.local();
+			std::vector<double> rx, ry, rz, R0, epsilon, divisor, gs;   // pairs of the current QM atom
+#pragma omp for reduction (+: e_vdw) schedule(static)
+			for (std::ptrdiff_t a = 0; a < Q; ++a)  // for every QM atom
 			{
-				auto e_type = mmc.atoms(j2).energy_type();  // get atom type
-				std::size_t j_vdw = cparams.type(e_type, tinker::potential_keys::VDW); // get index to find this atom type in vdw parameters
-				auto vparams_j = vdw_params[j_vdw - 1];  // get vdw parameters for MM atom
-
-				auto r_ij = coords->xyz(j) - coords->xyz(i);            // distance between QM and MM atom
-				if (Config::get().periodics.periodic) boundary(r_ij);   // if periodic boundaries: take shortest distance
-				coords::float_type d = len(r_ij);
-
-				double scaling = 1.0;     // determine scaling factor, default: no scaling
-				if (Config::get().energy.cutoff < std::numeric_limits<double>::max())
-				{
-					double const& c = Config::get().energy.cutoff;       // cutoff distance
-					double const& s = Config::get().energy.switchdist;   // distance where cutoff starts to kick in (only vdW)
-
-					if (d > c) scaling = 0.0;
-					else if (d > s) scaling = ((c * c - d * d) * (c * c - d * d) * (c * c + 2 * d * d - 3 * s * s)) / ((c * c - s * s) * (c * c - s * s) * (c * c - s * s));
-				}
-
-				double R_0;  // r_min or sigma
-				if (cparams.general().radiustype.value ==
-					::tinker::parameter::radius_types::T::SIGMA)
-				{
-					R_0 = sqrt(vparams_i.r * vparams_j.r);  // sigma
-				}
-				else if (cparams.general().radiustype.value ==
-					::tinker::parameter::radius_types::T::R_MIN)
-				{
-					R_0 = vparams_i.r + vparams_j.r;  // r_min
-				}
-				else throw std::runtime_error("no valid radius_type");
-
-				double epsilon = sqrt(vparams_i.e * vparams_j.e);  // epsilon
-				auto R_r = std::pow(R_0 / d, 6);
-
-				int calc_modus = calc_vdw(i, j);  // will the vdw interaction be calculated? if yes, will it be scaled down?
-				if (Config::get().general.verbosity > 4)
-				{
-					std::cout << "VdW calc_modus between atoms " << i + 1 << " and " << j + 1 << " is " << calc_modus << ".\n";
-				}
-
-				double vdw;  // vdw energy for current atom pair
-				if (calc_modus != 0)  // calculate vdW interaction
+				auto const i = qm_indices[a];
+				std::size_t const n = partners[a].size();
+				rx.resize(n); ry.resize(n); rz.resize(n);
+				R0.resize(n); epsilon.resize(n); divisor.resize(n); gs.resize(n);
+				for (std::size_t k = 0u; k < n; ++k)
 				{
-					if (cparams.general().radiustype.value ==
-						::tinker::parameter::radius_types::T::SIGMA)
-					{
-						vdw = 4 * R_r * epsilon * (R_r - 1.0) * scaling;
-						if (calc_modus == 2) vdw = vdw / 2;
-					}
-					else if (cparams.general().radiustype.value ==
-						::tinker::parameter::radius_types::T::R_MIN)
-					{
-						vdw = R_r * epsilon * (R_r - 2.0) * scaling;
-						if (calc_modus == 2) vdw = vdw / 2;
-					}
-					else
-					{
-						throw std::runtime_error("no valid radius_type");
-					}
-					vdw_energy += vdw;
+					auto const j = partners[a][k].first;
+					auto r_ij = coords->xyz(j) - coords->xyz(i);   // distance between QM and MM atom
+					if (periodic) boundary(r_ij);                 // if periodic boundaries: take shortest distance
+					rx[k] = r_ij.x();
+					ry[k] = r_ij.y();
+					rz[k] = r_ij.z();
+					std::size_t const t = ww_vdw_type[i] * ww_vdw_types + ww_vdw_type[j];
+					R0[k] = ww_R0[t];
+					epsilon[k] = ww_epsilon[t];
+					divisor[k] = partners[a][k].second ? 2.0 : 1.0;   // vdW is scaled down by 1/2 if there are 3 bonds between the atoms
 				}
+				if (ww_sigma) e_vdw += ww_vdw_pairs<true>(n, rx.data(), ry.data(), rz.data(), R0.data(), epsilon.data(), divisor.data(), gs.data(), cutoff, switchdist, cut);
+				else e_vdw += ww_vdw_pairs<false>(n, rx.data(), ry.data(), rz.data(), R0.data(), epsilon.data(), divisor.data(), gs.data(), cutoff, switchdist, cut);
 
 				if (if_gradient)  // gradients
 				{
-					if (calc_modus != 0)  // gradients of vdW interaction
+					for (std::size_t k = 0u; k < n; ++k)
 					{
-						if (cparams.general().radiustype.value
-							== ::tinker::parameter::radius_types::T::SIGMA)
-						{
-							coords::float_type const V = 4 * epsilon * R_r;
-							auto vdw_r_grad_sigma = (V / d) * (6.0 - 12.0 * R_r);
-							auto vdw_gradient_ij_sigma = ((r_ij * vdw_r_grad_sigma) / d) * scaling;
-
-							if (d > Config::get().energy.switchdist && d <= Config::get().energy.cutoff)  // additional gradient as charge changes with distance
-							{
-								double const& c = Config::get().energy.cutoff;
-								double const& s = Config::get().energy.switchdist;
-
-								auto E_unscaled = 4 * R_r * epsilon * (R_r - 1.0);
-								auto deriv_S = (-12 * d * (c * c - d * d) * (d * d - s * s)) / ((c * c - s * s) * (c * c - s * s) * (c * c - s * s));
-								auto abs_grad = E_unscaled * deriv_S;
-
-								vdw_gradient_ij_sigma += (r_ij / d) * abs_grad;  // give additional gradient a direction
-							}
-
-							if (calc_modus == 2) vdw_gradient_ij_sigma = vdw_gradient_ij_sigma / 2;
-							vdw_gradient[i] -= vdw_gradient_ij_sigma;
-							vdw_gradient[j] += vdw_gradient_ij_sigma;
-						}
-						else
-						{
-							coords::float_type const V = epsilon * R_r;
-							auto vdw_r_grad_R_MIN = (V / d) * 12 * (1.0 - R_r);
-							auto vdw_gradient_ij_R_MIN = ((r_ij * vdw_r_grad_R_MIN) / d) * scaling;
-
-							if (d > Config::get().energy.switchdist && d <= Config::get().energy.cutoff)  // additional gradient as charge changes with distance
-							{
-								double const& c = Config::get().energy.cutoff;
-								double const& s = Config::get().energy.switchdist;
-
-								auto E_unscaled = R_r * epsilon * (R_r - 2.0);
-								auto deriv_S = (-12 * d * (c * c - d * d) * (d * d - s * s)) / ((c * c - s * s) * (c * c - s * s) * (c * c - s * s));
-								auto abs_grad = E_unscaled * deriv_S;
-
-								vdw_gradient_ij_R_MIN += (r_ij / d) * abs_grad;  // give additional gradient a direction
-							}
-
-							if (calc_modus == 2) vdw_gradient_ij_R_MIN = vdw_gradient_ij_R_MIN / 2;
-							vdw_gradient[i] -= vdw_gradient_ij_R_MIN;
-							vdw_gradient[j] += vdw_gradient_ij_R_MIN;
-						}
+						coords::Cartesian_Point const vdw_gradient_ij(rx[k] * gs[k], ry[k] * gs[k], rz[k] * gs[k]);
+						tmp_grad[i] -= vdw_gradient_ij;
+						tmp_grad[partners[a][k].first] += vdw_gradient_ij;
 					}
 				}
-				++j2;
 			}
-			++i2;
+			if (if_gradient) ww_accumulator.reduce(vdw_gradient);
 		}
+		vdw_energy = e_vdw;
 
 		// ########## calculate coulomb interactions ##########################################
 
 		if (if_gradient == true && Config::get().energy.qmmm.zerocharge_bonds != 0)  // electrostatic embedding -> coulomb gradients on MM atoms
 		{
+			std::vector<double> chargesQM;   // charges of QM atoms
+			if (Config::get().energy.qmmm.cutoff != std::numeric_limits<double>::max())
+			{
+				chargesQM = qmc.energyinterface()->charges();
+			}
 			for (auto i = 0u; i < charge_indices.size(); ++i)
 			{
 				int mma = charge_indices[i];
@@ -700,7 +792,6 @@ void energy::interfaces::qmmm::QMMM::ww_calc(bool if_gradient)
 					double const& c = Config::get().energy.qmmm.cutoff;
 					double const& ext_chg = Config::get().energy.qmmm.mm_charges[i].original_charge;
 					double const& scaling = Config::get().energy.qmmm.mm_charges[i].scaled_charge / Config::get().energy.qmmm.mm_charges[i].original_charge;
-					auto chargesQM = qmc.energyinterface()->charges();
 
 					double sum_of_QM_interactions{ 0.0 };   // calculate sum(Q_qm * Q_ext / r)
 					for (auto j{ 0u }; j < qm_indices.size(); ++j)
@@ -727,75 +818,67 @@ void energy::interfaces::qmmm::QMMM::ww_calc(bool if_gradient)
 		else if (Config::get().energy.qmmm.zerocharge_bonds == 0)  // mechanical embedding -> coulomb energy and gradients from MM interface
 		{
 			auto c_params = cparams.charges();     // get forcefield parameters (charge)
-			double current_coul_energy, current_coul_grad, qm_charge;  // some variables
+			std::vector<double> qm_charges(qm_indices.size());
 
 			auto i2{ 0u };
 			for (auto i : qm_indices)  // for every QM atom
 			{
 				if (Config::get().general.input == config::input_types::AMBER || Config::get().general.chargefile)  // amber charges
 				{
-					qm_charge = total_amber_charges[i] / 18.2223;
+					qm_charges[i2] = total_amber_charges[i] / 18.2223;
 				}
 				else   // normally (i.e. OPLSAA)
 				{
 					auto z = qmc.atoms(i2).energy_type();  // get atom type
 					std::size_t i_coul = cparams.type(z, tinker::potential_keys::CHARGE);  // get index to find this atom type in charge parameters
-					qm_charge = c_params[i_coul - 1].c;  // get charge parameter for QM atom
+					qm_charges[i2] = c_params[i_coul - 1].c;  // get charge parameter for QM atom
 				}
+				i2++;
+			}
 
-				auto j2{ 0u };
-				for (auto j : mm_indices)
-				{
-					double mm_charge = mm_charge_vector[j2];    // MM charges were filled before
-					int calc_modus = calc_vdw(i, j);            // calc modus for coulomb interactions is the same as for vdw
+			double scaled_divisor = 1.0;   // calc modus for coulomb interactions is the same as for vdw
+			if (Config::get().energy.qmmm.mminterface == config::interface_types::T::OPLSAA) scaled_divisor = 2.0;
+			else if (Config::get().energy.qmmm.mminterface == config::interface_types::T::AMBER) scaled_divisor = 1.2;
+			double const electric = cparams.general().electric;
 
-					current_coul_energy = 0.0;
-					current_coul_grad = 0.0;
-					if (calc_modus != 0)
+			coords::float_type e_coul(0.0);
+#pragma omp parallel
+			{
+				coords::Representation_3D& tmp_grad = ww_accumulator.local();
+				std::vector<double> rx, ry, rz, qq, divisor, gs;   // pairs of the current QM atom
+#pragma omp for reduction (+: e_coul) schedule(static)
+				for (std::ptrdiff_t a = 0; a < Q; ++a)  // for every QM atom
+				{
+					auto const i = qm_indices[a];
+					std::size_t const n = partners[a].size();
+					rx.resize(n); ry.resize(n); rz.resize(n);
+					qq.resize(n); divisor.resize(n); gs.resize(n);
+					for (std::size_t k = 0u; k < n; ++k)
 					{
-						auto r_ij = coords->xyz(j) - coords->xyz(i);            // distance between QM and MM atom
-						if (Config::get().periodics.periodic) boundary(r_ij);   // if periodic boundaries: take shortest distance
-						coords::float_type d = len(r_ij);
-
-						double scaling = 1.0;     // determine scaling factor, default: no scaling
-						if (Config::get().energy.cutoff < std::numeric_limits<double>::max())
-						{
-							double const& c = Config::get().energy.cutoff;       // cutoff distance
-
-							if (d > c) scaling = 0.0;
-							else scaling = (1 - (d / c) * (d / c)) * (1 - (d / c) * (d / c));
-						}
-
-						current_coul_energy = ((qm_charge * mm_charge * cparams.general().electric) / d);   // calculate energy (unscaled)
-						if (calc_modus == 2)
-						{
-							if (Config::get().energy.qmmm.mminterface == config::interface_types::T::OPLSAA) {
-								current_coul_energy = current_coul_energy / 2;
-							}
-							else if (Config::get().energy.qmmm.mminterface == config::interface_types::T::AMBER) {
-								current_coul_energy = current_coul_energy / 1.2;
-							}
-						}
-						auto scaled_energy = current_coul_energy * scaling;
-						coulomb_energy += scaled_energy;
+						auto const j = partners[a][k].first;
+						auto r_ij = coords->xyz(j) - coords->xyz(i);   // distance between QM and MM atom
+						if (periodic) boundary(r_ij);                 // if periodic boundaries: take shortest distance
+						rx[k] = r_ij.x();
+						ry[k] = r_ij.y();
+						rz[k] = r_ij.z();
+						qq[k] = qm_charges[a] * mm_charge_vector[new_indices_mm[j]] * electric;   // MM charges were filled before
+						divisor[k] = partners[a][k].second ? scaled_divisor : 1.0;
+					}
+					e_coul += ww_coulomb_pairs(n, rx.data(), ry.data(), rz.data(), qq.data(), divisor.data(), gs.data(), cutoff, cut);
 
-						if (if_gradient == true)   // calculate gradient
+					if (if_gradient == true)   // calculate gradient
+					{
+						for (std::size_t k = 0u; k < n; ++k)
 						{
-							current_coul_grad = scaled_energy / d;      // gradient without direction (scaling already included)
-							if (d < Config::get().energy.cutoff)        // additional gradient because charge changes with distance
-							{
-								double const& c = Config::get().energy.cutoff;
-								current_coul_grad -= current_coul_energy * 4 * d * (d * d - c * c) / (c * c * c * c);  // minus because the vector r_ij is the other way round
-							}
-							auto new_grad = (r_ij / d) * current_coul_grad;   // gradient gets a direction
-							c_gradient[i] += new_grad;
-							c_gradient[j] -= new_grad;
+							coords::Cartesian_Point const new_grad(rx[k] * gs[k], ry[k] * gs[k], rz[k] * gs[k]);
+							tmp_grad[i] += new_grad;
+							tmp_grad[partners[a][k].first] -= new_grad;
 						}
 					}
-					j2++;
 				}
-				i2++;
+				if (if_gradient) ww_accumulator.reduce(c_gradient);
 			}
+			coulomb_energy = e_coul;
 		}
 	}
 }
@@ -835,6 +918,12 @@ void energy::interfaces::qmmm::QMMM::swap(QMMM& rhs)
 	std::swap(mm_energy, rhs.mm_energy);
 	c_gradient.swap(rhs.c_gradient);
 	vdw_gradient.swap(rhs.vdw_gradient);
+	std::swap(ww_sigma, rhs.ww_sigma);
+	std::swap(ww_vdw_types, rhs.ww_vdw_types);
+	ww_vdw_type.swap(rhs.ww_vdw_type);
+	ww_R0.swap(rhs.ww_R0);
+	ww_epsilon.swap(rhs.ww_epsilon);
+	ww_exceptions.swap(rhs.ww_exceptions);
 }
 
 // update structure (account for topology or rep change)
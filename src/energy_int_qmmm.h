@@ -28,6 +28,7 @@ Attention: Problems occur if charged atoms are in MM part near QM part! This sit
 #include <vector>
 #include "coords_atoms.h"
 #include "energy_int_aco.h"
+#include "energy_int_aco_accumulator.h"
 #include "energy_int_mopac.h"
 #include "tinker_parameters.h"
 #include "helperfunctions.h"
@@ -363,6 +364,14 @@ namespace energy
 				and 2 if vdW is scaled down by 1/2 (3 bonds between the atoms)*/
 				int calc_vdw(unsigned qm, unsigned mm);
 
+				/**resolves the parameters of the non-bonded interactions between QM and MM atoms
+				(vdW parameters of all pairs of atom types and scaled or excluded QM/MM pairs),
+				has to be called after prepare_bonded_qmmm()*/
+				void prepare_ww();
+				/**finds the MM atoms that interact with every QM atom via vdW (and coulomb for mechanical embedding):
+				MM atoms further away than the cutoff and those with calc_vdw() == 0 are omitted*/
+				std::vector<std::vector<std::pair<std::size_t, bool>>> ww_partners();
+
 				/**calculates interaction between QM and MM part
 				energy is only vdW interactions, gradients are coulomb and vdW
 				@param if_gradient: true if gradients should be calculated, false if not*/
@@ -441,6 +450,19 @@ namespace energy
 
 				/**total amber charges in amber units, i.e. they must be divided by 18.2223 (only used for mechanical embedding)*/
 				std::vector<double> total_amber_charges;
+
+				/**true if vdW radii are sigma, false if they are r_min*/
+				bool ww_sigma;
+				/**number of vdW parameters*/
+				std::size_t ww_vdw_types;
+				/**vdW parameter index (starting with 0) of every atom*/
+				std::vector<std::size_t> ww_vdw_type;
+				/**combined vdW radius (r_min or sigma) and epsilon for every pair of vdW parameter indices*/
+				std::vector<double> ww_R0, ww_epsilon;
+				/**for every QM atom: MM atoms (sorted) with calc_vdw() != 1 and their calc_vdw() value*/
+				std::vector<std::vector<std::pair<std::size_t, int>>> ww_exceptions;
+				/**thread-local gradient buffers for the QM/MM pair loops*/
+				aco::nb_grad_accumulator ww_accumulator;
 			};
 		}
 	}
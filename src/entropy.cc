@@ -1,4 +1,5 @@
 #include "entropy.h"
+#include "coords_io_stream.h"
 
 float_type ardakaniCorrection1D(float_type const& globMin, float_type const& globMax, float_type const& currentPoint, float_type const& NNdistance)
 {
@@ -172,7 +173,7 @@ namespace entropy
 
 		// Initialize the reference frame (for alignment etc)
 		coords::Coordinates coords_ref(coords);
-		auto holder = (*ci).PES()[Config::get().entropy.entropy_ref_frame_num].structure.cartesian;
+		auto holder = ci->frame(Config::get().entropy.entropy_ref_frame_num);
 		coords_ref.set_xyz(holder);
 
 
@@ -207,20 +208,20 @@ namespace entropy
 		// the angular space to a linear space
 		if (Config::get().entropy.entropy_use_internal)
 		{
-			coordsMatrix = Matrix_Class((size_t) /* explicitly casting to round down */ ((ci->size() - Config::get().entropy.entropy_start_frame_num) / Config::get().entropy.entropy_offset), \
+			coordsMatrix = Matrix_Class((size_t) /* explicitly casting to round down */ ((ci->frames() - Config::get().entropy.entropy_start_frame_num) / Config::get().entropy.entropy_offset), \
 				Config::get().entropy.entropy_internal_dih.size() * 2u);
 		}
 		// If truncated cartesians are desired, this section will
 		// handle it.
 		else if (Config::get().entropy.entropy_trunc_atoms_bool)
 		{
-			coordsMatrix = Matrix_Class((size_t) /* explicitly casting to round down */ ((ci->size() - Config::get().entropy.entropy_start_frame_num) / Config::get().entropy.entropy_offset), \
+			coordsMatrix = Matrix_Class((size_t) /* explicitly casting to round down */ ((ci->frames() - Config::get().entropy.entropy_start_frame_num) / Config::get().entropy.entropy_offset), \
 				Config::get().entropy.entropy_trunc_atoms_num.size() * 3u);
 		}
 		// This section is used if *all* cartesians of all atoms are used
 		else
 		{
-			coordsMatrix = Matrix_Class((size_t) /* explicitly casting to round down */ ((ci->size() - Config::get().entropy.entropy_start_frame_num) / Config::get().entropy.entropy_offset), \
+			coordsMatrix = Matrix_Class((size_t) /* explicitly casting to round down */ ((ci->frames() - Config::get().entropy.entropy_start_frame_num) / Config::get().entropy.entropy_offset), \
 				coords.atoms().size() * 3u);
 		}
 
@@ -235,40 +236,41 @@ namespace entropy
 		// Now the coordsMatrix will be filled with the coordinates
 		// read in from ci
 		//
-		// j counts the (truncated) matrix access, i the frames in ci
+		// j counts the (truncated) matrix access, the frames in ci
+		// are read chunk by chunk
 		{
 			size_t j = 0;
-			// This section if internals are used
-			// Remember: 
-			// If internals are used a nonlinear transform is applied
-			// according to Knapp (DOI 10.1063/1.2746330) to transform
-			// the angular space to a linear space
-			if (Config::get().entropy.entropy_use_internal)
+			coords::input::frame_chunks chunks(*ci, Config::get().entropy.entropy_start_frame_num,
+				Config::get().entropy.entropy_offset, coordsMatrix.rows());
+			coords::input::frame_chunk chunk;
+			while (chunks.next(chunk))
 			{
-				for (size_t i = Config::get().entropy.entropy_start_frame_num; j < coordsMatrix.rows(); ++j, i += Config::get().entropy.entropy_offset)
+				for (size_t k = 0; k < chunk.size(); ++k, ++j)
 				{
-					auto holder2 = ci->PES()[i].structure.cartesian;
-					coords.set_xyz(holder2);
-					coordsMatrix.set_row(j,::matop::transformToOneline(coords, Config::get().entropy.entropy_internal_dih, true));
-				}
-			}
-			// This section if cartesian coordinates are used
-			// They will *later* be massweighted
-			else
-			{
-				for (size_t i = Config::get().entropy.entropy_start_frame_num; j < coordsMatrix.rows(); ++j, i += Config::get().entropy.entropy_offset)
-				{
-					auto holder2 = ci->PES()[i].structure.cartesian;
-					coords.set_xyz(holder2);
-					// Translational and rotational alignment
-					if (Config::get().entropy.entropy_alignment)
+					coords.set_xyz(chunk.xyz[k]);
+					// This section if internals are used
+					// Remember: 
+					// If internals are used a nonlinear transform is applied
+					// according to Knapp (DOI 10.1063/1.2746330) to transform
+					// the angular space to a linear space
+					if (Config::get().entropy.entropy_use_internal)
+					{
+						coordsMatrix.set_row(j, ::matop::transformToOneline(coords, Config::get().entropy.entropy_internal_dih, true));
+					}
+					// This section if cartesian coordinates are used
+					// They will *later* be massweighted
+					else
 					{
-						// Alignes center of mass
-						align::centerOfGeometryAlignment(coords);
-						// Rotational alignment
-						align::kabschAlignment(coords, coords_ref);
+						// Translational and rotational alignment
+						if (Config::get().entropy.entropy_alignment)
+						{
+							// Alignes center of mass
+							align::centerOfGeometryAlignment(coords);
+							// Rotational alignment
+							align::kabschAlignment(coords, coords_ref);
+						}
+						coordsMatrix.set_row(j, ::matop::transformToOneline(coords, Config::get().entropy.entropy_trunc_atoms_num, false));
 					}
-          coordsMatrix.set_row(j, ::matop::transformToOneline(coords, Config::get().entropy.entropy_trunc_atoms_num, false));
 				}
 			}
 		}
@@ -16,10 +16,13 @@ Hnizdo, Hnizdo marginal, Knapp
 
 #include <cstdlib>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <omp.h>
 #include <limits>
+#include <sstream>
 #include <string>
 #include <cmath>
 #include <tuple>
@@ -30,6 +33,7 @@ Hnizdo, Hnizdo marginal, Knapp
 #include "matop.h"
 #include "alignment.h"
 #include "kahan_summation.h"
+#include "entropy_knn.h"
 
 /////////////////
 // Some constants
@@ -434,7 +438,6 @@ public:
 		transpose(dimPurgedDrawMatrix);
 		//transpose(drawMatrix);
 
-		Matrix_Class copytemp = dimPurgedDrawMatrix;
 		Matrix_Class eucl_kNN_distances(1u, numberOfDraws, 0.);
 		Matrix_Class maxnorm_kNN_distances(1u, numberOfDraws, 0.);
 		Matrix_Class eucl_kNN_distances_ardakani_corrected(1u, numberOfDraws, 0.);
@@ -459,12 +462,27 @@ public:
 			}
 		}
 
+		// Spatial index over all draws, built once and queried for every draw
+		std::vector<size_t> allRows;
+		for (unsigned int currentDim = 0u; currentDim < dimensionality; currentDim++)
+		{
+			allRows.push_back(currentDim);
+		}
+		scon::chrono::high_resolution_timer treeTimer;
+		entropy::KNNTree const kNNTree(dimPurgedDrawMatrix, allRows);
+		if (Config::get().general.verbosity >= 4)
+		{
+			std::cout << "kNN tree built in " << treeTimer << " ." << std::endl;
+		}
+		scon::chrono::high_resolution_timer queryTimer;
+
+		// the draws are only read, every thread writes just its current point
 #ifdef _OPENMP
-#pragma omp parallel firstprivate(copytemp, ardakaniCorrection_minimumValueInDataset, ardakaniCorrection_maximumValueInDataset ) \
-    shared(eucl_kNN_distances,maxnorm_kNN_distances, eucl_kNN_distances_ardakani_corrected, maxnorm_kNN_distances_ardakani_corrected)
+#pragma omp parallel shared(dimPurgedDrawMatrix, ardakaniCorrection_minimumValueInDataset, ardakaniCorrection_maximumValueInDataset, \
+    eucl_kNN_distances,maxnorm_kNN_distances, eucl_kNN_distances_ardakani_corrected, maxnorm_kNN_distances_ardakani_corrected)
 		{
 #endif
-			float_type* buffer = new float_type[kNN];
+			std::vector<double> current(ardakaniCorrection ? dimensionality : 0u);
 #ifdef _OPENMP
 			auto const n_omp = static_cast<std::ptrdiff_t>(numberOfDraws);
 
@@ -474,22 +492,16 @@ public:
 			for (size_t i = 0u; i < numberOfDraws; i++)
 #endif
 			{
-				std::vector<size_t> rowQueryPts;
-				for (unsigned int currentDim = 0u; currentDim < dimensionality; currentDim++)
-				{
-					rowQueryPts.push_back(currentDim);
-				}
 
-				std::vector<double> current;
 				if (ardakaniCorrection)
 				{
 					for (unsigned int j = 0u; j < dimensionality; j++)
-						current.push_back(copytemp(j, i));
+						current[j] = dimPurgedDrawMatrix(j, i);
 				}
 
 				if (norm == kNN_NORM::EUCLEDEAN)
 				{
-					const float_type holdNNdistanceEucl = sqrt(entropy::knn_distance_eucl_squared(copytemp, dimensionality, kNN, rowQueryPts, i, buffer));
+					const float_type holdNNdistanceEucl = sqrt(kNNTree.knn_distance_eucl_squared(kNN, i));
 					eucl_kNN_distances(0, i) = holdNNdistanceEucl;
 
 					if (ardakaniCorrection)
@@ -500,7 +512,7 @@ public:
 				}
 				else // norm == kNN_NORM::MAX
 				{
-					const float_type holdNNdistanceMax = entropy::maximum_norm_knn_distance(copytemp, dimensionality, kNN, rowQueryPts, i, buffer);
+					const float_type holdNNdistanceMax = kNNTree.maximum_norm_knn_distance(kNN, i);
 					maxnorm_kNN_distances(0, i) = holdNNdistanceMax;
 
 					if (ardakaniCorrection)
@@ -511,10 +523,13 @@ public:
 				}
 
 			}
-			delete[] buffer;
 #ifdef _OPENMP
 		}
 #endif
+		if (Config::get().general.verbosity >= 4)
+		{
+			std::cout << "kNN queries took " << queryTimer << " ." << std::endl;
+		}
 		double returnValue = std::numeric_limits<double>::quiet_NaN();
 
 		// Eucledean ArdakaniSum
@@ -977,7 +992,7 @@ public:
 				rowPts.push_back(i);
 		}
 		//transpose(drawMatrix);
-		helperFKT(norm, func, ardakaniCorrection, order_N, buffer, rowPts);
+		mutualInformationTerms(norm, func, ardakaniCorrection, order_N, buffer, rowPts);
 		transpose(drawMatrix);
 		//Insert unique
 		for (auto&& element : buffer)
@@ -1073,7 +1088,6 @@ private:
 	{
 		//transpose(drawMatrix);
 
-		Matrix_Class copytemp = drawMatrix;
 		Matrix_Class eucl_kNN_distances(1u, numberOfDraws, 0.);
 		Matrix_Class maxnorm_kNN_distances(1u, numberOfDraws, 0.);
 		Matrix_Class eucl_kNN_distances_ardakani_corrected(1u, numberOfDraws, 0.);
@@ -1097,12 +1111,22 @@ private:
 			}
 		}
 
+		// Spatial index over the draws in the dimensions of rowIndices
+		scon::chrono::high_resolution_timer treeTimer;
+		entropy::KNNTree const kNNTree(drawMatrix, rowIndices);
+		if (Config::get().general.verbosity >= 4)
+		{
+			std::cout << "kNN tree for " << rowIndices.size() << " dimension(s) built in " << treeTimer << " ." << std::endl;
+		}
+		scon::chrono::high_resolution_timer queryTimer;
+
+		// the draws are only read, every thread writes just its current point
 #ifdef _OPENMP
-#pragma omp parallel firstprivate(copytemp, ardakaniCorrection_minimumValueInDataset, ardakaniCorrection_maximumValueInDataset ) \
-    shared(eucl_kNN_distances,maxnorm_kNN_distances, eucl_kNN_distances_ardakani_corrected, maxnorm_kNN_distances_ardakani_corrected)
+#pragma omp parallel shared(ardakaniCorrection_minimumValueInDataset, ardakaniCorrection_maximumValueInDataset, \
+    eucl_kNN_distances,maxnorm_kNN_distances, eucl_kNN_distances_ardakani_corrected, maxnorm_kNN_distances_ardakani_corrected)
 		{
 #endif
-			float_type* buffer = new float_type[kNN];
+			std::vector<double> current(ardakaniCorrection ? rowIndices.size() : 0u);
 #ifdef _OPENMP
 			auto const n_omp = static_cast<std::ptrdiff_t>(numberOfDraws);
 
@@ -1112,22 +1136,16 @@ private:
 			for (size_t i = 0u; i < numberOfDraws; i++)
 #endif
 			{
-				std::vector<size_t> rowQueryPts;
-				for (unsigned int currentDim = 0u; currentDim < rowIndices.size(); currentDim++)
-				{
-					rowQueryPts.push_back(rowIndices.at(currentDim));
-				}
 
-				std::vector<double> current;
 				if (ardakaniCorrection)
 				{
 					for (unsigned int currentDim = 0u; currentDim < rowIndices.size(); currentDim++)
-						current.push_back(copytemp(rowIndices.at(currentDim), i));
+						current[currentDim] = drawMatrix(rowIndices.at(currentDim), i);
 				}
 
 				if (norm == kNN_NORM::EUCLEDEAN)
 				{
-					const float_type holdNNdistanceEucl = sqrt(entropy::knn_distance_eucl_squared(copytemp, rowIndices.size(), kNN, rowQueryPts, i, buffer));
+					const float_type holdNNdistanceEucl = sqrt(kNNTree.knn_distance_eucl_squared(kNN, i));
 					eucl_kNN_distances(0, i) = holdNNdistanceEucl;
 
 					if (ardakaniCorrection)
@@ -1138,7 +1156,7 @@ private:
 				}
 				else if (norm == kNN_NORM::MAXIMUM)
 				{
-					const float_type holdNNdistanceMax = entropy::maximum_norm_knn_distance(copytemp, rowIndices.size(), kNN, rowQueryPts, i, buffer);
+					const float_type holdNNdistanceMax = kNNTree.maximum_norm_knn_distance(kNN, i);
 					maxnorm_kNN_distances(0, i) = holdNNdistanceMax;
 
 					if (ardakaniCorrection)
@@ -1155,10 +1173,13 @@ private:
 
 			}
 
-      delete[] buffer;
 #ifdef _OPENMP
 		}
 #endif
+		if (Config::get().general.verbosity >= 4)
+		{
+			std::cout << "kNN queries took " << queryTimer << " ." << std::endl;
+		}
 
 		//transpose(drawMatrix);
 
@@ -1305,86 +1326,143 @@ private:
 		}
 	}
 
-	// Called recursivly, calculates joint entropies for all possible permutations of the rowIndices up to the full dimensional one
-	// and stores those results in the "result" vecor
-	void jointEntropiesOfCertainRows(const kNN_NORM norm, const kNN_FUNCTION func, bool const& ardakaniCorrection, std::vector<calcBuffer>& result, std::vector<size_t> rowIndices,
-		std::vector<size_t> curRowIndices = std::vector<size_t>{}, const size_t curDim = 0u, size_t startIter = 0u)
+	// Enumerates all subsets of rowIndices with at most maxDim elements in depth-first order
+	// ({0}, {0,1}, {0,1,2}, ..., {0,2}, ..., {1}, ...) and stores them in the "result" vector
+	static void subsetsOfRows(std::vector<size_t> const& rowIndices, const size_t maxDim, std::vector<std::vector<size_t>>& result,
+		std::vector<size_t> curRowIndices = std::vector<size_t>{}, size_t startIter = 0u)
 	{
-		const size_t maxDim = rowIndices.size();
-		if (curDim < maxDim)
+		if (curRowIndices.size() >= maxDim)
+			return;
+		for (size_t i = startIter; i < rowIndices.size(); i++)
 		{
-			for (size_t i = startIter; i < maxDim; i++)
-			{
-				if (curDim == 0u)
-					curRowIndices = std::vector<size_t>{};
-
-				if (curRowIndices.size() == curDim + 1u)
-					curRowIndices.at(curDim) = rowIndices.at(i);
-				else
-					curRowIndices.push_back(rowIndices.at(i));
-
-				size_t nextIter = i + 1u;
-
-				calcBuffer cBuffer;
-				cBuffer.dim = curRowIndices.size();
-				cBuffer.rowIdent = curRowIndices;
-
-				cBuffer.entropyValue = calculateNNsubentropy(norm, func, ardakaniCorrection, curRowIndices);
+			curRowIndices.push_back(rowIndices.at(i));
+			result.push_back(curRowIndices);
+			subsetsOfRows(rowIndices, maxDim, result, curRowIndices, i + 1u);
+			curRowIndices.pop_back();
+		}
+	}
 
-				result.push_back(cBuffer);
+	// First line of the checkpoint file, identifies the calculation
+	std::string miCheckpointHeader(const kNN_NORM norm, const kNN_FUNCTION func, bool const& ardakaniCorrection) const
+	{
+		double checksum = 0.;
+		for (size_t i = 0u; i < drawMatrix.rows(); i++)
+			for (size_t j = 0u; j < drawMatrix.cols(); j++)
+				checksum += drawMatrix(i, j);
+		std::ostringstream header;
+		header << std::setprecision(17) << "# CAST MIE checkpoint draws " << numberOfDraws << " k " << kNN << " norm " << static_cast<int>(norm)
+			<< " func " << static_cast<int>(func) << " ardakani " << ardakaniCorrection << " checksum " << checksum;
+		return header.str();
+	}
 
-				jointEntropiesOfCertainRows(norm, func, ardakaniCorrection, result, rowIndices, curRowIndices, curRowIndices.size(), nextIter);
-			}
+	// Reads the joint entropies of a checkpoint file (nothing is read if the file
+	// does not exist or belongs to another calculation)
+	static void readMICheckpoint(std::string const& filename, std::string const& header, std::map<std::vector<size_t>, double>& jointEntropies)
+	{
+		std::ifstream file(filename);
+		std::string line;
+		if (!file || !std::getline(file, line))
+			return;
+		if (line != header)
+		{
+			std::cout << "Checkpoint file " << filename << " belongs to another calculation and is overwritten." << std::endl;
+			return;
+		}
+		// "dimension row_1 ... row_dimension entropy", the last line of a killed run
+		// might be incomplete (no line break) and is ignored
+		while (std::getline(file, line) && !file.eof())
+		{
+			std::istringstream iss(line);
+			size_t dim = 0u;
+			std::vector<size_t> rows;
+			double value = 0.;
+			if (!(iss >> dim))
+				continue;
+			rows.resize(dim);
+			for (auto& row : rows)
+				iss >> row;
+			if (iss >> value)
+				jointEntropies[rows] = value;
 		}
 	}
 
-	// Called recursivly, calculates Higher-Order Mutual Information for all possible permutations of the rowIndices up to the full dimensional one
-	// and stores those results in the "result" vecor
-	void helperFKT(const kNN_NORM norm, const kNN_FUNCTION func, bool const& ardakaniCorrection, const size_t maxDim, std::vector<calcBuffer>& result, std::vector<size_t> rowIndices,
-		std::vector<size_t> curRowIndices = std::vector<size_t>{}, const size_t curDim = 0u, size_t startIter = 0u)
+	// Calculates the mutual information terms of all subsets of rowIndices with up to maxDim elements
+	// and stores them in the "result" vector (MI term of a subset = alternating sum of the joint entropies of all its subsets).
+	// Every joint entropy is calculated only once, the calculations are distributed dynamically over the threads
+	// and are written to a checkpoint file (Config::get().entropy.entropy_mi_checkpoint) so that a killed run can resume.
+	void mutualInformationTerms(const kNN_NORM norm, const kNN_FUNCTION func, bool const& ardakaniCorrection, const size_t maxDim,
+		std::vector<calcBuffer>& result, std::vector<size_t> const& rowIndices)
 	{
-		if (curDim < maxDim)
+		std::vector<std::vector<size_t>> subsets;
+		subsetsOfRows(rowIndices, maxDim, subsets);
+
+		std::map<std::vector<size_t>, double> jointEntropies;
+		std::string const& checkpointFile = Config::get().entropy.entropy_mi_checkpoint;
+		std::string const header = miCheckpointHeader(norm, func, ardakaniCorrection);
+		std::ofstream checkpoint;
+		if (!checkpointFile.empty())
 		{
-			for (size_t i = startIter; i < rowIndices.size(); i++)
+			readMICheckpoint(checkpointFile, header, jointEntropies);
+			// rewritten with the valid entries only, so that a cut off line does not stay in the file
+			checkpoint.open(checkpointFile, std::ios_base::trunc);
+			checkpoint << std::setprecision(17) << header << "\n";
+			for (auto const& entry : jointEntropies)
 			{
-				if (curDim == 0u)
-					curRowIndices = std::vector<size_t>{};
-
-				if (curRowIndices.size() == curDim + 1u)
-					curRowIndices.at(curDim) = rowIndices.at(i);
-				else
-					curRowIndices.push_back(rowIndices.at(i));
-
-				size_t nextIter = i + 1u;
-
-				std::vector<calcBuffer> results;
-				jointEntropiesOfCertainRows(norm, func, ardakaniCorrection, results, curRowIndices);
-
-
-
-				// Debug
-				//std::cout << "\n";
-				//for (auto&& item : results)
-				//{
-				//  for (auto&& subitem : item.rowIdent)
-				//    std::cout << " " << subitem;
-				//  std::cout << "\n";
-				//}
-				//std::cout << std::endl;
+				checkpoint << entry.first.size();
+				for (auto const row : entry.first)
+					checkpoint << " " << row;
+				checkpoint << " " << entry.second << "\n";
+			}
+			checkpoint.flush();
+		}
 
-				calcBuffer cBuffer;
-				cBuffer.dim = curRowIndices.size();
-				cBuffer.rowIdent = curRowIndices;
-				cBuffer.entropyValue = 0.;
-				// SUMM
-				for (size_t j = 0u; j < results.size(); j++)
+		std::vector<std::vector<size_t>> jobs;
+		for (auto const& subset : subsets)
+		{
+			if (jointEntropies.count(subset) == 0u)
+				jobs.push_back(subset);
+		}
+		std::cout << "Joint entropies needed: " << subsets.size() << ", read from checkpoint: " << subsets.size() - jobs.size() << std::endl;
+
+		// one job per joint entropy; with less jobs than threads the kNN search itself runs in parallel
+		std::vector<double> values(jobs.size());
+		auto const n_jobs = static_cast<std::ptrdiff_t>(jobs.size());
+		size_t done = 0u;
+#pragma omp parallel for schedule(dynamic, 1) if (n_jobs >= omp_get_max_threads())
+		for (std::ptrdiff_t i = 0; i < n_jobs; ++i)
+		{
+			values[i] = calculateNNsubentropy(norm, func, ardakaniCorrection, jobs[i]);
+#pragma omp critical (mi_checkpoint)
+			{
+				++done;
+				if (checkpoint.is_open())
 				{
-					cBuffer.entropyValue += std::pow(-1., results.at(j).dim + 1.) * results.at(j).entropyValue;
+					checkpoint << jobs[i].size();
+					for (auto const row : jobs[i])
+						checkpoint << " " << row;
+					checkpoint << " " << values[i] << std::endl;
 				}
-				result.push_back(cBuffer);
+				if (Config::get().general.verbosity >= 3)
+					std::cout << "Joint entropy " << done << " of " << jobs.size() << " done." << std::endl;
+			}
+		}
+		for (size_t i = 0u; i < jobs.size(); i++)
+			jointEntropies[jobs[i]] = values[i];
 
-				helperFKT(norm, func, ardakaniCorrection, maxDim, result, rowIndices, curRowIndices, curRowIndices.size(), nextIter);
+		for (auto const& subset : subsets)
+		{
+			std::vector<std::vector<size_t>> parts;
+			subsetsOfRows(subset, subset.size(), parts);
+			calcBuffer cBuffer;
+			cBuffer.dim = subset.size();
+			cBuffer.rowIdent = subset;
+			cBuffer.entropyValue = 0.;
+			// SUMM
+			for (auto const& part : parts)
+			{
+				cBuffer.entropyValue += std::pow(-1., part.size() + 1.) * jointEntropies.at(part);
 			}
+			result.push_back(cBuffer);
 		}
 	}
 
@@ -0,0 +1,163 @@
+#include "entropy_knn.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace entropy
+{
+	KNNTree::KNNTree(Matrix_Class const& input, std::vector<size_t> const& row_querypts, size_t const leaf_size)
+		: dim(row_querypts.size())
+	{
+		if (dim == 0u)
+		{
+			throw std::runtime_error("kNN tree needs at least one dimension.");
+		}
+		size_t const n = input.cols();
+		index.resize(n);
+		points.resize(n * dim);
+		for (size_t j = 0u; j < n; ++j)
+		{
+			index[j] = j;
+			for (size_t l = 0u; l < dim; ++l)
+			{
+				points[j * dim + l] = input(row_querypts[l], j);
+			}
+		}
+		if (n > 0u)
+		{
+			build(0u, n, std::max<size_t>(leaf_size, 1u));
+		}
+		// coordinates in tree order
+		std::vector<float_type> sorted(n * dim);
+		position.resize(n);
+		for (size_t i = 0u; i < n; ++i)
+		{
+			std::copy(points.begin() + index[i] * dim, points.begin() + (index[i] + 1u) * dim, sorted.begin() + i * dim);
+			position[index[i]] = i;
+		}
+		points.swap(sorted);
+	}
+
+	// points are still in column order while building, index is permuted
+	size_t KNNTree::build(size_t const begin, size_t const end, size_t const leaf_size)
+	{
+		size_t const id = nodes.size();
+		nodes.push_back(Node{ begin, end, 0u, 0u });
+		lower.resize(lower.size() + dim, std::numeric_limits<float_type>::max());
+		upper.resize(upper.size() + dim, -std::numeric_limits<float_type>::max());
+		for (size_t i = begin; i < end; ++i)
+		{
+			for (size_t l = 0u; l < dim; ++l)
+			{
+				float_type const x = points[index[i] * dim + l];
+				lower[id * dim + l] = std::min(lower[id * dim + l], x);
+				upper[id * dim + l] = std::max(upper[id * dim + l], x);
+			}
+		}
+		if (end - begin <= leaf_size) return id;
+
+		// split at the median of the dimension with the largest extent
+		size_t split_dim = 0u;
+		for (size_t l = 1u; l < dim; ++l)
+		{
+			if (upper[id * dim + l] - lower[id * dim + l] > upper[id * dim + split_dim] - lower[id * dim + split_dim]) split_dim = l;
+		}
+		if (!(upper[id * dim + split_dim] > lower[id * dim + split_dim])) return id;   // all draws identical
+		size_t const middle = begin + (end - begin) / 2u;
+		std::nth_element(index.begin() + begin, index.begin() + middle, index.begin() + end,
+			[this, split_dim](size_t const a, size_t const b) { return points[a * dim + split_dim] < points[b * dim + split_dim]; });
+		size_t const left = build(begin, middle, leaf_size);
+		size_t const right = build(middle, end, leaf_size);
+		nodes[id].left = left;
+		nodes[id].right = right;
+		return id;
+	}
+
+	template<bool MAXIMUM_NORM>
+	float_type KNNTree::query(size_t const k_in, size_t const col_querypt) const
+	{
+		if (k_in == 0u || col_querypt >= size())
+		{
+			throw std::runtime_error("Invalid kNN query.");
+		}
+		float_type const* const q = &points[position[col_querypt] * dim];
+		size_t const self = position[col_querypt];
+
+		// distance of the query point to the bounding box of a node (never larger than
+		// the distance to any draw in it, also with floating point rounding)
+		auto box_distance = [this, q](size_t const node) {
+			float_type d = 0.0;
+			for (size_t l = 0u; l < dim; ++l)
+			{
+				float_type diff = 0.0;
+				if (q[l] < lower[node * dim + l]) diff = lower[node * dim + l] - q[l];
+				else if (q[l] > upper[node * dim + l]) diff = q[l] - upper[node * dim + l];
+				if (MAXIMUM_NORM) d = std::max(d, diff);
+				else d += pow(diff, 2);
+			}
+			return d;
+		};
+
+		// k smallest distinct distances found so far (sorted)
+		std::vector<float_type> best;
+		best.reserve(k_in + 1u);
+		std::vector<std::pair<size_t, float_type>> stack;
+		stack.emplace_back(0u, 0.0);
+		while (!stack.empty())
+		{
+			auto const current = stack.back();
+			stack.pop_back();
+			if (best.size() == k_in && current.second >= best.back()) continue;
+			Node const& node = nodes[current.first];
+			if (node.left == 0u)
+			{
+				for (size_t i = node.begin; i < node.end; ++i)
+				{
+					if (i == self) continue;
+					float_type const* const p = &points[i * dim];
+					// same arithmetic as in knn_distance_eucl_squared and maximum_norm_knn_distance
+					float_type temp_distance = 0.0;
+					for (size_t l = 0u; l < dim; ++l)
+					{
+						if (MAXIMUM_NORM) temp_distance = std::max(temp_distance, std::abs(p[l] - q[l]));
+						else temp_distance += pow(p[l] - q[l], 2);
+					}
+					if (best.size() == k_in && temp_distance >= best.back()) continue;
+					auto const it = std::lower_bound(best.begin(), best.end(), temp_distance);
+					if (it != best.end() && *it == temp_distance) continue;   // distinct distances only
+					best.insert(it, temp_distance);
+					if (best.size() > k_in) best.pop_back();
+				}
+			}
+			else
+			{
+				float_type const dl = box_distance(node.left), dr = box_distance(node.right);
+				// nearer child is processed first
+				if (dl < dr)
+				{
+					stack.emplace_back(node.right, dr);
+					stack.emplace_back(node.left, dl);
+				}
+				else
+				{
+					stack.emplace_back(node.left, dl);
+					stack.emplace_back(node.right, dr);
+				}
+			}
+		}
+		return best.size() == k_in ? best.back() : std::numeric_limits<float_type>::max();
+	}
+
+	float_type KNNTree::knn_distance_eucl_squared(size_t const& k_in, size_t const& col_querypt) const
+	{
+		return query<false>(k_in, col_querypt);
+	}
+
+	float_type KNNTree::maximum_norm_knn_distance(size_t const& k_in, size_t const& col_querypt) const
+	{
+		return query<true>(k_in, col_querypt);
+	}
+}
@@ -0,0 +1,81 @@
+/**
+CAST 3
+entropy_knn.h
+Purpose:
+Spatial index for the k-nearest-neighbor searches of the
+entropy estimators (see entropy.h).
+
+@version 1.0
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "matop.h"
+
+namespace entropy
+{
+	/**
+	* k-d tree over the columns (draws) of a matrix whose rows are dimensions.
+	* The tree is built once for a subset of rows and answers the same
+	* queries as knn_distance_eucl_squared and maximum_norm_knn_distance,
+	* including their handling of ties (the k-th smallest distinct distance
+	* is returned, std::numeric_limits<float_type>::max() if there are
+	* less than k distinct distances). Distances are evaluated with
+	* exactly the same arithmetic, so the results are identical.
+	* Queries do not modify the tree and can be done in parallel.
+	*/
+	class KNNTree
+	{
+	public:
+		/**
+		* @param input Matrix with dimensions as rows and draws as columns.
+		* @param row_querypts Rows (ie dimensions) used in the search.
+		* @param leaf_size Maximum number of draws in a leaf of the tree.
+		*/
+		KNNTree(Matrix_Class const& input, std::vector<size_t> const& row_querypts, size_t const leaf_size = 16u);
+
+		/**
+		* Squared eucledean distance of the k-th nearest neighbor
+		* of the draw in column col_querypt.
+		*/
+		float_type knn_distance_eucl_squared(size_t const& k_in, size_t const& col_querypt) const;
+
+		/**
+		* Maximum norm distance of the k-th nearest neighbor
+		* of the draw in column col_querypt.
+		*/
+		float_type maximum_norm_knn_distance(size_t const& k_in, size_t const& col_querypt) const;
+
+		/**number of draws*/
+		size_t size() const { return index.size(); }
+		/**number of dimensions*/
+		size_t dimension() const { return dim; }
+
+	private:
+		struct Node
+		{
+			/**range of draws in tree order*/
+			size_t begin, end;
+			/**child nodes (0 for leaves)*/
+			size_t left, right;
+		};
+
+		size_t build(size_t const begin, size_t const end, size_t const leaf_size);
+		template<bool MAXIMUM_NORM>
+		float_type query(size_t const k_in, size_t const col_querypt) const;
+
+		size_t dim;
+		/**coordinates of the draws in tree order, draw i at [i*dim, (i+1)*dim)*/
+		std::vector<float_type> points;
+		/**column of draw i (tree order) in the input matrix*/
+		std::vector<size_t> index;
+		/**position in tree order of every column of the input matrix*/
+		std::vector<size_t> position;
+		/**bounding box of node j at [j*dim, (j+1)*dim)*/
+		std::vector<float_type> lower, upper;
+		std::vector<Node> nodes;
+	};
+}
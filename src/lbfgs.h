@@ -43,6 +43,10 @@
 #include <algorithm>
 #include "ls.h"
 
+namespace scon
+{
+	template<class T> class c3;
+}
 
 namespace optimization
 {
@@ -310,6 +314,300 @@ namespace optimization
 				(std::forward<LinesearchT>(ls), std::forward<LoggerT>(log));
 		}
 
+		namespace lbfgs_detail
+		{
+			/**copies the scalars of one element of a representation (a number or a scon::c3) from and to a flat array*/
+			template<class T>
+			struct scalars
+			{
+				static std::size_t const count = 1u;
+				template<class F> static void to(T const& v, F* out) { out[0] = static_cast<F>(v); }
+				template<class F> static void from(F const* in, T& v) { v = static_cast<T>(in[0]); }
+			};
+
+			template<class T>
+			struct scalars<scon::c3<T>>
+			{
+				static std::size_t const count = 3u;
+				template<class F> static void to(scon::c3<T> const& v, F* out)
+				{
+					out[0] = static_cast<F>(v.x());
+					out[1] = static_cast<F>(v.y());
+					out[2] = static_cast<F>(v.z());
+				}
+				template<class F> static void from(F const* in, scon::c3<T>& v)
+				{
+					v.x() = static_cast<T>(in[0]);
+					v.y() = static_cast<T>(in[1]);
+					v.z() = static_cast<T>(in[2]);
+				}
+			};
+
+			template<class C, class F>
+			void to_flat(C const& c, F* out)
+			{
+				using S = scalars<typename C::value_type>;
+				for (std::size_t k = 0u; k < c.size(); ++k) S::to(c[k], out + S::count * k);
+			}
+
+			template<class C, class F>
+			void from_flat(F const* in, C& c)
+			{
+				using S = scalars<typename C::value_type>;
+				for (std::size_t k = 0u; k < c.size(); ++k) S::from(in + S::count * k, c[k]);
+			}
+
+			/**out = a - b*/
+			template<class C, class F>
+			void difference_to_flat(C const& a, C const& b, F* out)
+			{
+				using S = scalars<typename C::value_type>;
+				F other[S::count];
+				for (std::size_t k = 0u; k < a.size(); ++k)
+				{
+					S::to(a[k], out + S::count * k);
+					S::to(b[k], other);
+					for (std::size_t i = 0u; i < S::count; ++i) out[S::count * k + i] -= other[i];
+				}
+			}
+
+			template<class F>
+			F dot(F const* a, F const* b, std::size_t const n)
+			{
+				F sum = F();
+#pragma omp simd reduction(+: sum)
+				for (std::size_t i = 0u; i < n; ++i) sum += a[i] * b[i];
+				return sum;
+			}
+
+			/**y += a * x*/
+			template<class F>
+			void axpy(F* y, F const a, F const* x, std::size_t const n)
+			{
+#pragma omp simd
+				for (std::size_t i = 0u; i < n; ++i) y[i] += a * x[i];
+			}
+		}
+
+		/*
+
+		L-BFGS with the same line search interface, iteration and convergence test as lbfgs
+		for representations that are random access containers of numbers or scon::c3 (like
+		coords::Representation_3D with double precision). The m corrections are kept in one
+		contiguous ring buffer of scalars and the two-loop recursion runs over flat arrays.
+		Corrections with non-positive curvature are not stored.
+
+		*/
+
+		template<class LineSearchT, class LoggerT = empty_void_functor>
+		class flat_lbfgs
+		{
+
+		public:
+
+			using linesearch_type = typename std::enable_if<
+				linesearch::is_valid_linesearch<LineSearchT>::value, LineSearchT
+			>::type;
+
+			using float_type = typename linesearch_type::float_type;
+			using rep_type = typename linesearch_type::rep_type;
+			using grad_type = typename linesearch_type::grad_type;
+			using callback_type = typename linesearch_type::callback_type;
+
+			using point_type = Point < rep_type, grad_type, float_type >;
+
+			using logger_type = LoggerT;
+
+			linesearch_type ls;
+			logger_type log;
+
+			struct configuration
+			{
+				// Number of Hessian Corrections
+				std::size_t m;
+				// maximum number of iterations
+				std::size_t max_iterations;
+				// Convergence epsilon
+				float_type epsilon;
+				configuration() :
+					m(6u), max_iterations(500u), epsilon(float_type(1.e-4))
+				{ }
+			} config;
+
+		private:
+
+			using F = float_type;
+			using rep_scalars = lbfgs_detail::scalars<typename rep_type::value_type>;
+
+			point_type current, previous;
+			float_type xnorm, gnorm;
+
+			// correction k: s = x_(k+1) - x_k in s_ring[k * n, (k + 1) * n), y = g_(k+1) - g_k in y_ring
+			std::vector<float_type> s_ring, y_ring, rho, alpha, q, w;
+			std::size_t n, newest, stored;
+			float_type gamma;
+
+			grad_type d;
+			float_type step;
+			std::size_t iteration;
+			status rstate;
+			bool go_on;
+
+			void norms()
+			{
+				using std::sqrt;
+				xnorm = sqrt(dot(current.x, current.x));
+				gnorm = sqrt(dot(current.g, current.g));
+			}
+
+			bool convergence() const
+			{
+				using std::max;
+				return (gnorm / max(xnorm, F(1))) < config.epsilon;
+			}
+
+			void store_correction()
+			{
+				// s and y are built in q and w, a rejected correction must not overwrite the oldest stored one
+				float_type* s = q.data();
+				float_type* y = w.data();
+				lbfgs_detail::difference_to_flat(current.x, previous.x, s);
+				lbfgs_detail::difference_to_flat(current.g, previous.g, y);
+				float_type const sy = lbfgs_detail::dot(s, y, n), yy = lbfgs_detail::dot(y, y, n);
+				if (!(sy > F(0)) || !(yy > F(0))) return;
+				std::size_t const slot = stored == 0u ? 0u : (newest + 1u) % config.m;
+				std::copy(s, s + n, s_ring.begin() + slot * n);
+				std::copy(y, y + n, y_ring.begin() + slot * n);
+				rho[slot] = F(1) / sy;
+				gamma = sy / yy;
+				newest = slot;
+				stored = std::min(stored + 1u, config.m);
+			}
+
+			void direction()
+			{
+				lbfgs_detail::to_flat(current.g, q.data());
+				for (auto& v : q) v = -v;
+				std::size_t const M = config.m;
+				std::size_t j(newest);
+				for (std::size_t i(0U); i < stored; ++i)
+				{
+					alpha[j] = rho[j] * lbfgs_detail::dot(s_ring.data() + j * n, q.data(), n);
+					lbfgs_detail::axpy(q.data(), -alpha[j], y_ring.data() + j * n, n);
+					if (i + 1u < stored) j = (j + M - 1U) % M;
+				}
+				if (stored > 0u)
+				{
+					for (auto& v : q) v *= gamma;
+				}
+				for (std::size_t i(0U); i < stored; ++i)
+				{
+					float_type const beta(rho[j] * lbfgs_detail::dot(y_ring.data() + j * n, q.data(), n));
+					lbfgs_detail::axpy(q.data(), alpha[j] - beta, s_ring.data() + j * n, n);
+					j = (j + 1U) % M;
+				}
+				d = current.g;
+				lbfgs_detail::from_flat(q.data(), d);
+			}
+
+			status optimize()
+			{
+				using std::sqrt;
+				if (convergence())
+				{
+					return rstate = status::SUCCESS;
+				}
+				step = float_type(1) / sqrt(dot(d, d));
+				log(current);
+				for (std::size_t i(1U); i <= config.max_iterations; ++i)
+				{
+					previous = current;
+					auto const lsr = ls(d, step, current, previous.x, i);
+					if (lsr != status::SUCCESS)
+					{
+						current = previous;
+						norms();
+						return lsr;
+					}
+					log(current);
+					norms();
+					++iteration;
+					if (convergence())
+					{
+						return rstate = status::SUCCESS;
+					}
+					store_correction();
+					direction();
+					step = stored > 0u ? float_type(1) : float_type(1) / sqrt(dot(d, d));
+				}
+				return rstate = status::ERR_MAX_ITERATIONS;
+			}
+
+		public:
+
+			flat_lbfgs(linesearch_type linesearch_object,
+				logger_type logger_object = logger_type())
+				: ls(std::move(linesearch_object)),
+				log(logger_object),
+				config(), current(), previous(), xnorm(), gnorm(),
+				s_ring(), y_ring(), rho(), alpha(), q(), w(),
+				n(), newest(), stored(), gamma(),
+				d(), step(), iteration(), rstate(status::UNDEFINED), go_on(true)
+			{ }
+
+			void init(point_type const& p)
+			{
+				rstate = status::UNDEFINED;
+				current = p;
+				iteration = 0u;
+				current.f = ls.callback(current.x, current.g, iteration, go_on);
+				norms();
+				n = rep_scalars::count * current.x.size();
+				s_ring.assign(config.m * n, F());
+				y_ring.assign(config.m * n, F());
+				rho.assign(config.m, F());
+				alpha.assign(config.m, F());
+				q.assign(n, F());
+				w.assign(n, F());
+				newest = 0u;
+				stored = 0u;
+				gamma = F(1);
+				d = -current.g;
+			}
+
+			point_type const& p() const { return current; }
+			point_type& p() { return current; }
+
+			status state() const { return rstate; }
+			std::size_t iter() const { return iteration; }
+
+			callback_type&& operator() (point_type& p)
+			{
+				init(p);
+				rstate = optimize();
+				return std::move(ls.callback);
+			}
+
+		};
+
+		template<class LinesearchT>
+		inline flat_lbfgs<typename std::remove_reference<LinesearchT>::type>
+			make_flat_lbfgs(LinesearchT&& ls)
+		{
+			return flat_lbfgs<typename std::remove_reference<LinesearchT>::type>
+				(std::forward<LinesearchT>(ls));
+		}
+
+		template<class LinesearchT, class LoggerT>
+		inline flat_lbfgs<typename std::remove_reference<LinesearchT>::type,
+			typename std::remove_reference<LoggerT>::type>
+			make_flat_lbfgs(LinesearchT&& ls, LoggerT&& log)
+		{
+			return flat_lbfgs<typename std::remove_reference<LinesearchT>::type,
+				typename std::remove_reference<LoggerT>::type>
+				(std::forward<LinesearchT>(ls), std::forward<LoggerT>(log));
+		}
+
 	}
 
 }
@@ -33,6 +33,7 @@
 //////////////////////////
 #include "configuration.h"
 #include "coords_io.h"
+#include "coords_io_stream.h"
 #include "Scon/scon_chrono.h"
 #include "helperfunctions.h"
 #include "Scon/scon_log.h"
@@ -174,10 +175,10 @@ int main(int argc, char** argv)
 			std::cout << "-------------------------------------------------\n";
 			std::cout << "Initialization\n";
 			std::cout << "-------------------------------------------------\n";
-			std::cout << "Loaded " << ci->size() << " structure" << (ci->size() == 1 ? "" : "s");
+			std::cout << "Loaded " << ci->frames() << " structure" << (ci->frames() == 1 ? "" : "s");
 			std::cout << ". (" << ci->atoms() << " atom" << (ci->atoms() == 1 ? "" : "s");
 			std::cout << " and " << coords.weight() << " g/mol";
-			std::cout << (ci->size() > 1 ? " each" : "") << ")\n";
+			std::cout << (ci->frames() > 1 ? " each" : "") << ")\n";
 			std::size_t const susysize(coords.subsystems().size());
 			if (susysize > 1U)
 			{
@@ -837,79 +838,83 @@ int main(int argc, char** argv)
 			*
 			*/
 
+			// the structures are read and written chunk by chunk
 			std::ofstream out(coords::output::filename("_noexplwater").c_str(), std::ios::app);
-			std::string* hold_str = new std::string[ci->size()];
+			coords::input::frame_chunks chunks(*ci);
+			coords::input::frame_chunk chunk;
+			while (chunks.next(chunk))
+			{
+				std::vector<std::string> hold_str(chunk.size());
 #ifdef _OPENMP
-			auto const n_omp = static_cast<std::ptrdiff_t>(ci->size());
-#pragma omp parallel for firstprivate(coords) shared(hold_str)
-			for (std::ptrdiff_t iter = 0; iter < n_omp; ++iter)
+				auto const n_omp = static_cast<std::ptrdiff_t>(chunk.size());
+#pragma omp parallel for firstprivate(coords) shared(hold_str, chunk)
+				for (std::ptrdiff_t iter = 0; iter < n_omp; ++iter)
 #else
-			for (std::size_t iter = 0; iter < ci->size(); ++iter)
+				for (std::size_t iter = 0; iter < chunk.size(); ++iter)
 #endif
-			{
-				auto holder = ci->PES()[iter].structure.cartesian;
-				coords.set_xyz(holder);
-
-				std::vector<size_t> atomsToBePurged;
-				coords::Atoms truncAtoms;
-				coords::Representation_3D positions;
-				for (size_t i = 0u; i < coords.atoms().size(); i++)
 				{
-					coords::Atom atom(coords.atoms().atom(i));
-					if (atom.number() != 8u && atom.number() != 1u)
-					{
-						truncAtoms.add(atom);
-						positions.push_back(coords.xyz(i));
-					}
-					else if (atom.number() == 1u)
+					coords.set_xyz(chunk.xyz[iter]);
+
+					std::vector<size_t> atomsToBePurged;
+					coords::Atoms truncAtoms;
+					coords::Representation_3D positions;
+					for (size_t i = 0u; i < coords.atoms().size(); i++)
 					{
-						// Check if hydrogen is bound to something else than Oxygen
-						bool checker = true;
-						for (size_t j = 0u; j < atom.bonds().size(); j++)
-						{
-							if (coords.atoms().atom(atom.bonds()[j]).number() == 8u) checker = false;
-						}
-						if (checker)
+						coords::Atom atom(coords.atoms().atom(i));
+						if (atom.number() != 8u && atom.number() != 1u)
 						{
 							truncAtoms.add(atom);
 							positions.push_back(coords.xyz(i));
 						}
-					}
-					else if (atom.number() == 8u)
-					{
-						//checker checks if only hydrogens are bound to this current oxygen
-						bool checker = true;
-						for (size_t j = 0u; j < atom.bonds().size(); j++)
+						else if (atom.number() == 1u)
 						{
-							if (coords.atoms().atom(atom.bonds()[j]).number() != 1u) checker = false;
+							// Check if hydrogen is bound to something else than Oxygen
+							bool checker = true;
+							for (size_t j = 0u; j < atom.bonds().size(); j++)
+							{
+								if (coords.atoms().atom(atom.bonds()[j]).number() == 8u) checker = false;
+							}
+							if (checker)
+							{
+								truncAtoms.add(atom);
+								positions.push_back(coords.xyz(i));
+							}
 						}
-						if (!checker)
+						else if (atom.number() == 8u)
 						{
-							truncAtoms.add(atom);
-							positions.push_back(coords.xyz(i));
-							for (auto const& bond : atom.bonds())
+							//checker checks if only hydrogens are bound to this current oxygen
+							bool checker = true;
+							for (size_t j = 0u; j < atom.bonds().size(); j++)
+							{
+								if (coords.atoms().atom(atom.bonds()[j]).number() != 1u) checker = false;
+							}
+							if (!checker)
 							{
-								if (coords.atoms().atom(bond).number() == 1u)
+								truncAtoms.add(atom);
+								positions.push_back(coords.xyz(i));
+								for (auto const& bond : atom.bonds())
 								{
-									truncAtoms.add(coords.atoms().atom(bond));
-									positions.push_back(coords.xyz(bond));
+									if (coords.atoms().atom(bond).number() == 1u)
+									{
+										truncAtoms.add(coords.atoms().atom(bond));
+										positions.push_back(coords.xyz(bond));
+									}
 								}
 							}
 						}
 					}
+					coords::Coordinates newCoords;
+					coords::PES_Point x(positions);
+					newCoords.init_in(truncAtoms, x);
+					std::stringstream temporaryStringstream;
+					temporaryStringstream << newCoords;
+					hold_str[iter] = temporaryStringstream.str();
+				}
+				for (auto const& str : hold_str)
+				{
+					out << str;
 				}
-				coords::Coordinates newCoords;
-				coords::PES_Point x(positions);
-				newCoords.init_in(truncAtoms, x);
-				std::stringstream temporaryStringstream;
-				temporaryStringstream << newCoords;
-				hold_str[iter] = temporaryStringstream.str();
 			}
-			for (size_t i = 0; i < ci->size(); i++)
-
-      {
-        out << hold_str[i];
-      }
 		    break;
       }
 	  case config::tasks::SCAN2D:
@@ -52,14 +52,27 @@ namespace
 		if (sn == 0u) return 0u;
 		return st / std::min(st, sn);
 	}
+
+	/**snapshots are written in the background,
+	optimizations only with forcefields because the copies of other interfaces share their files*/
+	inline bool async_snapshots()
+	{
+		if (!Config::get().md.async_snapshots) return false;
+		if (!Config::get().md.optimize_snapshots) return true;
+		auto const ei = Config::get().general.energy_interface;
+		return ei == config::interface_types::T::AMBER || ei == config::interface_types::T::AMOEBA ||
+			ei == config::interface_types::T::CHARMM22 || ei == config::interface_types::T::OPLSAA;
+	}
 }
 
 
-md::Logger::Logger(coords::Coordinates& coords, std::size_t snap_offset) :
-	snap_buffer(coords::make_buffered_cartesian_log(coords, "_MD_SNAP",
-		Config::get().md.max_snap_buffer, snap_offset, Config::get().md.optimize_snapshots)),
+md::Logger::Logger(coords::Coordinates& coords, std::size_t snap_offset, std::string const& suffix) :
+	snap_buffer(coords::make_buffered_cartesian_log(coords, "_MD_SNAP" + suffix,
+		Config::get().md.max_snap_buffer, snap_offset, Config::get().md.optimize_snapshots,
+		Config::get().md.binary_snapshots ? Config::get().md.snap_precision : 0.0, Config::get().md.resume,
+		async_snapshots(), Config::get().md.snap_threads)),
 	data_buffer(scon::offset_call_buffer<trace_data>(50u, Config::get().md.trackoffset,
-		trace_writer{ coords::output::filename("_MD_TRACE", ".csv").c_str() })),
+		trace_writer{ coords::output::filename("_MD_TRACE" + suffix, ".csv").c_str() })),
 	snapnum()
 {
 }
@@ -80,6 +93,12 @@ bool md::Logger::operator()(std::size_t const iter, coords::float_type const T,
 	return data_buffer(trace_data(Eia, T, Ek, Ep, P, iter, snap_buffer(x) ? ++snapnum : 0u));
 }
 
+void md::Logger::flush()
+{
+	snap_buffer.flush();
+	snap_buffer.p.first.wait();
+}
+
 // The Coords Object's functions
 bool md::CoordinatesUBIAS::validate_bonds()
 {
@@ -148,6 +167,22 @@ md::simulation::simulation(coords::Coordinates& coord_object) :
 	if (Config::get().md.ana_pairs.size() > 0) md_analysis::create_ana_pairs(this);   // create atom pairs to analyze, fetch information and save
 }
 
+// the analysis of distances and zones is only done for the main simulation
+md::simulation::simulation(simulation const& fep_parent, coords::Coordinates& window_coords, std::string const& suffix) :
+	coordobj(std::addressof(window_coords)),
+	logging(window_coords, gap(Config::get().md.num_steps, Config::get().md.num_snapShots), suffix),
+	P(fep_parent.P), P_old(fep_parent.P_old), P_start(fep_parent.P_start),
+	F(fep_parent.F), F_old(fep_parent.F_old), V(fep_parent.V), M(fep_parent.M),
+	M_total(fep_parent.M_total), E_kin_tensor(fep_parent.E_kin_tensor), E_kin(fep_parent.E_kin),
+	T(fep_parent.T), temp(fep_parent.temp), press(fep_parent.press), dt(fep_parent.dt),
+	freedom(fep_parent.freedom), snapGap(fep_parent.snapGap), C_geo(fep_parent.C_geo), C_mass(fep_parent.C_mass),
+	nht(fep_parent.nht), rattle_bonds(fep_parent.rattle_bonds), distances(fep_parent.distances),
+	inner_atoms(fep_parent.inner_atoms), movable_atoms(fep_parent.movable_atoms),
+	window(fep_parent.window), udatacontainer(fep_parent.udatacontainer),
+	restarted(fep_parent.restarted), file_suffix(suffix)
+{
+}
+
 
 void md::simulation::run(bool const restart)
 {
@@ -249,6 +284,8 @@ void md::simulation::integrate(bool fep, std::size_t const k_init)
 		integrator(fep, k_init, false);
 	}
 	}
+	// wait for snapshots written in the background
+	logging.flush();
 }
 
 
@@ -931,6 +968,121 @@ std::vector<double> md::simulation::fepanalyze(std::vector<double> dE_pots, int
 }
 #endif
 
+double md::fep_exchange_probability(double const dE, double const dE_back, double const T)
+{
+	// change of the reduced energy if configuration i moves to window i+1 and configuration i+1 to window i
+	double const delta = (dE - dE_back) / (md::R * T);
+	return delta <= 0.0 ? 1.0 : std::exp(-delta);
+}
+
+// swap the configurations of two neighbouring FEP windows (same temperature, so the velocities are not scaled)
+void md::simulation::exchange_configuration(simulation& other)
+{
+	auto const xyz = coordobj.xyz();
+	coordobj.set_xyz(other.coordobj.xyz());
+	other.coordobj.set_xyz(xyz);
+	std::swap(P_old, other.P_old);
+	std::swap(F_old, other.F_old);
+	std::swap(V, other.V);
+	// the gradients belong to the Hamiltonian of the other window,
+	// the additional energy calculation is no sample of the windows
+	auto const samples = coordobj.getFep().fepdata.size();
+	coordobj.g();
+	coordobj.getFep().fepdata.resize(samples);
+	auto const other_samples = other.coordobj.getFep().fepdata.size();
+	other.coordobj.g();
+	other.coordobj.getFep().fepdata.resize(other_samples);
+}
+
+// run all FEP windows at the same time, each one on its own copy of the coordinates
+void md::simulation::fep_concurrent_windows(std::vector<std::vector<energy::fepvect>>& equilibration,
+	std::vector<std::vector<energy::fepvect>>& production)
+{
+	auto const n = coordobj.getFep().window.size();
+	auto const threads = std::min(Config::get().fep.concurrent, n);
+	std::vector<coords::Coordinates> window_coords(n, coordobj.get_coordinates());
+	std::vector<std::unique_ptr<simulation>> windows;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		window_coords[i].getFep().window[0U].step = static_cast<int>(i);
+		window_coords[i].getFep().fepdata.clear();
+		windows.emplace_back(new simulation(*this, window_coords[i], "_FEP" + std::to_string(i)));
+	}
+	std::cout << "Simulating " << n << " FEP windows, " << threads << " at the same time.\n";
+
+	auto const run_windows = [&](std::size_t const k_init)
+	{
+		std::exception_ptr error;
+		auto const m = static_cast<std::ptrdiff_t>(n);
+#pragma omp parallel for schedule(dynamic) num_threads(static_cast<int>(threads))
+		for (std::ptrdiff_t i = 0; i < m; ++i)
+		{
+			try
+			{
+				windows[i]->integrate(true, k_init);
+			}
+			catch (...)
+			{
+#pragma omp critical (fep_window_error)
+				if (!error) error = std::current_exception();
+			}
+		}
+		if (error) std::rethrow_exception(error);
+	};
+
+	// equilibration of all windows
+	Config::set().md.num_steps = Config::get().fep.equil;
+	run_windows(0U);
+	equilibration.resize(n);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		equilibration[i].swap(window_coords[i].getFep().fepdata);
+	}
+
+	// production in pieces of Config::get().fep.exchange steps, after every piece exchanges
+	// of the pairs (0,1), (2,3), ... or (1,2), (3,4), ... are attempted in turns
+	auto const steps = Config::get().fep.steps;
+	auto const offset = Config::get().fep.exchange;
+	std::vector<std::size_t> attempts(n), accepted(n);
+	std::default_random_engine generator(static_cast<unsigned> (time(0)));
+	std::uniform_real_distribution<double> dist01(0.0, 1.0);
+	for (std::size_t k = 0, round = 0; k < steps; ++round)
+	{
+		auto const end = offset > 0u ? std::min(steps, k + offset) : steps;
+		Config::set().md.num_steps = end;
+		run_windows(k);
+		k = end;
+		if (k >= steps) break;
+		for (std::size_t i = round % 2u; i + 1u < n; i += 2u)
+		{
+			auto const& lower = window_coords[i].getFep().fepdata;
+			auto const& upper = window_coords[i + 1u].getFep().fepdata;
+			if (lower.empty() || upper.empty()) continue;
+			++attempts[i];
+			if (dist01(generator) < fep_exchange_probability(lower.back().dE, upper.back().dE_back, windows[i]->T))
+			{
+				windows[i]->exchange_configuration(*windows[i + 1u]);
+				++accepted[i];
+			}
+		}
+	}
+	if (offset > 0u)
+	{
+		std::cout << "Accepted replica exchanges:\n";
+		for (std::size_t i = 0; i + 1u < n; ++i)
+		{
+			std::cout << "Windows " << i << " and " << i + 1u << ": " << accepted[i] << " of " << attempts[i] << "\n";
+		}
+	}
+	production.resize(n);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		production[i].swap(window_coords[i].getFep().fepdata);
+	}
+	// end with the structure of the last window like the sequential run
+	coordobj.set_xyz(window_coords.back().xyz(), true);
+}
+
 // perform FEP calculation if requested
 void md::simulation::feprun()
 {
@@ -940,21 +1092,47 @@ void md::simulation::feprun()
 	}
 	std::vector<double> dE_pots;
 
+	// concurrent windows are simulated first, then the output is written like for sequential windows
+	bool concurrent(Config::get().fep.concurrent > 1u);
+	if (concurrent && Config::get().md.pressure)
+	{
+		std::cout << "Pressure control changes the box of all windows, the FEP windows are simulated one after another.\n";
+		concurrent = false;
+	}
+	if (concurrent && (!Config::get().md.ana_pairs.empty() || Config::get().md.analyze_zones))
+	{
+		// every window would write and plot the same analysis files at the same time
+		std::cout << "Distances or zones are analyzed, the FEP windows are simulated one after another.\n";
+		concurrent = false;
+	}
+	std::vector<std::vector<energy::fepvect>> equilibration, production;
+	if (concurrent) fep_concurrent_windows(equilibration, production);
+
 	for (auto i(0U); i < coordobj.getFep().window.size(); ++i)  //for every window
 	{
 		std::cout << "Lambda:  " << i * Config::get().fep.dlambda << "\n";
 		coordobj.getFep().window[0U].step = static_cast<int>(i);
-		coordobj.getFep().fepdata.clear();
-		// equilibration run for window i
-		Config::set().md.num_steps = Config::get().fep.equil;
-		integrate(true);
-		// write output for equlibration and clear fep vector
-		this->prod = false;
-		freewrite(i);
-		coordobj.getFep().fepdata.clear();
-		// production run for window i
-		Config::set().md.num_steps = Config::get().fep.steps;
-		integrate(true);
+		if (concurrent)
+		{
+			coordobj.getFep().fepdata.swap(equilibration[i]);
+			this->prod = false;
+			freewrite(i);
+			coordobj.getFep().fepdata.swap(production[i]);
+		}
+		else
+		{
+			coordobj.getFep().fepdata.clear();
+			// equilibration run for window i
+			Config::set().md.num_steps = Config::get().fep.equil;
+			integrate(true);
+			// write output for equlibration and clear fep vector
+			this->prod = false;
+			freewrite(i);
+			coordobj.getFep().fepdata.clear();
+			// production run for window i
+			Config::set().md.num_steps = Config::get().fep.steps;
+			integrate(true);
+		}
 		this->prod = true;
 		// calculate free energy change for window and write output
 		freecalc();
@@ -1738,6 +1916,10 @@ void md::simulation::integrator(bool fep, std::size_t k_init, bool beeman)
 		{
 			std::cout << "Beeman integration took " << integration_timer << '\n';
 		}
+		if (Config::get().energy.verlet_skin > 0.0)
+		{
+			coordobj.energyinterface()->print_nb_stats(std::cout);
+		}
 	}
 }
 
@@ -1847,7 +2029,7 @@ void md::simulation::write_restartfile(std::size_t const k)
 	buffer << k << *this;
 	// Create ofstream and insert buffer into stream
 	std::ofstream restart_stream(
-		(Config::get().general.outputFilename + "_MD_restart.cbf").c_str(),
+		(Config::get().general.outputFilename + "_MD_restart" + file_suffix + ".cbf").c_str(),
 		std::ofstream::out | std::ofstream::binary
 	);
 	restart_stream.write(buffer.v.data(), buffer.v.size());
@@ -23,6 +23,8 @@ Purpose: header for molecular dynamics simulation
 #include <atomic>
 #include <string>
 #include <memory>
+#include <exception>
+#include <random>
 
 
 
@@ -57,6 +59,13 @@ namespace md
 	static const double presc = 6.85684112e4;   // 1.0/6.85684112e4 would make more sense in my opinion 
 																							// but the program wouldn't always give 0.00000 for pressure
 
+	/**probability for the exchange of the configurations of two neighbouring FEP windows i and i+1
+	(Metropolis criterion of Hamiltonian replica exchange)
+	@param dE: energy difference U(lambda_i+1) - U(lambda_i) of the configuration of window i
+	@param dE_back: energy difference U(lambda_i+1) - U(lambda_i) of the configuration of window i+1
+	@param T: temperature*/
+	double fep_exchange_probability(double const dE, double const dE_back, double const T);
+
 
 	/** Nose-Hover thermostat. Variable names and implementation are identical to the book of
 	Frenkel and Smit, Understanding Molecular Simulation, Appendix E */
@@ -142,6 +151,8 @@ namespace md
 			return coordinates->getFep();
 		}
 		std::vector<std::vector<float>> const& getBrokenBonds() const { return broken_bonds; }
+		/**returns the coordinates object which is moved*/
+		coords::Coordinates& get_coordinates() const { return *coordinates; }
 		auto center_of_mass() const {
 			return coordinates->center_of_mass();
 		}
@@ -238,6 +249,8 @@ namespace md
 		};
 		/**returns the virial coefficients*/
 		coords::virial_t const& virial() const { return coordinates->m_virial; }
+		/**returns the energy interface*/
+		energy::interface_base* energyinterface() const { return coordinates->energyinterface(); }
 		decltype(std::declval<coords::Coordinates>().pes())
 			pes() const {
 			return coordinates->pes();
@@ -322,6 +335,25 @@ namespace md
 
 		/** save restarted status */
 		bool restarted;
+		/** appended to the names of the output files (snapshots, trace, restart file) */
+		std::string file_suffix;
+
+		/** simulation of one window of a concurrent FEP run which starts from the current state of fep_parent
+		@param fep_parent: simulation after fepinit() and the initial MD
+		@param window_coords: copy of the coordinates of fep_parent which is moved in this window
+		@param suffix: appended to the names of the output files */
+		simulation(simulation const& fep_parent, coords::Coordinates& window_coords, std::string const& suffix);
+
+		/** runs equilibration and production of all FEP windows at the same time
+		(Config::get().fep.concurrent windows in parallel) and exchanges the configurations of
+		neighbouring windows every Config::get().fep.exchange steps of the production (Hamiltonian replica exchange)
+		@param equilibration: FEP data of the equilibration of every window
+		@param production: FEP data of the production of every window */
+		void fep_concurrent_windows(std::vector<std::vector<energy::fepvect>>& equilibration,
+			std::vector<std::vector<energy::fepvect>>& production);
+		/** swaps configuration and velocities with the simulation of another FEP window
+		and recalculates the gradients of both */
+		void exchange_configuration(simulation& other);
 
 		/** initialization */
 		void init(void);
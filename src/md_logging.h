@@ -130,8 +130,9 @@ namespace md
 		/**writes snapshots
 		@param coords: coords-object
 		@param snap_offset: has something to do with MDsnapbuffer???
+		@param suffix: appended to the names of the snapshot and trace files (e.g. for the windows of a concurrent FEP run)
 		*/
-		Logger(coords::Coordinates& coords, std::size_t snap_offset);
+		Logger(coords::Coordinates& coords, std::size_t snap_offset, std::string const& suffix = std::string());
 
 		/**looks every 5000 steps if temperature, pressure or energy is nan and throws an error if yes
 		*/
@@ -143,6 +144,10 @@ namespace md
 			std::vector<coords::float_type> const Eia,
 			coords::Representation_3D const& x);
 
+		/**writes all buffered snapshots and waits until they are in the file
+		(throws errors of the background output)*/
+		void flush();
+
 		/**
 		overload of << operator
 		*/
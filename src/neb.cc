@@ -17,6 +17,21 @@
 #include "optimization_global.h"
 #include "matop.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+	/**the forcefield interfaces can calculate several images at the same time with their own copies*/
+	bool parallel_images()
+	{
+		auto const ei = Config::get().general.energy_interface;
+		return ei == config::interface_types::T::AMBER || ei == config::interface_types::T::AMOEBA ||
+			ei == config::interface_types::T::CHARMM22 || ei == config::interface_types::T::OPLSAA;
+	}
+}
+
 /**
 * NEB constructor
 */
@@ -194,6 +209,15 @@ void neb::preprocess(ptrdiff_t& file, ptrdiff_t& image, ptrdiff_t& count, const
 void neb::preprocess(std::vector<coords::Representation_3D>& ini_path, ptrdiff_t& count) {
 	std::vector<size_t> image_remember;
 	std::vector<std::vector<size_t> > atoms_remember;
+	set_path(ini_path);
+	if (Config::get().neb.CONSTRAINT_GLOBAL)
+		run(count, image_remember, atoms_remember);
+	else run(count);
+
+}
+
+void neb::set_path(std::vector<coords::Representation_3D> const& ini_path)
+{
 	coords::Representation_3D ini_path_x;
 	N_atoms = cPtr->size();
 	ts = false;
@@ -219,15 +243,12 @@ void neb::preprocess(std::vector<coords::Representation_3D>& ini_path, ptrdiff_t
 	final(ini_path_x);
 	create_ini_path(ini_path);
 	images.clear();
-	if (Config::get().neb.CONSTRAINT_GLOBAL)
-		run(count, image_remember, atoms_remember);
-	else run(count);
-
 }
 
 // Sets xyz coordinates of first structure in coords obj
 void neb::initial(void)
 {
+	image_workers.clear();   // new run
 	imagi[0] = cPtr->xyz();
 }
 
@@ -322,6 +343,7 @@ void neb::initial(const coords::Representation_3D& start)
 	{
 		throw std::logic_error("Critical Error in NEB procedure. Failing...");
 	}
+	image_workers.clear();   // new run
 	for (size_t i = 0; i < start.size(); i++)
 	{
 		imagi[0].push_back(start[i]);
@@ -440,11 +462,8 @@ void neb::run(ptrdiff_t& count, std::vector<size_t>&, std::vector<std::vector<si
 
 void neb::get_energies(void)
 {
-	for (size_t i = 0; i < num_images; i++)
-	{
-		cPtr->set_xyz(imagi[i]);
-		energies[i] = cPtr->g();
-	}
+	auto const evaluated = evaluate_images(0u, num_images);
+	for (size_t i = 0; i < num_images; i++) energies[i] = evaluated[i].energy;
 
 	if (Config::get().general.verbosity > 4)
 		std::cout << "maximum energy image is: " << CIMaximum << "\n";
@@ -893,196 +912,206 @@ double neb::lbfgs_maxflux()
 	return cPtr->g();
 }
 
-double neb::g_new()
+std::vector<energy::qm_job_result> neb::evaluate_images(size_t const first, size_t const last)
 {
-	double Rp1mag{ 0.0 }, Rm1mag{ 0.0 }, energytemp{ 0.0 };
-	Rp1.resize(cPtr->size());
-	Rm1.resize(cPtr->size());
-	Fvertical.resize(cPtr->size());
-	Fpar.resize(cPtr->size());
-	if (Config::get().neb.IDPP) Fidpp.resize(cPtr->size());
-	grad_tot.clear();
-
-	calc_tau();
-
-
-
-	for (size_t im = 1; im < num_images - 1; im++)
-	{
-
-		imagi[im].clear();
-		for (size_t kk = (im - 1) * cPtr->size(); kk < im * cPtr->size(); kk++)  imagi[im].push_back(images_initial[kk]);
-
-		cPtr->set_xyz(imagi[im]);
-		energies_NEB[im] = energytemp = this->cPtr->g();
-		energytemp += energytemp;
-		if (ClimbingImage == true && num_images == static_cast<decltype(num_images)>(CIMaximum))
+	std::vector<energy::qm_job_result> results(last);
+	if (first >= last) return results;
+	if (energy::use_qm_job_pool() && last - first > 1u)
+	{
+		std::vector<coords::Representation_3D> structures(imagi.begin() + first, imagi.begin() + last);
+		energy::qm_job_pool pool(*cPtr, Config::get().energy.qm_worker.jobs);
+		auto pooled = pool.run(structures, energy::qm_job_types::GRADIENT);
+		for (size_t im = first; im < last; ++im)
 		{
-			double magni = 0.0;
-			magni = dot_uneq(cPtr->g_xyz(), tau[im]);
-			if (len(tau[im]) == 0.0) { magni = 0.0; }
-			else { magni = magni / len(tau[im]); }
-			for (size_t i = 0; i < cPtr->size(); i++) cPtr->update_g_xyz(i, cPtr->g_xyz(i) - tau[im][i] * magni * 2.0);
+			if (!pooled[im - first].ok)
+				throw std::runtime_error("Energy calculation of NEB image " + std::to_string(im) + " failed: " + pooled[im - first].error);
+			results[im] = std::move(pooled[im - first]);
 		}
-		else
+		cPtr->set_xyz(imagi[last - 1]);
+		return results;
+	}
+	auto evaluate = [&](coords::Coordinates& c, size_t const im)
+	{
+		c.set_xyz(imagi[im]);
+		results[im].energy = c.g();
+		results[im].gradient = c.g_xyz();
+		results[im].xyz = c.xyz();
+		results[im].integrity = c.integrity();
+		results[im].ok = true;
+	};
+#ifdef _OPENMP
+	auto const threads = static_cast<size_t>(omp_get_max_threads());
+	if (threads > 1u && last - first > 1u && parallel_images())
+	{
+		// one clone per thread, the last image is calculated by cPtr itself
+		if (image_workers.size() != threads || image_workers_source != cPtr
+			|| image_workers_interface != cPtr->energyinterface() || image_workers_atoms != cPtr->size())
 		{
-
-			tauderiv = dot_uneq(cPtr->g_xyz(), tau[im]);
-
-			if (len(tau[im]) == 0.0) { tauderiv = 0.0; }
-			else { tauderiv /= len(tau[im]); }
-			if (tauderiv != tauderiv) tauderiv = 0.0;
-			for (size_t j = 0; j < cPtr->size(); j++)
+			image_workers.clear();
+			image_workers.reserve(threads);
+			for (size_t t = 0; t < threads; ++t) image_workers.emplace_back(*cPtr);
+			image_workers_source = cPtr;
+			image_workers_interface = cPtr->energyinterface();
+			image_workers_atoms = cPtr->size();
+		}
+		// fixed atoms of the copies are kept where they are in cPtr (which is changed by the last image)
+		auto const base = cPtr->xyz();
+		std::vector<bool> fixed(cPtr->size());
+		for (size_t i = 0; i < cPtr->size(); i++) fixed[i] = cPtr->atoms(i).fixed();
+		auto const n = static_cast<std::ptrdiff_t>(last - first);
+#pragma omp parallel for schedule(dynamic)
+		for (std::ptrdiff_t k = 0; k < n; ++k)
+		{
+			auto const im = first + static_cast<size_t>(k);
+			if (im + 1 == last) evaluate(*cPtr, im);
+			else
 			{
+				auto& worker = image_workers[omp_get_thread_num()];
+				for (size_t i = 0; i < fixed.size(); i++) worker.fix(i, fixed[i]);
+				worker.set_xyz(base, true);
+				evaluate(worker, im);
+			}
+		}
+		return results;
+	}
+#endif
+	for (size_t im = first; im < last; ++im) evaluate(*cPtr, im);
+	return results;
+}
 
-				Rm1[j].x() = imagi[im - 1][j].x() - imagi[im][j].x();
-				Rm1[j].y() = imagi[im - 1][j].y() - imagi[im][j].y();
-				Rm1[j].z() = imagi[im - 1][j].z() - imagi[im][j].z();
-
-				Rp1[j].x() = imagi[im + 1][j].x() - imagi[im][j].x();
-				Rp1[j].y() = imagi[im + 1][j].y() - imagi[im][j].y();
-				Rp1[j].z() = imagi[im + 1][j].z() - imagi[im][j].z();
+void neb::update_images(std::vector<coords::Representation_3D>& previous)
+{
+	previous = imagi;
+	for (size_t im = 1; im < num_images - 1; im++)
+	{
+		imagi[im].assign(images_initial.begin() + (im - 1) * cPtr->size(), images_initial.begin() + im * cPtr->size());
+	}
+}
 
-			}
-			Rm1mag = len(imagi[im - 1]) - len(imagi[im]);
-			Rp1mag = len(imagi[im + 1]) - len(imagi[im]);
-			if (Rm1mag != Rm1mag) Rm1mag = 0.0;
-			if (Rp1mag != Rp1mag) Rp1mag = 0.0;
-			for (size_t i = 0; i < cPtr->size(); i++)
-			{
-				Fvertical[i].x() = cPtr->g_xyz(i).x() - tauderiv * tau[im][i].x();
-				Fvertical[i].y() = cPtr->g_xyz(i).y() - tauderiv * tau[im][i].y();
-				Fvertical[i].z() = cPtr->g_xyz(i).z() - tauderiv * tau[im][i].z();
+void neb::collect_forces(std::vector<coords::Representation_3D> const& forces)
+{
+	grad_tot.clear();
+	for (size_t im = 1; im < num_images - 1; im++)
+	{
+		grad_tot.insert(grad_tot.end(), forces[im].begin(), forces[im].end());
+	}
+	// cPtr holds the last image with its projected force
+	for (size_t j = 0; j < cPtr->size(); j++) cPtr->update_g_xyz(j, forces[num_images - 2][j]);
+}
 
-				Fpar[i].x() = springconstant * (Rp1mag - Rm1mag) * tau[im][i].x();
-				Fpar[i].y() = springconstant * (Rp1mag - Rm1mag) * tau[im][i].y();
-				Fpar[i].z() = springconstant * (Rp1mag - Rm1mag) * tau[im][i].z();
+double neb::g_new()
+{
+	calc_tau();
 
-			}
-			if (Config::get().neb.IDPP)
-			{
-				auto bond_dummy{ bond_dir(imagi[im]) };
-				auto eu_dummy{ euclid_dist<double>(imagi[im]) };
-				Fidpp = idpp_gradients<double, dist_T<double>>(bond_dummy, eu_st, eu_dummy, eu_fi, im);
-			}
+	// the following image is projected at its position of the previous call
+	std::vector<coords::Representation_3D> previous;
+	update_images(previous);
+	auto const evaluated = evaluate_images(1u, num_images - 1);
+	for (size_t im = 1; im < num_images - 1; im++) energies_NEB[im] = evaluated[im].energy;
+
+	bool const climbing = ClimbingImage == true && num_images == static_cast<decltype(num_images)>(CIMaximum);
+	std::vector<coords::Representation_3D> forces(num_images);
+	auto const n_images = static_cast<std::ptrdiff_t>(num_images);
+#pragma omp parallel for schedule(dynamic)
+	for (std::ptrdiff_t k = 1; k < n_images - 1; ++k)
+	{
+		auto const im = static_cast<size_t>(k);
+		auto const& g = evaluated[im].gradient;
+		auto& F = forces[im];
+		F.resize(g.size());
+		double taulen = len(tau[im]);
+		if (climbing)
+		{
+			double magni = taulen == 0.0 ? 0.0 : dot_uneq(g, tau[im]) / taulen;
+			for (size_t i = 0; i < g.size(); i++) F[i] = g[i] - tau[im][i] * magni * 2.0;
+			continue;
+		}
+		double tauderiv = taulen == 0.0 ? 0.0 : dot_uneq(g, tau[im]) / taulen;
+		if (tauderiv != tauderiv) tauderiv = 0.0;
+		double Rm1mag = len(imagi[im - 1]) - len(imagi[im]);
+		double Rp1mag = len(previous[im + 1]) - len(imagi[im]);
+		if (Rm1mag != Rm1mag) Rm1mag = 0.0;
+		if (Rp1mag != Rp1mag) Rp1mag = 0.0;
+		for (size_t i = 0; i < g.size(); i++)
+		{
+			// perpendicular part of the gradient and spring force along the band
+			F[i] = g[i] - tau[im][i] * tauderiv + tau[im][i] * (springconstant * (Rp1mag - Rm1mag));
 		}
-
-		for (size_t j = 0; j < cPtr->size(); j++)
+		if (Config::get().neb.IDPP)
 		{
-			if (Config::get().neb.IDPP)
-			{
-				auto const g = Fvertical[j] + Fpar[j] + Fidpp[j];
-				cPtr->update_g_xyz(j, g);
-				grad_tot.push_back(g);
-			}
-			else
-			{
-				auto const g = Fvertical[j] + Fpar[j];
-				cPtr->update_g_xyz(j, g);
-				grad_tot.push_back(g);
-
-			}
-
+			auto bond_dummy{ bond_dir(imagi[im]) };
+			auto eu_dummy{ euclid_dist<double>(imagi[im]) };
+			auto const Fi = idpp_gradients<double, dist_T<double>>(bond_dummy, eu_st, eu_dummy, eu_fi, im);
+			for (size_t i = 0; i < g.size(); i++) F[i] += Fi[i];
 		}
-
 	}
+	collect_forces(forces);
 
-	return energytemp;
+	return 2.0 * energies_NEB[num_images - 2];
 }
 
 double neb::g_new_maxflux()
 {
-	double Rp1mag{ 0.0 }, Rm1mag{ 0.0 }, energytemp{ 0.0 }, cosi2{ 0.0 }, kappa{ 0.0 };
-	coords::Cartesian_Point rv_p, rv_n;
-	Rp1.resize(cPtr->size());
-	Rm1.resize(cPtr->size());
-	Fvertical.resize(cPtr->size());
-	Fpar.resize(cPtr->size());
-	grad_tot.clear();
 	calc_tau();
-	for (size_t im = 1; im < num_images - 1; im++)
-	{
-		imagi[im].clear();
-		for (size_t kk = (im - 1) * cPtr->size(); kk < im * cPtr->size(); kk++)  imagi[im].push_back(images_initial[kk]);
 
-		cPtr->set_xyz(imagi[im]);
-		energies_NEB[im] = energytemp = this->cPtr->g();
-		energytemp += energytemp;
-		if (ClimbingImage == true && num_images == static_cast<decltype(num_images)>(CIMaximum))
+	// the following image is projected at its position of the previous call
+	std::vector<coords::Representation_3D> previous;
+	update_images(previous);
+	auto const evaluated = evaluate_images(1u, num_images - 1);
+	for (size_t im = 1; im < num_images - 1; im++) energies_NEB[im] = evaluated[im].energy;
+
+	bool const climbing = ClimbingImage == true && num_images == static_cast<decltype(num_images)>(CIMaximum);
+	std::vector<coords::Representation_3D> forces(num_images);
+	auto const n_images = static_cast<std::ptrdiff_t>(num_images);
+#pragma omp parallel for schedule(dynamic)
+	for (std::ptrdiff_t k = 1; k < n_images - 1; ++k)
+	{
+		auto const im = static_cast<size_t>(k);
+		auto const& g = evaluated[im].gradient;
+		auto const& xyz = evaluated[im].xyz;
+		auto& F = forces[im];
+		F.resize(g.size());
+		double taulen = len(tau[im]);
+		if (climbing)
 		{
-			double magni = 0.0;
-			magni = dot_uneq(cPtr->g_xyz(), tau[im]);
-
-			if (len(tau[im]) == 0.0) { magni = 0.0; }
-			else { magni = magni / len(tau[im]); }
-			for (size_t i = 0; i < cPtr->size(); i++) cPtr->update_g_xyz(i, cPtr->g_xyz(i) - tau[im][i] * magni * 2.0);
+			double magni = taulen == 0.0 ? 0.0 : dot_uneq(g, tau[im]) / taulen;
+			for (size_t i = 0; i < g.size(); i++) F[i] = g[i] - tau[im][i] * magni * 2.0;
 		}
 		else
 		{
-			tauderiv = dot_uneq(cPtr->g_xyz(), tau[im]);
-			if (len(tau[im]) == 0.0) { tauderiv = 0.0; }
-			else { tauderiv /= len(tau[im]); }
+			double tauderiv = taulen == 0.0 ? 0.0 : dot_uneq(g, tau[im]) / taulen;
 			if (tauderiv != tauderiv) tauderiv = 0.0;
-			for (size_t j = 0; j < cPtr->size(); j++)
-			{
-
-				Rm1[j].x() = imagi[im - 1][j].x() - imagi[im][j].x();
-				Rm1[j].y() = imagi[im - 1][j].y() - imagi[im][j].y();
-				Rm1[j].z() = imagi[im - 1][j].z() - imagi[im][j].z();
-
-				Rp1[j].x() = imagi[im + 1][j].x() - imagi[im][j].x();
-				Rp1[j].y() = imagi[im + 1][j].y() - imagi[im][j].y();
-				Rp1[j].z() = imagi[im + 1][j].z() - imagi[im][j].z();
-			}
-			Rm1mag = len(imagi[im - 1]) - len(imagi[im]);
-			Rp1mag = len(imagi[im + 1]) - len(imagi[im]);
+			double Rm1mag = len(imagi[im - 1]) - len(imagi[im]);
+			double Rp1mag = len(previous[im + 1]) - len(imagi[im]);
 			if (Rm1mag != Rm1mag) Rm1mag = 0.0;
 			if (Rp1mag != Rp1mag) Rp1mag = 0.0;
-			for (size_t i = 0; i < cPtr->size(); i++)
+			for (size_t i = 0; i < g.size(); i++)
 			{
-				Fvertical[i].x() = cPtr->g_xyz(i).x() - tauderiv * tau[im][i].x();
-				Fvertical[i].y() = cPtr->g_xyz(i).y() - tauderiv * tau[im][i].y();
-				Fvertical[i].z() = cPtr->g_xyz(i).z() - tauderiv * tau[im][i].z();
-
-				Fpar[i].x() = springconstant * (Rp1mag - Rm1mag) * tau[im][i].x();
-				Fpar[i].y() = springconstant * (Rp1mag - Rm1mag) * tau[im][i].y();
-				Fpar[i].z() = springconstant * (Rp1mag - Rm1mag) * tau[im][i].z();
-
+				F[i] = g[i] - tau[im][i] * tauderiv + tau[im][i] * (springconstant * (Rp1mag - Rm1mag));
 			}
-
 		}
-
-
-		for (size_t i = 0; i < cPtr->size(); i++)
+		for (size_t i = 0; i < g.size(); i++)
 		{
+			coords::Cartesian_Point rv_n, rv_p;
+			double cosi2{ 0.0 };
 			auto L = scon::geometric_length(tau[im][i]);
 			if (L != 0.0)
 			{
-				cosi2 = (cPtr->xyz(i).x() * tau[im][i].x() + cPtr->xyz(i).y() * tau[im][i].y() + cPtr->xyz(i).z() * tau[im][i].z()) / (L * L);
-			}
-			else
-			{
-				cosi2 = 0.0;
+				cosi2 = (xyz[i].x() * tau[im][i].x() + xyz[i].y() * tau[im][i].y() + xyz[i].z() * tau[im][i].z()) / (L * L);
 			}
-			if (cosi2 != cosi2)cosi2 = 0.0;
-			rv_n.x() = cPtr->xyz(i).x() - (cosi2 * tau[im][i].x());
-			rv_n.y() = cPtr->xyz(i).y() - (cosi2 * tau[im][i].y());
-			rv_n.z() = cPtr->xyz(i).z() - (cosi2 * tau[im][i].z());
+			if (cosi2 != cosi2) cosi2 = 0.0;
+			rv_n = xyz[i] - tau[im][i] * cosi2;
 
-			kappa = acos(dot(tau[im - 1][i], tau[im + 1][i])) / (len(imagi[im][i] - imagi[im - 1][i]) + len(imagi[im + 1][i] - imagi[im][i]));
-			if (kappa != kappa)kappa = 0.0;
-			rv_p.x() = (kappa / _KT_) * rv_n.x();
-			rv_p.y() = (kappa / _KT_) * rv_n.y();
-			rv_p.z() = (kappa / _KT_) * rv_n.z();
+			double kappa = acos(dot(tau[im - 1][i], tau[im + 1][i])) / (len(imagi[im][i] - imagi[im - 1][i]) + len(previous[im + 1][i] - imagi[im][i]));
+			if (kappa != kappa) kappa = 0.0;
+			rv_p = rv_n * (kappa / _KT_);
 
-			auto const g = Fpar[i] + Fvertical[i] - rv_p;
-			cPtr->update_g_xyz(i, g);
-			grad_tot.push_back(g);
+			F[i] -= rv_p;
 		}
-
 	}
+	collect_forces(forces);
 
-	return energytemp;
+	return 2.0 * energies_NEB[num_images - 2];
 }
 
 void neb::calc_shift(void)
@@ -26,6 +26,7 @@
 #include <fstream>
 #include <iomanip>
 #include "interpolation.h"
+#include "qm_job_pool.h"
 
 template<typename T>
 using dist_T = std::vector<std::vector<T>>;
@@ -73,6 +74,8 @@ public:
 	void preprocess(ptrdiff_t& image, ptrdiff_t& count, const coords::Representation_3D& start, const coords::Representation_3D& fi, const std::vector <double>& ts_energy, const std::vector <double>& min_energy, bool reverse, const coords::Representation_3D& ts_path);
 	void preprocess(ptrdiff_t& file, ptrdiff_t& image, ptrdiff_t& count, const coords::Representation_3D& start, const coords::Representation_3D& fi, bool reverse);
 	void preprocess(std::vector<coords::Representation_3D>& ini_path, ptrdiff_t& count);
+	/**sets up the band from the images of ini_path (without optimizing it)*/
+	void set_path(std::vector<coords::Representation_3D> const& ini_path);
 	void initial(void);
 	void final(void);
 	void initial(const coords::Representation_3D& start);
@@ -88,6 +91,14 @@ public:
 	void print(std::string const&, std::vector <coords::Representation_3D >&, ptrdiff_t&);
 	void print_rev(std::string const&, std::vector <coords::Representation_3D >&, ptrdiff_t&);
 	void printmono(std::string const&, coords::Representation_3D& print, ptrdiff_t&);
+	/**energies and gradients of the images first ... last - 1 at their positions in imagi,
+	calculated as concurrent jobs (see qm_job_pool.h), by one thread per image for forcefields
+	or one after another (the result of image i is at index i, cPtr is set to the last image)*/
+	std::vector<energy::qm_job_result> evaluate_images(size_t const first, size_t const last);
+	/**moves the inner images to images_initial, previous gets their old positions*/
+	void update_images(std::vector<coords::Representation_3D>& previous);
+	/**concatenates the projected forces of the inner images to grad_tot*/
+	void collect_forces(std::vector<coords::Representation_3D> const& forces);
 	double g_new();
 	double g_new_maxflux();
 	double g_int(std::vector <scon::c3 <float> >  tx);
@@ -188,22 +199,31 @@ public:
 
 private:
 
+	/**sets up the climbing image in the tests*/
+	friend struct neb_test_access;
+
 	std::vector<coords::Representation_3D> bond_st;
-	coords::Representation_3D Fidpp;
 	std::vector<std::vector<double>> eu_st, eu_fi;
 	// IDPP end
 
 	double springconstant;
-	double tauderiv;
 	double EnergyPml, EnergyPpl;
 	const double _KT_;
 
 	ptrdiff_t natoms;
 	ptrdiff_t nvar;
+	/**last image with a higher energy than its predecessor, set by calc_tau*/
 	ptrdiff_t CIMaximum;
 
 	coords::Representation_3D images_initial, grad_tot;
-	coords::Representation_3D images, tempimage_final, tempimage_ini, Rm1, Rp1, Fvertical, Fpar;
+	/**copies of cPtr used to calculate images in parallel*/
+	std::vector<coords::Coordinates> image_workers;
+	/**coordinates, energy interface and number of atoms the copies were made from
+	(they are made again if one of them changes)*/
+	coords::Coordinates const* image_workers_source = nullptr;
+	energy::interface_base const* image_workers_interface = nullptr;
+	size_t image_workers_atoms = 0u;
+	coords::Representation_3D images, tempimage_final, tempimage_ini;
 
 };
 
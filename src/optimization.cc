@@ -6,6 +6,9 @@ template<>
 float const optimization::constants<float>::kB = 0.001987204118f;
 
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <string>
 #include <fstream>
 #include "coords.h"
@@ -75,6 +78,113 @@ void optimization::perform_locopt(coords::Coordinates& coords, coords::input::fo
 	}
 }
 
+optimization::global::Tabu_Fingerprint::Tabu_Fingerprint(coords::PES_Point const& point, coords::Coordinates const& co)
+	: valid(true), n_main(point.structure.main.size()), n_intern(point.structure.intern.size()),
+	n_xyz(point.structure.cartesian.size()), relevant_main(), relevant_intern()
+{
+	// same relevance criteria as in coords::Coordinates::is_equal_structure
+	auto const N = co.size();
+	auto const& atoms = co.atoms();
+	for (std::size_t i = 0; i < n_main; ++i)
+	{
+		if (atoms.atom(atoms.intern_of_main_idihedral(i)).idihedral() < N)
+		{
+			++relevant_main;
+			auto const a = point.structure.main[i].radians();
+			main_cos.add(std::cos(a));
+			main_sin.add(std::sin(a));
+		}
+	}
+	for (std::size_t i = 0; i < n_intern && i < N; ++i)
+	{
+		auto const& atom = atoms.atom(i);
+		if (atom.ibond() < N && atom.iangle() < N && atom.idihedral() < N)
+		{
+			++relevant_intern;
+			auto const& s = point.structure.intern[i];
+			radius.add(s.radius());
+			incl_cos.add(std::cos(s.inclination().radians()));
+			incl_sin.add(std::sin(s.inclination().radians()));
+			azim_cos.add(std::cos(s.azimuth().radians()));
+			azim_sin.add(std::sin(s.azimuth().radians()));
+		}
+	}
+	for (std::size_t i = 0; i < n_xyz; ++i)
+	{
+		auto const& r = point.structure.cartesian[i];
+		x.add(r.x());
+		y.add(r.y());
+		z.add(r.z());
+		if (i >= N) continue;
+		auto const e = std::find(elements.begin(), elements.end(), atoms.atom(i).number());
+		if (e == elements.end())
+		{
+			elements.push_back(atoms.atom(i).number());
+			boxes.emplace_back(r, r);
+			continue;
+		}
+		auto& box = boxes[static_cast<std::size_t>(e - elements.begin())];
+		box.first = coords::Cartesian_Point(std::min(box.first.x(), r.x()), std::min(box.first.y(), r.y()), std::min(box.first.z(), r.z()));
+		box.second = coords::Cartesian_Point(std::max(box.second.x(), r.x()), std::max(box.second.y(), r.y()), std::max(box.second.z(), r.z()));
+	}
+}
+
+bool optimization::global::Tabu_Fingerprint::may_be_equal(Tabu_Fingerprint const& rhs) const
+{
+	if (!valid || !rhs.valid || n_main != rhs.n_main || n_intern != rhs.n_intern || n_xyz != rhs.n_xyz
+		|| Config::get().coords.decouple_internals)
+	{
+		return true;
+	}
+	// if each of n summands differs by at most the tolerance so do the sums by n times the tolerance
+	auto const apart = [](sum const& a, sum const& b, std::size_t const n, double const tolerance)
+	{
+		auto const rounding = 4.0 * std::numeric_limits<double>::epsilon() * (n + 1u) * (a.magnitude + b.magnitude + n);
+		return std::abs(a.value - b.value) > n * std::abs(tolerance) + rounding;
+	};
+	auto const& eq = Config::get().coords.equals;
+	auto const md = eq.main.radians();
+	if (!apart(main_cos, rhs.main_cos, relevant_main, md) && !apart(main_sin, rhs.main_sin, relevant_main, md))
+	{
+		return true;
+	}
+	auto const ir = eq.intern.radius(), ii = eq.intern.inclination().radians(), ia = eq.intern.azimuth().radians();
+	if (!apart(radius, rhs.radius, relevant_intern, ir)
+		&& !apart(incl_cos, rhs.incl_cos, relevant_intern, ii) && !apart(incl_sin, rhs.incl_sin, relevant_intern, ii)
+		&& !apart(azim_cos, rhs.azim_cos, relevant_intern, ia) && !apart(azim_sin, rhs.azim_sin, relevant_intern, ia))
+	{
+		return true;
+	}
+	return !apart(x, rhs.x, n_xyz, eq.xyz.x()) && !apart(y, rhs.y, n_xyz, eq.xyz.y()) && !apart(z, rhs.z, n_xyz, eq.xyz.z());
+}
+
+bool optimization::global::Tabu_Fingerprint::may_superpose(Tabu_Fingerprint const& candidate, double const x) const
+{
+	if (!valid || !candidate.valid || n_xyz != candidate.n_xyz || elements != candidate.elements)
+	{
+		return true;
+	}
+	// every atom has to be closer than x to an atom of the same element in the candidate
+	double const limit(x + 1e-9);
+	for (std::size_t i = 0; i < boxes.size(); ++i)
+	{
+		auto const& a = boxes[i];
+		auto const& b = candidate.boxes[i];
+		if (b.first.x() - a.first.x() >= limit || b.first.y() - a.first.y() >= limit || b.first.z() - a.first.z() >= limit
+			|| a.second.x() - b.second.x() >= limit || a.second.y() - b.second.y() >= limit || a.second.z() - b.second.z() >= limit)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void optimization::global::Tabu_List::add(Tabu_Point point, coords::Coordinates const& co)
+{
+	point.fingerprint = Tabu_Fingerprint(point.pes, co);
+	scon::sorted::insert(*this, point);
+}
+
 bool optimization::global::Tabu_List::tabu(coords::PES_Point const& point, coords::Coordinates const& co) const
 {
 	if (this->empty() || point.energy < (front().pes.energy - 1.0))
@@ -86,15 +196,19 @@ bool optimization::global::Tabu_List::tabu(coords::PES_Point const& point, coord
 		return false;
 	}
 	double const low_bound(point.energy - 1.0), high_bound(point.energy + 1.0);
-	base_type::size_type const sizeOfTabuPointList = this->size();
-	for (base_type::size_type i(0u); i < sizeOfTabuPointList; ++i)
+	// the list is sorted by energy, so only the points inside the window are visited
+	auto it = std::upper_bound(begin(), end(), low_bound,
+		[](double const e, Tabu_Point const& tp) { return e < tp.pes.energy; });
+	if (it == end() || !(it->pes.energy < high_bound))
 	{
-		if ((*this)[i].pes.energy < high_bound && (*this)[i].pes.energy > low_bound)
+		return false;
+	}
+	Tabu_Fingerprint const candidate(point, co);
+	for (; it != end() && it->pes.energy < high_bound; ++it)
+	{
+		if (it->fingerprint.may_be_equal(candidate) && co.is_equal_structure(it->pes, point))
 		{
-			if (co.is_equal_structure((*this)[i].pes, point))
-			{
-				return true;
-			}
+			return true;
 		}
 	}
 	return false;
@@ -103,9 +217,12 @@ bool optimization::global::Tabu_List::tabu(coords::PES_Point const& point, coord
 
 bool optimization::global::Tabu_List::has_superposition(coords::PES_Point const& point, coords::Coordinates const& coord) const
 {
+	if (this->empty()) return false;
+	Tabu_Fingerprint const candidate(point, coord);
 	for (auto const& tp : *this)
 	{
-		if (coord.check_superposition_xyz(tp.pes.structure.cartesian, point.structure.cartesian)) return true;
+		if (tp.fingerprint.may_superpose(candidate)
+			&& coord.check_superposition_xyz(tp.pes.structure.cartesian, point.structure.cartesian)) return true;
 	}
 	return false;
 }
@@ -331,7 +448,7 @@ optimization::global::optimizer::min_status::T optimization::global::optimizer::
 	setTemp(T * Config::get().optimization.global.temp_scale);
 	accepted_log(i, accepted_minima.back().pes);
 	//accepted_iteration.push_back(i);
-	scon::sorted::insert(tabulist, accepted_minima.back());
+	tabulist.add(accepted_minima.back(), coordobj);
 	found_new_minimum = true;
 	return global ? min_status::ACCEPT_GLOBAL_MINIMUM : min_status::ACCEPT_MINIMUM;
 }
@@ -612,7 +729,7 @@ void optimization::global::optimizer::updateRange(coords::PES_Point const& p)
 			range_minima.insert(range_minima.begin() + insertion_point, p);
 			range_iteration.insert(range_iteration.begin() + insertion_point, i);
 		}
-		scon::sorted::insert(range_tabu, Tabu_Point(p));
+		range_tabu.add(Tabu_Point(p), coordobj);
 	}
 }
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <cmath>
+#include <utility>
 #include <random>
 #include <string>
 #include <memory>
@@ -23,6 +25,35 @@ namespace optimization
 			coords::Coordinates* coords;
 		};
 
+		/**sums over the coordinates compared by coords::Coordinates::is_equal_structure
+		and bounding boxes of the atoms of each element, used to skip most of the
+		full comparisons in Tabu_List::tabu and Tabu_List::has_superposition*/
+		struct Tabu_Fingerprint
+		{
+			/**value and sum of the absolute values of the summands (for the rounding error)*/
+			struct sum
+			{
+				double value, magnitude;
+				sum() : value(), magnitude() {}
+				void add(double const x) { value += x; magnitude += std::abs(x); }
+			};
+			bool valid;
+			/**sizes of the main, internal and cartesian representations*/
+			std::size_t n_main, n_intern, n_xyz;
+			/**number of main torsions and internal coordinates relevant for the comparison*/
+			std::size_t relevant_main, relevant_intern;
+			sum main_cos, main_sin, radius, incl_cos, incl_sin, azim_cos, azim_sin, x, y, z;
+			/**atomic numbers and lowest / highest position of their atoms*/
+			std::vector<std::size_t> elements;
+			std::vector<std::pair<coords::Cartesian_Point, coords::Cartesian_Point>> boxes;
+			Tabu_Fingerprint() : valid(false), n_main(), n_intern(), n_xyz(), relevant_main(), relevant_intern() {}
+			Tabu_Fingerprint(coords::PES_Point const&, coords::Coordinates const&);
+			/**false only if coords::Coordinates::is_equal_structure is false for the two points*/
+			bool may_be_equal(Tabu_Fingerprint const&) const;
+			/**false only if coords::Coordinates::check_superposition_xyz(this, candidate) is false*/
+			bool may_superpose(Tabu_Fingerprint const& candidate, double const x = 0.35) const;
+		};
+
 		struct Tabu_Point
 		{
 			coords::PES_Point pes;
@@ -30,6 +61,7 @@ namespace optimization
 			std::vector<coords::Representation_Internal> intern_direction;
 			std::vector<coords::Representation_3D> xyz_direction;
 			std::size_t visited, iteration;
+			Tabu_Fingerprint fingerprint;
 			Tabu_Point() : visited(0), iteration() {}
 			Tabu_Point(coords::PES_Point const& pes_point, std::size_t const iter = 0)
 				: pes(pes_point), visited(0), iteration(iter)
@@ -41,6 +73,7 @@ namespace optimization
 				intern_direction.swap(rhs.intern_direction);
 				xyz_direction.swap(rhs.xyz_direction);
 				std::swap(visited, rhs.visited);
+				std::swap(fingerprint, rhs.fingerprint);
 			}
 			operator coords::PES_Point() const { return pes; }
 		};
@@ -54,6 +87,10 @@ namespace optimization
 			: public std::vector<Tabu_Point>
 		{
 			typedef std::vector<Tabu_Point> base_type;
+			/**inserts the point (sorted by energy) and computes its fingerprint*/
+			void add(Tabu_Point point, coords::Coordinates const&);
+			/**true if a point within 1 kcal/mol is equal to the given one,
+			the list has to be sorted by energy*/
 			bool tabu(coords::PES_Point const&, coords::Coordinates const&) const;
 			bool has_superposition(coords::PES_Point const&, coords::Coordinates const&) const;
 			void clear_above_e(coords::float_type const minimum, coords::float_type const kT);
@@ -0,0 +1,345 @@
+#include "qm_job_pool.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <experimental/filesystem>
+
+#if !defined(_MSC_VER)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "configuration.h"
+#include "qm_worker.h"
+
+namespace fs = std::experimental::filesystem;
+
+namespace
+{
+	energy::qm_job_result calculate(coords::Coordinates& c, coords::Representation_3D const& xyz, energy::qm_job_types::T const type)
+	{
+		energy::qm_job_result r;
+		c.set_xyz(xyz, true);
+		switch (type)
+		{
+		case energy::qm_job_types::ENERGY:
+			r.energy = c.e();
+			break;
+		case energy::qm_job_types::GRADIENT:
+			r.energy = c.g();
+			break;
+		default:
+			r.energy = c.o();
+		}
+		r.integrity = c.integrity();
+		r.gradient = c.g_xyz();
+		r.xyz = c.xyz();
+		r.ok = true;
+		return r;
+	}
+
+	template<typename T>
+	void append(std::string& data, T const& value)
+	{
+		data.append(reinterpret_cast<char const*>(&value), sizeof(T));
+	}
+
+	void append(std::string& data, coords::Representation_3D const& xyz)
+	{
+		append(data, static_cast<std::uint64_t>(xyz.size()));
+		for (auto const& p : xyz)
+		{
+			append(data, static_cast<double>(p.x()));
+			append(data, static_cast<double>(p.y()));
+			append(data, static_cast<double>(p.z()));
+		}
+	}
+
+	template<typename T>
+	bool extract(std::string const& data, std::size_t& pos, T& value)
+	{
+		if (data.size() < pos + sizeof(T)) return false;
+		std::memcpy(&value, data.data() + pos, sizeof(T));
+		pos += sizeof(T);
+		return true;
+	}
+
+	bool extract(std::string const& data, std::size_t& pos, coords::Representation_3D& xyz)
+	{
+		std::uint64_t n(0u);
+		if (!extract(data, pos, n) || data.size() < pos + n * 3u * sizeof(double)) return false;
+		xyz.resize(static_cast<std::size_t>(n));
+		for (auto& p : xyz)
+		{
+			double x, y, z;
+			extract(data, pos, x);
+			extract(data, pos, y);
+			extract(data, pos, z);
+			p = coords::Cartesian_Point(x, y, z);
+		}
+		return true;
+	}
+
+	/**result as sent from a job process to the pool*/
+	std::string serialize(energy::qm_job_result const& r)
+	{
+		std::string data;
+		append(data, static_cast<std::uint8_t>(r.ok));
+		if (!r.ok)
+		{
+			append(data, static_cast<std::uint64_t>(r.error.size()));
+			data += r.error;
+			return data;
+		}
+		append(data, static_cast<std::uint8_t>(r.integrity));
+		append(data, static_cast<double>(r.energy));
+		append(data, r.gradient);
+		append(data, r.xyz);
+		return data;
+	}
+
+	/**makes the words of a path or command line which name an existing file or directory
+	relative to the working directory absolute, the jobs run in their scratch directories*/
+	void make_absolute(std::string& command)
+	{
+		std::string result;
+		std::size_t pos(0u);
+		while (pos < command.size())
+		{
+			auto const begin = command.find_first_not_of(" \t", pos);
+			result.append(command, pos, (begin == std::string::npos ? command.size() : begin) - pos);
+			if (begin == std::string::npos) break;
+			auto end = command.find_first_of(" \t", begin);
+			if (end == std::string::npos) end = command.size();
+			fs::path const word(command.substr(begin, end - begin));
+			std::error_code ec;
+			if (word.is_relative() && fs::exists(word, ec)) result += (fs::current_path() / word).string();
+			else result += word.string();
+			pos = end;
+		}
+		command = result;
+	}
+
+	/**energy configuration with absolute paths to programs, drivers and parameter files*/
+	config::energy job_energy_config()
+	{
+		auto e = Config::get().energy;
+		for (auto* path : { &e.mopac.path, &e.dftbaby.path, &e.dftb.path, &e.dftb.sk_files, &e.orca.path,
+			&e.gaussian.path, &e.chemshell.path, &e.chemshell.babel_path, &e.chemshell.extra_pdb,
+			&e.chemshell.optional_inpcrd, &e.chemshell.optional_prmtop, &e.psi4.path, &e.qm_worker.driver })
+		{
+			make_absolute(*path);
+		}
+		return e;
+	}
+
+	energy::qm_job_result deserialize(std::string const& data)
+	{
+		energy::qm_job_result r;
+		std::size_t pos(0u);
+		std::uint8_t ok(0u), integrity(0u);
+		if (!extract(data, pos, ok))
+		{
+			r.error = "Job process died without result.";
+			return r;
+		}
+		if (ok == 0u)
+		{
+			std::uint64_t n(0u);
+			if (extract(data, pos, n) && data.size() >= pos + n) r.error.assign(data, pos, static_cast<std::size_t>(n));
+			return r;
+		}
+		double e(0.0);
+		if (extract(data, pos, integrity) && extract(data, pos, e) && extract(data, pos, r.gradient) && extract(data, pos, r.xyz))
+		{
+			r.ok = true;
+			r.integrity = integrity != 0u;
+			r.energy = e;
+		}
+		else r.error = "Incomplete result of job process.";
+		return r;
+	}
+}
+
+energy::qm_job_pool::qm_job_pool(coords::Coordinates const& c, std::size_t const jobs)
+	: coords(&c), max_jobs(jobs > 0u ? jobs : 1u), batches(0u)
+{ }
+
+std::vector<energy::qm_job_result> energy::qm_job_pool::run_sequential(std::vector<coords::Representation_3D> const& structures,
+	qm_job_types::T const type, std::function<void(std::size_t, qm_job_result const&)> const& done) const
+{
+	std::vector<qm_job_result> results(structures.size());
+	coords::Coordinates c(*coords);
+	for (std::size_t i = 0u; i < structures.size(); ++i)
+	{
+		try
+		{
+			results[i] = calculate(c, structures[i], type);
+		}
+		catch (std::exception const& e)
+		{
+			results[i].error = e.what();
+		}
+		catch (...)
+		{
+			results[i].error = "Unknown exception.";
+		}
+		if (done) done(i, results[i]);
+	}
+	return results;
+}
+
+#if !defined(_MSC_VER)
+
+std::vector<energy::qm_job_result> energy::qm_job_pool::run(std::vector<coords::Representation_3D> const& structures,
+	qm_job_types::T const type, std::function<void(std::size_t, qm_job_result const&)> const& done)
+{
+	if (max_jobs < 2u || structures.size() < 2u) return run_sequential(structures, type, done);
+
+	struct job
+	{
+		pid_t pid;
+		int fd;
+		std::size_t index;
+		std::string data;
+		fs::path dir;
+	};
+
+	std::vector<qm_job_result> results(structures.size());
+	std::vector<job> running;
+	std::string const prefix("cast_job_" + std::to_string(::getpid()) + "_" + std::to_string(batches++) + "_");
+	std::size_t next(0u);
+	// relative paths would be resolved against the scratch directories
+	auto const energy_config = job_energy_config();
+
+	auto start = [&](std::size_t const i)
+	{
+		std::string const name(prefix + std::to_string(i));
+		fs::path const dir(fs::current_path() / name);
+		fs::create_directories(dir);
+		int fds[2];
+		if (::pipe(fds) != 0) throw std::runtime_error("Creating a pipe for a QM job failed.");
+		::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+		::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+		std::cout.flush();
+		auto qm_lock = energy::lock_qm_call();
+		auto const pid = ::fork();
+		// the forking thread owns the lock in both processes
+		qm_lock.unlock();
+		if (pid < 0)
+		{
+			::close(fds[0]);
+			::close(fds[1]);
+			throw std::runtime_error("Starting a QM job failed.");
+		}
+		if (pid == 0)
+		{
+			// job process: works in its own directory with its own QM driver
+			::close(fds[0]);
+			energy::detach_qm_worker();
+#ifdef _OPENMP
+			omp_set_num_threads(1);
+#endif
+			qm_job_result r;
+			try
+			{
+				Config::set().energy = energy_config;
+				fs::current_path(dir);
+				coords::Coordinates c(*coords);
+				c.energyinterface()->id = name;
+				r = calculate(c, structures[i], type);
+			}
+			catch (std::exception const& e)
+			{
+				r.ok = false;
+				r.error = e.what();
+			}
+			catch (...)
+			{
+				r.ok = false;
+				r.error = "Unknown exception.";
+			}
+			std::cout.flush();
+			auto const data = serialize(r);
+			for (std::size_t sent = 0u; sent < data.size(); )
+			{
+				auto const n = ::write(fds[1], data.data() + sent, data.size() - sent);
+				if (n < 0 && errno == EINTR) continue;
+				if (n <= 0) break;
+				sent += static_cast<std::size_t>(n);
+			}
+			::_exit(0);
+		}
+		::close(fds[1]);
+		running.push_back(job{ pid, fds[0], i, std::string(), dir });
+	};
+
+	auto finish = [&](job& j)
+	{
+		::close(j.fd);
+		::waitpid(j.pid, nullptr, 0);
+		results[j.index] = deserialize(j.data);
+		std::error_code ec;
+		// directories of failed jobs are kept for inspection
+		if (results[j.index].ok) fs::remove_all(j.dir, ec);
+		else if (Config::get().general.verbosity > 1U)
+		{
+			std::cout << "QM job " << j.index << " failed: " << results[j.index].error
+				<< " (files kept in " << j.dir.string() << ")\n";
+		}
+		if (done) done(j.index, results[j.index]);
+	};
+
+	while (next < structures.size() || !running.empty())
+	{
+		while (running.size() < max_jobs && next < structures.size()) start(next++);
+		std::vector<pollfd> fds;
+		for (auto const& j : running) fds.push_back(pollfd{ j.fd, POLLIN, 0 });
+		if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0)
+		{
+			if (errno == EINTR) continue;
+			throw std::runtime_error("Waiting for QM jobs failed.");
+		}
+		for (std::size_t k = fds.size(); k-- > 0u; )
+		{
+			if (fds[k].revents == 0) continue;
+			char chunk[65536];
+			auto const n = ::read(running[k].fd, chunk, sizeof(chunk));
+			if (n < 0 && errno == EINTR) continue;
+			if (n > 0)
+			{
+				running[k].data.append(chunk, static_cast<std::size_t>(n));
+				continue;
+			}
+			finish(running[k]);
+			running.erase(running.begin() + static_cast<std::ptrdiff_t>(k));
+		}
+	}
+	return results;
+}
+
+#else
+
+std::vector<energy::qm_job_result> energy::qm_job_pool::run(std::vector<coords::Representation_3D> const& structures,
+	qm_job_types::T const type, std::function<void(std::size_t, qm_job_result const&)> const& done)
+{
+	// no fork on Windows
+	return run_sequential(structures, type, done);
+}
+
+#endif
+
+bool energy::use_qm_job_pool()
+{
+	return Config::get().energy.qm_worker.jobs > 1u;
+}
@@ -0,0 +1,72 @@
+/**
+CAST 3
+qm_job_pool.h
+Purpose:
+Concurrent energy / gradient / optimization jobs for batches of structures.
+Task drivers which evaluate several independent structures (e.g. NEB images)
+submit them as a batch. Up to Config::get().energy.qm_worker.jobs jobs run at the
+same time, each one in a forked process working in its own scratch directory
+with a unique interface id, so the input and output files of external QM programs
+do not collide. Results are collected as the jobs complete.
+
+@version 1.0
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "coords.h"
+
+namespace energy
+{
+	/**what is calculated for the structures of a batch*/
+	struct qm_job_types { enum T { ENERGY, GRADIENT, OPTIMIZATION }; };
+
+	/**result of one structure of a batch*/
+	struct qm_job_result
+	{
+		/**job finished (false if it threw or its process died)*/
+		bool ok = false;
+		/**integrity of the structure after the calculation*/
+		bool integrity = false;
+		coords::float_type energy = 0.0;
+		/**cartesian gradients (ENERGY jobs: gradients of the interface after the call)*/
+		coords::Gradients_3D gradient;
+		/**structure after the job (changed by OPTIMIZATION jobs)*/
+		coords::Representation_3D xyz;
+		/**error message if the job failed*/
+		std::string error;
+	};
+
+	/**runs batches of jobs with copies of a coordinates object*/
+	class qm_job_pool
+	{
+	public:
+		/**@param c: coordinates (atoms, energy interface) used for the jobs
+		@param max_jobs: maximum number of concurrent jobs (1: jobs run one after another in this process)*/
+		qm_job_pool(coords::Coordinates const& c, std::size_t const max_jobs);
+
+		/**calculates all structures, the results are in the order of the structures
+		@param done: called in this thread for every finished job with its index (in the order of completion)*/
+		std::vector<qm_job_result> run(std::vector<coords::Representation_3D> const& structures, qm_job_types::T const type,
+			std::function<void(std::size_t, qm_job_result const&)> const& done = nullptr);
+
+		std::size_t jobs() const { return max_jobs; }
+
+	private:
+		std::vector<qm_job_result> run_sequential(std::vector<coords::Representation_3D> const& structures,
+			qm_job_types::T const type, std::function<void(std::size_t, qm_job_result const&)> const& done) const;
+
+		coords::Coordinates const* coords;
+		std::size_t max_jobs;
+		/**number of batches run so far (part of the scratch directory names)*/
+		std::size_t batches;
+	};
+
+	/**true if batches should be calculated by a qm_job_pool (Config::get().energy.qm_worker.jobs > 1)*/
+	bool use_qm_job_pool();
+}
@@ -0,0 +1,325 @@
+#include "qm_worker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if !defined(_MSC_VER)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "configuration.h"
+#include "Scon/scon_utility.h"
+
+energy::qm_worker::qm_worker(std::string const& driver_command, double const timeout_seconds, std::size_t const restarts)
+	: driver(driver_command), timeout(timeout_seconds), max_restarts(restarts), n_restarts(0u), pid(0), sock(-1), buffer()
+{
+	if (driver.empty()) throw std::logic_error("No command given for the QM driver.");
+}
+
+#if !defined(_MSC_VER)
+
+energy::qm_worker::~qm_worker()
+{
+	if (pid <= 0) return;
+	// the driver is expected to exit at the end of its input
+	::close(sock);
+	sock = -1;
+	for (int i = 0; i < 200; ++i)
+	{
+		if (::waitpid(pid, nullptr, WNOHANG) == pid)
+		{
+			pid = 0;
+			return;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	kill();
+}
+
+void energy::qm_worker::start()
+{
+	int fds[2];
+#if defined(SOCK_CLOEXEC)
+	if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+#else
+	if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+#endif
+		throw std::runtime_error("Creating the socket for the QM driver failed.");
+	::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#if defined(SO_NOSIGPIPE)
+	int const one(1);
+	::setsockopt(fds[0], SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+	auto const child = ::fork();
+	if (child < 0)
+	{
+		::close(fds[0]);
+		::close(fds[1]);
+		throw std::runtime_error("Starting the QM driver '" + driver + "' failed.");
+	}
+	if (child == 0)
+	{
+		// own process group, so the driver and everything it started can be killed at once
+		::setpgid(0, 0);
+		::dup2(fds[1], 0);
+		::dup2(fds[1], 1);
+		::execl("/bin/sh", "sh", "-c", driver.c_str(), static_cast<char*>(nullptr));
+		::_exit(127);
+	}
+	::setpgid(child, child);
+	::close(fds[1]);
+	sock = fds[0];
+	pid = static_cast<int>(child);
+	buffer.clear();
+}
+
+void energy::qm_worker::kill()
+{
+	if (pid > 0)
+	{
+		::kill(-pid, SIGKILL);
+		::kill(pid, SIGKILL);
+		::waitpid(pid, nullptr, 0);
+		pid = 0;
+	}
+	if (sock >= 0) ::close(sock);
+	sock = -1;
+	buffer.clear();
+}
+
+void energy::qm_worker::detach()
+{
+	// the driver belongs to another process, only the copy of the socket is closed
+	if (sock >= 0) ::close(sock);
+	sock = -1;
+	pid = 0;
+	buffer.clear();
+}
+
+bool energy::qm_worker::request(std::string const& message, int& status, std::vector<std::string>& answer)
+{
+#if defined(MSG_NOSIGNAL)
+	int const flags(MSG_NOSIGNAL);
+#else
+	int const flags(0);
+#endif
+	answer.clear();
+	for (std::size_t sent = 0u; sent < message.size(); )
+	{
+		auto const n = ::send(sock, message.data() + sent, message.size() - sent, flags);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;
+		sent += static_cast<std::size_t>(n);
+	}
+	using clock = std::chrono::steady_clock;
+	auto const deadline = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(timeout));
+	for (;;)
+	{
+		for (std::size_t end = buffer.find('\n'); end != std::string::npos; end = buffer.find('\n'))
+		{
+			std::string line(buffer, 0u, end);
+			buffer.erase(0u, end + 1u);
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (line.compare(0u, 5u, "DONE ") == 0)
+			{
+				status = std::atoi(line.c_str() + 5);
+				return true;
+			}
+			answer.push_back(std::move(line));
+		}
+		int wait_ms(-1);
+		if (timeout > 0.0)
+		{
+			auto const left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+			if (left <= 0) return false;
+			wait_ms = static_cast<int>(std::min<long long>(left, 1000000000LL));
+		}
+		pollfd p{ sock, POLLIN, 0 };
+		auto const ready = ::poll(&p, 1, wait_ms);
+		if (ready < 0 && errno == EINTR) continue;
+		if (ready == 0) return false;
+		char chunk[4096];
+		auto const n = ::recv(sock, chunk, sizeof(chunk), 0);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;   // driver died
+		buffer.append(chunk, static_cast<std::size_t>(n));
+	}
+}
+
+int energy::qm_worker::call(std::string const& message, std::string const& description, std::vector<std::string>& answer)
+{
+	for (std::size_t attempt = 0u; ; ++attempt)
+	{
+		if (pid <= 0) start();
+		int status(0);
+		if (request(message, status, answer)) return status;
+		kill();
+		if (attempt >= max_restarts)
+		{
+			std::cout << "QM driver '" << driver << "' failed " << attempt + 1u << " times running '" << description << "'.\n";
+			return -1;
+		}
+		++n_restarts;
+		if (Config::get().general.verbosity > 1U)
+		{
+			std::cout << "QM driver '" << driver << "' crashed or timed out. Restarting it.\n";
+		}
+	}
+}
+
+#else
+
+energy::qm_worker::~qm_worker() { }
+
+void energy::qm_worker::detach() { }
+
+void energy::qm_worker::start()
+{
+	throw std::runtime_error("Persistent QM drivers are not supported on Windows.");
+}
+
+void energy::qm_worker::kill() { }
+
+bool energy::qm_worker::request(std::string const&, int&, std::vector<std::string>&)
+{
+	return false;
+}
+
+int energy::qm_worker::call(std::string const&, std::string const&, std::vector<std::string>&)
+{
+	start();
+	return -1;
+}
+
+#endif
+
+int energy::qm_worker::run(std::string const& command)
+{
+	std::string cmd(command);
+	std::replace(cmd.begin(), cmd.end(), '\n', ' ');
+	std::vector<std::string> answer;
+	return call("RUN " + cmd + "\n", cmd, answer);
+}
+
+namespace
+{
+	/**reads three numbers behind a keyword*/
+	bool read_vector(std::string const& line, std::size_t const keyword_length, std::array<double, 3>& v)
+	{
+		std::istringstream in(line.substr(keyword_length));
+		return static_cast<bool>(in >> v[0] >> v[1] >> v[2]);
+	}
+}
+
+int energy::qm_worker::evaluate(qm_geometry const& geometry, qm_result& result)
+{
+	if (geometry.symbols.size() != geometry.xyz.size())
+		throw std::logic_error("Number of element symbols and positions sent to the QM driver differ.");
+	std::ostringstream message;
+	message << std::setprecision(17);
+	message << "GEOMETRY " << geometry.xyz.size() << ' ' << geometry.point_charges.size() << ' '
+		<< geometry.charge << ' ' << (geometry.gradients ? 1 : 0) << '\n';
+	for (std::size_t i = 0u; i < geometry.xyz.size(); ++i)
+	{
+		message << geometry.symbols[i] << ' ' << geometry.xyz[i][0] << ' ' << geometry.xyz[i][1] << ' ' << geometry.xyz[i][2] << '\n';
+	}
+	for (auto const& q : geometry.point_charges)
+	{
+		message << q[0] << ' ' << q[1] << ' ' << q[2] << ' ' << q[3] << '\n';
+	}
+
+	std::vector<std::string> answer;
+	auto const status = call(message.str(), "GEOMETRY", answer);
+	if (status != 0) return status;
+
+	result = qm_result();
+	bool has_energy(false), complete(true);
+	for (auto const& line : answer)
+	{
+		std::array<double, 3> v;
+		if (line.compare(0u, 7u, "ENERGY ") == 0)
+		{
+			std::istringstream in(line.substr(7u));
+			has_energy = static_cast<bool>(in >> result.energy);
+		}
+		else if (line.compare(0u, 9u, "GRADIENT ") == 0)
+		{
+			complete = read_vector(line, 9u, v) && complete;
+			result.gradients.push_back(v);
+		}
+		else if (line.compare(0u, 15u, "CHARGEGRADIENT ") == 0)
+		{
+			complete = read_vector(line, 15u, v) && complete;
+			result.charge_gradients.push_back(v);
+		}
+		else if (line.compare(0u, 7u, "CHARGE ") == 0)
+		{
+			result.partial_charges.push_back(std::atof(line.c_str() + 7));
+		}
+	}
+	if (geometry.gradients)
+	{
+		complete = complete && result.gradients.size() == geometry.xyz.size()
+			&& result.charge_gradients.size() == geometry.point_charges.size();
+	}
+	if (!result.partial_charges.empty() && result.partial_charges.size() != geometry.xyz.size()) complete = false;
+	if (!has_energy || !complete)
+	{
+		std::cout << "QM driver '" << driver << "' sent an incomplete answer to GEOMETRY.\n";
+		return -1;
+	}
+	return 0;
+}
+
+namespace
+{
+	// one driver for all interfaces, they work in the same directory
+	std::mutex qm_call_mutex;
+	std::unique_ptr<energy::qm_worker> qm_call_worker;
+}
+
+int energy::qm_call(std::string const& command)
+{
+	auto const& conf = Config::get().energy.qm_worker;
+	if (conf.driver.empty()) return scon::system_call(command);
+	std::lock_guard<std::mutex> lock(qm_call_mutex);
+	if (!qm_call_worker) qm_call_worker.reset(new qm_worker(conf.driver, conf.timeout, conf.restarts));
+	return qm_call_worker->run(command);
+}
+
+int energy::qm_evaluate(qm_geometry const& geometry, qm_result& result)
+{
+	auto const& conf = Config::get().energy.qm_worker;
+	if (conf.driver.empty()) throw std::logic_error("Sending structures to a QM driver needs QMWORKERdriver.");
+	std::lock_guard<std::mutex> lock(qm_call_mutex);
+	if (!qm_call_worker) qm_call_worker.reset(new qm_worker(conf.driver, conf.timeout, conf.restarts));
+	return qm_call_worker->evaluate(geometry, result);
+}
+
+std::unique_lock<std::mutex> energy::lock_qm_call()
+{
+	return std::unique_lock<std::mutex>(qm_call_mutex);
+}
+
+void energy::detach_qm_worker()
+{
+	// the driver belongs to the parent process
+	if (qm_call_worker) qm_call_worker->detach();
+	qm_call_worker.reset();
+}
@@ -0,0 +1,135 @@
+/**
+CAST 3
+qm_worker.h
+Purpose:
+Persistent driver processes for external QM programs.
+Instead of spawning a shell and the QM program for every energy evaluation
+the command lines of the interfaces (MOPAC, DFTB+, ORCA, Gaussian, Psi4, ChemShell)
+are sent to a driver process which is kept alive across calls.
+With RUN the driver still has to start the QM program for every call,
+only the shell started by CAST is saved.
+
+Protocol (one line each, over stdin / stdout of the driver):
+  CAST -> driver:  RUN <command line>
+  driver -> CAST:  DONE <exit status>
+Only the DFTB+ interface (with QMWORKERgeometry) sends the structure itself
+instead of writing an input file and starting the program,
+so only there the driver can keep the program (or its library) loaded between the steps:
+  CAST -> driver:  GEOMETRY <atoms> <point charges> <total charge> <0: energy, 1: energy and gradients>
+                   <symbol> <x> <y> <z>            one line per atom (Angstrom)
+                   <x> <y> <z> <charge>            one line per external point charge (Angstrom)
+  driver -> CAST:  ENERGY <energy>                 (hartree)
+                   GRADIENT <x> <y> <z>            one line per atom (hartree / bohr), if requested
+                   CHARGEGRADIENT <x> <y> <z>      one line per point charge, if requested
+                   CHARGE <q>                      optional, one line per atom (partial charges)
+                   DONE <exit status>
+Other lines written by the driver are ignored.
+The driver is restarted if it dies or does not answer within the timeout.
+A mock driver is found in optional_files/build/test_files/mock_qm_driver.sh.
+
+@version 1.0
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace energy
+{
+	/**structure sent to the driver with the GEOMETRY message*/
+	struct qm_geometry
+	{
+		/**element symbols of the atoms*/
+		std::vector<std::string> symbols;
+		/**positions of the atoms (Angstrom)*/
+		std::vector<std::array<double, 3>> xyz;
+		/**external point charges: position (Angstrom) and charge*/
+		std::vector<std::array<double, 4>> point_charges;
+		/**total charge of the system*/
+		int charge = 0;
+		/**are gradients needed?*/
+		bool gradients = false;
+	};
+
+	/**answer of the driver to the GEOMETRY message (atomic units)*/
+	struct qm_result
+	{
+		/**energy (hartree)*/
+		double energy = 0.0;
+		/**gradients of the atoms (hartree / bohr)*/
+		std::vector<std::array<double, 3>> gradients;
+		/**gradients of the external point charges (hartree / bohr)*/
+		std::vector<std::array<double, 3>> charge_gradients;
+		/**partial charges of the atoms (empty if the driver does not send them)*/
+		std::vector<double> partial_charges;
+	};
+
+	/**driver process which runs the command lines of a QM interface*/
+	class qm_worker
+	{
+	public:
+		/**@param driver_command: shell command starting the driver
+		@param timeout_seconds: maximum time for one call (0: no limit)
+		@param max_restarts: restarts of the driver per call before the call fails*/
+		qm_worker(std::string const& driver_command, double const timeout_seconds, std::size_t const max_restarts);
+		/**closes the input of the driver and terminates it if it does not exit*/
+		~qm_worker();
+
+		qm_worker(qm_worker const&) = delete;
+		qm_worker& operator=(qm_worker const&) = delete;
+
+		/**runs a command line in the driver (which is started if necessary)
+		@return: exit status reported by the driver, -1 if the driver failed after all restarts*/
+		int run(std::string const& command);
+		/**sends a structure to the driver and reads energy and gradients
+		@return: exit status reported by the driver, -1 if the driver failed after all restarts
+		or its answer is incomplete*/
+		int evaluate(qm_geometry const& geometry, qm_result& result);
+		/**forgets the driver without stopping it and closes the socket (in a forked process)*/
+		void detach();
+		/**process id of the running driver (0 if not running)*/
+		long driver_pid() const { return static_cast<long>(pid); }
+		/**number of restarts of the driver after a crash or timeout*/
+		std::size_t restarts() const { return n_restarts; }
+
+	private:
+		void start();
+		/**kills the driver (and the processes it started)*/
+		void kill();
+		/**sends a message and waits for the answer, false if the driver died or timed out
+		@param answer: the lines received before DONE*/
+		bool request(std::string const& message, int& status, std::vector<std::string>& answer);
+		/**sends a message (restarting the driver if needed)
+		@param description: shown if the call fails*/
+		int call(std::string const& message, std::string const& description, std::vector<std::string>& answer);
+
+		std::string driver;
+		double timeout;
+		std::size_t max_restarts, n_restarts;
+		int pid;
+		/**socket connected to stdin and stdout of the driver*/
+		int sock;
+		/**received data which is not a complete line yet*/
+		std::string buffer;
+	};
+
+	/**runs a QM program: through the persistent driver if Config::get().energy.qm_worker.driver is set,
+	with scon::system_call otherwise
+	@return: exit status of the command*/
+	int qm_call(std::string const& command);
+
+	/**sends a structure to the driver of Config::get().energy.qm_worker.driver (see qm_worker::evaluate)*/
+	int qm_evaluate(qm_geometry const& geometry, qm_result& result);
+
+	/**locks the driver of qm_call and qm_evaluate, held while forking so that
+	the forked process does not inherit a lock owned by another thread*/
+	std::unique_lock<std::mutex> lock_qm_call();
+
+	/**forgets the driver of qm_call in a forked process without stopping it
+	and closes the inherited socket, the process starts its own driver when needed (see qm_job_pool.h)*/
+	void detach_qm_worker();
+}
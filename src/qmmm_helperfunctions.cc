@@ -1,4 +1,5 @@
 #include"qmmm_helperfunctions.h"
+#include"Scon/scon_linkedcell.h"
 
 
 std::vector<LinkAtom> qmmm_helpers::create_link_atoms(std::vector<size_t> const& qm_indices, coords::Coordinates* coords,
@@ -376,6 +377,37 @@ void qmmm_helpers::add_external_charges(std::vector<size_t> const& ignore_indize
 	}
 }
 
+std::vector<std::vector<std::size_t>> qmmm_helpers::find_mm_atoms_near_qm(coords::Representation_3D const& xyz, std::vector<std::size_t> const& qm_indices,
+	std::vector<std::size_t> const& mm_indices, double const cutoff)
+{
+	std::vector<std::vector<std::size_t>> result(qm_indices.size());
+	if (cutoff > 500.0)   // no linked cell algorithm for large cutoffs (same as for forcefield pairlists)
+	{
+		for (auto& r : result) r = mm_indices;
+		return result;
+	}
+
+	std::vector<bool> is_mm(xyz.size(), false);
+	for (auto j : mm_indices) is_mm[j] = true;
+
+	using cells_type = scon::linked::Cells<coords::float_type, coords::Cartesian_Point, coords::Representation_3D>;
+	cells_type const cells(xyz, cutoff, Config::get().periodics.periodic, Config::get().periodics.pb_box,
+		coords::float_type(0), scon::linked::fragmentation::half);
+
+	std::ptrdiff_t const Q(qm_indices.size());
+#pragma omp parallel for schedule(dynamic)
+	for (std::ptrdiff_t a = 0; a < Q; ++a)
+	{
+		auto box_of_qm = cells.box_of_element(qm_indices[a]);
+		for (auto j : box_of_qm.adjacencies())
+		{
+			if (j >= 0 && is_mm[static_cast<std::size_t>(j)]) result[a].push_back(static_cast<std::size_t>(j));
+		}
+		std::sort(result[a].begin(), result[a].end());   // same order as in mm_indices
+	}
+	return result;
+}
+
 void qmmm_helpers::save_outputfiles(config::interface_types::T const& interface, std::string const& id, std::string const& systemname)
 {
 	if (interface == config::interface_types::T::DFTB && Config::get().energy.dftb.verbosity > 0)
@@ -192,6 +192,17 @@ namespace qmmm_helpers
 	void add_external_charges(std::vector<size_t> const& ignore_indizes, std::vector<double> const& charges, std::vector<size_t> const& indizes_of_charges,
 		std::vector<LinkAtom> const& link_atoms, std::vector<int>& charge_indizes, coords::Coordinates* coords, std::size_t const QMcenter);
 
+	/**finds the MM atoms that might be closer than a cutoff to the QM atoms (linked cell algorithm,
+	with periodic boundaries the cells wrap around the box)
+	every MM atom within the cutoff of a QM atom is found, some of the returned atoms might be further away
+	@param xyz: positions of all atoms
+	@param qm_indices: indizes of QM atoms
+	@param mm_indices: indizes of MM atoms (sorted)
+	@param cutoff: cutoff distance
+	returns one vector of MM atom indices (sorted) for every QM atom*/
+	std::vector<std::vector<std::size_t>> find_mm_atoms_near_qm(coords::Representation_3D const& xyz, std::vector<std::size_t> const& qm_indices,
+		std::vector<std::size_t> const& mm_indices, double const cutoff);
+
 	/**renames outputfiles for calculations with external energyinterfaces to prevent them from being overwritten
 	@param interface: energy interface for which files should be renamed (can be DFTB, MOPAC, ORCA, GAUSSIAN or PSI4)
 	@param id: id from which filesnames in that interface are created (should be member of energy interface)
@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <memory>
 #include <stdexcept>
 #include <utility>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 #include "Scon/scon_linkedcell.h"
 #include "tinker_refine.h"
 #include "tinker_parameters.h"
@@ -555,12 +561,45 @@ void tinker::refine::refined::refine_nb(coords::Coordinates const& coords)
 	else if (m_cparams.vdwc_used(R15)) build_pairs_direct<R15>(coords);
 	else build_pairs_direct<R1N>(coords);
 
+	m_nb_reference = coords.xyz();
+	m_nb_box = Config::get().periodics.pb_box;
+	++m_nb_stats.builds;
 	//std::cout << "refine_nb time: " << rnbt << "\n";
 	// Todo: build pairs using new-linkedcells (todo: new linkedcells)
 }
 
+bool tinker::refine::refined::update_nb(coords::Coordinates const& coords)
+{
+	++m_nb_stats.checks;
+	std::size_t const N(coords.size());
+	double max_rr(0.0);
+	bool const periodic(Config::get().periodics.periodic);
+	coords::Cartesian_Point const& box(Config::get().periodics.pb_box);
+	// a new box (pressure coupling) moves the periodic images, so the pairs are built again
+	if (m_nb_reference.size() == N && (!periodic || box == m_nb_box))
+	{
+		for (std::size_t i(0u); i < N; ++i)
+		{
+			coords::Cartesian_Point d(coords.xyz(i) - m_nb_reference[i]);
+			if (periodic)   // jumps into neighboring boxes are no displacements
+			{
+				d.x() -= box.x() * std::round(d.x() / box.x());
+				d.y() -= box.y() * std::round(d.y() / box.y());
+				d.z() -= box.z() * std::round(d.z() / box.z());
+			}
+			max_rr = std::max(max_rr, dot(d, d));
+		}
+		m_nb_stats.max_displacement = std::sqrt(max_rr);
+		// no pair can have moved into the cutoff sphere if no atom moved more than half of the skin
+		if (2.0 * m_nb_stats.max_displacement <= Config::get().energy.verlet_skin) return false;
+	}
+	refine_nb(coords);
+	return true;
+}
+
 template<tinker::refine::refined::rel RELATION>
-bool tinker::refine::refined::add_pair(coords::Coordinates const& coords, std::size_t const row, std::size_t const col, std::array<std::size_t, 5u> const& to_matrix_id)
+bool tinker::refine::refined::add_pair(coords::Coordinates const& coords, std::size_t const row, std::size_t const col,
+	std::array<std::size_t, 5u> const& to_matrix_id, std::vector<types::nbpm>& pair_matrices) const
 {
 	::tinker::parameter::parameters const* params = &m_cparams;
 	if (
@@ -578,33 +617,33 @@ bool tinker::refine::refined::add_pair(coords::Coordinates const& coords, std::s
 		{
 			if (params->vdwc_used(R12))
 			{
-				m_pair_matrices[to_matrix_id[R12]].pair_matrix(coords.atoms(row).system(), coords.atoms(col).system()).push_back(pair);
+				pair_matrices[to_matrix_id[R12]].pair_matrix(coords.atoms(row).system(), coords.atoms(col).system()).push_back(pair);
 			}
 		}
 		else if ((RELATION == R12 || RELATION == R13) && to_matrix_id[R13] > 0 && scon::sorted::exists(m_relations[R13][col], row))
 		{
 			if (params->vdwc_used(R13))
 			{
-				m_pair_matrices[to_matrix_id[R13]].pair_matrix(coords.atoms(row).system(), coords.atoms(col).system()).push_back(pair);
+				pair_matrices[to_matrix_id[R13]].pair_matrix(coords.atoms(row).system(), coords.atoms(col).system()).push_back(pair);
 			}
 		}
 		else if ((RELATION == R12 || RELATION == R13 || RELATION == R14) && to_matrix_id[R14] > 0 && scon::sorted::exists(m_relations[R14][col], row))
 		{
 			if (params->vdwc_used(R14))
 			{
-				m_pair_matrices[to_matrix_id[R14]].pair_matrix(coords.atoms(row).system(), coords.atoms(col).system()).push_back(pair);
+				pair_matrices[to_matrix_id[R14]].pair_matrix(coords.atoms(row).system(), coords.atoms(col).system()).push_back(pair);
 			}
 		}
 		else if ((RELATION == R12 || RELATION == R13 || RELATION == R14 || RELATION == R15) && to_matrix_id[R15] > 0 && scon::sorted::exists(m_relations[R15][col], row))
 		{
 			if (params->vdwc_used(R15))
 			{
-				m_pair_matrices[to_matrix_id[R15]].pair_matrix(coords.atoms(row).system(), coords.atoms(col).system()).push_back(pair);
+				pair_matrices[to_matrix_id[R15]].pair_matrix(coords.atoms(row).system(), coords.atoms(col).system()).push_back(pair);
 			}
 		}
 		else
 		{
-			m_pair_matrices[0u].pair_matrix(coords.atoms(row).system(), coords.atoms(col).system()).push_back(pair);
+			pair_matrices[0u].pair_matrix(coords.atoms(row).system(), coords.atoms(col).system()).push_back(pair);
 		}
 		return true;
 	}
@@ -651,74 +690,103 @@ void tinker::refine::refined::build_pairs_direct(coords::Coordinates const& coor
 			}
 		}
 	}
-	for (std::size_t k = 0; k < num_sys; ++k)
+	std::size_t const N = coords.size();
+	bool const all_pairs(Config::get().energy.cutoff > 500.0);   // no linked cell algorithm if cutoff > 500
+	using cells_type = scon::linked::Cells < coords::float_type, coords::Cartesian_Point, coords::Representation_3D >;
+	std::unique_ptr<cells_type> atmcells;
+	if (!all_pairs)
 	{
-		for (std::size_t l = 0; l < num_sys; ++l)
+		// with periodic boundaries the cells wrap around the box, so the adjacencies
+		// contain all atoms that are within the cutoff in the minimum image convention
+		atmcells.reset(new cells_type(
+			coords.xyz(),
+			Config::get().energy.cutoff + Config::get().energy.verlet_skin,
+			Config::get().periodics.periodic, Config::get().periodics.pb_box, coords::float_type(0),
+			scon::linked::fragmentation::half));
+	}
+
+	// The atoms are split into chunks of consecutive rows which are processed in parallel.
+	// Every chunk collects its pairs in its own pair matrices, which are concatenated in chunk order
+	// afterwards, so the order of the pairs is the same as in a serial run for any number of threads.
+	std::vector<std::size_t> const bounds(pair_chunk_bounds(N, all_pairs));
+	std::vector<std::vector<types::nbpm>> chunks(bounds.size() - 1u, m_pair_matrices);
+	std::ptrdiff_t const C(chunks.size());
+#pragma omp parallel for schedule(dynamic)
+	for (std::ptrdiff_t c = 0; c < C; ++c)
+	{
+		std::vector<types::nbpm>& pairs = chunks[c];
+		for (std::size_t i = bounds[c]; i < bounds[c + 1]; ++i)
 		{
-			if (k != l)
+			if (all_pairs)
 			{
-				m_pair_matrices[0].pair_matrix(k, l).reserve(coords.subsystems(k).size() * coords.subsystems(l).size());
+				for (std::size_t j = 0; j < i; ++j)
+				{
+					add_pair<RELATION>(coords, i, j, to_matrix_id, pairs);
+				}
 			}
-			else
+			else    // linked cell algorithm
 			{
-				std::size_t const ks = coords.subsystems(k).size();
-				m_pair_matrices[0].pair_matrix(k, l).reserve((ks * (ks - 1u)) / 2u);
+				auto box_of_i = atmcells->box_of_element(i);
+				for (auto j : box_of_i.adjacencies())
+				{
+					if (j >= 0 && static_cast<std::size_t>(j) < i)
+					{
+						add_pair<RELATION>(coords, i, static_cast<std::size_t>(j), to_matrix_id, pairs);
+					}
+				}
 			}
 		}
 	}
+	concatenate_pairs(chunks);
+}
+
+std::vector<std::size_t> tinker::refine::refined::pair_chunk_bounds(std::size_t const N, bool const all_pairs)
+{
+	// a few chunks per thread for load balancing
+#if defined(_OPENMP)
+	std::size_t const C(std::max<std::size_t>(std::min<std::size_t>(N, 4u * static_cast<std::size_t>(omp_get_max_threads())), 1u));
+#else
+	std::size_t const C(1u);
+#endif
+	std::vector<std::size_t> bounds(C + 1u, N);
+	for (std::size_t c(0u); c < C; ++c)
+	{
+		double const f(static_cast<double>(c) / static_cast<double>(C));
+		// row i has i candidates if all pairs are used, so equal numbers of pairs need sqrt-spaced bounds
+		bounds[c] = static_cast<std::size_t>(static_cast<double>(N) * (all_pairs ? std::sqrt(f) : f));
+	}
+	return bounds;
+}
 
-	if (Config::get().energy.cutoff > 500.0 || Config::get().periodics.periodic)   // no linked cell algorithm
-	{                                                      // if cutoff > 500 or periodic boundaries activated
-		const std::size_t N = coords.size(), M = (N * N - N) / 2;
-		for (std::size_t i(0u), atom_row(1u), relation_col(0u); i < M; ++i)
+void tinker::refine::refined::concatenate_pairs(std::vector<std::vector<types::nbpm>> const& chunks)
+{
+	std::size_t const C(chunks.size()), M(m_pair_matrices.size());
+	std::size_t const IA(M > 0u ? m_pair_matrices[0u].pair_matrix.size() : 0u);
+	// offset of every chunk in the final pair vectors (prefix sum over the chunk sizes)
+	std::vector<std::size_t> offsets(C * M * IA);
+	for (std::size_t m(0u); m < M; ++m)
+	{
+		for (std::size_t k(0u); k < IA; ++k)
 		{
-			add_pair<RELATION>(coords, atom_row, relation_col, to_matrix_id);
-			++relation_col;
-			if (relation_col == atom_row)
+			std::size_t total(0u);
+			for (std::size_t c(0u); c < C; ++c)
 			{
-				relation_col = 0;
-				++atom_row;
+				offsets[(c * M + m) * IA + k] = total;
+				total += chunks[c][m].pair_matrix(k).size();
 			}
+			m_pair_matrices[m].pair_matrix(k).resize(total);
 		}
 	}
-	else    // linked cell algorithm
+	std::ptrdiff_t const sC(C);
+#pragma omp parallel for schedule(dynamic)
+	for (std::ptrdiff_t c = 0; c < sC; ++c)
 	{
-		using cells_type = scon::linked::Cells < coords::float_type, coords::Cartesian_Point, coords::Representation_3D >;
-		cells_type atmcells(
-			coords.xyz(),
-			Config::get().energy.cutoff,
-			Config::get().periodics.periodic, Config::get().periodics.pb_box, coords::float_type(0),
-			scon::linked::fragmentation::half);
-		std::size_t const N = coords.size();
-		//coords::Cartesian_Point const halfbox(Config::get().periodics.pb_box / 2.);
-		#pragma omp parallel     
-		for (std::size_t i = 0; i < N; ++i)
+		for (std::size_t m(0u); m < M; ++m)
 		{
-			auto box_of_i = atmcells.box_of_element(i);
-			for (auto j : box_of_i.adjacencies())
+			for (std::size_t k(0u); k < IA; ++k)
 			{
-				if (j >= 0)
-				{
-					std::size_t const uj = static_cast<std::size_t>(j);
-					if (uj < i)
-					{
-						/*if (Config::get().energy.periodic)   // linked cell for periodic boundaries is deactivated because it has a bug
-						{
-							coords::Cartesian_Point d(scon::abs(coords.xyz(i) - coords.xyz(uj)));
-							if (d.x() > halfbox.x()) d.x() = std::abs(d.x() - Config::get().energy.pb_box.x());
-							if (d.y() > halfbox.y()) d.y() = std::abs(d.y() - Config::get().energy.pb_box.y());
-							if (d.z() > halfbox.z()) d.z() = std::abs(d.z() - Config::get().energy.pb_box.z());
-							if (geometric_length(d) < Config::get().energy.cutoff + 5.0)
-							{
-								add_pair<RELATION>(i, uj, to_matrix_id);
-							}
-						}
-						else
-						{*/
-						add_pair<RELATION>(coords, i, uj, to_matrix_id);
-						/*}*/
-					}
-				}
+				auto const& src = chunks[c][m].pair_matrix(k);
+				std::copy(src.begin(), src.end(), m_pair_matrices[m].pair_matrix(k).begin() + offsets[(c * M + m) * IA + k]);
 			}
 		}
 	}
@@ -1042,6 +1110,7 @@ void tinker::refine::refined::clear(void)
 	m_multipole_vec.clear();
 	m_polarize_vec.clear();
 	m_pair_matrices.clear();
+	m_nb_reference.clear();
 	for (auto& relation : m_relations) relation.clear();
 	for (auto& vdwc_matrix : m_vdwc_matrices) vdwc_matrix.clear();
 }
@@ -1060,6 +1129,9 @@ void tinker::refine::refined::swap_data(refined& rhs)
 	m_red_types.swap(rhs.m_red_types);
 	m_multipole_vec.swap(rhs.m_multipole_vec);
 	m_polarize_vec.swap(rhs.m_polarize_vec);
+	m_nb_reference.swap(rhs.m_nb_reference);
+	std::swap(m_nb_box, rhs.m_nb_box);
+	std::swap(m_nb_stats, rhs.m_nb_stats);
 
 	for (std::size_t i(0u); i < 6u; ++i) m_vdwc_matrices[i].swap(rhs.m_vdwc_matrices[i]);
 }
@@ -1162,6 +1234,17 @@ std::ostream& tinker::refine::types::operator<< (std::ostream& stream, nbpm cons
 	return stream;
 }
 
+std::ostream& tinker::refine::operator<< (std::ostream& stream, nb_list_stats const& stats)
+{
+	stream << "Nonbonded pairs built " << stats.builds << " times in " << stats.checks << " Verlet list checks";
+	if (stats.builds > 1u)
+	{
+		stream << " (every " << static_cast<double>(stats.checks) / static_cast<double>(stats.builds - 1u) << " checks)";
+	}
+	stream << ", last maximum displacement: " << stats.max_displacement << " Angstrom.";
+	return stream;
+}
+
 std::ostream& tinker::refine::operator<< (std::ostream& stream, refined const& ref)
 {
 	stream << "Bonds:" << std::endl;
@@ -161,6 +161,20 @@ namespace tinker
     typedef std::vector<std::size_t>               vector_size_1d;
     typedef std::vector<vector_size_1d>            vector_size_2d;
 
+    /**statistics of the nonbonded pair list*/
+    struct nb_list_stats
+    {
+      /**number of checks whether the Verlet list is still valid*/
+      std::size_t checks;
+      /**number of times the pairs were built*/
+      std::size_t builds;
+      /**maximum atomic displacement at the last check*/
+      double max_displacement;
+      nb_list_stats(void) : checks(), builds(), max_displacement() {}
+    };
+
+    std::ostream& operator<< (std::ostream& stream, nb_list_stats const& stats);
+
     class refined
     {
     public:
@@ -185,6 +199,7 @@ namespace tinker
       vector_biquad const &   ureys(void) const { return m_ureys; }
       std::vector<types::nbpm> const & pair_matrices(void) const { return m_pair_matrices; };
       vector_size_1d const &   remove_relations(std::size_t const index) { return m_removes[index]; }
+      vector_size_1d const &   relations(std::size_t const relation, std::size_t const index) const { return m_relations[relation][index]; }
       std::vector<vector_multipole> const & multipole_vecs(void) const { return m_multipole_vec; };
       std::vector<vector_polarize> const & polarize_vecs(void) const { return m_polarize_vec; };
 
@@ -221,6 +236,11 @@ namespace tinker
 			}
 
       void refine_nb(coords::Coordinates const & cobj);
+      /**Verlet list: rebuilds the nonbonded pairs only if an atom moved more than
+      half of the skin distance or the periodic box changed since the last build
+      @return true if the pairs were rebuilt*/
+      bool update_nb(coords::Coordinates const & cobj);
+      nb_list_stats const & nb_stats(void) const { return m_nb_stats; }
 
     private:
       //
@@ -230,7 +250,12 @@ namespace tinker
       void remove_loose_relations(std::size_t const atom, std::size_t const related, std::size_t const relation_to_check);
       void add_relation(tinker::parameter::parameters const & pobj, std::size_t const atom, std::size_t const related, std::size_t const relation);
       template<rel RELATION> void build_pairs_direct(coords::Coordinates const & coords);
-      template<rel RELATION> bool add_pair(coords::Coordinates const & coords,std::size_t const row, std::size_t const col, std::array<std::size_t, 5u> const & to_matrix_id);
+      template<rel RELATION> bool add_pair(coords::Coordinates const & coords,std::size_t const row, std::size_t const col, std::array<std::size_t, 5u> const & to_matrix_id,
+        std::vector<types::nbpm> & pair_matrices) const;
+      /**splits the rows of the pair search into chunks for the parallel build*/
+      static std::vector<std::size_t> pair_chunk_bounds(std::size_t const N, bool const all_pairs);
+      /**concatenates the pair matrices of all chunks (in chunk order) into m_pair_matrices*/
+      void concatenate_pairs(std::vector<std::vector<types::nbpm>> const & chunks);
 
       //void refine_mp(coords::Coordinates const & coords, tinker::parameter::parameters const & params);
       //void refine_pol(void);
@@ -257,6 +282,11 @@ namespace tinker
       // removed relations
       vector_size_2d                                                m_removes;
       vector_size_1d                                                m_red_types;
+      // positions at the last build of the nonbonded pairs (Verlet list)
+      coords::Representation_3D                                     m_nb_reference;
+      // periodic box at the last build (scaled by the barostat)
+      coords::Cartesian_Point                                       m_nb_box;
+      nb_list_stats                                                 m_nb_stats;
       // Refined vdw matrices
       // 6u -> (-11- -12- -13- -14- -15- -1n-)
       std::array<scon::matrix<parameter::combi::vdwc, true>, 6u>    m_vdwc_matrices;